@@ -3,6 +3,7 @@
 #include <execinfo.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <uuid/uuid.h>
 
@@ -200,15 +201,27 @@ void Logger::Log(Level log_level, const char* fmt, ...) {
   }
 }
 
+/**
+ * @brief 生成日志前缀
+ *
+ * @note localtime_r 需要加锁读取时区信息, 开销远大于读取时间本身, 因此每个线程缓存最近一秒格式化好的日期和时间,
+ *       同一秒内的日志只需要重新格式化微秒部分
+ */
 std::string Logger::GenLogPrefix() {
-  struct timeval now;
-  ::gettimeofday(&now, nullptr);
-  struct tm tm_now;
-  ::localtime_r(&now.tv_sec, &tm_now);
+  static thread_local time_t t_cached_seconds = -1;
+  static thread_local char t_cached_time[64];
+
+  struct timespec now;
+  ::clock_gettime(CLOCK_REALTIME, &now);
+  if (now.tv_sec != t_cached_seconds) {
+    struct tm tm_now;
+    ::localtime_r(&now.tv_sec, &tm_now);
+    snprintf(t_cached_time, sizeof(t_cached_time), "%04d-%02d-%02d %02d:%02d:%02d", tm_now.tm_year + 1900,
+             tm_now.tm_mon + 1, tm_now.tm_mday, tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec);
+    t_cached_seconds = now.tv_sec;
+  }
   char time_str[100];
-  snprintf(time_str, sizeof(time_str), "[%04d-%02d-%02d %02d:%02d:%02d.%06ld][%d:%lx]", tm_now.tm_year + 1900,
-           tm_now.tm_mon + 1, tm_now.tm_mday, tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec, now.tv_usec, t_pid,
-           t_trace_id);
+  snprintf(time_str, sizeof(time_str), "[%s.%06ld][%d:%lx]", t_cached_time, now.tv_nsec / 1000, t_pid, t_trace_id);
   return time_str;
 }
 
@@ -0,0 +1,93 @@
+#include "net/acceptor.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "logger/log.h"
+#include "net/event_loop.h"
+
+namespace net {
+
+Acceptor::Acceptor(EventLoop* loop, const InetAddress& listen_addr, const bool reuse_port)
+    : loop_(loop),
+      accept_socket_(sockets::CreateNonblockingOrDie(listen_addr.family())),
+      accept_channel_(loop, accept_socket_.fd()),
+      idle_fd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)) {
+  CHECK_GE(idle_fd_, 0);
+  accept_socket_.SetReuseAddr(true);
+  accept_socket_.SetReusePort(reuse_port);
+  accept_socket_.BindAddress(listen_addr);
+  accept_channel_.SetReadCallback(std::bind(&Acceptor::HandleRead, this));
+}
+
+Acceptor::~Acceptor() {
+  if (listening_) {
+    accept_channel_.DisableAll();
+    accept_channel_.Remove();
+  }
+  ::close(idle_fd_);
+}
+
+void Acceptor::SetNewConnectionCallback(const NewConnectionCallback& cb) {
+  new_connection_callback_ = cb;
+}
+
+void Acceptor::Listen() {
+  loop_->AssertInLoopThread();
+  listening_ = true;
+  accept_socket_.Listen();
+  accept_channel_.EnableReading();
+}
+
+bool Acceptor::listening() const {
+  return listening_;
+}
+
+bool Acceptor::AttachReusePortCpuSteering(const uint32_t group_size) {
+  return accept_socket_.AttachReusePortCpuSteering(group_size);
+}
+
+InetAddress Acceptor::listen_addr() const {
+  // sockaddr_in6 足够容纳 IPv4 地址, InetAddress 根据 family 解析
+  return InetAddress(sockets::GetLocalAddr(accept_socket_.fd()));
+}
+
+void Acceptor::HandleRead() {
+  loop_->AssertInLoopThread();
+  while (true) {
+    InetAddress peer_addr;
+    int connfd = accept_socket_.Accept(&peer_addr);
+    if (connfd >= 0) {
+      if (new_connection_callback_) {
+        new_connection_callback_(connfd, peer_addr);
+      } else {
+        ::close(connfd);
+      }
+      continue;
+    }
+
+    int saved_errno = errno;
+    if (saved_errno == EAGAIN || saved_errno == EWOULDBLOCK) {
+      // backlog 已经取完
+      break;
+    } else if (saved_errno == EINTR || saved_errno == ECONNABORTED || saved_errno == EPROTO) {
+      // 对端在 accept 之前就断开了, 继续取下一个
+      continue;
+    } else if (saved_errno == EMFILE || saved_errno == ENFILE) {
+      LOG_ERROR << "accept fail with error [" << ::strerror(saved_errno) << "], reject the new connection";
+      ::close(idle_fd_);
+      idle_fd_ = ::accept(accept_socket_.fd(), nullptr, nullptr);
+      ::close(idle_fd_);
+      idle_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+      break;
+    } else {
+      LOG_ERROR << "accept fail with error [" << ::strerror(saved_errno) << "]";
+      break;
+    }
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <functional>
+
+#include "net/channel.h"
+#include "net/inet_address.h"
+#include "net/socket.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class EventLoop;
+
+/**
+ * @brief 监听 socket 并接受新连接, 只能在所属的 IO 线程中使用
+ *
+ * @note
+ *   1. 每次可读事件都会循环调用 accept4 直到 EAGAIN, 把 backlog 中已经完成握手的连接一次性取完,
+ *      高并发建连时可以显著减少 IO 线程被唤醒的次数
+ *   2. 进程的 fd 耗尽 (EMFILE) 时预留的 idle_fd_ 会被临时关闭, 用来接受并立即关闭新连接, 否则水平触发的
+ *      监听 socket 会一直可读, IO 线程会陷入忙等
+ */
+class Acceptor final {
+ public:
+  using NewConnectionCallback = std::function<void(const int sockfd, const InetAddress& peer_addr)>;
+
+ public:
+  Acceptor(EventLoop* loop, const InetAddress& listen_addr, const bool reuse_port);
+  ~Acceptor();
+
+ public:
+  void SetNewConnectionCallback(const NewConnectionCallback& cb);
+  void Listen();
+  bool listening() const;
+  // 见 Socket::AttachReusePortCpuSteering
+  bool AttachReusePortCpuSteering(const uint32_t group_size);
+  // 实际监听的地址, 监听 0 端口时可以通过它获取内核分配的端口
+  InetAddress listen_addr() const;
+
+ private:
+  void HandleRead();
+
+ private:
+  EventLoop* loop_;
+  Socket accept_socket_;
+  Channel accept_channel_;
+  NewConnectionCallback new_connection_callback_;
+  bool listening_ = false;
+  int idle_fd_ = -1;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Acceptor);
+};
+
+}  // namespace net
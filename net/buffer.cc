@@ -0,0 +1,294 @@
+#include "net/buffer.h"
+
+#include <endian.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "logger/log.h"
+
+namespace net {
+
+Buffer::Buffer(const size_t initial_size)
+    : buffer_(kCheapPrepend + initial_size), reader_index_(kCheapPrepend), writer_index_(kCheapPrepend) {
+}
+
+void Buffer::Swap(Buffer& other) {
+  buffer_.swap(other.buffer_);
+  std::swap(reader_index_, other.reader_index_);
+  std::swap(writer_index_, other.writer_index_);
+}
+
+size_t Buffer::ReadableBytes() const {
+  return writer_index_ - reader_index_;
+}
+
+size_t Buffer::WritableBytes() const {
+  return buffer_.size() - writer_index_;
+}
+
+size_t Buffer::PrependableBytes() const {
+  return reader_index_;
+}
+
+size_t Buffer::capacity() const {
+  return buffer_.capacity();
+}
+
+const char* Buffer::Peek() const {
+  return Begin() + reader_index_;
+}
+
+char* Buffer::MutablePeek() {
+  return Begin() + reader_index_;
+}
+
+std::string_view Buffer::ToStringView() const {
+  return std::string_view(Peek(), ReadableBytes());
+}
+
+const char* Buffer::FindCRLF() const {
+  return SearchCRLF(Peek(), BeginWrite());
+}
+
+const char* Buffer::FindCRLF(const char* start) const {
+  CHECK(Peek() <= start && start <= BeginWrite());
+  return SearchCRLF(start, BeginWrite());
+}
+
+const char* Buffer::FindEOL() const {
+  return FindEOL(Peek());
+}
+
+const char* Buffer::FindEOL(const char* start) const {
+  CHECK(Peek() <= start && start <= BeginWrite());
+  // glibc 的 memchr 已经用 SIMD 实现
+  const void* eol = ::memchr(start, '\n', BeginWrite() - start);
+  return static_cast<const char*>(eol);
+}
+
+void Buffer::Retrieve(const size_t len) {
+  CHECK_LE(len, ReadableBytes());
+  if (len < ReadableBytes()) {
+    reader_index_ += len;
+  } else {
+    RetrieveAll();
+  }
+}
+
+void Buffer::RetrieveUntil(const char* end) {
+  CHECK(Peek() <= end && end <= BeginWrite());
+  Retrieve(end - Peek());
+}
+
+void Buffer::RetrieveAll() {
+  // 数据取完之后两个下标都回到开头, 之后的写入不需要压缩
+  reader_index_ = kCheapPrepend;
+  writer_index_ = kCheapPrepend;
+}
+
+std::string Buffer::RetrieveAsString(const size_t len) {
+  CHECK_LE(len, ReadableBytes());
+  std::string result(Peek(), len);
+  Retrieve(len);
+  return result;
+}
+
+std::string Buffer::RetrieveAllAsString() {
+  return RetrieveAsString(ReadableBytes());
+}
+
+void Buffer::Append(const char* data, const size_t len) {
+  EnsureWritableBytes(len);
+  std::copy(data, data + len, BeginWrite());
+  HasWritten(len);
+}
+
+void Buffer::Append(const void* data, const size_t len) {
+  Append(static_cast<const char*>(data), len);
+}
+
+void Buffer::Append(std::string_view data) {
+  Append(data.data(), data.size());
+}
+
+void Buffer::Prepend(const void* data, const size_t len) {
+  CHECK_LE(len, PrependableBytes());
+  reader_index_ -= len;
+  const char* d = static_cast<const char*>(data);
+  std::copy(d, d + len, Begin() + reader_index_);
+}
+
+void Buffer::AppendInt16(const int16_t x) {
+  uint16_t be = htobe16(static_cast<uint16_t>(x));
+  Append(&be, sizeof be);
+}
+
+void Buffer::AppendInt32(const int32_t x) {
+  uint32_t be = htobe32(static_cast<uint32_t>(x));
+  Append(&be, sizeof be);
+}
+
+void Buffer::AppendInt64(const int64_t x) {
+  uint64_t be = htobe64(static_cast<uint64_t>(x));
+  Append(&be, sizeof be);
+}
+
+void Buffer::PrependInt16(const int16_t x) {
+  uint16_t be = htobe16(static_cast<uint16_t>(x));
+  Prepend(&be, sizeof be);
+}
+
+void Buffer::PrependInt32(const int32_t x) {
+  uint32_t be = htobe32(static_cast<uint32_t>(x));
+  Prepend(&be, sizeof be);
+}
+
+void Buffer::PrependInt64(const int64_t x) {
+  uint64_t be = htobe64(static_cast<uint64_t>(x));
+  Prepend(&be, sizeof be);
+}
+
+int16_t Buffer::PeekInt16() const {
+  CHECK_GE(ReadableBytes(), sizeof(int16_t));
+  uint16_t be = 0;
+  ::memcpy(&be, Peek(), sizeof be);
+  return static_cast<int16_t>(be16toh(be));
+}
+
+int32_t Buffer::PeekInt32() const {
+  CHECK_GE(ReadableBytes(), sizeof(int32_t));
+  uint32_t be = 0;
+  ::memcpy(&be, Peek(), sizeof be);
+  return static_cast<int32_t>(be32toh(be));
+}
+
+int64_t Buffer::PeekInt64() const {
+  CHECK_GE(ReadableBytes(), sizeof(int64_t));
+  uint64_t be = 0;
+  ::memcpy(&be, Peek(), sizeof be);
+  return static_cast<int64_t>(be64toh(be));
+}
+
+int16_t Buffer::ReadInt16() {
+  int16_t result = PeekInt16();
+  Retrieve(sizeof result);
+  return result;
+}
+
+int32_t Buffer::ReadInt32() {
+  int32_t result = PeekInt32();
+  Retrieve(sizeof result);
+  return result;
+}
+
+int64_t Buffer::ReadInt64() {
+  int64_t result = PeekInt64();
+  Retrieve(sizeof result);
+  return result;
+}
+
+void Buffer::EnsureWritableBytes(const size_t len) {
+  if (WritableBytes() < len) {
+    MakeSpace(len);
+  }
+}
+
+char* Buffer::BeginWrite() {
+  return Begin() + writer_index_;
+}
+
+const char* Buffer::BeginWrite() const {
+  return Begin() + writer_index_;
+}
+
+void Buffer::HasWritten(const size_t len) {
+  CHECK_LE(len, WritableBytes());
+  writer_index_ += len;
+}
+
+void Buffer::Unwrite(const size_t len) {
+  CHECK_LE(len, ReadableBytes());
+  writer_index_ -= len;
+}
+
+void Buffer::Shrink(const size_t reserve) {
+  Buffer other(ReadableBytes() + reserve);
+  other.Append(Peek(), ReadableBytes());
+  other.buffer_.shrink_to_fit();
+  Swap(other);
+}
+
+ssize_t Buffer::ReadFd(const int fd, int* const saved_errno) {
+  char extra_buffer[kExtraBufferSize];
+  const size_t writable = WritableBytes();
+  struct iovec vec[2];
+  vec[0].iov_base = BeginWrite();
+  vec[0].iov_len = writable;
+  vec[1].iov_base = extra_buffer;
+  vec[1].iov_len = sizeof extra_buffer;
+  const ssize_t n = ::readv(fd, vec, 2);
+  if (n < 0) {
+    *saved_errno = errno;
+  } else if (static_cast<size_t>(n) <= writable) {
+    writer_index_ += n;
+  } else {
+    writer_index_ = buffer_.size();
+    Append(extra_buffer, n - writable);
+  }
+  return n;
+}
+
+const char* Buffer::SearchCRLF(const char* begin, const char* end) {
+  const char* p = begin;
+#if defined(__SSE2__)
+  // 同时比较 p[i] == '\r' 和 p[i + 1] == '\n', 因此每次需要 17 字节
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  while (end - p >= 17) {
+    __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+    __m128i match = _mm_and_si128(_mm_cmpeq_epi8(first, cr), _mm_cmpeq_epi8(second, lf));
+    int mask = _mm_movemask_epi8(match);
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+    p += 16;
+  }
+#endif
+  for (; end - p >= 2; ++p) {
+    if (p[0] == '\r' && p[1] == '\n') {
+      return p;
+    }
+  }
+  return nullptr;
+}
+
+char* Buffer::Begin() {
+  return buffer_.data();
+}
+
+const char* Buffer::Begin() const {
+  return buffer_.data();
+}
+
+void Buffer::MakeSpace(const size_t len) {
+  if (WritableBytes() + PrependableBytes() < len + kCheapPrepend) {
+    buffer_.resize(writer_index_ + len);
+  } else {
+    // 空间足够, 把可读数据挪到开头
+    CHECK_LT(kCheapPrepend, reader_index_);
+    const size_t readable = ReadableBytes();
+    std::copy(Begin() + reader_index_, Begin() + writer_index_, Begin() + kCheapPrepend);
+    reader_index_ = kCheapPrepend;
+    writer_index_ = reader_index_ + readable;
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief 网络 IO 使用的缓冲区
+ *
+ * @note
+ *   1. 内存布局如下, readable 是还没有被处理的数据, writable 是可以直接写入的空间:
+ *        +-------------------+------------------+------------------+
+ *        | prependable bytes |  readable bytes  |  writable bytes  |
+ *        +-------------------+------------------+------------------+
+ *        0             reader_index_      writer_index_        size()
+ *   2. 开头预留 kCheapPrepend 字节, 序列化完消息体之后可以直接在前面写入长度头, 不需要移动数据
+ *   3. 空间不足时先尝试把 readable 数据挪到开头 (原地压缩), 仍然不够才扩容
+ *   4. ReadFd 用 readv 同时读入 writable 空间和栈上的 kExtraBufferSize 字节, 一次系统调用就能读空 socket,
+ *      不需要给每个连接预先分配很大的缓冲区
+ *   5. 不是线程安全的
+ */
+class Buffer {
+ public:
+  static constexpr size_t kCheapPrepend = 8;
+  static constexpr size_t kInitialSize = 1024;
+  // ReadFd 使用的栈上缓冲区大小
+  static constexpr size_t kExtraBufferSize = 64 * 1024;
+
+ public:
+  explicit Buffer(const size_t initial_size = kInitialSize);
+
+ public:
+  void Swap(Buffer& other);
+
+  size_t ReadableBytes() const;
+  size_t WritableBytes() const;
+  size_t PrependableBytes() const;
+  // 已经分配的内存大小
+  size_t capacity() const;
+
+  // 可读数据的起始位置
+  const char* Peek() const;
+  // 可以原地修改的可读数据, 例如 WebSocket 原地去掉掩码
+  char* MutablePeek();
+  std::string_view ToStringView() const;
+
+  // 查找 "\r\n", 返回 '\r' 的位置, 没有时返回 nullptr
+  const char* FindCRLF() const;
+  const char* FindCRLF(const char* start) const;
+  // 查找 '\n', 没有时返回 nullptr
+  const char* FindEOL() const;
+  const char* FindEOL(const char* start) const;
+
+  // 取走 len 字节数据
+  void Retrieve(const size_t len);
+  // 取走 [Peek(), end) 的数据
+  void RetrieveUntil(const char* end);
+  void RetrieveAll();
+  std::string RetrieveAsString(const size_t len);
+  std::string RetrieveAllAsString();
+
+  void Append(const char* data, const size_t len);
+  void Append(const void* data, const size_t len);
+  void Append(std::string_view data);
+  // 在可读数据之前写入 len 字节, len 不能超过 PrependableBytes
+  void Prepend(const void* data, const size_t len);
+
+  // 以网络字节序写入 / 读取整数
+  void AppendInt16(const int16_t x);
+  void AppendInt32(const int32_t x);
+  void AppendInt64(const int64_t x);
+  void PrependInt16(const int16_t x);
+  void PrependInt32(const int32_t x);
+  void PrependInt64(const int64_t x);
+  // 要求 ReadableBytes 不少于整数的长度
+  int16_t PeekInt16() const;
+  int32_t PeekInt32() const;
+  int64_t PeekInt64() const;
+  int16_t ReadInt16();
+  int32_t ReadInt32();
+  int64_t ReadInt64();
+
+  // 保证至少有 len 字节的 writable 空间
+  void EnsureWritableBytes(const size_t len);
+  char* BeginWrite();
+  const char* BeginWrite() const;
+  // 直接写入 BeginWrite 之后调用, 移动 writer_index_
+  void HasWritten(const size_t len);
+  // 撤销最后写入的 len 字节
+  void Unwrite(const size_t len);
+
+  // 把可读数据挪到开头, 并把容量收缩到可读数据加上 reserve 字节
+  void Shrink(const size_t reserve);
+
+  /**
+   * @brief 从 fd 中读取数据, 一次最多读取 WritableBytes() + kExtraBufferSize 字节
+   *
+   * @param fd
+   * @param saved_errno 失败时保存 errno
+   * @return ssize_t 读取的字节数, 0 表示对端关闭, -1 表示失败
+   */
+  ssize_t ReadFd(const int fd, int* const saved_errno);
+
+ public:
+  /**
+   * @brief 在 [begin, end) 中查找 "\r\n", 返回 '\r' 的位置, 没有时返回 nullptr
+   * @note 支持 SSE2 时每次比较 16 字节, HTTP 等文本协议解析的热点
+   */
+  static const char* SearchCRLF(const char* begin, const char* end);
+
+ private:
+  char* Begin();
+  const char* Begin() const;
+  void MakeSpace(const size_t len);
+
+ private:
+  std::vector<char> buffer_;
+  size_t reader_index_;
+  size_t writer_index_;
+};
+
+}  // namespace net
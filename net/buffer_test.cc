@@ -0,0 +1,148 @@
+#include "net/buffer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace net {
+
+TEST(BufferTest, append_and_retrieve) {
+  Buffer buffer;
+  EXPECT_EQ(buffer.ReadableBytes(), 0UL);
+  EXPECT_EQ(buffer.WritableBytes(), Buffer::kInitialSize);
+  EXPECT_EQ(buffer.PrependableBytes(), Buffer::kCheapPrepend);
+
+  const std::string str(200, 'x');
+  buffer.Append(str);
+  EXPECT_EQ(buffer.ReadableBytes(), str.size());
+  EXPECT_EQ(buffer.WritableBytes(), Buffer::kInitialSize - str.size());
+
+  EXPECT_EQ(buffer.RetrieveAsString(50), std::string(50, 'x'));
+  EXPECT_EQ(buffer.ReadableBytes(), str.size() - 50);
+  EXPECT_EQ(buffer.PrependableBytes(), Buffer::kCheapPrepend + 50);
+
+  EXPECT_EQ(buffer.RetrieveAllAsString(), std::string(150, 'x'));
+  // 取完之后下标回到开头
+  EXPECT_EQ(buffer.ReadableBytes(), 0UL);
+  EXPECT_EQ(buffer.PrependableBytes(), Buffer::kCheapPrepend);
+  EXPECT_EQ(buffer.WritableBytes(), Buffer::kInitialSize);
+}
+
+TEST(BufferTest, grow_and_compact) {
+  Buffer buffer;
+  buffer.Append(std::string(400, 'y'));
+  buffer.Retrieve(300);
+  const char* old_data = buffer.Peek() - buffer.PrependableBytes();
+
+  // 可写空间 624, 加上前面空出来的 300 字节足够放下 800 字节, 应该原地压缩而不是扩容
+  buffer.Append(std::string(800, 'z'));
+  EXPECT_EQ(buffer.Peek() - buffer.PrependableBytes(), old_data);
+  EXPECT_EQ(buffer.PrependableBytes(), Buffer::kCheapPrepend);
+  EXPECT_EQ(buffer.ReadableBytes(), 900UL);
+  EXPECT_EQ(buffer.ToStringView(), std::string(100, 'y') + std::string(800, 'z'));
+
+  // 空间不足时扩容
+  buffer.Append(std::string(2000, 'w'));
+  EXPECT_EQ(buffer.ReadableBytes(), 2900UL);
+  EXPECT_GE(buffer.capacity(), Buffer::kCheapPrepend + 2900);
+
+  buffer.Retrieve(2800);
+  buffer.Shrink(0);
+  EXPECT_EQ(buffer.ToStringView(), std::string(100, 'w'));
+  EXPECT_LT(buffer.capacity(), 2900UL);
+}
+
+TEST(BufferTest, prepend_and_integers) {
+  Buffer buffer;
+  buffer.Append(std::string("payload"));
+  buffer.PrependInt32(static_cast<int32_t>(buffer.ReadableBytes()));
+  EXPECT_EQ(buffer.PrependableBytes(), Buffer::kCheapPrepend - sizeof(int32_t));
+  EXPECT_EQ(buffer.ReadInt32(), 7);
+  EXPECT_EQ(buffer.RetrieveAllAsString(), "payload");
+
+  buffer.AppendInt16(-2);
+  buffer.AppendInt32(0x12345678);
+  buffer.AppendInt64(-1234567890123LL);
+  // 网络字节序
+  EXPECT_EQ(static_cast<unsigned char>(buffer.Peek()[2]), 0x12);
+  EXPECT_EQ(buffer.ReadInt16(), -2);
+  EXPECT_EQ(buffer.PeekInt32(), 0x12345678);
+  EXPECT_EQ(buffer.ReadInt32(), 0x12345678);
+  EXPECT_EQ(buffer.ReadInt64(), -1234567890123LL);
+  EXPECT_EQ(buffer.ReadableBytes(), 0UL);
+}
+
+TEST(BufferTest, find_crlf_and_eol) {
+  Buffer buffer;
+  buffer.Append(std::string("GET / HTTP/1.1\r\nHost: x\r\n\r\n"));
+  const char* crlf = buffer.FindCRLF();
+  ASSERT_NE(crlf, nullptr);
+  EXPECT_EQ(std::string(buffer.Peek(), crlf), "GET / HTTP/1.1");
+  EXPECT_EQ(buffer.FindEOL(), crlf + 1);
+  EXPECT_EQ(std::string(crlf + 2, buffer.FindCRLF(crlf + 2)), "Host: x");
+  buffer.RetrieveUntil(crlf + 2);
+  EXPECT_EQ(buffer.FindCRLF(buffer.Peek() + buffer.ReadableBytes()), nullptr);
+
+  buffer.RetrieveAll();
+  buffer.Append(std::string("no line end\r"));
+  EXPECT_EQ(buffer.FindCRLF(), nullptr);
+  EXPECT_EQ(buffer.FindEOL(), nullptr);
+}
+
+/**
+ * @brief 在各种长度和位置放置 "\r\n" 以及干扰字符, 和逐字节查找的结果对比, 覆盖 SIMD 路径和块边界
+ */
+TEST(BufferTest, search_crlf_matches_naive) {
+  std::mt19937 rng(7);
+  const char alphabet[] = {'a', '\r', '\n', 'b'};
+  for (int round = 0; round < 20000; ++round) {
+    size_t len = rng() % 80;
+    std::string data(len, 'a');
+    for (char& c : data) {
+      c = alphabet[rng() % 4];
+    }
+    const char* begin = data.data();
+    const char* end = begin + data.size();
+    const char* expected = nullptr;
+    for (const char* p = begin; p + 1 < end; ++p) {
+      if (p[0] == '\r' && p[1] == '\n') {
+        expected = p;
+        break;
+      }
+    }
+    ASSERT_EQ(Buffer::SearchCRLF(begin, end), expected) << "round " << round;
+  }
+}
+
+TEST(BufferTest, read_fd) {
+  int fds[2];
+  ASSERT_EQ(::pipe2(fds, O_NONBLOCK), 0);
+  ::fcntl(fds[1], F_SETPIPE_SZ, 1024 * 1024);
+
+  // 超过 writable 空间的数据进入栈上缓冲区, 之后追加到 Buffer 中
+  std::string data(50000, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 31);
+  }
+  ASSERT_EQ(::write(fds[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+
+  Buffer buffer;
+  int saved_errno = 0;
+  EXPECT_EQ(buffer.ReadFd(fds[0], &saved_errno), static_cast<ssize_t>(data.size()));
+  EXPECT_EQ(buffer.ToStringView(), data);
+
+  EXPECT_EQ(buffer.ReadFd(fds[0], &saved_errno), -1);
+  EXPECT_EQ(saved_errno, EAGAIN);
+
+  ::close(fds[1]);
+  EXPECT_EQ(buffer.ReadFd(fds[0], &saved_errno), 0);
+  ::close(fds[0]);
+}
+
+}  // namespace net
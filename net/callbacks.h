@@ -1,9 +1,30 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <memory>
+
+#include "util/time/timestamp.hpp"
 
 namespace net {
 
+class Buffer;
+class TcpConnection;
+using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+
 using TimerCallback = std::function<void()>;
 
-}
+// 连接建立和断开时都会调用, 通过 TcpConnection::Connected 区分
+using ConnectionCallback = std::function<void(const TcpConnectionPtr&)>;
+// 收到数据时调用, 回调中需要从 buffer 中取走已经处理的数据, 剩下的数据会保留到下一次回调
+using MessageCallback = std::function<void(const TcpConnectionPtr&, Buffer* buffer, util::time::Timestamp)>;
+// 输出缓冲区中的数据全部写入内核时调用
+using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
+using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
+// 输出队列中的字节数从低于水位线变为不低于水位线时调用, 第二个参数是当前排队的字节数
+using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
+
+void DefaultConnectionCallback(const TcpConnectionPtr& conn);
+void DefaultMessageCallback(const TcpConnectionPtr& conn, Buffer* buffer, util::time::Timestamp receive_time);
+
+}  // namespace net
@@ -3,6 +3,7 @@
 #include <sys/poll.h>
 
 #include <memory>
+#include <sstream>
 
 #include "logger/log.h"
 #include "net/event_loop.h"
@@ -50,7 +51,7 @@ void Channel::HandleEvent(const ::util::time::Timestamp receive_time) {
  */
 void Channel::HandleEventWithGuard(const ::util::time::Timestamp receive_time) {
   event_handling_ = true;
-  LOG_INFO << ReventsToString();
+  LOG_DEBUG << ReventsToString();
   if ((revents_ & POLLHUP) && !(revents_ & POLLIN)) {
     // 表示挂断 (hangup) 或者连接中断
     LOG_WARN << "fd = " << fd_ << " Channel::handle_event() POLLHUP";
@@ -59,7 +60,10 @@ void Channel::HandleEventWithGuard(const ::util::time::Timestamp receive_time) {
     }
   }
   if (revents_ & (POLLERR | POLLNVAL)) {
-    if (error_callback_) {
+    // POLLERR 可能只是因为错误队列中有通知, 读取之后不算错误
+    bool error_queue_only = (revents_ & POLLERR) && !(revents_ & POLLNVAL) && error_queue_callback_ &&
+                            error_queue_callback_();
+    if (!error_queue_only && error_callback_) {
       error_callback_();
     }
   }
@@ -76,6 +80,26 @@ void Channel::HandleEventWithGuard(const ::util::time::Timestamp receive_time) {
   event_handling_ = false;
 }
 
+void Channel::SetReadCallback(const ReadEventCallback& cb) {
+  read_callback_ = cb;
+}
+
+void Channel::SetWriteCallback(const EventCallback& cb) {
+  write_callback_ = cb;
+}
+
+void Channel::SetCloseCallback(const EventCallback& cb) {
+  close_callback_ = cb;
+}
+
+void Channel::SetErrorCallback(const EventCallback& cb) {
+  error_callback_ = cb;
+}
+
+void Channel::SetErrorQueueCallback(const ErrorQueueCallback& cb) {
+  error_queue_callback_ = cb;
+}
+
 int Channel::index() const {
   return index_;
 }
@@ -88,6 +112,10 @@ int Channel::events() const {
   return events_;
 }
 
+int Channel::revents() const {
+  return revents_;
+}
+
 void Channel::set_revents(const int revents) {
   revents_ = revents;
 }
@@ -111,12 +139,6 @@ void Channel::Update() {
   loop_->UpdateChannel(this);
 }
 
-void Channel::Remove() {
-  CHECK(IsNoneEvent());
-  added_to_loop_ = false;
-  loop_->RemoveChannel(this);
-}
-
 std::string Channel::ReventsToString() const {
   return EventsToString(fd_, revents_);
 }
@@ -186,4 +208,46 @@ bool Channel::IsReading() const {
   return events_ & kReadEvent;
 }
 
+void Channel::EnableEdgeTriggered() {
+  edge_triggered_ = true;
+  // 尚未注册到 Poller 时只记录标志, 在 EnableReading / EnableWriting 时一起生效
+  if (added_to_loop_) {
+    Update();
+  }
+}
+
+void Channel::DisableEdgeTriggered() {
+  edge_triggered_ = false;
+  if (added_to_loop_) {
+    Update();
+  }
+}
+
+void Channel::EnableOneShot() {
+  one_shot_ = true;
+  if (added_to_loop_) {
+    Update();
+  }
+}
+
+void Channel::DisableOneShot() {
+  one_shot_ = false;
+  if (added_to_loop_) {
+    Update();
+  }
+}
+
+void Channel::Rearm() {
+  CHECK(one_shot_) << "fd = " << fd_ << " is not in one shot mode";
+  Update();
+}
+
+bool Channel::IsEdgeTriggered() const {
+  return edge_triggered_;
+}
+
+bool Channel::IsOneShot() const {
+  return one_shot_;
+}
+
 }  // namespace net
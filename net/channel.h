@@ -19,11 +19,18 @@ class EventLoop;
  * @note
  *   1. 每个 Channel 对象只属于一个 EventLoop 对象, 因此它只属于某个 IO 线程
  *   2. 每个 Channel 对象只负责一个 fd 的 IO 事件分发, 但它并不拥有这个 fd
+ *   3. 默认是水平触发, 可以通过 EnableEdgeTriggered 切换成边缘触发 (EPOLLET), 此时每次状态变化只会通知一次,
+ *      读写回调必须一直读写到 EAGAIN, 或者在用完 EventLoop::io_budget_bytes 之后调用 EventLoop::DeferChannel
+ *      让 IO 线程在下一轮循环中继续处理, 避免一个繁忙的 fd 饿死其他 fd
+ *   4. EnableOneShot 之后每次通知后都会自动停止关注 (EPOLLONESHOT), 需要在 IO 线程中调用 Rearm 重新关注,
+ *      适合把事件交给工作线程处理、处理完之前不希望再收到通知的场景
  */
 class Channel final {
  public:
   using EventCallback = std::function<void()>;
   using ReadEventCallback = std::function<void(util::time::Timestamp)>;
+  // 读取 socket 错误队列中的通知, 返回是否读到了通知
+  using ErrorQueueCallback = std::function<bool()>;
 
  public:
   enum EventType {
@@ -45,6 +52,11 @@ class Channel final {
   void SetWriteCallback(const EventCallback& cb);
   void SetCloseCallback(const EventCallback& cb);
   void SetErrorCallback(const EventCallback& cb);
+  /**
+   * @brief socket 错误队列 (MSG_ERRQUEUE) 非空时同样会产生 POLLERR, 例如 MSG_ZEROCOPY 的完成通知;
+   *        设置之后收到 POLLERR 时先调用 cb 读取错误队列, 读到了通知时不再调用 error callback
+   */
+  void SetErrorQueueCallback(const ErrorQueueCallback& cb);
 
   EventLoop* OwnerLoop() const;
   void Remove();
@@ -58,10 +70,21 @@ class Channel final {
   bool IsWriting() const;
   bool IsReading() const;
 
+  // 切换触发方式, 需要在 IO 线程中调用
+  void EnableEdgeTriggered();
+  void DisableEdgeTriggered();
+  void EnableOneShot();
+  void DisableOneShot();
+  // 重新关注 EPOLLONESHOT 模式下已经触发过的事件
+  void Rearm();
+  bool IsEdgeTriggered() const;
+  bool IsOneShot() const;
+
  public:
   int fd() const;
   int index() const;
   int events() const;
+  int revents() const;
   void set_index(const int index);
   void set_revents(const int revents);
 
@@ -80,6 +103,8 @@ class Channel final {
   bool tied_ = false;            // 是否绑定了 tie_ 对象
   bool event_handling_ = false;  // 是否正在处理事件
   bool added_to_loop_ = false;
+  bool edge_triggered_ = false;  // 是否边缘触发
+  bool one_shot_ = false;        // 是否每次通知后自动停止关注
 
   EventLoop* loop_ = nullptr;
   const int fd_ = 0;
@@ -91,6 +116,7 @@ class Channel final {
   EventCallback write_callback_ = nullptr;
   EventCallback close_callback_ = nullptr;
   EventCallback error_callback_ = nullptr;
+  ErrorQueueCallback error_queue_callback_ = nullptr;
 
  private:
   // 禁止拷贝
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "logger/log.h"
+
+namespace net {
+
+class Channel;
+
+/**
+ * @brief 以 fd 为下标的 Channel 注册表
+ *
+ * @note
+ *   1. fd 是从小到大复用的稠密整数, 用 vector 代替 std::map 可以把每次查找从 O(log n) 的指针跳转降为一次数组访问
+ *   2. 每个槽位带有一个 generation, 每次注册新的 Channel 时递增. Poller 把 (fd, generation) 编码进 epoll / io_uring
+ *      的 user data 中, 这样 fd 被关闭并复用之后, 旧注册产生的事件会因为 generation 不匹配而被识别出来
+ */
+class ChannelTable {
+ public:
+  Channel* Find(const int fd) const {
+    if (fd < 0 || static_cast<size_t>(fd) >= slots_.size()) {
+      return nullptr;
+    }
+    return slots_[fd].channel;
+  }
+
+  bool Contains(const int fd, const Channel* channel) const {
+    return channel != nullptr && Find(fd) == channel;
+  }
+
+  /**
+   * @brief 注册 Channel, 返回本次注册的 generation
+   */
+  uint32_t Insert(const int fd, Channel* channel) {
+    CHECK_GE(fd, 0);
+    if (static_cast<size_t>(fd) >= slots_.size()) {
+      slots_.resize(std::max(static_cast<size_t>(fd) + 1, slots_.size() * 2));
+    }
+    Slot& slot = slots_[fd];
+    CHECK(slot.channel == nullptr) << "fd [" << fd << "] has already been registered";
+    slot.channel = channel;
+    ++size_;
+    return ++slot.generation;
+  }
+
+  void Erase(const int fd) {
+    CHECK(Find(fd) != nullptr) << "fd [" << fd << "] has not been registered";
+    Slot& slot = slots_[fd];
+    slot.channel = nullptr;
+    // 注销时同样递增 generation, 使得注销之前提交的请求的事件全部失效
+    ++slot.generation;
+    --size_;
+  }
+
+  uint32_t generation(const int fd) const {
+    CHECK(Find(fd) != nullptr) << "fd [" << fd << "] has not been registered";
+    return slots_[fd].generation;
+  }
+
+  /**
+   * @brief 递增 fd 的 generation, 用于使该 fd 上已提交请求的事件失效
+   */
+  uint32_t BumpGeneration(const int fd) {
+    CHECK(Find(fd) != nullptr) << "fd [" << fd << "] has not been registered";
+    return ++slots_[fd].generation;
+  }
+
+  /**
+   * @brief 根据 Encode 得到的 tag 查找 Channel, generation 不匹配时返回 nullptr
+   */
+  Channel* FindByTag(const uint64_t tag) const {
+    int fd = static_cast<int>(tag & 0xFFFFFFFF);
+    uint32_t generation = static_cast<uint32_t>(tag >> 32);
+    Channel* channel = Find(fd);
+    if (channel == nullptr || slots_[fd].generation != generation) {
+      return nullptr;
+    }
+    return channel;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ public:
+  // 将 fd 和 generation 编码成 64 位的 tag, generation 从 1 开始, 因此 tag 永远不会是 0
+  static uint64_t Encode(const int fd, const uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+  }
+
+ private:
+  struct Slot {
+    Channel* channel = nullptr;
+    uint32_t generation = 0;
+  };
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace net
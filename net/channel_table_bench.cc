@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "net/channel_table.hpp"
+#include "util/time/timestamp.hpp"
+
+// 对比 Poller::UpdateChannel / RemoveChannel 中 Channel 注册表的开销: 原来的 std::map<int, Channel*> 和 ChannelTable
+// 这里只测试注册表本身的查找/插入/删除, 不包含 epoll_ctl 系统调用, 因此可以模拟百万级别的 fd
+
+namespace {
+
+constexpr uint64_t kUpdateCount = 10 * 1000 * 1000;
+
+net::Channel* FakeChannel(const int fd) {
+  return reinterpret_cast<net::Channel*>(static_cast<uintptr_t>(fd + 1) * 64);
+}
+
+/**
+ * @brief 原来的实现: 和 EpollPoller::UpdateChannel 一样, 每次修改都需要 find + operator[] 两次树查找
+ */
+class MapRegistry {
+ public:
+  void Add(const int fd) {
+    if (channel_map_.find(fd) == channel_map_.end()) {
+      channel_map_[fd] = FakeChannel(fd);
+    }
+  }
+
+  bool Update(const int fd) {
+    return channel_map_.find(fd) != channel_map_.end() && channel_map_[fd] == FakeChannel(fd);
+  }
+
+  void Remove(const int fd) {
+    if (channel_map_.find(fd) != channel_map_.end() && channel_map_[fd] == FakeChannel(fd)) {
+      channel_map_.erase(fd);
+    }
+  }
+
+ private:
+  std::map<int, net::Channel*> channel_map_;
+};
+
+/**
+ * @brief 新的实现: 以 fd 为下标的 ChannelTable
+ */
+class TableRegistry {
+ public:
+  void Add(const int fd) {
+    if (channel_table_.Find(fd) == nullptr) {
+      channel_table_.Insert(fd, FakeChannel(fd));
+    }
+  }
+
+  bool Update(const int fd) {
+    return channel_table_.Contains(fd, FakeChannel(fd));
+  }
+
+  void Remove(const int fd) {
+    if (channel_table_.Contains(fd, FakeChannel(fd))) {
+      channel_table_.Erase(fd);
+    }
+  }
+
+ private:
+  net::ChannelTable channel_table_;
+};
+
+template <typename Registry>
+void Bench(const char* name, const int fd_num) {
+  Registry registry;
+  for (int fd = 0; fd < fd_num; ++fd) {
+    registry.Add(fd);
+  }
+
+  // 随机选择已注册的 fd 修改关注事件, 每 16 次修改模拟一次连接关闭后 fd 被复用
+  std::mt19937 rng(fd_num);
+  std::uniform_int_distribution<int> dist(0, fd_num - 1);
+  std::vector<int> fds(kUpdateCount);
+  for (int& fd : fds) {
+    fd = dist(rng);
+  }
+
+  uint64_t hit = 0;
+  uint64_t t_start_ns = util::time::TimestampNanoSec();
+  for (uint64_t i = 0; i < kUpdateCount; ++i) {
+    int fd = fds[i];
+    if ((i & 0xF) == 0) {
+      registry.Remove(fd);
+      registry.Add(fd);
+    }
+    hit += registry.Update(fd);
+  }
+  double t_cost_seconds = static_cast<double>(util::time::TimestampNanoSec() - t_start_ns) / 1000.0 / 1000.0 / 1000.0;
+
+  printf("[ChannelTable Bench] %-12s fds=%-8d %8.3f seconds || %12.2f updates/s || %6.2f ns/update (hit=%lu)\n", name,
+         fd_num, t_cost_seconds, kUpdateCount / t_cost_seconds, t_cost_seconds * 1e9 / kUpdateCount, hit);
+}
+
+}  // namespace
+
+int main() {
+  for (int fd_num : {1000, 100 * 1000, 1000 * 1000}) {
+    Bench<MapRegistry>("std::map", fd_num);
+    Bench<TableRegistry>("ChannelTable", fd_num);
+  }
+}
@@ -0,0 +1,54 @@
+#include "net/channel_table.hpp"
+
+#include "gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+Channel* FakeChannel(const uintptr_t id) {
+  return reinterpret_cast<Channel*>(id * 64);
+}
+
+}  // namespace
+
+TEST(ChannelTableTest, insert_and_erase) {
+  ChannelTable table;
+  EXPECT_EQ(table.Find(3), nullptr);
+  EXPECT_EQ(table.Find(-1), nullptr);
+
+  table.Insert(3, FakeChannel(1));
+  table.Insert(1000, FakeChannel(2));
+  EXPECT_EQ(table.size(), 2UL);
+  EXPECT_TRUE(table.Contains(3, FakeChannel(1)));
+  EXPECT_FALSE(table.Contains(3, FakeChannel(2)));
+  EXPECT_EQ(table.Find(1000), FakeChannel(2));
+  EXPECT_EQ(table.Find(999), nullptr);
+
+  table.Erase(3);
+  EXPECT_EQ(table.Find(3), nullptr);
+  EXPECT_EQ(table.size(), 1UL);
+}
+
+TEST(ChannelTableTest, generation_catch_fd_reuse) {
+  ChannelTable table;
+  uint32_t generation = table.Insert(5, FakeChannel(1));
+  uint64_t tag = ChannelTable::Encode(5, generation);
+  EXPECT_NE(tag, 0UL);
+  EXPECT_EQ(table.FindByTag(tag), FakeChannel(1));
+
+  // fd 被关闭后复用, 旧 tag 不再匹配
+  table.Erase(5);
+  EXPECT_EQ(table.FindByTag(tag), nullptr);
+  uint32_t new_generation = table.Insert(5, FakeChannel(2));
+  EXPECT_NE(generation, new_generation);
+  EXPECT_EQ(table.FindByTag(tag), nullptr);
+  EXPECT_EQ(table.FindByTag(ChannelTable::Encode(5, new_generation)), FakeChannel(2));
+
+  // BumpGeneration 使之前的 tag 失效
+  table.BumpGeneration(5);
+  EXPECT_EQ(table.FindByTag(ChannelTable::Encode(5, new_generation)), nullptr);
+  EXPECT_EQ(table.FindByTag(ChannelTable::Encode(5, table.generation(5))), FakeChannel(2));
+}
+
+}  // namespace net
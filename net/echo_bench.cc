@@ -0,0 +1,159 @@
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger/log.h"
+#include "logger/logger.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/inet_address.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+#include "util/time/timestamp.hpp"
+
+// echo 服务的吞吐: 服务端和客户端在同一个进程中, 客户端使用阻塞 socket
+//   1. 短连接: 每个连接只发送一条消息, 收到回显之后立即关闭, 统计每秒建立的连接数
+//   2. 长连接: 每个连接不停地发送消息并等待回显 (ping-pong), 统计每秒完成的请求数
+// 用法: echo_bench [io 线程数] [客户端线程数] [每个阶段的秒数] [single|reuseport|cpu]
+
+namespace {
+
+constexpr size_t kMessageSize = 64;
+
+int Connect(const net::InetAddress& addr) {
+  int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || ::connect(fd, addr.GetSockAddr(), addr.GetSockLen()) != 0) {
+    perror("connect");
+    exit(1);
+  }
+  int on = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+  return fd;
+}
+
+bool PingPong(const int fd, const std::string& message, char* const buf) {
+  if (::write(fd, message.data(), message.size()) != static_cast<ssize_t>(message.size())) {
+    return false;
+  }
+  size_t received = 0;
+  while (received < message.size()) {
+    ssize_t n = ::read(fd, buf + received, message.size() - received);
+    if (n <= 0) {
+      return false;
+    }
+    received += n;
+  }
+  return true;
+}
+
+/**
+ * @brief 启动 client_threads 个线程运行 fn 直到 seconds 秒后, 返回所有线程完成的操作总数
+ */
+template <typename Fn>
+uint64_t RunClients(const int client_threads, const double seconds, Fn&& fn) {
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> total = {0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < client_threads; ++i) {
+    threads.emplace_back([&]() {
+      uint64_t count = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        count += fn();
+      }
+      total += count;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return total;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int io_threads = argc > 1 ? atoi(argv[1]) : 1;
+  int client_threads = argc > 2 ? atoi(argv[2]) : 4;
+  double seconds = argc > 3 ? atof(argv[3]) : 3.0;
+  std::string mode = argc > 4 ? argv[4] : "single";
+  net::TcpServer::AcceptMode accept_mode = net::TcpServer::AcceptMode::kSingleAcceptor;
+  if (mode == "reuseport") {
+    accept_mode = net::TcpServer::AcceptMode::kReusePort;
+  } else if (mode == "cpu") {
+    accept_mode = net::TcpServer::AcceptMode::kReusePortCpuSteering;
+  }
+  // 每个连接都会打印 DEBUG 日志, 压测时只把警告和错误写到日志文件
+  std::string path = std::filesystem::path(__FILE__).parent_path().string();
+  if (!logger::Logger::Instance().Init(path + "/conf/echo_bench.conf")) {
+    LogError("init logger fail, print to console");
+  }
+
+  // 服务端运行在单独的线程中
+  std::promise<std::pair<net::EventLoop*, net::InetAddress>> started;
+  std::thread server_thread([&]() {
+    net::EventLoop loop(net::Poller::PollerType::kEpollPoller);
+    net::TcpServer server(&loop, net::InetAddress(0, true), "EchoBench", false, accept_mode);
+    server.SetThreadNum(io_threads);
+    server.SetConnectionCallback([](const net::TcpConnectionPtr& conn) {
+      if (conn->Connected()) {
+        conn->SetTcpNoDelay(true);
+      }
+    });
+    server.SetMessageCallback([](const net::TcpConnectionPtr& conn, net::Buffer* buffer, util::time::Timestamp) {
+      conn->Send(buffer);
+    });
+    server.Start();
+    started.set_value(std::make_pair(&loop, server.listen_addr()));
+    loop.Loop();
+  });
+  std::pair<net::EventLoop*, net::InetAddress> server = started.get_future().get();
+  net::EventLoop* server_loop = server.first;
+  const net::InetAddress addr = server.second;
+  const std::string message(kMessageSize, 'x');
+
+  printf("[Echo Bench] io_threads=%d client_threads=%d seconds=%.1f message_size=%zu accept_mode=%s\n", io_threads,
+         client_threads, seconds, kMessageSize, mode.c_str());
+
+  uint64_t conns = RunClients(client_threads, seconds, [&]() -> uint64_t {
+    char buf[kMessageSize];
+    int fd = Connect(addr);
+    bool ok = PingPong(fd, message, buf);
+    // 由客户端主动 RST 关闭, 避免大量 TIME_WAIT 耗尽本地端口
+    struct linger so_linger = {1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &so_linger, sizeof so_linger);
+    ::close(fd);
+    return ok ? 1 : 0;
+  });
+  printf("[Echo Bench] %-12s %12.0f conns/sec\n", "short conn", conns / seconds);
+
+  std::vector<int> fds;
+  std::atomic<int> next_fd = {0};
+  for (int i = 0; i < client_threads; ++i) {
+    fds.push_back(Connect(addr));
+  }
+  uint64_t requests = RunClients(client_threads, seconds, [&]() -> uint64_t {
+    thread_local int fd = fds[next_fd++];
+    char buf[kMessageSize];
+    return PingPong(fd, message, buf) ? 1 : 0;
+  });
+  printf("[Echo Bench] %-12s %12.0f requests/sec\n", "ping-pong", requests / seconds);
+  for (int fd : fds) {
+    ::close(fd);
+  }
+
+  server_loop->Quit();
+  server_thread.join();
+  return 0;
+}
@@ -1,20 +1,38 @@
 #include "net/event_loop.h"
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <thread>
+#include <utility>
 
 #include "logger/log.h"
 #include "net/channel.h"
-#include "net/poller/epoll_poller.h"
-#include "net/poller/poll_poller.h"
 
 namespace net {
 
 namespace {
 thread_local EventLoop* t_ThisThreadEventLoop = nullptr;
+
+int CreateEventFd() {
+  int event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd < 0) {
+    LOG_FATAL << "eventfd fail with error [" << ::strerror(errno) << "]";
+  }
+  return event_fd;
 }
 
-EventLoop::EventLoop(const Poller::PollerType poller_type) : thread_id_(std::this_thread::get_id()) {
+}  // namespace
+
+EventLoop::EventLoop(const Poller::PollerType poller_type, const TimerQueue::Type timer_queue_type,
+                     const uint64_t timer_tick_ms)
+    : thread_id_(std::this_thread::get_id()),
+      poller_type_(poller_type),
+      wakeup_fd_(CreateEventFd()),
+      wakeup_channel_(std::make_unique<Channel>(this, wakeup_fd_)) {
   LOG_INFO << "create EventLoop [" << this << "] in thread [" << std::this_thread::get_id();
   if (t_ThisThreadEventLoop != nullptr) {
     // 如果当前线程已经有一个正在工作的 EventLoop, 直接抛出异常退出
@@ -24,25 +42,34 @@ EventLoop::EventLoop(const Poller::PollerType poller_type) : thread_id_(std::thi
     t_ThisThreadEventLoop = this;
   }
 
-  switch (poller_type) {
-    case Poller::PollerType::kPollPoller: {
-      poller_ = std::make_unique<PollPoller>(this);
-    }
-    case Poller::PollerType::kEpollPoller: {
-      poller_ = std::make_unique<EpollPoller>(this);
-    }
-    default: {
-      CHECK(false) << "unsupported poller type: [" << static_cast<int>(poller_type) << "]";
-    }
-  }
+  poller_ = Poller::NewPoller(poller_type, this);
+  timer_queue_ = std::make_unique<TimerQueue>(this, timer_queue_type, timer_tick_ms);
+
+  // 所有跨线程投递的任务都通过 wakeup_fd_ 唤醒 IO 线程
+  wakeup_channel_->SetReadCallback(std::bind(&EventLoop::HandleWakeup, this));
+  wakeup_channel_->EnableReading();
 }
 
 EventLoop::~EventLoop() {
   LOG_INFO << "EventLoop [" << this << "] of thread [" << thread_id_ << "] destructs in thread ["
            << std::this_thread::get_id() << "]";
+  // TimerQueue 析构时需要从 poller_ 中移除 timerfd 对应的 Channel
+  timer_queue_.reset();
+  wakeup_channel_->DisableAll();
+  wakeup_channel_->Remove();
+  ::close(wakeup_fd_);
+  // 丢弃尚未执行的任务
+  while (pending_functors_.Drain(SIZE_MAX, std::default_delete<PendingFunctor>()) > 0) {
+  }
   t_ThisThreadEventLoop = nullptr;
 }
 
+/**
+ * @brief 事件循环的主体, 每一轮循环:
+ *   1. 阻塞在 Poller::Poll 上直到有 IO 事件 / 被唤醒 / 超时
+ *   2. 依次调用活跃 Channel 的 HandleEvent 分发 IO 事件
+ *   3. 执行其他线程通过 QueueInLoop 投递过来的任务
+ */
 void EventLoop::Loop() {
   CHECK(!looping_);
   AssertInLoopThread();
@@ -50,22 +77,50 @@ void EventLoop::Loop() {
   quit_ = false;
   LOG_INFO << "EventLoop [" << this << "] start looping";
 
+  std::vector<std::pair<Channel*, int>> deferred_channels;
   while (!quit_) {
+    active_channels_.clear();
+    // 有推迟分发的 Channel 时不能阻塞, 只收集已经就绪的事件
+    poll_return_time_ = poller_->Poll(deferred_channels_.empty() ? kPollTimeMs : 0, &active_channels_);
+    poll_return_monotonic_time_ = util::time::TimestampMonotonicNanoSec();
+    ++iteration_;
+    if (!deferred_channels_.empty()) {
+      deferred_channels.swap(deferred_channels_);
+      MergeDeferredChannels(deferred_channels);
+      deferred_channels.clear();
+    }
+
+    event_handling_ = true;
+    for (Channel* channel : active_channels_) {
+      current_active_channel_ = channel;
+      current_active_channel_->HandleEvent(poll_return_time_);
+    }
+    current_active_channel_ = nullptr;
+    event_handling_ = false;
+
+    DoPendingFunctors();
   }
+
+  LOG_INFO << "EventLoop [" << this << "] stop looping";
+  looping_ = false;
 }
 
 void EventLoop::Quit() {
   quit_ = true;
+  // 如果在其他线程调用 Quit, IO 线程可能正阻塞在 Poll 中, 需要唤醒它
+  if (!IsInLoopThread()) {
+    Wakeup();
+  }
 }
+
 bool EventLoop::IsInLoopThread() const {
   return thread_id_ == std::this_thread::get_id();
 }
 
 bool EventLoop::HasChannel(const Channel* const channel) {
-  (void)channel;
-  // CHECK()
-  // FIXME:
-  return true;
+  CHECK(channel->OwnerLoop() == this);
+  AssertInLoopThread();
+  return poller_->HasChannel(channel);
 }
 
 void EventLoop::UpdateChannel(Channel* const channel) {
@@ -74,6 +129,22 @@ void EventLoop::UpdateChannel(Channel* const channel) {
   poller_->UpdateChannel(channel);
 }
 
+void EventLoop::RemoveChannel(Channel* const channel) {
+  CHECK(channel->OwnerLoop() == this);
+  AssertInLoopThread();
+  deferred_channels_.erase(std::remove_if(deferred_channels_.begin(), deferred_channels_.end(),
+                                          [channel](const std::pair<Channel*, int>& deferred) {
+                                            return deferred.first == channel;
+                                          }),
+                           deferred_channels_.end());
+  if (event_handling_) {
+    // 只允许在 HandleEvent 中移除自己, 或者移除本轮不活跃的 Channel
+    CHECK(current_active_channel_ == channel ||
+          std::find(active_channels_.begin(), active_channels_.end(), channel) == active_channels_.end());
+  }
+  poller_->RemoveChannel(channel);
+}
+
 void EventLoop::AssertInLoopThread() const {
   if (!IsInLoopThread()) {
     LOG_FATAL << "EventLoop [" << this << "] was created in [" << thread_id_ << "] but now is running in ["
@@ -81,12 +152,133 @@ void EventLoop::AssertInLoopThread() const {
   }
 }
 
+void EventLoop::RunInLoop(Functor cb) {
+  if (IsInLoopThread()) {
+    cb();
+  } else {
+    QueueInLoop(std::move(cb));
+  }
+}
+
+void EventLoop::QueueInLoop(Functor cb) {
+  bool was_empty = pending_functors_.Push(new PendingFunctor(std::move(cb)));
+
+  // 只有队列由空变为非空时才需要唤醒 IO 线程, 队列非空时说明已经有人唤醒过或者 IO 线程会在 DoPendingFunctors
+  // 结束时自己唤醒自己; IO 线程自己投递的任务会在本轮循环末尾执行, 同样无需唤醒
+  if (was_empty && !IsInLoopThread()) {
+    Wakeup();
+  }
+}
+
+size_t EventLoop::QueueSize() const {
+  return pending_functors_.Size();
+}
+
+TimerId EventLoop::RunAt(util::time::Timestamp time, TimerCallback cb, const double slack_seconds) {
+  return timer_queue_->AddTimer(std::move(cb), time, 0.0, slack_seconds);
+}
+
+TimerId EventLoop::RunAfter(const double delay_seconds, TimerCallback cb, const double slack_seconds) {
+  util::time::Timestamp time = util::time::SecondsLater(util::time::TimestampNanoSec(), delay_seconds);
+  return RunAt(time, std::move(cb), slack_seconds);
+}
+
+TimerId EventLoop::RunEvery(const double interval_seconds, TimerCallback cb, const double slack_seconds) {
+  util::time::Timestamp time = util::time::SecondsLater(util::time::TimestampNanoSec(), interval_seconds);
+  return timer_queue_->AddTimer(std::move(cb), time, interval_seconds, slack_seconds);
+}
+
+void EventLoop::Cancel(const TimerId& timer_id) {
+  timer_queue_->Cancel(timer_id);
+}
+
+void EventLoop::Wakeup() {
+  uint64_t one = 1;
+  ssize_t n = ::write(wakeup_fd_, &one, sizeof one);
+  if (n != sizeof one) {
+    LOG_ERROR << "EventLoop::Wakeup() writes " << n << " bytes instead of 8";
+  }
+}
+
+void EventLoop::DeferChannel(Channel* const channel) {
+  CHECK(channel->OwnerLoop() == this);
+  AssertInLoopThread();
+  deferred_channels_.emplace_back(channel, channel->revents());
+}
+
+/**
+ * @brief 将上一轮推迟的 Channel 加入本轮的活跃列表, 如果本轮 Poll 也返回了这个 Channel 则合并 revents
+ */
+void EventLoop::MergeDeferredChannels(const std::vector<std::pair<Channel*, int>>& deferred_channels) {
+  for (const auto& [channel, revents] : deferred_channels) {
+    auto iter = std::find(active_channels_.begin(), active_channels_.end(), channel);
+    if (iter == active_channels_.end()) {
+      channel->set_revents(revents);
+      active_channels_.push_back(channel);
+    } else {
+      channel->set_revents(channel->revents() | revents);
+    }
+  }
+}
+
+void EventLoop::HandleWakeup() {
+  uint64_t one = 1;
+  ssize_t n = ::read(wakeup_fd_, &one, sizeof one);
+  if (n != sizeof one) {
+    LOG_ERROR << "EventLoop::HandleWakeup() reads " << n << " bytes instead of 8";
+  }
+}
+
+/**
+ * @brief 执行其他线程投递过来的任务
+ *
+ * @note
+ *   1. 每轮最多执行进入函数时队列中的任务数, 避免任务内部不断调用 QueueInLoop 导致 IO 线程饿死
+ *   2. 执行期间入队的任务不会触发 Wakeup (队列非空), 因此结束时如果还有剩余任务需要自己唤醒自己,
+ *      保证下一轮 Poll 立即返回
+ */
+void EventLoop::DoPendingFunctors() {
+  size_t batch_size = pending_functors_.Size();
+  if (batch_size == 0) {
+    return;
+  }
+
+  size_t remaining = pending_functors_.Drain(batch_size, [](PendingFunctor* node) {
+    std::unique_ptr<PendingFunctor> guard(node);
+    guard->functor();
+  });
+  if (remaining > 0) {
+    Wakeup();
+  }
+}
+
 util::time::Timestamp EventLoop::poll_return_time() const {
   return poll_return_time_;
 }
 
+util::time::Timestamp EventLoop::poll_return_monotonic_time() const {
+  return poll_return_monotonic_time_;
+}
+
 int64_t EventLoop::iteration() const {
   return iteration_;
 }
 
+Poller::PollerType EventLoop::poller_type() const {
+  return poller_type_;
+}
+
+const TimerQueue::Stats& EventLoop::timer_stats() const {
+  AssertInLoopThread();
+  return timer_queue_->stats();
+}
+
+size_t EventLoop::io_budget_bytes() const {
+  return io_budget_bytes_;
+}
+
+void EventLoop::set_io_budget_bytes(const size_t io_budget_bytes) {
+  io_budget_bytes_ = io_budget_bytes;
+}
+
 }  // namespace net
@@ -4,10 +4,15 @@
 #include <functional>
 #include <memory>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include "net/callbacks.h"
 #include "net/poller.h"
+#include "net/timer_id.hpp"
+#include "net/timer_queue.h"
 #include "util/macros/macros.h"
+#include "util/sync/mpsc_queue.hpp"
 #include "util/time/timestamp.hpp"
 
 namespace net {
@@ -21,7 +26,14 @@ class Channel;
  */
 class EventLoop final {
  public:
-  EventLoop(const Poller::PollerType poller_type);
+  /**
+   * @param poller_type IO 多路复用的实现
+   * @param timer_queue_type 定时器的组织方式, 见 TimerQueue::Type
+   * @param timer_tick_ms 时间轮的 tick 大小, 只在 timer_queue_type 为 kTimingWheel 时生效
+   */
+  EventLoop(const Poller::PollerType poller_type,
+            const TimerQueue::Type timer_queue_type = TimerQueue::Type::kPrecise,
+            const uint64_t timer_tick_ms = TimerQueue::kDefaultTickMs);
   ~EventLoop();
 
  public:
@@ -39,36 +51,103 @@ class EventLoop final {
   // 判断是否持有某个 Channel
   bool HasChannel(const Channel* const channel);
   // 移除 Channel
-  void RemoveChannel(const Channel* const channel);
+  void RemoveChannel(Channel* const channel);
   // 更新 Channel
   void UpdateChannel(Channel* const channel);
 
   // 断言当前线程就是 EventLoop 所在的 IO 线程
   void AssertInLoopThread() const;
 
+  // 在 IO 线程中执行 cb, 如果当前就是 IO 线程则立即执行, 否则放入队列并唤醒 IO 线程
   void RunInLoop(Functor cb);
+  // 将 cb 放入队列, 在本轮 IO 事件处理完之后执行, 可以跨线程调用且不会加锁
   void QueueInLoop(Functor cb);
+  // 唤醒阻塞在 Poller::Poll 中的 IO 线程
+  void Wakeup();
+
+  /**
+   * @brief 让 channel 在下一轮循环中以相同的 revents 再次被分发
+   *
+   * @note 边缘触发的 Channel 在用完 io_budget_bytes 之后还没有读写到 EAGAIN 时调用, 内核不会再次通知这个 fd,
+   *       由 EventLoop 负责在下一轮循环中继续分发, 期间 Poll 不会阻塞, 其他 fd 的事件也能及时得到处理
+   */
+  void DeferChannel(Channel* const channel);
 
   size_t QueueSize() const;
 
+  // 在 time 时刻执行 cb, 可以跨线程调用; slack_seconds 大于 0 时允许推迟执行以便和其他定时器合并
+  TimerId RunAt(util::time::Timestamp time, TimerCallback cb, const double slack_seconds = 0.0);
+  // 在 delay_seconds 秒之后执行 cb, 可以跨线程调用
+  TimerId RunAfter(const double delay_seconds, TimerCallback cb, const double slack_seconds = 0.0);
+  // 每隔 interval_seconds 秒执行一次 cb, 可以跨线程调用
+  TimerId RunEvery(const double interval_seconds, TimerCallback cb, const double slack_seconds = 0.0);
+  // 取消定时任务, 可以跨线程调用
+  void Cancel(const TimerId& timer_id);
+
  public:
-  // Poll 返回数据的时间
+  /**
+   * @brief 本轮 Poll 返回的时间, 每轮循环只读取一次时钟, IO 回调和定时器回调应该优先使用它而不是重新读取时钟
+   * @note 在同一轮循环中越靠后的回调看到的时间越旧, 需要精确时间的场景 (例如计算超时的起点) 仍然应该读取时钟
+   */
   util::time::Timestamp poll_return_time() const;
+  // 本轮 Poll 返回时的单调时钟时间, 用于计算耗时和超时, 不受系统时间调整的影响
+  util::time::Timestamp poll_return_monotonic_time() const;
   int64_t iteration() const;
+  Poller::PollerType poller_type() const;
+  // 定时器合并的统计信息, 只能在 IO 线程调用
+  const TimerQueue::Stats& timer_stats() const;
+  // 单个 Channel 每次被分发时最多读写的字节数
+  size_t io_budget_bytes() const;
+  void set_io_budget_bytes(const size_t io_budget_bytes);
+
+ private:
+  // 处理 wakeup_fd_ 上的可读事件
+  void HandleWakeup();
+  // 执行 pending_functors_ 中的任务
+  void DoPendingFunctors();
+  void MergeDeferredChannels(const std::vector<std::pair<Channel*, int>>& deferred_channels);
 
  private:
   // 创建当前 EventLoop 的线程 ID (即 IO 线程), 但是可能被其他线程持有这个 EventLoop
   const std::thread::id thread_id_;
+  const Poller::PollerType poller_type_;
   // 是否处于 Loop 循环中
   bool looping_ = false;
   // 是否停止
   std::atomic<bool> quit_ = false;
 
   util::time::Timestamp poll_return_time_ = 0;
+  util::time::Timestamp poll_return_monotonic_time_ = 0;
   int64_t iteration_ = 0;
 
   std::unique_ptr<Poller> poller_;
-  std::vector<Channel> channel_list_;
+  std::unique_ptr<TimerQueue> timer_queue_;
+
+  // 用于跨线程唤醒 IO 线程的 eventfd 及其对应的 Channel
+  int wakeup_fd_ = -1;
+  std::unique_ptr<Channel> wakeup_channel_;
+
+  // 本轮 Poll 返回的活跃 Channel 列表, 复用以避免每轮循环分配内存
+  Poller::ChannelList active_channels_;
+  Channel* current_active_channel_ = nullptr;
+  bool event_handling_ = false;
+
+  // 通过 DeferChannel 推迟到下一轮循环分发的 Channel 及其 revents
+  std::vector<std::pair<Channel*, int>> deferred_channels_;
+  size_t io_budget_bytes_ = kDefaultIoBudgetBytes;
+
+  // 其他线程通过 QueueInLoop 投递过来的任务
+  struct PendingFunctor : public util::sync::MpscQueueNode {
+    explicit PendingFunctor(Functor&& cb) : functor(std::move(cb)) {
+    }
+    Functor functor;
+  };
+  util::sync::MpscQueue<PendingFunctor> pending_functors_;
+
+ private:
+  // Poll 的超时时间, 没有任何事件时 IO 线程最多阻塞这么久
+  static constexpr int kPollTimeMs = 10000;
+  static constexpr size_t kDefaultIoBudgetBytes = 256 * 1024;
 
  private:
   // 禁止拷贝
@@ -0,0 +1,103 @@
+#include "net/event_loop.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "logger/log.h"
+
+namespace net {
+
+namespace {
+
+/**
+ * @brief 在新线程中创建 EventLoop 并运行, 返回前保证 EventLoop 已经创建完成
+ */
+class LoopThread {
+ public:
+  explicit LoopThread(const Poller::PollerType poller_type) {
+    std::promise<EventLoop*> promise;
+    std::future<EventLoop*> future = promise.get_future();
+    thread_ = std::thread([&promise, poller_type]() {
+      EventLoop loop(poller_type);
+      promise.set_value(&loop);
+      loop.Loop();
+    });
+    loop_ = future.get();
+  }
+
+  ~LoopThread() {
+    loop_->Quit();
+    thread_.join();
+  }
+
+  EventLoop* loop() const {
+    return loop_;
+  }
+
+ private:
+  EventLoop* loop_ = nullptr;
+  std::thread thread_;
+};
+
+}  // namespace
+
+TEST(EventLoopTest, run_in_loop_in_io_thread) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  bool called = false;
+  loop.RunInLoop([&called]() {
+    called = true;
+  });
+  // 在 IO 线程中调用 RunInLoop 会立即执行
+  EXPECT_TRUE(called);
+  EXPECT_EQ(loop.QueueSize(), 0UL);
+}
+
+TEST(EventLoopTest, queue_in_loop_cross_thread) {
+  for (auto poller_type : {Poller::PollerType::kPollPoller, Poller::PollerType::kEpollPoller,
+                           Poller::PollerType::kIoUringPoller}) {
+    LoopThread loop_thread(poller_type);
+    std::promise<std::thread::id> promise;
+    loop_thread.loop()->QueueInLoop([&promise]() {
+      promise.set_value(std::this_thread::get_id());
+    });
+
+    // Poll 的超时时间远大于这里的等待时间, 能及时执行说明 eventfd 唤醒生效
+    std::future<std::thread::id> future = promise.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    EXPECT_NE(future.get(), std::this_thread::get_id());
+  }
+}
+
+TEST(EventLoopTest, idle_loop_does_not_spin) {
+  LoopThread loop_thread(Poller::PollerType::kEpollPoller);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  std::promise<int64_t> promise;
+  loop_thread.loop()->RunInLoop([&promise, &loop_thread]() {
+    promise.set_value(loop_thread.loop()->iteration());
+  });
+  // 空闲时 IO 线程阻塞在 Poll 中, 只有被唤醒时才会进入新一轮循环
+  EXPECT_LE(promise.get_future().get(), 2);
+}
+
+TEST(EventLoopTest, quit_from_other_thread) {
+  std::atomic<bool> exited = {false};
+  std::promise<EventLoop*> promise;
+  std::thread thread([&promise, &exited]() {
+    EventLoop loop(Poller::PollerType::kEpollPoller);
+    promise.set_value(&loop);
+    loop.Loop();
+    exited = true;
+  });
+
+  EventLoop* loop = promise.get_future().get();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  loop->Quit();
+  thread.join();
+  EXPECT_TRUE(exited);
+}
+
+}  // namespace net
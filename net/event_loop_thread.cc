@@ -0,0 +1,53 @@
+#include "net/event_loop_thread.h"
+
+#include "logger/log.h"
+#include "net/event_loop.h"
+
+namespace net {
+
+EventLoopThread::EventLoopThread(const Poller::PollerType poller_type, const ThreadInitCallback& cb,
+                                 const std::string& name)
+    : poller_type_(poller_type), name_(name), init_callback_(cb) {
+}
+
+EventLoopThread::~EventLoopThread() {
+  if (thread_.joinable()) {
+    // Quit 也通过任务队列投递, 保证在它之前投递的任务 (例如销毁连接) 都能被执行
+    EventLoop* loop = loop_;
+    loop->QueueInLoop([loop]() {
+      loop->Quit();
+    });
+    thread_.join();
+  }
+}
+
+EventLoop* EventLoopThread::StartLoop() {
+  CHECK(!thread_.joinable());
+  thread_ = std::thread(&EventLoopThread::ThreadFunc, this);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() {
+    return loop_ != nullptr;
+  });
+  return loop_;
+}
+
+void EventLoopThread::ThreadFunc() {
+  EventLoop loop(poller_type_);
+  if (init_callback_) {
+    init_callback_(&loop);
+  }
+  // 在第一轮循环中才通知 StartLoop 返回, 保证之后调用 Quit 不会被 Loop 开头的状态重置覆盖
+  loop.QueueInLoop([this, &loop]() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loop_ = &loop;
+    cond_.notify_one();
+  });
+  // IO 线程自己投递任务时不会唤醒, 这里主动唤醒以免第一轮 Poll 阻塞
+  loop.Wakeup();
+  LOG_INFO << "EventLoopThread [" << name_ << "] start";
+  loop.Loop();
+  LOG_INFO << "EventLoopThread [" << name_ << "] exit";
+}
+
+}  // namespace net
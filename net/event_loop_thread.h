@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "net/poller.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class EventLoop;
+
+/**
+ * @brief 在一个新线程中创建并运行 EventLoop, 即一个 IO 线程
+ *
+ * @note EventLoop 对象在新线程的栈上创建, 生命周期和线程一致; 析构时会让 EventLoop 执行完已经投递的任务之后退出,
+ *       并等待线程结束
+ */
+class EventLoopThread final {
+ public:
+  using ThreadInitCallback = std::function<void(EventLoop*)>;
+
+ public:
+  EventLoopThread(const Poller::PollerType poller_type, const ThreadInitCallback& cb = ThreadInitCallback(),
+                  const std::string& name = std::string());
+  ~EventLoopThread();
+
+ public:
+  // 启动线程, 阻塞直到新线程中的 EventLoop 开始循环, 返回该 EventLoop
+  EventLoop* StartLoop();
+
+ private:
+  void ThreadFunc();
+
+ private:
+  const Poller::PollerType poller_type_;
+  const std::string name_;
+  ThreadInitCallback init_callback_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  EventLoop* loop_ = nullptr;
+  std::thread thread_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(EventLoopThread);
+};
+
+}  // namespace net
@@ -0,0 +1,63 @@
+#include "net/event_loop_thread_pool.h"
+
+#include "logger/log.h"
+#include "net/event_loop.h"
+
+namespace net {
+
+EventLoopThreadPool::EventLoopThreadPool(EventLoop* base_loop, const std::string& name)
+    : base_loop_(base_loop), name_(name) {
+}
+
+EventLoopThreadPool::~EventLoopThreadPool() = default;
+
+void EventLoopThreadPool::SetThreadNum(const int num_threads) {
+  CHECK(!started_);
+  CHECK_GE(num_threads, 0);
+  num_threads_ = num_threads;
+}
+
+void EventLoopThreadPool::Start(const EventLoopThread::ThreadInitCallback& cb) {
+  CHECK(!started_);
+  base_loop_->AssertInLoopThread();
+  started_ = true;
+
+  for (int i = 0; i < num_threads_; ++i) {
+    std::string name = name_ + "#" + std::to_string(i);
+    threads_.push_back(std::make_unique<EventLoopThread>(base_loop_->poller_type(), cb, name));
+    loops_.push_back(threads_.back()->StartLoop());
+  }
+  if (num_threads_ == 0 && cb) {
+    cb(base_loop_);
+  }
+}
+
+EventLoop* EventLoopThreadPool::GetNextLoop() {
+  base_loop_->AssertInLoopThread();
+  CHECK(started_);
+  if (loops_.empty()) {
+    return base_loop_;
+  }
+  EventLoop* loop = loops_[next_];
+  next_ = (next_ + 1) % loops_.size();
+  return loop;
+}
+
+std::vector<EventLoop*> EventLoopThreadPool::GetAllLoops() const {
+  base_loop_->AssertInLoopThread();
+  CHECK(started_);
+  if (loops_.empty()) {
+    return std::vector<EventLoop*>(1, base_loop_);
+  }
+  return loops_;
+}
+
+bool EventLoopThreadPool::started() const {
+  return started_;
+}
+
+const std::string& EventLoopThreadPool::name() const {
+  return name_;
+}
+
+}  // namespace net
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/event_loop_thread.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class EventLoop;
+
+/**
+ * @brief IO 线程池, 每个线程运行一个 EventLoop (one loop per thread)
+ *
+ * @note
+ *   1. 线程数为 0 时所有连接都由 base_loop 处理
+ *   2. Start / GetNextLoop / GetAllLoops 只能在 base_loop 所在的线程调用
+ */
+class EventLoopThreadPool final {
+ public:
+  EventLoopThreadPool(EventLoop* base_loop, const std::string& name);
+  ~EventLoopThreadPool();
+
+ public:
+  void SetThreadNum(const int num_threads);
+  void Start(const EventLoopThread::ThreadInitCallback& cb = EventLoopThread::ThreadInitCallback());
+  // 轮询选择下一个 IO 线程的 EventLoop
+  EventLoop* GetNextLoop();
+  std::vector<EventLoop*> GetAllLoops() const;
+
+ public:
+  bool started() const;
+  const std::string& name() const;
+
+ private:
+  EventLoop* base_loop_;
+  const std::string name_;
+  bool started_ = false;
+  int num_threads_ = 0;
+  size_t next_ = 0;
+  std::vector<std::unique_ptr<EventLoopThread>> threads_;
+  std::vector<EventLoop*> loops_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(EventLoopThreadPool);
+};
+
+}  // namespace net
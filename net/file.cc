@@ -0,0 +1,51 @@
+#include "net/file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "logger/log.h"
+
+namespace net {
+
+File::File(const int fd, const size_t size) : fd_(fd), size_(size) {
+}
+
+File::~File() {
+  if (::close(fd_) < 0) {
+    LOG_ERROR << "close fd [" << fd_ << "] fail with error [" << ::strerror(errno) << "]";
+  }
+}
+
+std::shared_ptr<File> File::Open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  int saved_errno = 0;
+  if (::fstat(fd, &st) < 0) {
+    saved_errno = errno;
+  } else if (!S_ISREG(st.st_mode)) {
+    saved_errno = S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+  }
+  if (saved_errno != 0) {
+    ::close(fd);
+    errno = saved_errno;
+    return nullptr;
+  }
+  return std::make_shared<File>(fd, static_cast<size_t>(st.st_size));
+}
+
+int File::fd() const {
+  return fd_;
+}
+
+size_t File::size() const {
+  return size_;
+}
+
+}  // namespace net
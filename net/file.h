@@ -0,0 +1,44 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "util/macros/macros.h"
+
+namespace net {
+
+/**
+ * @brief 只读打开的文件, 析构时关闭 fd
+ *
+ * @note 通过 shared_ptr 放入 TcpConnection 的输出队列, 保证 sendfile 完成之前 fd 不会被关闭; 多个连接可以共享同一个
+ *       File, 它们各自维护发送的偏移量, 不使用也不修改 fd 的文件偏移
+ */
+class File final {
+ public:
+  File(const int fd, const size_t size);
+  ~File();
+
+ public:
+  /**
+   * @brief 以 O_RDONLY | O_CLOEXEC 打开普通文件
+   * @return std::shared_ptr<File> 失败 (包括 path 不是普通文件) 时返回 nullptr 并保留 errno
+   */
+  static std::shared_ptr<File> Open(const std::string& path);
+
+ public:
+  int fd() const;
+  // 打开时的文件大小
+  size_t size() const;
+
+ private:
+  const int fd_;
+  const size_t size_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(File);
+};
+
+}  // namespace net
@@ -0,0 +1,138 @@
+#include "net/http/broadcast_hub.h"
+
+#include <utility>
+
+#include "logger/log.h"
+#include "net/event_loop.h"
+
+namespace net {
+
+BroadcastHub::BroadcastHub() = default;
+
+BroadcastHub::~BroadcastHub() = default;
+
+BroadcastHub::SubscriptionId BroadcastHub::Subscribe(const std::string& topic, EventLoop* const loop,
+                                                     DeliverCallback deliver) {
+  CHECK(loop != nullptr);
+  CHECK(deliver != nullptr);
+  SubscriptionId id = 0;
+  ShardPtr shard;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = next_id_++;
+    ShardPtr& slot = shards_[loop];
+    if (slot == nullptr) {
+      slot = std::make_shared<Shard>(loop);
+    }
+    shard = slot;
+    Topic& entry = topics_[topic];
+    if (entry.counts[shard.get()]++ == 0) {
+      RebuildShardsLocked(&entry);
+    }
+    ++entry.subscriber_num;
+    subscriptions_.emplace(id, Subscription{topic, shard});
+    // 在锁内投递, 保证排在之后 Publish 的消息之前
+    loop->QueueInLoop([shard, topic, id, deliver = std::move(deliver)]() mutable {
+      shard->topics[topic].emplace(id, std::move(deliver));
+    });
+  }
+  return id;
+}
+
+BroadcastHub::SubscriptionId BroadcastHub::Subscribe(const std::string& topic, const WebSocketConnectionPtr& ws) {
+  EventLoop* loop = ws->GetLoop();
+  CHECK(loop != nullptr) << "WebSocket connection is not attached";
+  std::weak_ptr<WebSocketConnection> weak_ws = ws;
+  return Subscribe(topic, loop, [weak_ws](const std::shared_ptr<const std::string>& frame) {
+    WebSocketConnectionPtr conn = weak_ws.lock();
+    if (conn != nullptr) {
+      conn->SendFrame(frame);
+    }
+  });
+}
+
+void BroadcastHub::Unsubscribe(const SubscriptionId id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = subscriptions_.find(id);
+  if (it == subscriptions_.end()) {
+    return;
+  }
+  std::string topic = std::move(it->second.topic);
+  ShardPtr shard = std::move(it->second.shard);
+  subscriptions_.erase(it);
+
+  auto topic_it = topics_.find(topic);
+  CHECK(topic_it != topics_.end());
+  Topic& entry = topic_it->second;
+  auto count_it = entry.counts.find(shard.get());
+  CHECK(count_it != entry.counts.end());
+  if (--count_it->second == 0) {
+    entry.counts.erase(count_it);
+    RebuildShardsLocked(&entry);
+  }
+  if (--entry.subscriber_num == 0) {
+    topics_.erase(topic_it);
+  }
+  EventLoop* loop = shard->loop;
+  loop->QueueInLoop([shard = std::move(shard), topic = std::move(topic), id]() {
+    auto subscribers = shard->topics.find(topic);
+    if (subscribers == shard->topics.end()) {
+      return;
+    }
+    subscribers->second.erase(id);
+    if (subscribers->second.empty()) {
+      shard->topics.erase(subscribers);
+    }
+  });
+}
+
+size_t BroadcastHub::Publish(const std::string& topic, std::shared_ptr<const std::string> message) {
+  std::shared_ptr<const ShardList> shards;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = topics_.find(topic);
+    if (it == topics_.end()) {
+      return 0;
+    }
+    shards = it->second.shards;
+    // 和 Subscribe / Unsubscribe 一样在锁内投递, 每个 EventLoop 中订阅关系的修改和消息的顺序一致
+    for (const ShardPtr& shard : *shards) {
+      shard->loop->QueueInLoop([shard, topic, message]() {
+        auto subscribers = shard->topics.find(topic);
+        if (subscribers == shard->topics.end()) {
+          return;
+        }
+        // 修改订阅关系的任务都通过 QueueInLoop 执行, 回调中 Subscribe / Unsubscribe 不会使迭代器失效
+        for (const auto& [id, deliver] : subscribers->second) {
+          deliver(message);
+        }
+      });
+    }
+  }
+  return shards->size();
+}
+
+size_t BroadcastHub::PublishWebSocket(const std::string& topic, const WebSocketOpcode opcode,
+                                      std::string_view payload) {
+  if (subscriber_num(topic) == 0) {
+    return 0;
+  }
+  return Publish(topic, EncodeWebSocketFrame(opcode, payload));
+}
+
+size_t BroadcastHub::subscriber_num(const std::string& topic) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = topics_.find(topic);
+  return it == topics_.end() ? 0 : it->second.subscriber_num;
+}
+
+void BroadcastHub::RebuildShardsLocked(Topic* const topic) {
+  std::shared_ptr<ShardList> shards = std::make_shared<ShardList>();
+  shards->reserve(topic->counts.size());
+  for (const auto& [shard, count] : topic->counts) {
+    shards->push_back(shards_.at(shard->loop));
+  }
+  topic->shards = std::move(shards);
+}
+
+}  // namespace net
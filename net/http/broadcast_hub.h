@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "net/http/websocket_codec.h"
+#include "net/http/websocket_connection.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class EventLoop;
+
+/**
+ * @brief 按主题的发布/订阅, 把一条消息广播给分布在多个 IO 线程中的大量订阅者 (例如 WebSocket 或者 SSE 连接)
+ *
+ * @note
+ *   1. 订阅者按所属的 EventLoop 分组, 每个 EventLoop 一个分片, 分片中的订阅者列表只在它的 IO 线程中访问;
+ *      Publish 只在锁内取出主题涉及的分片列表, 然后每个 EventLoop 调用一次 QueueInLoop,
+ *      由 IO 线程把同一份消息交给本线程的所有订阅者. 跨线程的任务数是 O(EventLoop) 而不是 O(订阅者)
+ *   2. 消息是不可变的共享内存, 所有订阅者共享同一份, WebSocket 订阅者直接交给 TcpConnection 的输出队列, 不经过拷贝;
+ *      PublishWebSocket 只编码一次帧
+ *   3. Subscribe / Unsubscribe / Publish 可以在任何线程中调用. 订阅关系的修改和消息一样通过 QueueInLoop 生效,
+ *      同一个线程中先 Subscribe 再 Publish 的消息一定会收到; Unsubscribe 返回时已经投递的消息仍然可能被回调一次,
+ *      回调中不要持有可能已经析构的对象的裸指针
+ *   4. 连接断开时不会自动退订, 在 WebSocketConnection 的 CloseCallback 中调用 Unsubscribe;
+ *      慢消费者由 WebSocketOptions::max_queued_bytes 限制, 不会拖慢同一个 IO 线程中的其他订阅者
+ *   5. BroadcastHub 可以先于 EventLoop 析构, 已经投递的任务持有分片的引用
+ *
+ * @example
+ *   ws->SetMessageCallback([&hub](const WebSocketConnectionPtr& conn, std::string_view topic, bool) {
+ *     BroadcastHub::SubscriptionId id = hub.Subscribe(std::string(topic), conn);
+ *     conn->SetCloseCallback([&hub, id](const WebSocketConnectionPtr&, uint16_t) { hub.Unsubscribe(id); });
+ *   });
+ *   hub.PublishWebSocket("news", WebSocketOpcode::kText, "hello");  // 任意线程
+ */
+class BroadcastHub final {
+ public:
+  using SubscriptionId = uint64_t;
+  // 在订阅者所属的 IO 线程中调用, message 是所有订阅者共享的同一份内存
+  using DeliverCallback = std::function<void(const std::shared_ptr<const std::string>& message)>;
+
+ public:
+  BroadcastHub();
+  ~BroadcastHub();
+
+ public:
+  // deliver 在 loop 中执行
+  SubscriptionId Subscribe(const std::string& topic, EventLoop* const loop, DeliverCallback deliver);
+  // WebSocket 订阅者, 收到的消息应该是编码好的帧; ws 必须已经绑定到连接 (在它的回调中调用)
+  SubscriptionId Subscribe(const std::string& topic, const WebSocketConnectionPtr& ws);
+  // 重复退订或者未知的 id 被忽略
+  void Unsubscribe(const SubscriptionId id);
+
+  /**
+   * @brief 把 message 投递给 topic 的所有订阅者
+   * @return size_t 投递到的 EventLoop 个数, 没有订阅者时为 0
+   */
+  size_t Publish(const std::string& topic, std::shared_ptr<const std::string> message);
+  // 编码一次 WebSocket 帧之后 Publish
+  size_t PublishWebSocket(const std::string& topic, const WebSocketOpcode opcode, std::string_view payload);
+
+  size_t subscriber_num(const std::string& topic) const;
+
+ private:
+  // 一个 EventLoop 中的订阅者
+  struct Shard {
+    explicit Shard(EventLoop* const loop) : loop(loop) {}
+
+    EventLoop* const loop;
+    // 只在 loop 线程中访问
+    std::unordered_map<std::string, std::unordered_map<SubscriptionId, DeliverCallback>> topics;
+  };
+  using ShardPtr = std::shared_ptr<Shard>;
+  using ShardList = std::vector<ShardPtr>;
+
+  struct Topic {
+    // 每个分片中的订阅者个数
+    std::unordered_map<Shard*, size_t> counts;
+    // 有订阅者的分片, 只在分片增减时重建, Publish 只需要拷贝指针
+    std::shared_ptr<const ShardList> shards;
+    size_t subscriber_num = 0;
+  };
+
+  struct Subscription {
+    std::string topic;
+    ShardPtr shard;
+  };
+
+ private:
+  // 调用者持有 mutex_
+  void RebuildShardsLocked(Topic* const topic);
+
+ private:
+  mutable std::mutex mutex_;
+  SubscriptionId next_id_ = 1;
+  std::unordered_map<EventLoop*, ShardPtr> shards_;
+  std::unordered_map<std::string, Topic> topics_;
+  std::unordered_map<SubscriptionId, Subscription> subscriptions_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BroadcastHub);
+};
+
+}  // namespace net
@@ -0,0 +1,223 @@
+#include "net/http/broadcast_hub.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/event_loop.h"
+#include "net/event_loop_thread.h"
+#include "net/http/http_response.h"
+#include "net/http/http_server.h"
+#include "net/http/http_test_util.hpp"
+#include "net/inet_address.h"
+
+namespace net {
+
+namespace {
+
+constexpr int kLoops = 3;
+
+// 启动 kLoops 个 IO 线程
+class LoopThreads {
+ public:
+  LoopThreads() {
+    for (int i = 0; i < kLoops; ++i) {
+      threads_.push_back(std::make_unique<EventLoopThread>(Poller::PollerType::kEpollPoller));
+      loops_.push_back(threads_.back()->StartLoop());
+    }
+  }
+
+  EventLoop* loop(const int i) const { return loops_[i]; }
+
+  // 等待所有 IO 线程执行完已经投递的任务
+  void Drain() const {
+    for (EventLoop* loop : loops_) {
+      std::promise<void> done;
+      loop->QueueInLoop([&done]() { done.set_value(); });
+      done.get_future().wait();
+    }
+  }
+
+ private:
+  std::vector<std::unique_ptr<EventLoopThread>> threads_;
+  std::vector<EventLoop*> loops_;
+};
+
+// 记录一个订阅者收到的消息
+struct Inbox {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<const std::string>> messages;
+  std::atomic<int> wrong_thread = {0};
+};
+
+BroadcastHub::DeliverCallback Recorder(EventLoop* const loop, Inbox* const inbox) {
+  return [loop, inbox](const std::shared_ptr<const std::string>& message) {
+    if (!loop->IsInLoopThread()) {
+      ++inbox->wrong_thread;
+    }
+    std::lock_guard<std::mutex> lock(inbox->mutex);
+    inbox->messages.push_back(message);
+  };
+}
+
+// 读取服务端的一个文本消息, 连接关闭时返回空
+std::string ReadText(const int fd) {
+  WebSocketOpcode opcode;
+  std::string payload;
+  if (!ReadFrame(fd, &opcode, &payload) || opcode != WebSocketOpcode::kText) {
+    return "";
+  }
+  return payload;
+}
+
+// 完成握手, 然后订阅 topic
+int Subscribe(const InetAddress& addr, std::string_view topic) {
+  int fd = BlockingConnect(addr);
+  if (fd < 0 || !WriteAll(fd, UpgradeRequest("/ws") + ClientFrame(WebSocketOpcode::kText, topic))) {
+    return -1;
+  }
+  EXPECT_EQ(ReadHeader(fd).substr(0, 34), "HTTP/1.1 101 Switching Protocols\r\n");
+  EXPECT_EQ(ReadText(fd), "subscribed");
+  return fd;
+}
+
+}  // namespace
+
+TEST(BroadcastHubTest, fan_out) {
+  LoopThreads threads;
+  BroadcastHub hub;
+  constexpr int kSubscribersPerLoop = 5;
+  std::vector<std::unique_ptr<Inbox>> inboxes;
+  for (int i = 0; i < kLoops; ++i) {
+    for (int j = 0; j < kSubscribersPerLoop; ++j) {
+      inboxes.push_back(std::make_unique<Inbox>());
+      hub.Subscribe("a", threads.loop(i), Recorder(threads.loop(i), inboxes.back().get()));
+    }
+  }
+  Inbox only_b;
+  hub.Subscribe("b", threads.loop(0), Recorder(threads.loop(0), &only_b));
+  EXPECT_EQ(hub.subscriber_num("a"), static_cast<size_t>(kLoops * kSubscribersPerLoop));
+  EXPECT_EQ(hub.subscriber_num("b"), 1u);
+
+  // 每个 IO 线程只投递一次
+  constexpr int kMessages = 100;
+  std::vector<std::shared_ptr<const std::string>> messages;
+  for (int i = 0; i < kMessages; ++i) {
+    messages.push_back(std::make_shared<const std::string>(std::to_string(i)));
+    EXPECT_EQ(hub.Publish("a", messages.back()), static_cast<size_t>(kLoops));
+  }
+  EXPECT_EQ(hub.Publish("b", std::make_shared<const std::string>("b")), 1u);
+  EXPECT_EQ(hub.Publish("c", std::make_shared<const std::string>("c")), 0u);
+  threads.Drain();
+
+  // 所有订阅者按顺序收到同一份内存
+  for (const std::unique_ptr<Inbox>& inbox : inboxes) {
+    EXPECT_EQ(inbox->wrong_thread, 0);
+    EXPECT_EQ(inbox->messages, messages);
+  }
+  ASSERT_EQ(only_b.messages.size(), 1u);
+  EXPECT_EQ(*only_b.messages[0], "b");
+}
+
+TEST(BroadcastHubTest, unsubscribe) {
+  LoopThreads threads;
+  BroadcastHub hub;
+  Inbox first;
+  Inbox second;
+  BroadcastHub::SubscriptionId first_id = hub.Subscribe("t", threads.loop(0), Recorder(threads.loop(0), &first));
+  BroadcastHub::SubscriptionId second_id = hub.Subscribe("t", threads.loop(1), Recorder(threads.loop(1), &second));
+  // 先 Subscribe 再 Publish 的消息一定会收到
+  EXPECT_EQ(hub.Publish("t", std::make_shared<const std::string>("1")), 2u);
+
+  hub.Unsubscribe(first_id);
+  hub.Unsubscribe(first_id);
+  hub.Unsubscribe(12345);
+  EXPECT_EQ(hub.subscriber_num("t"), 1u);
+  EXPECT_EQ(hub.Publish("t", std::make_shared<const std::string>("2")), 1u);
+  hub.Unsubscribe(second_id);
+  EXPECT_EQ(hub.subscriber_num("t"), 0u);
+  EXPECT_EQ(hub.Publish("t", std::make_shared<const std::string>("3")), 0u);
+  threads.Drain();
+  EXPECT_EQ(first.messages.size(), 1u);
+  EXPECT_EQ(second.messages.size(), 2u);
+
+  // 回调中退订自己并订阅新的主题
+  std::atomic<int> calls = {0};
+  std::promise<BroadcastHub::SubscriptionId> self_id;
+  std::shared_future<BroadcastHub::SubscriptionId> self_id_future = self_id.get_future().share();
+  Inbox other;
+  self_id.set_value(hub.Subscribe("t", threads.loop(2), [&](const std::shared_ptr<const std::string>&) {
+    ++calls;
+    hub.Unsubscribe(self_id_future.get());
+    hub.Subscribe("u", threads.loop(2), Recorder(threads.loop(2), &other));
+  }));
+  Inbox sibling;
+  hub.Subscribe("t", threads.loop(2), Recorder(threads.loop(2), &sibling));
+  EXPECT_EQ(hub.Publish("t", std::make_shared<const std::string>("4")), 1u);
+  threads.Drain();
+  EXPECT_EQ(hub.Publish("t", std::make_shared<const std::string>("5")), 1u);
+  EXPECT_EQ(hub.Publish("u", std::make_shared<const std::string>("6")), 1u);
+  threads.Drain();
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(sibling.messages.size(), 2u);
+  ASSERT_EQ(other.messages.size(), 1u);
+  EXPECT_EQ(*other.messages[0], "6");
+}
+
+TEST(BroadcastHubTest, websocket) {
+  // 在 HttpServer 之后析构, 关闭连接时的回调中还会访问
+  BroadcastHub hub;
+  HttpTestServer http("BroadcastServer", kLoops);
+  std::mutex mutex;
+  std::map<EventLoop*, int> loop_subscribers;
+  http.server()->SetHttpCallback([&](const HttpRequest& request, HttpResponse* response) {
+    WebSocketConnectionPtr ws = response->UpgradeToWebSocket(request);
+    if (ws == nullptr) {
+      return;
+    }
+    // 连接按轮转分配到 IO 线程, 每个主题的订阅者分布在所有 IO 线程中; 收到的第一个消息是要订阅的主题
+    ws->SetMessageCallback([&](const WebSocketConnectionPtr& conn, std::string_view topic, bool) {
+      BroadcastHub::SubscriptionId id = hub.Subscribe(std::string(topic), conn);
+      conn->SetCloseCallback([&hub, id](const WebSocketConnectionPtr&, uint16_t) { hub.Unsubscribe(id); });
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++loop_subscribers[conn->GetLoop()];
+      }
+      conn->SendText("subscribed");
+    });
+  });
+
+  http.Run([&](const InetAddress& addr) {
+    constexpr int kClients = 9;
+    std::vector<int> fds;
+    for (int i = 0; i < kClients; ++i) {
+      fds.push_back(Subscribe(addr, i < 6 ? "news" : "other"));
+      ASSERT_GE(fds.back(), 0);
+    }
+    EXPECT_EQ(hub.subscriber_num("news"), 6u);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      EXPECT_EQ(loop_subscribers.size(), static_cast<size_t>(kLoops));
+    }
+    EXPECT_EQ(hub.PublishWebSocket("news", WebSocketOpcode::kText, "hello"), static_cast<size_t>(kLoops));
+    EXPECT_EQ(hub.PublishWebSocket("other", WebSocketOpcode::kText, "world"), static_cast<size_t>(kLoops));
+    EXPECT_EQ(hub.PublishWebSocket("nobody", WebSocketOpcode::kText, "x"), 0u);
+    for (int i = 0; i < kClients; ++i) {
+      EXPECT_EQ(ReadText(fds[i]), i < 6 ? "hello" : "world") << i;
+      ::close(fds[i]);
+    }
+  });
+  // 连接断开时在 CloseCallback 中退订
+  EXPECT_EQ(hub.subscriber_num("news"), 0u);
+  EXPECT_EQ(hub.subscriber_num("other"), 0u);
+}
+
+}  // namespace net
@@ -0,0 +1,216 @@
+#include "net/http/compression_cache.h"
+
+#include <openssl/sha.h>
+
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "util/threadpool.h"
+
+namespace net {
+
+namespace {
+
+// 每条记录在压缩结果之外的开销, 让不值得压缩的记录也计入缓存大小, 数量不会无限增长
+constexpr size_t kSlotOverhead = 64;
+
+struct Key {
+  ContentDigest digest;
+  ContentEncoding encoding = ContentEncoding::kIdentity;
+
+  bool operator==(const Key& other) const {
+    return digest == other.digest && encoding == other.encoding;
+  }
+};
+
+struct KeyHash {
+  // 摘要本身是均匀分布的, 取前 8 个字节作为桶的哈希就够了, 相等由 operator== 比较完整的摘要
+  size_t operator()(const Key& key) const {
+    uint64_t prefix = 0;
+    std::memcpy(&prefix, key.digest.sha256.data(), sizeof prefix);
+    return static_cast<size_t>(prefix ^ (static_cast<uint64_t>(key.encoding) * 0x9e3779b97f4a7c15ULL));
+  }
+};
+
+}  // namespace
+
+struct CompressionCache::State {
+  using LruList = std::list<Key>;
+
+  struct Slot {
+    // 压缩结果, 正在压缩或者不值得压缩时为空
+    std::shared_ptr<const std::string> data;
+    bool pending = true;
+    // 压缩完成之后才放入 LRU 链表
+    LruList::iterator lru;
+  };
+
+  explicit State(const CompressionOptions& compression_options) : options(compression_options) {}
+
+  // 压缩任务完成, data 为空表示不值得压缩
+  void Finish(const Key& key, std::shared_ptr<const std::string> data);
+  void RemoveLocked(std::unordered_map<Key, Slot, KeyHash>::iterator it);
+
+  const CompressionOptions options;
+  mutable std::mutex mutex;
+  // 头部是最近使用的
+  LruList lru;
+  std::unordered_map<Key, Slot, KeyHash> slots;
+  size_t cached_bytes = 0;
+  size_t pending = 0;
+  Stats stats;
+};
+
+void CompressionCache::State::Finish(const Key& key, std::shared_ptr<const std::string> data) {
+  std::lock_guard<std::mutex> lock(mutex);
+  --pending;
+  ++stats.compressions;
+  if (data == nullptr) {
+    ++stats.incompressible;
+  }
+  auto it = slots.find(key);
+  if (it == slots.end()) {
+    return;
+  }
+  const size_t bytes = (data == nullptr ? 0 : data->size()) + kSlotOverhead;
+  if (bytes > options.max_cache_bytes) {
+    slots.erase(it);
+    return;
+  }
+  while (!lru.empty() && cached_bytes + bytes > options.max_cache_bytes) {
+    RemoveLocked(slots.find(lru.back()));
+    ++stats.evictions;
+  }
+  Slot& slot = it->second;
+  slot.data = std::move(data);
+  slot.pending = false;
+  lru.push_front(key);
+  slot.lru = lru.begin();
+  cached_bytes += bytes;
+}
+
+void CompressionCache::State::RemoveLocked(std::unordered_map<Key, Slot, KeyHash>::iterator it) {
+  const Slot& slot = it->second;
+  cached_bytes -= (slot.data == nullptr ? 0 : slot.data->size()) + kSlotOverhead;
+  lru.erase(slot.lru);
+  slots.erase(it);
+}
+
+CompressionCache::CompressionCache(util::ThreadPool* pool, const CompressionOptions& options)
+    : pool_(pool), state_(std::make_shared<State>(options)) {}
+
+CompressionCache::~CompressionCache() = default;
+
+ContentDigest CompressionCache::Digest(std::string_view data) {
+  ContentDigest digest;
+  static_assert(sizeof digest.sha256 == SHA256_DIGEST_LENGTH);
+  ::SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest.sha256.data());
+  digest.size = data.size();
+  return digest;
+}
+
+std::shared_ptr<const std::string> CompressionCache::Find(const ContentDigest& digest,
+                                                          const ContentEncoding encoding, bool* const known) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  auto it = state_->slots.find(Key{digest, encoding});
+  if (known != nullptr) {
+    *known = it != state_->slots.end();
+  }
+  if (it == state_->slots.end() || it->second.data == nullptr) {
+    ++state_->stats.misses;
+    return nullptr;
+  }
+  ++state_->stats.hits;
+  state_->lru.splice(state_->lru.begin(), state_->lru, it->second.lru);
+  return it->second.data;
+}
+
+bool CompressionCache::CompressAsync(const ContentDigest& digest, const ContentEncoding encoding,
+                                     std::shared_ptr<const void> holder, std::string_view data) {
+  if (encoding == ContentEncoding::kIdentity || data.size() < state_->options.min_bytes ||
+      data.size() > state_->options.max_bytes) {
+    return false;
+  }
+  const Key key{digest, encoding};
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->slots.emplace(key, State::Slot()).second) {
+      return false;
+    }
+    ++state_->pending;
+  }
+  const int level =
+      encoding == ContentEncoding::kGzip ? state_->options.gzip_level : state_->options.brotli_quality;
+  pool_->Post([state = state_, key, holder = std::move(holder), data, level]() {
+    std::string output;
+    if (Compress(key.encoding, data, level, &output) && output.size() < data.size()) {
+      state->Finish(key, std::make_shared<const std::string>(std::move(output)));
+    } else {
+      state->Finish(key, nullptr);
+    }
+  });
+  return true;
+}
+
+bool CompressionCache::Apply(const HttpRequest& request, HttpResponse* const response) {
+  const std::string& body = response->body();
+  if (response->status_code() != 200 || response->BodyBytes() != body.size() ||
+      body.size() < state_->options.min_bytes || body.size() > state_->options.max_bytes ||
+      !response->GetHeader("Content-Encoding").empty() || !response->GetHeader("ETag").empty() ||
+      !IsCompressibleType(response->GetHeader("Content-Type"))) {
+    return false;
+  }
+  response->AddHeader("Vary", "Accept-Encoding");
+  if (!request.HasHeader("Accept-Encoding")) {
+    return false;
+  }
+  const AcceptedEncodings accepted = ParseAcceptEncoding(request.GetHeader("Accept-Encoding"));
+  if (accepted.size == 0) {
+    return false;
+  }
+
+  const ContentDigest digest = Digest(body);
+  bool known = false;
+  for (size_t i = 0; i < accepted.size; ++i) {
+    std::shared_ptr<const std::string> compressed = Find(digest, accepted.encodings[i], i == 0 ? &known : nullptr);
+    if (compressed != nullptr) {
+      response->AddHeader("Content-Encoding", ContentEncodingName(accepted.encodings[i]));
+      response->SetBody(std::string());
+      response->AddSharedBody(compressed, *compressed);
+      return true;
+    }
+  }
+  if (!known) {
+    // 响应体在本次回复之后就被释放, 压缩任务需要自己的一份
+    std::shared_ptr<const std::string> copy = std::make_shared<const std::string>(body);
+    CompressAsync(digest, accepted.encodings[0], copy, *copy);
+  }
+  return false;
+}
+
+CompressionCache::Stats CompressionCache::stats() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->stats;
+}
+
+size_t CompressionCache::size() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->slots.size() - state_->pending;
+}
+
+size_t CompressionCache::cached_bytes() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->cached_bytes;
+}
+
+size_t CompressionCache::pending() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->pending;
+}
+
+}  // namespace net
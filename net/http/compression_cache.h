@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "net/http/content_encoding.h"
+#include "util/macros/macros.h"
+
+namespace util {
+class ThreadPool;
+}  // namespace util
+
+namespace net {
+
+class HttpRequest;
+class HttpResponse;
+
+struct CompressionOptions {
+  int gzip_level = 6;
+  // 按需压缩用中等的质量, 在压缩率和后台线程的 CPU 之间折中; 需要最高压缩率的文件应该提供预压缩的 .br 文件
+  int brotli_quality = 5;
+  // 小于这个大小的内容不压缩, 压缩节省的字节抵不上 Content-Encoding 等响应头
+  size_t min_bytes = 256;
+  // 大于这个大小的内容不压缩, 避免长时间占用后台线程
+  size_t max_bytes = 4 * 1024 * 1024;
+  // 压缩结果的总大小上限
+  size_t max_cache_bytes = 32 * 1024 * 1024;
+};
+
+// 内容的 SHA-256 摘要和长度, 压缩结果以它为 key
+struct ContentDigest {
+  std::array<uint8_t, 32> sha256 = {};
+  uint64_t size = 0;
+
+  bool operator==(const ContentDigest& other) const {
+    return size == other.size && sha256 == other.sha256;
+  }
+};
+
+/**
+ * @brief 压缩结果的缓存, 以内容的摘要和编码为 key, 内容相同的响应 (不论来自哪个文件或者哪个接口) 只压缩一次
+ *
+ * @note
+ *   1. 压缩在后台的 util::ThreadPool 中进行, 从不阻塞 IO 线程: 第一次查找没有结果时提交压缩任务并返回 nullptr,
+ *      调用者先回复未压缩的内容, 压缩完成之后的请求直接使用缓存的结果 (共享内存, 零拷贝发送)
+ *   2. 同一内容同时只有一个压缩任务; 压缩之后没有变小的内容也会记录下来, 之后不再尝试
+ *   3. 压缩结果按 LRU 淘汰; 可以在多个 IO 线程中同时使用, 锁内只做查表
+ *   4. key 是 SHA-256 摘要加上长度, 而不是可以被构造出碰撞的普通哈希: 否则客户端可以让一个接口的内容
+ *      被另一个内容的压缩结果替换. 计算摘要需要读一遍内容, 静态文件只在加载时计算一次
+ *   5. 线程池需要比 CompressionCache 活得更久; 没有完成的压缩任务持有内部状态, CompressionCache 可以先析构
+ *
+ * @example
+ *   util::ThreadPool pool("compress", 2);
+ *   CompressionCache compression(&pool);
+ *   server.SetHttpCallback([&](const HttpRequest& request, HttpResponse* response) {
+ *     response->SetContentType("application/json");
+ *     response->SetBody(RenderJson());
+ *     compression.Apply(request, response);
+ *   });
+ */
+class CompressionCache final {
+ public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // 完成的压缩任务数
+    uint64_t compressions = 0;
+    // 压缩之后没有变小的内容数
+    uint64_t incompressible = 0;
+    uint64_t evictions = 0;
+  };
+
+ public:
+  explicit CompressionCache(util::ThreadPool* pool, const CompressionOptions& options = CompressionOptions());
+  ~CompressionCache();
+
+ public:
+  static ContentDigest Digest(std::string_view data);
+
+  /**
+   * @brief 查找摘要为 digest 的内容的 encoding 压缩结果
+   * @param known 非空时返回缓存是否已经知道这个内容: 已经压缩好、正在压缩或者不值得压缩, 为 false 时需要 CompressAsync
+   * @return 没有压缩好或者不值得压缩时返回 nullptr
+   */
+  std::shared_ptr<const std::string> Find(const ContentDigest& digest, const ContentEncoding encoding,
+                                          bool* const known = nullptr);
+
+  /**
+   * @brief 在后台压缩 data, 完成之后可以用 Find 找到
+   * @param holder 保证 data 在压缩完成之前有效
+   * @return bool 大小不在压缩范围内、已经压缩过或者正在压缩时返回 false
+   */
+  bool CompressAsync(const ContentDigest& digest, const ContentEncoding encoding, std::shared_ptr<const void> holder,
+                     std::string_view data);
+
+  /**
+   * @brief 按照请求的 Accept-Encoding 压缩动态生成的响应
+   * @note 只处理状态码为 200、没有 Content-Encoding 和 ETag (不同编码需要不同的 ETag)、可压缩的 Content-Type、
+   *       响应体只由 SetBody 设置的响应. 可压缩的响应都会加上 Vary: Accept-Encoding. 没有压缩结果时拷贝一份响应体
+   *       提交后台压缩, 本次回复原始内容
+   * @return bool 是否替换成了压缩之后的响应体
+   */
+  bool Apply(const HttpRequest& request, HttpResponse* const response);
+
+ public:
+  Stats stats() const;
+  // 缓存的压缩结果数量, 包括不值得压缩的记录
+  size_t size() const;
+  size_t cached_bytes() const;
+  // 正在排队或者压缩中的任务数
+  size_t pending() const;
+
+ private:
+  struct State;
+
+ private:
+  util::ThreadPool* pool_;
+  // 压缩任务持有 state_, 保证 CompressionCache 析构之后完成的任务仍然可以安全地写入
+  std::shared_ptr<State> state_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CompressionCache);
+};
+
+}  // namespace net
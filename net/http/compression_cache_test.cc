@@ -0,0 +1,178 @@
+#include "net/http/compression_cache.h"
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "net/buffer.h"
+#include "net/http/http_parser.h"
+#include "net/http/http_response.h"
+#include "net/test_util.hpp"
+#include "util/threadpool.h"
+
+namespace net {
+
+namespace {
+
+std::shared_ptr<const std::string> MakeJson(const int items) {
+  std::string json = "[";
+  for (int i = 0; i < items; ++i) {
+    json += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\"},";
+  }
+  json.back() = ']';
+  return std::make_shared<const std::string>(std::move(json));
+}
+
+}  // namespace
+
+TEST(CompressionCacheTest, digest) {
+  // FIPS 180-2 中 "abc" 的 SHA-256
+  const ContentDigest abc = CompressionCache::Digest("abc");
+  EXPECT_EQ(abc.size, 3u);
+  EXPECT_EQ(abc.sha256[0], 0xba);
+  EXPECT_EQ(abc.sha256[31], 0xad);
+  EXPECT_TRUE(abc == CompressionCache::Digest(std::string("abc")));
+  // 长度相同、内容不同
+  EXPECT_FALSE(abc == CompressionCache::Digest("abd"));
+  EXPECT_FALSE(CompressionCache::Digest("") == CompressionCache::Digest(std::string(1, '\0')));
+}
+
+TEST(CompressionCacheTest, compress_async) {
+  util::ThreadPool pool("compression_cache_test", 1);
+  CompressionOptions options;
+  CompressionCache cache(&pool, options);
+  std::shared_ptr<const std::string> json = MakeJson(100);
+  const ContentDigest digest = CompressionCache::Digest(*json);
+
+  bool known = true;
+  EXPECT_EQ(cache.Find(digest, ContentEncoding::kBrotli, &known), nullptr);
+  EXPECT_FALSE(known);
+  EXPECT_TRUE(cache.CompressAsync(digest, ContentEncoding::kBrotli, json, *json));
+  // 同一内容只压缩一次
+  EXPECT_FALSE(cache.CompressAsync(digest, ContentEncoding::kBrotli, json, *json));
+  EXPECT_TRUE(cache.CompressAsync(digest, ContentEncoding::kGzip, json, *json));
+  ASSERT_TRUE(WaitFor([&cache]() { return cache.pending() == 0; }));
+
+  std::string expected;
+  ASSERT_TRUE(Compress(ContentEncoding::kBrotli, *json, options.brotli_quality, &expected));
+  std::shared_ptr<const std::string> compressed = cache.Find(digest, ContentEncoding::kBrotli, &known);
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_TRUE(known);
+  EXPECT_TRUE(*compressed == expected);
+  ASSERT_TRUE(Compress(ContentEncoding::kGzip, *json, options.gzip_level, &expected));
+  ASSERT_NE(cache.Find(digest, ContentEncoding::kGzip), nullptr);
+  EXPECT_TRUE(*cache.Find(digest, ContentEncoding::kGzip) == expected);
+  EXPECT_EQ(cache.size(), 2u);
+
+  // 太小、太大和压缩之后没有变小的内容
+  EXPECT_FALSE(cache.CompressAsync(CompressionCache::Digest("tiny"), ContentEncoding::kGzip, nullptr, "tiny"));
+  const std::string huge(options.max_bytes + 1, 'a');
+  EXPECT_FALSE(cache.CompressAsync(CompressionCache::Digest(huge), ContentEncoding::kGzip, nullptr, huge));
+  std::mt19937 random(7);
+  std::string noise(4096, '\0');
+  for (char& c : noise) {
+    c = static_cast<char>(random());
+  }
+  const ContentDigest noise_digest = CompressionCache::Digest(noise);
+  EXPECT_TRUE(cache.CompressAsync(noise_digest, ContentEncoding::kGzip, nullptr, noise));
+  ASSERT_TRUE(WaitFor([&cache]() { return cache.pending() == 0; }));
+  EXPECT_EQ(cache.Find(noise_digest, ContentEncoding::kGzip, &known), nullptr);
+  EXPECT_TRUE(known);
+  EXPECT_FALSE(cache.CompressAsync(noise_digest, ContentEncoding::kGzip, nullptr, noise));
+
+  CompressionCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.compressions, 3u);
+  EXPECT_EQ(stats.incompressible, 1u);
+  EXPECT_EQ(stats.hits, 3u);
+}
+
+TEST(CompressionCacheTest, eviction) {
+  util::ThreadPool pool("compression_cache_test", 1);
+  CompressionOptions options;
+  options.max_cache_bytes = 1200;
+  CompressionCache cache(&pool, options);
+  // 每个结果大约 500 字节, 缓存只能放下两个
+  std::shared_ptr<const std::string> texts[3];
+  ContentDigest digests[3];
+  for (int i = 0; i < 3; ++i) {
+    std::string text;
+    std::mt19937 random(i);
+    for (int j = 0; j < 800; ++j) {
+      text += static_cast<char>('a' + random() % 16);
+    }
+    texts[i] = std::make_shared<const std::string>(text);
+    digests[i] = CompressionCache::Digest(*texts[i]);
+    ASSERT_TRUE(cache.CompressAsync(digests[i], ContentEncoding::kGzip, texts[i], *texts[i]));
+    ASSERT_TRUE(WaitFor([&cache]() { return cache.pending() == 0; }));
+    if (i == 1) {
+      // 访问第一个, 淘汰的是第二个
+      EXPECT_NE(cache.Find(digests[0], ContentEncoding::kGzip), nullptr);
+    }
+  }
+  EXPECT_LE(cache.cached_bytes(), options.max_cache_bytes);
+  EXPECT_EQ(cache.stats().evictions, 1u);
+  EXPECT_NE(cache.Find(digests[0], ContentEncoding::kGzip), nullptr);
+  EXPECT_EQ(cache.Find(digests[1], ContentEncoding::kGzip), nullptr);
+  EXPECT_NE(cache.Find(digests[2], ContentEncoding::kGzip), nullptr);
+}
+
+TEST(CompressionCacheTest, apply) {
+  util::ThreadPool pool("compression_cache_test", 1);
+  CompressionCache cache(&pool);
+  const std::string json = *MakeJson(100);
+
+  HttpParser parser;
+  Buffer buffer;
+  auto apply = [&](const std::string& request, HttpResponse* response) {
+    buffer.RetrieveAll();
+    buffer.Append(request);
+    parser.Reset();
+    EXPECT_EQ(parser.Parse(buffer), HttpParser::Result::kComplete);
+    return cache.Apply(parser.request(), response);
+  };
+  auto json_response = [&json]() {
+    HttpResponse response(false);
+    response.SetContentType("application/json");
+    response.SetBody(json);
+    return response;
+  };
+
+  // 第一次回复原始内容并在后台压缩
+  HttpResponse first = json_response();
+  EXPECT_FALSE(apply("GET / HTTP/1.1\r\nAccept-Encoding: gzip, br\r\n\r\n", &first));
+  EXPECT_EQ(first.GetHeader("Vary"), "Accept-Encoding");
+  EXPECT_EQ(first.body(), json);
+  ASSERT_TRUE(WaitFor([&cache]() { return cache.pending() == 0; }));
+
+  HttpResponse second = json_response();
+  EXPECT_TRUE(apply("GET / HTTP/1.1\r\nAccept-Encoding: gzip, br\r\n\r\n", &second));
+  EXPECT_EQ(second.GetHeader("Content-Encoding"), "br");
+  EXPECT_TRUE(second.body().empty());
+  EXPECT_LT(second.BodyBytes(), json.size() / 4);
+  // 客户端只接受 gzip 时还没有结果
+  HttpResponse gzip = json_response();
+  EXPECT_FALSE(apply("GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n", &gzip));
+  EXPECT_TRUE(gzip.GetHeader("Content-Encoding").empty());
+
+  // 不压缩的响应
+  HttpResponse identity = json_response();
+  EXPECT_FALSE(apply("GET / HTTP/1.1\r\n\r\n", &identity));
+  EXPECT_EQ(identity.GetHeader("Vary"), "Accept-Encoding");
+  HttpResponse image(false);
+  image.SetContentType("image/png");
+  image.SetBody(json);
+  EXPECT_FALSE(apply("GET / HTTP/1.1\r\nAccept-Encoding: br\r\n\r\n", &image));
+  EXPECT_TRUE(image.GetHeader("Vary").empty());
+  HttpResponse tagged = json_response();
+  tagged.AddHeader("ETag", "\"v1\"");
+  EXPECT_FALSE(apply("GET / HTTP/1.1\r\nAccept-Encoding: br\r\n\r\n", &tagged));
+  HttpResponse not_found = json_response();
+  not_found.SetStatusCode(404);
+  EXPECT_FALSE(apply("GET / HTTP/1.1\r\nAccept-Encoding: br\r\n\r\n", &not_found));
+  ASSERT_TRUE(WaitFor([&cache]() { return cache.pending() == 0; }));
+  EXPECT_EQ(cache.size(), 2u);
+}
+
+}  // namespace net
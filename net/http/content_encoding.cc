@@ -0,0 +1,186 @@
+#include "net/http/content_encoding.h"
+
+#include <brotli/encode.h>
+#include <zlib.h>
+
+#include <algorithm>
+
+#include "net/http/http_request.h"
+
+namespace net {
+
+namespace {
+
+std::string_view Trim(std::string_view text) {
+  size_t begin = text.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    return std::string_view();
+  }
+  return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+// 解析 q 值 ("0" ~ "1", 最多三位小数), 返回千分比, 非法时返回 -1
+int ParseQValue(std::string_view text) {
+  if (text.empty() || (text[0] != '0' && text[0] != '1')) {
+    return -1;
+  }
+  int value = (text[0] - '0') * 1000;
+  if (text.size() == 1) {
+    return value;
+  }
+  if (text[1] != '.' || text.size() > 5) {
+    return -1;
+  }
+  int scale = 100;
+  for (char c : text.substr(2)) {
+    if (c < '0' || c > '9') {
+      return -1;
+    }
+    value += (c - '0') * scale;
+    scale /= 10;
+  }
+  return value <= 1000 ? value : -1;
+}
+
+bool StartsWithIgnoreCase(std::string_view text, std::string_view prefix) {
+  return text.size() >= prefix.size() && EqualsIgnoreCase(text.substr(0, prefix.size()), prefix);
+}
+
+bool EndsWithIgnoreCase(std::string_view text, std::string_view suffix) {
+  return text.size() >= suffix.size() && EqualsIgnoreCase(text.substr(text.size() - suffix.size()), suffix);
+}
+
+bool CompressGzip(std::string_view data, const int level, std::string* const output) {
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  // windowBits 加 16 生成 gzip 格式而不是 zlib 格式
+  if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  output->resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  stream.avail_out = static_cast<uInt>(output->size());
+  int ret = deflate(&stream, Z_FINISH);
+  output->resize(stream.total_out);
+  deflateEnd(&stream);
+  return ret == Z_STREAM_END;
+}
+
+bool CompressBrotli(std::string_view data, const int level, std::string* const output) {
+  size_t size = BrotliEncoderMaxCompressedSize(data.size());
+  if (size == 0) {
+    return false;
+  }
+  output->resize(size);
+  if (!BrotliEncoderCompress(level, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+                             reinterpret_cast<const uint8_t*>(data.data()), &size,
+                             reinterpret_cast<uint8_t*>(&(*output)[0]))) {
+    return false;
+  }
+  output->resize(size);
+  return true;
+}
+
+}  // namespace
+
+AcceptedEncodings ParseAcceptEncoding(std::string_view value) {
+  // 每种编码的 q 值, -1 表示没有单独列出
+  int qvalues[kContentEncodingNum] = {-1, -1, -1};
+  int wildcard = -1;
+  while (!value.empty()) {
+    size_t comma = value.find(',');
+    std::string_view item = value.substr(0, comma);
+    value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+
+    size_t semicolon = item.find(';');
+    std::string_view coding = Trim(item.substr(0, semicolon));
+    int q = 1000;
+    if (semicolon != std::string_view::npos) {
+      std::string_view param = Trim(item.substr(semicolon + 1));
+      if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=') {
+        continue;
+      }
+      q = ParseQValue(Trim(param.substr(2)));
+      if (q < 0) {
+        continue;
+      }
+    }
+    if (EqualsIgnoreCase(coding, "br")) {
+      qvalues[static_cast<size_t>(ContentEncoding::kBrotli)] = q;
+    } else if (EqualsIgnoreCase(coding, "gzip") || EqualsIgnoreCase(coding, "x-gzip")) {
+      qvalues[static_cast<size_t>(ContentEncoding::kGzip)] = q;
+    } else if (coding == "*") {
+      wildcard = q;
+    }
+  }
+
+  AcceptedEncodings accepted;
+  for (ContentEncoding encoding : {ContentEncoding::kBrotli, ContentEncoding::kGzip}) {
+    int& q = qvalues[static_cast<size_t>(encoding)];
+    if (q < 0) {
+      q = wildcard;
+    }
+    if (q > 0) {
+      accepted.encodings[accepted.size++] = encoding;
+    }
+  }
+  // 稳定排序保持 q 值相同时 br 在前
+  std::stable_sort(accepted.encodings, accepted.encodings + accepted.size,
+                   [&qvalues](const ContentEncoding a, const ContentEncoding b) {
+                     return qvalues[static_cast<size_t>(a)] > qvalues[static_cast<size_t>(b)];
+                   });
+  return accepted;
+}
+
+const char* ContentEncodingName(const ContentEncoding encoding) {
+  switch (encoding) {
+    case ContentEncoding::kGzip:
+      return "gzip";
+    case ContentEncoding::kBrotli:
+      return "br";
+    default:
+      return "identity";
+  }
+}
+
+const char* ContentEncodingSuffix(const ContentEncoding encoding) {
+  switch (encoding) {
+    case ContentEncoding::kGzip:
+      return ".gz";
+    case ContentEncoding::kBrotli:
+      return ".br";
+    default:
+      return "";
+  }
+}
+
+bool IsCompressibleType(std::string_view content_type) {
+  std::string_view type = Trim(content_type.substr(0, content_type.find(';')));
+  if (StartsWithIgnoreCase(type, "text/") || EndsWithIgnoreCase(type, "+json") || EndsWithIgnoreCase(type, "+xml")) {
+    return true;
+  }
+  for (std::string_view compressible : {"application/json", "application/javascript", "application/x-javascript",
+                                        "application/xml", "application/wasm"}) {
+    if (EqualsIgnoreCase(type, compressible)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Compress(const ContentEncoding encoding, std::string_view data, const int level, std::string* const output) {
+  switch (encoding) {
+    case ContentEncoding::kGzip:
+      return CompressGzip(data, level, output);
+    case ContentEncoding::kBrotli:
+      return CompressBrotli(data, level, output);
+    default:
+      return false;
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace net {
+
+enum class ContentEncoding : uint8_t {
+  kIdentity = 0,
+  kGzip = 1,
+  kBrotli = 2,
+};
+
+constexpr size_t kContentEncodingNum = 3;
+
+// 客户端可以接受的压缩编码, 按偏好从高到低排列, 不包含 identity
+struct AcceptedEncodings {
+  ContentEncoding encodings[kContentEncodingNum - 1] = {};
+  size_t size = 0;
+};
+
+/**
+ * @brief 解析 Accept-Encoding 请求头, 例如 "gzip;q=0.8, br, *;q=0.1"
+ * @note q 值高的优先, q 值相同时 br 优先 (压缩率更高); q=0 和不认识的编码被忽略, "*" 匹配所有没有单独列出的编码
+ */
+AcceptedEncodings ParseAcceptEncoding(std::string_view value);
+
+// Content-Encoding 响应头的值, 例如 "gzip"
+const char* ContentEncodingName(const ContentEncoding encoding);
+
+// 预压缩文件的后缀, 例如 ".gz"
+const char* ContentEncodingSuffix(const ContentEncoding encoding);
+
+// 文本类的内容压缩效果好, 图片、音视频和字体等已经压缩过的格式不再压缩
+bool IsCompressibleType(std::string_view content_type);
+
+/**
+ * @brief 把 data 压缩成 encoding 格式
+ * @param level gzip 为 1 ~ 9, brotli 为 0 ~ 11
+ * @return bool 压缩失败或者 encoding 是 identity 时返回 false
+ */
+bool Compress(const ContentEncoding encoding, std::string_view data, const int level, std::string* const output);
+
+}  // namespace net
@@ -0,0 +1,121 @@
+#include "net/http/content_encoding.h"
+
+#include <brotli/decode.h>
+#include <zlib.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// 把协商结果转换成 "br,gzip" 方便比较
+std::string Format(const AcceptedEncodings& accepted) {
+  std::string text;
+  for (size_t i = 0; i < accepted.size; ++i) {
+    if (!text.empty()) {
+      text += ",";
+    }
+    text += ContentEncodingName(accepted.encodings[i]);
+  }
+  return text;
+}
+
+bool Gunzip(const std::string& data, std::string* const output) {
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+    return false;
+  }
+  output->clear();
+  char buf[4096];
+  int ret = Z_OK;
+  while (ret == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef*>(buf);
+    stream.avail_out = sizeof buf;
+    ret = inflate(&stream, Z_NO_FLUSH);
+    output->append(buf, sizeof buf - stream.avail_out);
+  }
+  inflateEnd(&stream);
+  return ret == Z_STREAM_END;
+}
+
+bool Unbrotli(const std::string& data, const size_t size, std::string* const output) {
+  output->resize(size);
+  size_t decoded = size;
+  if (BrotliDecoderDecompress(data.size(), reinterpret_cast<const uint8_t*>(data.data()), &decoded,
+                              reinterpret_cast<uint8_t*>(&(*output)[0])) != BROTLI_DECODER_RESULT_SUCCESS) {
+    return false;
+  }
+  output->resize(decoded);
+  return true;
+}
+
+}  // namespace
+
+TEST(ContentEncodingTest, parse_accept_encoding) {
+  struct {
+    const char* value;
+    const char* accepted;
+  } const kCases[] = {
+      {"", ""},
+      {"identity", ""},
+      {"gzip", "gzip"},
+      {"gzip, deflate, br", "br,gzip"},
+      {"GZIP;Q=0.5, BR;q=0.4", "gzip,br"},
+      {"gzip;q=1.0, br;q=1", "br,gzip"},
+      {"br;q=0, gzip", "gzip"},
+      {"*", "br,gzip"},
+      {"*;q=0.1, gzip;q=0.5", "gzip,br"},
+      {"*;q=0, gzip", "gzip"},
+      {"x-gzip", "gzip"},
+      {" br ; q=0.001 ,", "br"},
+      {"br;q=2, gzip;q=0.1234, deflate", ""},
+      {"br;level=1, gzip;q=abc", ""},
+  };
+  for (const auto& test_case : kCases) {
+    EXPECT_EQ(Format(ParseAcceptEncoding(test_case.value)), test_case.accepted) << test_case.value;
+  }
+}
+
+TEST(ContentEncodingTest, compressible_type) {
+  for (const char* type : {"text/html; charset=utf-8", "TEXT/CSS", "application/json", "application/problem+json",
+                           "image/svg+xml", "application/javascript", "application/wasm"}) {
+    EXPECT_TRUE(IsCompressibleType(type)) << type;
+  }
+  for (const char* type : {"", "image/png", "application/octet-stream", "font/woff2", "video/mp4", "textplain"}) {
+    EXPECT_FALSE(IsCompressibleType(type)) << type;
+  }
+}
+
+TEST(ContentEncodingTest, compress) {
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    data += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\"},";
+  }
+  std::string compressed;
+  std::string decompressed;
+  ASSERT_TRUE(Compress(ContentEncoding::kGzip, data, 6, &compressed));
+  EXPECT_LT(compressed.size(), data.size() / 4);
+  ASSERT_TRUE(Gunzip(compressed, &decompressed));
+  EXPECT_TRUE(decompressed == data);
+
+  ASSERT_TRUE(Compress(ContentEncoding::kBrotli, data, 5, &compressed));
+  EXPECT_LT(compressed.size(), data.size() / 4);
+  ASSERT_TRUE(Unbrotli(compressed, data.size(), &decompressed));
+  EXPECT_TRUE(decompressed == data);
+
+  // 空内容也能压缩
+  ASSERT_TRUE(Compress(ContentEncoding::kGzip, "", 1, &compressed));
+  ASSERT_TRUE(Gunzip(compressed, &decompressed));
+  EXPECT_TRUE(decompressed.empty());
+  EXPECT_FALSE(Compress(ContentEncoding::kIdentity, data, 6, &compressed));
+}
+
+}  // namespace net
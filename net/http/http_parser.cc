@@ -0,0 +1,526 @@
+#include "net/http/http_parser.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#include "logger/log.h"
+#include "net/buffer.h"
+
+namespace net {
+
+namespace {
+
+// chunk-size 行 (包括 chunk-ext) 的最大长度
+constexpr size_t kMaxChunkSizeLine = 1024;
+// 16 个十六进制数字就可能溢出
+constexpr size_t kMaxChunkSizeDigits = 15;
+
+/**
+ * @brief RFC 9110 中的 tchar: "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." / "^" / "_" / "`" / "|" / "~"
+ *        / DIGIT / ALPHA, 用于请求方法和请求头名字
+ */
+struct TokenTable {
+  bool value[256] = {};
+
+  constexpr TokenTable() {
+    for (int c = '0'; c <= '9'; ++c) {
+      value[c] = true;
+    }
+    for (int c = 'a'; c <= 'z'; ++c) {
+      value[c] = true;
+      value[c - 'a' + 'A'] = true;
+    }
+    for (const char* p = "!#$%&'*+-.^_`|~"; *p != '\0'; ++p) {
+      value[static_cast<unsigned char>(*p)] = true;
+    }
+  }
+};
+
+constexpr TokenTable kTokenTable;
+
+bool IsToken(const char c) {
+  return kTokenTable.value[static_cast<unsigned char>(c)];
+}
+
+// request-target 中允许出现可见字符和 obs-text
+bool IsTargetChar(const char c) {
+  unsigned char uc = static_cast<unsigned char>(c);
+  return uc > 0x20 && uc != 0x7f;
+}
+
+bool IsFieldValueChar(const char c) {
+  unsigned char uc = static_cast<unsigned char>(c);
+  return uc >= 0x20 ? uc != 0x7f : uc == '\t';
+}
+
+/**
+ * @brief 检查 [begin, end) 中没有除 HTAB 以外的控制字符
+ * @note 支持 SSE2 时每次检查 16 字节; 大于等于 0x80 的 obs-text 在有符号比较中是负数, 需要排除
+ */
+bool IsValidFieldValue(const char* begin, const char* end) {
+  const char* p = begin;
+#if defined(__SSE2__)
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i minus_one = _mm_set1_epi8(-1);
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i ctl = _mm_and_si128(_mm_cmplt_epi8(v, space), _mm_cmpgt_epi8(v, minus_one));
+    ctl = _mm_andnot_si128(_mm_cmpeq_epi8(v, tab), ctl);
+    if (_mm_movemask_epi8(_mm_or_si128(ctl, _mm_cmpeq_epi8(v, del))) != 0) {
+      return false;
+    }
+    p += 16;
+  }
+#endif
+  for (; p < end; ++p) {
+    if (!IsFieldValueChar(*p)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsWhitespace(const char c) {
+  return c == ' ' || c == '\t';
+}
+
+HttpMethod ToMethod(std::string_view name) {
+  switch (name.size()) {
+    case 3:
+      if (name == "GET") {
+        return HttpMethod::kGet;
+      }
+      if (name == "PUT") {
+        return HttpMethod::kPut;
+      }
+      break;
+    case 4:
+      if (name == "POST") {
+        return HttpMethod::kPost;
+      }
+      if (name == "HEAD") {
+        return HttpMethod::kHead;
+      }
+      break;
+    case 5:
+      if (name == "PATCH") {
+        return HttpMethod::kPatch;
+      }
+      if (name == "TRACE") {
+        return HttpMethod::kTrace;
+      }
+      break;
+    case 6:
+      if (name == "DELETE") {
+        return HttpMethod::kDelete;
+      }
+      break;
+    case 7:
+      if (name == "OPTIONS") {
+        return HttpMethod::kOptions;
+      }
+      if (name == "CONNECT") {
+        return HttpMethod::kConnect;
+      }
+      break;
+    default:
+      break;
+  }
+  return HttpMethod::kUnknown;
+}
+
+bool IsDigit(const char c) {
+  return c >= '0' && c <= '9';
+}
+
+int HexValue(const char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+}  // namespace
+
+HttpParser::HttpParser(const HttpLimits& limits) : limits_(limits) {
+  // 偏移用 32 位记录
+  CHECK_LE(limits_.max_request_line + limits_.max_header_bytes, static_cast<size_t>(UINT32_MAX));
+}
+
+HttpParser::Result HttpParser::Parse(const Buffer& buffer) {
+  const char* base = buffer.Peek();
+  const char* end = buffer.BeginWrite();
+  request_.base_ = base;
+
+  while (true) {
+    switch (state_) {
+      case State::kRequestLine: {
+        bool too_long = false;
+        const char* eol = FindLine(base, end, limits_.max_request_line, &too_long);
+        if (eol == nullptr) {
+          return too_long ? Fail(Error::kUriTooLong) : Result::kIncomplete;
+        }
+        const char* line = base + pos_;
+        pos_ = eol + 2 - base;
+        // 请求行之前的空行应该被忽略, 但是不能无限制地累积
+        if (eol == line) {
+          if (pos_ > limits_.max_request_line) {
+            return Fail(Error::kBadRequest);
+          }
+          continue;
+        }
+        if (!ParseRequestLine(base, line, eol)) {
+          return Result::kError;
+        }
+        state_ = State::kHeaders;
+        break;
+      }
+      case State::kHeaders:
+      case State::kTrailers: {
+        bool too_long = false;
+        const size_t max_len = header_bytes_ < limits_.max_header_bytes ? limits_.max_header_bytes - header_bytes_ : 0;
+        const char* eol = FindLine(base, end, max_len, &too_long);
+        if (eol == nullptr) {
+          return too_long ? Fail(Error::kHeaderTooLarge) : Result::kIncomplete;
+        }
+        const char* line = base + pos_;
+        pos_ = eol + 2 - base;
+        header_bytes_ += eol + 2 - line;
+        if (eol == line) {
+          if (state_ == State::kTrailers) {
+            request_.body_ = chunked_body_;
+            state_ = State::kComplete;
+          } else if (!PrepareBody()) {
+            return Result::kError;
+          }
+          break;
+        }
+        if (header_bytes_ > limits_.max_header_bytes) {
+          return Fail(Error::kHeaderTooLarge);
+        }
+        // trailer 中的字段不允许影响请求的处理方式, 直接丢弃
+        if (state_ == State::kHeaders && !ParseHeaderLine(base, line, eol)) {
+          return Result::kError;
+        }
+        break;
+      }
+      case State::kBody: {
+        if (static_cast<size_t>(end - base) - body_offset_ < body_remaining_) {
+          return Result::kIncomplete;
+        }
+        request_.body_ = std::string_view(base + body_offset_, body_remaining_);
+        pos_ = body_offset_ + body_remaining_;
+        body_remaining_ = 0;
+        state_ = State::kComplete;
+        break;
+      }
+      case State::kChunkSize: {
+        bool too_long = false;
+        const char* eol = FindLine(base, end, kMaxChunkSizeLine, &too_long);
+        if (eol == nullptr) {
+          return too_long ? Fail(Error::kBadRequest) : Result::kIncomplete;
+        }
+        const char* line = base + pos_;
+        pos_ = eol + 2 - base;
+        if (!ParseChunkSize(line, eol)) {
+          return Result::kError;
+        }
+        break;
+      }
+      case State::kChunkData: {
+        size_t n = std::min(static_cast<size_t>(end - base) - pos_, body_remaining_);
+        chunked_body_.append(base + pos_, n);
+        pos_ += n;
+        body_remaining_ -= n;
+        if (body_remaining_ > 0) {
+          return Result::kIncomplete;
+        }
+        state_ = State::kChunkDataEnd;
+        break;
+      }
+      case State::kChunkDataEnd: {
+        const size_t available = static_cast<size_t>(end - base) - pos_;
+        if ((available >= 1 && base[pos_] != '\r') || (available >= 2 && base[pos_ + 1] != '\n')) {
+          return Fail(Error::kBadRequest);
+        }
+        if (available < 2) {
+          return Result::kIncomplete;
+        }
+        pos_ += 2;
+        state_ = State::kChunkSize;
+        break;
+      }
+      case State::kComplete:
+        return Result::kComplete;
+      case State::kError:
+        return Result::kError;
+    }
+  }
+}
+
+void HttpParser::Reset() {
+  state_ = State::kRequestLine;
+  error_ = Error::kNone;
+  request_.Clear();
+  pos_ = 0;
+  scan_pos_ = 0;
+  header_bytes_ = 0;
+  body_offset_ = 0;
+  body_remaining_ = 0;
+  chunked_body_.clear();
+}
+
+const HttpRequest& HttpParser::request() const {
+  return request_;
+}
+
+size_t HttpParser::consumed_bytes() const {
+  return pos_;
+}
+
+HttpParser::Error HttpParser::error() const {
+  return error_;
+}
+
+int HttpParser::ErrorToStatusCode(const Error error) {
+  switch (error) {
+    case Error::kNone:
+      return 200;
+    case Error::kBadRequest:
+      return 400;
+    case Error::kUriTooLong:
+      return 414;
+    case Error::kHeaderTooLarge:
+      return 431;
+    case Error::kPayloadTooLarge:
+      return 413;
+    case Error::kNotImplemented:
+      return 501;
+    case Error::kVersionNotSupported:
+      return 505;
+  }
+  return 400;
+}
+
+const char* HttpParser::ErrorToString(const Error error) {
+  switch (error) {
+    case Error::kNone:
+      return "None";
+    case Error::kBadRequest:
+      return "Bad Request";
+    case Error::kUriTooLong:
+      return "URI Too Long";
+    case Error::kHeaderTooLarge:
+      return "Request Header Fields Too Large";
+    case Error::kPayloadTooLarge:
+      return "Payload Too Large";
+    case Error::kNotImplemented:
+      return "Not Implemented";
+    case Error::kVersionNotSupported:
+      return "HTTP Version Not Supported";
+  }
+  return "Bad Request";
+}
+
+const char* HttpParser::FindLine(const char* base, const char* end, const size_t max_len, bool* const too_long) {
+  const char* line = base + pos_;
+  const char* eol = Buffer::SearchCRLF(base + std::max(scan_pos_, pos_), end);
+  if (eol == nullptr) {
+    // 最后一个字节可能是 '\r', 下次从它开始查找
+    scan_pos_ = std::max(pos_, static_cast<size_t>(end - base) - 1);
+    *too_long = static_cast<size_t>(end - line) > max_len + 1;
+    return nullptr;
+  }
+  if (static_cast<size_t>(eol - line) > max_len) {
+    *too_long = true;
+    return nullptr;
+  }
+  scan_pos_ = eol + 2 - base;
+  return eol;
+}
+
+bool HttpParser::ParseRequestLine(const char* base, const char* line, const char* eol) {
+  // method SP request-target SP HTTP-version
+  const char* p = line;
+  while (p < eol && IsToken(*p)) {
+    ++p;
+  }
+  if (p == line || p == eol || *p != ' ') {
+    Fail(Error::kBadRequest);
+    return false;
+  }
+  request_.method_name_ = {static_cast<uint32_t>(line - base), static_cast<uint32_t>(p - line)};
+  request_.method_ = ToMethod(std::string_view(line, p - line));
+
+  const char* target = ++p;
+  while (p < eol && IsTargetChar(*p)) {
+    ++p;
+  }
+  if (p == target || p == eol || *p != ' ') {
+    Fail(Error::kBadRequest);
+    return false;
+  }
+  request_.target_ = {static_cast<uint32_t>(target - base), static_cast<uint32_t>(p - target)};
+  const void* question = ::memchr(target, '?', p - target);
+  request_.query_pos_ =
+      static_cast<uint32_t>(question == nullptr ? p - target : static_cast<const char*>(question) - target);
+
+  std::string_view version(p + 1, eol - p - 1);
+  if (version.size() != 8 || version.compare(0, 5, "HTTP/") != 0 || !IsDigit(version[5]) || version[6] != '.' ||
+      !IsDigit(version[7])) {
+    Fail(Error::kBadRequest);
+    return false;
+  }
+  if (version[5] != '1') {
+    Fail(Error::kVersionNotSupported);
+    return false;
+  }
+  request_.version_minor_ = version[7] - '0';
+  return true;
+}
+
+bool HttpParser::ParseHeaderLine(const char* base, const char* line, const char* eol) {
+  if (request_.headers_.size() >= limits_.max_headers) {
+    Fail(Error::kHeaderTooLarge);
+    return false;
+  }
+  // field-name ":" OWS field-value OWS, 名字和冒号之间不允许有空白, 也不支持已经废弃的折行 (obs-fold)
+  const char* p = line;
+  while (p < eol && IsToken(*p)) {
+    ++p;
+  }
+  if (p == line || p == eol || *p != ':') {
+    Fail(Error::kBadRequest);
+    return false;
+  }
+  const char* name_end = p++;
+  while (p < eol && IsWhitespace(*p)) {
+    ++p;
+  }
+  const char* value_end = eol;
+  while (value_end > p && IsWhitespace(value_end[-1])) {
+    --value_end;
+  }
+  if (!IsValidFieldValue(p, value_end)) {
+    Fail(Error::kBadRequest);
+    return false;
+  }
+  HttpRequest::HeaderSpan header;
+  header.name = {static_cast<uint32_t>(line - base), static_cast<uint32_t>(name_end - line)};
+  header.value = {static_cast<uint32_t>(p - base), static_cast<uint32_t>(value_end - p)};
+  request_.headers_.push_back(header);
+  return true;
+}
+
+bool HttpParser::PrepareBody() {
+  bool has_transfer_encoding = false;
+  bool has_content_length = false;
+  uint64_t content_length = 0;
+  for (const HttpRequest::HeaderSpan& span : request_.headers_) {
+    std::string_view name = request_.View(span.name);
+    std::string_view value = request_.View(span.value);
+    if (EqualsIgnoreCase(name, "Transfer-Encoding")) {
+      // 只支持 chunked, 其他的传输编码无法确定请求体的边界
+      if (has_transfer_encoding || !EqualsIgnoreCase(value, "chunked")) {
+        Fail(Error::kNotImplemented);
+        return false;
+      }
+      has_transfer_encoding = true;
+    } else if (EqualsIgnoreCase(name, "Content-Length")) {
+      if (value.empty() || value.size() > 19) {
+        Fail(Error::kBadRequest);
+        return false;
+      }
+      uint64_t length = 0;
+      for (char c : value) {
+        if (!IsDigit(c)) {
+          Fail(Error::kBadRequest);
+          return false;
+        }
+        length = length * 10 + (c - '0');
+      }
+      if (has_content_length && length != content_length) {
+        Fail(Error::kBadRequest);
+        return false;
+      }
+      has_content_length = true;
+      content_length = length;
+    }
+  }
+
+  body_offset_ = pos_;
+  if (has_transfer_encoding) {
+    // 同时出现时两端对请求边界的理解可能不同, 按 RFC 9112 的建议直接拒绝
+    if (has_content_length || request_.version_minor_ == 0) {
+      Fail(Error::kBadRequest);
+      return false;
+    }
+    request_.chunked_ = true;
+    state_ = State::kChunkSize;
+    return true;
+  }
+  if (content_length > limits_.max_body_bytes) {
+    Fail(Error::kPayloadTooLarge);
+    return false;
+  }
+  body_remaining_ = content_length;
+  state_ = content_length > 0 ? State::kBody : State::kComplete;
+  return true;
+}
+
+bool HttpParser::ParseChunkSize(const char* line, const char* eol) {
+  // chunk-size [ chunk-ext ], chunk-ext 被忽略
+  const char* p = line;
+  uint64_t size = 0;
+  while (p < eol && HexValue(*p) >= 0) {
+    if (static_cast<size_t>(p - line) == kMaxChunkSizeDigits) {
+      Fail(Error::kPayloadTooLarge);
+      return false;
+    }
+    size = size * 16 + HexValue(*p);
+    ++p;
+  }
+  if (p == line) {
+    Fail(Error::kBadRequest);
+    return false;
+  }
+  while (p < eol && IsWhitespace(*p)) {
+    ++p;
+  }
+  if (p != eol && *p != ';') {
+    Fail(Error::kBadRequest);
+    return false;
+  }
+
+  if (size == 0) {
+    state_ = State::kTrailers;
+    return true;
+  }
+  if (chunked_body_.size() + size > limits_.max_body_bytes) {
+    Fail(Error::kPayloadTooLarge);
+    return false;
+  }
+  body_remaining_ = size;
+  state_ = State::kChunkData;
+  return true;
+}
+
+HttpParser::Result HttpParser::Fail(const Error error) {
+  error_ = error;
+  state_ = State::kError;
+  return Result::kError;
+}
+
+}  // namespace net
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "net/http/http_request.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class Buffer;
+
+// HttpParser 的各项上限, 超过时解析失败并给出对应的状态码
+struct HttpLimits {
+  // 请求行的最大长度, 超过时返回 414
+  size_t max_request_line = 8 * 1024;
+  // 请求头 (包括 chunked 的 trailer) 的最大总长度和最大个数, 超过时返回 431
+  size_t max_header_bytes = 64 * 1024;
+  size_t max_headers = 100;
+  // 请求体的最大长度, 超过时返回 413
+  size_t max_body_bytes = 8 * 1024 * 1024;
+};
+
+/**
+ * @brief 可以增量解析的 HTTP/1.1 请求解析器
+ *
+ * @note
+ *   1. 直接在 Buffer 的可读数据上解析, 数据不完整时返回 kIncomplete, 收到更多数据之后用同一个 Buffer 再次调用
+ *      Parse 即可, 已经解析过的行不会重新扫描. 两次调用之间调用方不能从 Buffer 中取走数据, 但是 Buffer
+ *      可以扩容, 因为解析器只记录相对于 Buffer::Peek() 的偏移
+ *   2. 按行解析, 行尾用 Buffer::SearchCRLF (SSE2) 查找, 请求头的值用 SSE2 检查控制字符
+ *   3. 返回 kComplete 之后, 请求占用了 Buffer 开头的 consumed_bytes() 字节, 调用方处理完 request() 之后
+ *      Retrieve 这些字节并调用 Reset, 然后可以继续解析 Buffer 中剩下的数据 (pipelining)
+ *   4. 支持 Content-Length 和 Transfer-Encoding: chunked 的请求体. 同时出现两者 (请求走私的常见手段)、
+ *      Content-Length 不合法或者多个值不一致时返回 400
+ *   5. 不是线程安全的, 每个连接一个
+ */
+class HttpParser {
+ public:
+  enum class Result {
+    kIncomplete = 0,
+    kComplete = 1,
+    kError = 2,
+  };
+
+  enum class Error {
+    kNone = 0,
+    kBadRequest = 1,
+    kUriTooLong = 2,
+    kHeaderTooLarge = 3,
+    kPayloadTooLarge = 4,
+    kNotImplemented = 5,
+    kVersionNotSupported = 6,
+  };
+
+ public:
+  explicit HttpParser(const HttpLimits& limits = HttpLimits());
+
+ public:
+  Result Parse(const Buffer& buffer);
+  // 准备解析下一个请求, 保留已经申请的内存
+  void Reset();
+
+ public:
+  const HttpRequest& request() const;
+  // 当前请求在 Buffer 中占用的字节数, 只在 kComplete 之后有意义
+  size_t consumed_bytes() const;
+  Error error() const;
+  // error 对应的 HTTP 状态码
+  static int ErrorToStatusCode(const Error error);
+  static const char* ErrorToString(const Error error);
+
+ private:
+  enum class State {
+    kRequestLine = 0,
+    kHeaders = 1,
+    kBody = 2,
+    kChunkSize = 3,
+    kChunkData = 4,
+    kChunkDataEnd = 5,
+    kTrailers = 6,
+    kComplete = 7,
+    kError = 8,
+  };
+
+ private:
+  /**
+   * @brief 从 pos_ 开始查找一行
+   * @param too_long 行的长度 (不包括 "\r\n") 超过 max_len 时置为 true
+   * @return const char* 行尾 '\r' 的位置, 数据不够或者行太长时返回 nullptr
+   */
+  const char* FindLine(const char* base, const char* end, const size_t max_len, bool* const too_long);
+  bool ParseRequestLine(const char* base, const char* line, const char* eol);
+  bool ParseHeaderLine(const char* base, const char* line, const char* eol);
+  // 请求头结束之后根据 Content-Length / Transfer-Encoding 决定如何读取请求体
+  bool PrepareBody();
+  bool ParseChunkSize(const char* line, const char* eol);
+  Result Fail(const Error error);
+
+ private:
+  const HttpLimits limits_;
+  State state_ = State::kRequestLine;
+  Error error_ = Error::kNone;
+  HttpRequest request_;
+  // 下一个待解析的字节相对于 Buffer::Peek() 的偏移
+  size_t pos_ = 0;
+  // 当前行已经查找过 "\r\n" 的位置, 避免数据不完整时重复扫描
+  size_t scan_pos_ = 0;
+  // 请求头和 trailer 的总长度
+  size_t header_bytes_ = 0;
+  // 请求体的起始偏移和剩余长度 (Content-Length 或者当前 chunk 剩余的长度)
+  size_t body_offset_ = 0;
+  size_t body_remaining_ = 0;
+  // chunked 解码后的请求体
+  std::string chunked_body_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HttpParser);
+};
+
+}  // namespace net
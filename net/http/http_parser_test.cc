@@ -0,0 +1,181 @@
+#include "net/http/http_parser.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/buffer.h"
+
+namespace net {
+
+TEST(HttpParserTest, request_line_and_headers) {
+  const std::string request =
+      "GET /index.html?a=1&b=2 HTTP/1.1\r\n"
+      "Host: example.com\r\n"
+      "User-Agent:curl/8.0 \r\n"
+      "Accept: \t*/*\r\n"
+      "X-Empty:\r\n"
+      "\r\n";
+  Buffer buffer;
+  buffer.Append(request);
+  HttpParser parser;
+  ASSERT_EQ(parser.Parse(buffer), HttpParser::Result::kComplete);
+  EXPECT_EQ(parser.consumed_bytes(), request.size());
+
+  const HttpRequest& req = parser.request();
+  EXPECT_EQ(req.method(), HttpMethod::kGet);
+  EXPECT_EQ(req.method_name(), "GET");
+  EXPECT_EQ(req.target(), "/index.html?a=1&b=2");
+  EXPECT_EQ(req.path(), "/index.html");
+  EXPECT_EQ(req.query(), "a=1&b=2");
+  EXPECT_EQ(req.version_minor(), 1);
+  ASSERT_EQ(req.header_num(), 4UL);
+  EXPECT_EQ(req.header(1).name, "User-Agent");
+  EXPECT_EQ(req.header(1).value, "curl/8.0");
+  EXPECT_EQ(req.GetHeader("host"), "example.com");
+  EXPECT_EQ(req.GetHeader("ACCEPT"), "*/*");
+  EXPECT_TRUE(req.HasHeader("x-empty"));
+  EXPECT_TRUE(req.GetHeader("x-empty").empty());
+  EXPECT_FALSE(req.HasHeader("Cookie"));
+  EXPECT_TRUE(req.body().empty());
+  // string_view 直接指向 Buffer 中的数据
+  EXPECT_EQ(req.GetHeader("Host").data(), buffer.Peek() + request.find("example.com"));
+}
+
+TEST(HttpParserTest, byte_by_byte) {
+  const std::string request =
+      "\r\nPOST /upload HTTP/1.0\r\n"
+      "Content-Length: 11\r\n"
+      "Content-Type: text/plain\r\n"
+      "\r\n"
+      "hello world";
+  Buffer buffer;
+  HttpParser parser;
+  for (size_t i = 0; i < request.size(); ++i) {
+    ASSERT_EQ(parser.Parse(buffer), HttpParser::Result::kIncomplete) << i;
+    buffer.Append(request.data() + i, 1);
+  }
+  ASSERT_EQ(parser.Parse(buffer), HttpParser::Result::kComplete);
+  const HttpRequest& req = parser.request();
+  EXPECT_EQ(req.method(), HttpMethod::kPost);
+  EXPECT_EQ(req.path(), "/upload");
+  EXPECT_TRUE(req.query().empty());
+  EXPECT_EQ(req.version_minor(), 0);
+  EXPECT_EQ(req.GetHeader("Content-Type"), "text/plain");
+  EXPECT_EQ(req.body(), "hello world");
+  EXPECT_EQ(parser.consumed_bytes(), request.size());
+}
+
+TEST(HttpParserTest, pipelined_requests) {
+  Buffer buffer;
+  buffer.Append(std::string("PUT /a HTTP/1.1\r\nContent-Length: 3\r\n\r\nabcGET /b HTTP/1.1\r\n\r\nDELETE /c HTT"));
+  HttpParser parser;
+  std::vector<std::string> paths;
+  while (parser.Parse(buffer) == HttpParser::Result::kComplete) {
+    paths.emplace_back(parser.request().path());
+    buffer.Retrieve(parser.consumed_bytes());
+    parser.Reset();
+  }
+  EXPECT_EQ(paths, std::vector<std::string>({"/a", "/b"}));
+
+  buffer.Append(std::string("P/1.1\r\n\r\n"));
+  ASSERT_EQ(parser.Parse(buffer), HttpParser::Result::kComplete);
+  EXPECT_EQ(parser.request().method(), HttpMethod::kDelete);
+  EXPECT_EQ(parser.request().path(), "/c");
+  EXPECT_EQ(parser.consumed_bytes(), buffer.ReadableBytes());
+}
+
+TEST(HttpParserTest, chunked_body) {
+  const std::string request =
+      "POST /stream HTTP/1.1\r\n"
+      "Transfer-Encoding: Chunked\r\n"
+      "\r\n"
+      "5;name=value\r\nhello\r\n"
+      "1\r\n \r\n"
+      "a \r\n0123456789\r\n"
+      "0\r\n"
+      "X-Checksum: 42\r\n"
+      "\r\n";
+  // 分成大小不同的片段, 覆盖各个状态中数据不完整的情况
+  for (size_t step : {1UL, 3UL, 7UL, request.size()}) {
+    Buffer buffer;
+    HttpParser parser;
+    HttpParser::Result result = HttpParser::Result::kIncomplete;
+    for (size_t i = 0; i < request.size(); i += step) {
+      ASSERT_EQ(result, HttpParser::Result::kIncomplete);
+      buffer.Append(request.substr(i, step));
+      result = parser.Parse(buffer);
+    }
+    ASSERT_EQ(result, HttpParser::Result::kComplete) << step;
+    EXPECT_TRUE(parser.request().chunked());
+    EXPECT_EQ(parser.request().body(), "hello 0123456789");
+    EXPECT_FALSE(parser.request().HasHeader("X-Checksum"));
+    EXPECT_EQ(parser.consumed_bytes(), request.size());
+  }
+}
+
+TEST(HttpParserTest, buffer_reallocation) {
+  // 两次 Parse 之间 Buffer 扩容, 之前记录的偏移仍然有效
+  Buffer buffer(16);
+  HttpParser parser;
+  buffer.Append(std::string("GET /x HTTP/1.1\r\nHost: a\r\n"));
+  ASSERT_EQ(parser.Parse(buffer), HttpParser::Result::kIncomplete);
+  const char* old_peek = buffer.Peek();
+  std::string long_value(30000, 'v');
+  buffer.Append("Cookie: " + long_value + "\r\n\r\n");
+  EXPECT_NE(buffer.Peek(), old_peek);
+  ASSERT_EQ(parser.Parse(buffer), HttpParser::Result::kComplete);
+  EXPECT_EQ(parser.request().path(), "/x");
+  EXPECT_EQ(parser.request().GetHeader("Host"), "a");
+  EXPECT_EQ(parser.request().GetHeader("Cookie"), long_value);
+}
+
+TEST(HttpParserTest, errors) {
+  struct Case {
+    std::string request;
+    HttpParser::Error error;
+  };
+  HttpLimits limits;
+  limits.max_request_line = 64;
+  limits.max_header_bytes = 256;
+  limits.max_headers = 4;
+  limits.max_body_bytes = 16;
+  const std::vector<Case> cases = {
+      {"GET\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"GET / HTTP/1.1 \r\n\r\n", HttpParser::Error::kBadRequest},
+      {"G(T / HTTP/1.1\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"GET / HTTP/2.0\r\n\r\n", HttpParser::Error::kVersionNotSupported},
+      {"GET / FTP/1.1\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"GET /" + std::string(100, 'a') + " HTTP/1.1\r\n\r\n", HttpParser::Error::kUriTooLong},
+      {"GET /" + std::string(100, 'a'), HttpParser::Error::kUriTooLong},
+      {"GET / HTTP/1.1\r\nHost : a\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"GET / HTTP/1.1\r\nHost: a\r\n folded\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"GET / HTTP/1.1\r\nHost: a\x01 b\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"GET / HTTP/1.1\r\nX-Long: " + std::string(300, 'x') + "\r\n\r\n", HttpParser::Error::kHeaderTooLarge},
+      {"GET / HTTP/1.1\r\na: 1\r\nb: 2\r\nc: 3\r\nd: 4\r\ne: 5\r\n\r\n", HttpParser::Error::kHeaderTooLarge},
+      {"POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"POST / HTTP/1.1\r\nContent-Length: 17\r\n\r\n", HttpParser::Error::kPayloadTooLarge},
+      {"POST / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"POST / HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n\r\n", HttpParser::Error::kNotImplemented},
+      {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"POST / HTTP/1.0\r\nTransfer-Encoding: chunked\r\n\r\n", HttpParser::Error::kBadRequest},
+      {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", HttpParser::Error::kBadRequest},
+      {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcX", HttpParser::Error::kBadRequest},
+      {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n11\r\n", HttpParser::Error::kPayloadTooLarge},
+      {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nffffffffffffffff\r\n",
+       HttpParser::Error::kPayloadTooLarge},
+  };
+  for (const Case& c : cases) {
+    Buffer buffer;
+    buffer.Append(c.request);
+    HttpParser parser(limits);
+    EXPECT_EQ(parser.Parse(buffer), HttpParser::Result::kError) << c.request;
+    EXPECT_EQ(parser.error(), c.error) << c.request;
+    // 出错之后再次调用仍然返回错误
+    EXPECT_EQ(parser.Parse(buffer), HttpParser::Result::kError);
+  }
+  EXPECT_EQ(HttpParser::ErrorToStatusCode(HttpParser::Error::kHeaderTooLarge), 431);
+}
+
+}  // namespace net
@@ -0,0 +1,118 @@
+#include "net/http/http_range.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "net/http/http_request.h"
+
+namespace net {
+
+namespace {
+
+std::string_view Trim(std::string_view text) {
+  size_t begin = text.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    return std::string_view();
+  }
+  return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+// 解析非空的十进制数, 溢出时返回 false
+bool ParseNumber(std::string_view text, size_t* const value) {
+  if (text.empty()) {
+    return false;
+  }
+  *value = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    size_t digit = static_cast<size_t>(c - '0');
+    if (*value > (std::numeric_limits<size_t>::max() - digit) / 10) {
+      return false;
+    }
+    *value = *value * 10 + digit;
+  }
+  return true;
+}
+
+}  // namespace
+
+RangeResult ParseRange(std::string_view value, const size_t size, std::vector<ByteRange>* const ranges,
+                       const size_t max_ranges) {
+  ranges->clear();
+  value = Trim(value);
+  constexpr std::string_view kUnit = "bytes=";
+  if (value.size() < kUnit.size() || !EqualsIgnoreCase(value.substr(0, kUnit.size()), kUnit)) {
+    return RangeResult::kIgnored;
+  }
+  value.remove_prefix(kUnit.size());
+
+  bool has_range = false;
+  while (!value.empty()) {
+    size_t comma = value.find(',');
+    std::string_view spec = Trim(value.substr(0, comma));
+    value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+    if (spec.empty()) {
+      // 允许空的列表元素, 例如 "bytes=0-1,,5-6"
+      continue;
+    }
+    size_t dash = spec.find('-');
+    if (dash == std::string_view::npos) {
+      return RangeResult::kIgnored;
+    }
+    has_range = true;
+
+    size_t first = 0;
+    size_t last = 0;
+    if (dash == 0) {
+      // 后缀范围 "-n": 最后 n 个字节
+      if (!ParseNumber(spec.substr(1), &last)) {
+        return RangeResult::kIgnored;
+      }
+      if (last > 0 && size > 0) {
+        size_t len = std::min(last, size);
+        ranges->push_back({size - len, len});
+      }
+      continue;
+    }
+    if (!ParseNumber(spec.substr(0, dash), &first)) {
+      return RangeResult::kIgnored;
+    }
+    if (dash + 1 == spec.size()) {
+      last = size == 0 ? 0 : size - 1;
+    } else if (!ParseNumber(spec.substr(dash + 1), &last) || last < first) {
+      return RangeResult::kIgnored;
+    }
+    if (first < size) {
+      ranges->push_back({first, std::min(last, size - 1) - first + 1});
+    }
+  }
+  if (!has_range) {
+    return RangeResult::kIgnored;
+  }
+  if (ranges->empty()) {
+    return RangeResult::kNotSatisfiable;
+  }
+
+  std::sort(ranges->begin(), ranges->end(),
+            [](const ByteRange& a, const ByteRange& b) { return a.offset < b.offset; });
+  size_t merged = 0;
+  for (size_t i = 1; i < ranges->size(); ++i) {
+    ByteRange& last = (*ranges)[merged];
+    const ByteRange& range = (*ranges)[i];
+    if (range.offset <= last.offset + last.len) {
+      last.len = std::max(last.offset + last.len, range.offset + range.len) - last.offset;
+    } else {
+      (*ranges)[++merged] = range;
+    }
+  }
+  ranges->resize(merged + 1);
+  if (ranges->size() > max_ranges) {
+    ranges->clear();
+    return RangeResult::kIgnored;
+  }
+  return RangeResult::kSatisfiable;
+}
+
+}  // namespace net
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace net {
+
+// 文件中 [offset, offset + len) 的一段
+struct ByteRange {
+  size_t offset = 0;
+  size_t len = 0;
+};
+
+enum class RangeResult {
+  // 没有 Range、单位不是 bytes、语法错误或者范围太多, 按照没有 Range 处理, 回复整个文件
+  kIgnored,
+  // 至少有一个范围可以满足, 回复 206
+  kSatisfiable,
+  // 所有范围都超出了文件大小, 回复 416
+  kNotSatisfiable,
+};
+
+/**
+ * @brief 解析 Range 请求头, 例如 "bytes=0-499, 1000-, -200"
+ *
+ * @param value Range 请求头的值
+ * @param size 文件大小
+ * @param ranges 可以满足的范围, 按 offset 排序, 重叠或者相邻的范围会被合并, 避免客户端用大量重叠的小范围放大响应
+ * @param max_ranges 合并之后超过这个数量时忽略 Range
+ * @return RangeResult
+ */
+RangeResult ParseRange(std::string_view value, const size_t size, std::vector<ByteRange>* const ranges,
+                       const size_t max_ranges = 16);
+
+}  // namespace net
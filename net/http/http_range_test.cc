@@ -0,0 +1,81 @@
+#include "net/http/http_range.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// 把解析结果转换成 "offset+len,offset+len" 方便比较
+std::string Format(const std::vector<ByteRange>& ranges) {
+  std::string text;
+  for (const ByteRange& range : ranges) {
+    if (!text.empty()) {
+      text += ",";
+    }
+    text += std::to_string(range.offset) + "+" + std::to_string(range.len);
+  }
+  return text;
+}
+
+}  // namespace
+
+TEST(HttpRangeTest, satisfiable) {
+  struct {
+    const char* value;
+    const char* ranges;
+  } const kCases[] = {
+      {"bytes=0-499", "0+500"},
+      {"bytes=500-999", "500+500"},
+      {"bytes=9500-", "9500+500"},
+      {"bytes=-500", "9500+500"},
+      {"bytes=-20000", "0+10000"},
+      {"bytes=9990-20000", "9990+10"},
+      {"BYTES = 0-0", ""},
+      {"Bytes=0-0, -1", "0+1,9999+1"},
+      {"bytes=500-600,601-999", "500+500"},
+      {"bytes=500-700,601-999", "500+500"},
+      {"bytes=900-999, 0-9", "0+10,900+100"},
+      {"bytes=0-1,,5-6", "0+2,5+2"},
+      {"bytes=0-1, 20000-", "0+2"},
+  };
+  std::vector<ByteRange> ranges;
+  for (const auto& test_case : kCases) {
+    RangeResult result = ParseRange(test_case.value, 10000, &ranges);
+    if (test_case.ranges[0] == '\0') {
+      EXPECT_EQ(result, RangeResult::kIgnored) << test_case.value;
+      continue;
+    }
+    EXPECT_EQ(result, RangeResult::kSatisfiable) << test_case.value;
+    EXPECT_EQ(Format(ranges), test_case.ranges) << test_case.value;
+  }
+}
+
+TEST(HttpRangeTest, ignored_and_not_satisfiable) {
+  std::vector<ByteRange> ranges;
+  for (const char* value : {"", "items=0-1", "bytes=", "bytes=,", "bytes=1", "bytes=5-1", "bytes=a-b", "bytes=--1",
+                            "bytes=0-1x", "bytes=99999999999999999999999-"}) {
+    EXPECT_EQ(ParseRange(value, 100, &ranges), RangeResult::kIgnored) << value;
+    EXPECT_TRUE(ranges.empty());
+  }
+  for (const char* value : {"bytes=100-", "bytes=100-200, 300-", "bytes=-0"}) {
+    EXPECT_EQ(ParseRange(value, 100, &ranges), RangeResult::kNotSatisfiable) << value;
+  }
+  // 空文件没有可以满足的范围
+  EXPECT_EQ(ParseRange("bytes=0-", 0, &ranges), RangeResult::kNotSatisfiable);
+  EXPECT_EQ(ParseRange("bytes=-5", 0, &ranges), RangeResult::kNotSatisfiable);
+
+  // 合并之后的范围数量超过上限
+  std::string many = "bytes=0-0";
+  for (int i = 1; i < 20; ++i) {
+    many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+  }
+  EXPECT_EQ(ParseRange(many, 100, &ranges, 16), RangeResult::kIgnored);
+  EXPECT_EQ(ParseRange(many, 100, &ranges, 20), RangeResult::kSatisfiable);
+  EXPECT_EQ(ranges.size(), 20u);
+}
+
+}  // namespace net
@@ -0,0 +1,155 @@
+#include "net/http/http_request.h"
+
+#include "logger/log.h"
+
+namespace net {
+
+HttpMethod HttpRequest::method() const {
+  return method_;
+}
+
+std::string_view HttpRequest::method_name() const {
+  return View(method_name_);
+}
+
+std::string_view HttpRequest::target() const {
+  return View(target_);
+}
+
+std::string_view HttpRequest::path() const {
+  return target().substr(0, query_pos_);
+}
+
+std::string_view HttpRequest::query() const {
+  std::string_view target = this->target();
+  return query_pos_ < target.size() ? target.substr(query_pos_ + 1) : std::string_view();
+}
+
+int HttpRequest::version_minor() const {
+  return version_minor_;
+}
+
+size_t HttpRequest::header_num() const {
+  return headers_.size();
+}
+
+HttpHeader HttpRequest::header(const size_t index) const {
+  CHECK_LT(index, headers_.size());
+  return {View(headers_[index].name), View(headers_[index].value)};
+}
+
+std::string_view HttpRequest::GetHeader(std::string_view name) const {
+  for (const HeaderSpan& header : headers_) {
+    if (header.name.len == name.size() && EqualsIgnoreCase(View(header.name), name)) {
+      return View(header.value);
+    }
+  }
+  return std::string_view();
+}
+
+bool HttpRequest::HasHeader(std::string_view name) const {
+  for (const HeaderSpan& header : headers_) {
+    if (header.name.len == name.size() && EqualsIgnoreCase(View(header.name), name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string_view HttpRequest::body() const {
+  return body_;
+}
+
+bool HttpRequest::chunked() const {
+  return chunked_;
+}
+
+bool HttpRequest::KeepAlive() const {
+  std::string_view connection = GetHeader("Connection");
+  if (version_minor_ >= 1) {
+    return !HasToken(connection, "close");
+  }
+  return HasToken(connection, "keep-alive");
+}
+
+void HttpRequest::Clear() {
+  base_ = nullptr;
+  method_ = HttpMethod::kUnknown;
+  method_name_ = Span();
+  target_ = Span();
+  query_pos_ = 0;
+  version_minor_ = 1;
+  headers_.clear();
+  body_ = std::string_view();
+  chunked_ = false;
+}
+
+std::string_view HttpRequest::View(const Span& span) const {
+  return span.len == 0 ? std::string_view() : std::string_view(base_ + span.offset, span.len);
+}
+
+const char* HttpMethodToString(const HttpMethod method) {
+  switch (method) {
+    case HttpMethod::kGet:
+      return "GET";
+    case HttpMethod::kHead:
+      return "HEAD";
+    case HttpMethod::kPost:
+      return "POST";
+    case HttpMethod::kPut:
+      return "PUT";
+    case HttpMethod::kDelete:
+      return "DELETE";
+    case HttpMethod::kOptions:
+      return "OPTIONS";
+    case HttpMethod::kPatch:
+      return "PATCH";
+    case HttpMethod::kConnect:
+      return "CONNECT";
+    case HttpMethod::kTrace:
+      return "TRACE";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    // 'A' ^ 'a' == 0x20, 只在两边都是字母时才允许这一位不同
+    unsigned char x = static_cast<unsigned char>(a[i]);
+    unsigned char y = static_cast<unsigned char>(b[i]);
+    if (x != y) {
+      unsigned char lower = x | 0x20;
+      if ((x ^ y) != 0x20 || lower < 'a' || lower > 'z') {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool HasToken(std::string_view list, std::string_view token) {
+  while (!list.empty()) {
+    size_t comma = list.find(',');
+    std::string_view item = list.substr(0, comma);
+    while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+      item.remove_prefix(1);
+    }
+    while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+      item.remove_suffix(1);
+    }
+    if (EqualsIgnoreCase(item, token)) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+  return false;
+}
+
+}  // namespace net
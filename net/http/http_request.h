@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "util/macros/macros.h"
+
+namespace net {
+
+class HttpParser;
+
+enum class HttpMethod {
+  kUnknown = 0,
+  kGet = 1,
+  kHead = 2,
+  kPost = 3,
+  kPut = 4,
+  kDelete = 5,
+  kOptions = 6,
+  kPatch = 7,
+  kConnect = 8,
+  kTrace = 9,
+};
+
+struct HttpHeader {
+  std::string_view name;
+  std::string_view value;
+};
+
+/**
+ * @brief HttpParser 解析出的一个 HTTP 请求
+ *
+ * @note
+ *   1. 请求行和请求头只记录在 Buffer 中的偏移, 访问时再拼成 string_view, 不为每个请求头分配 std::string.
+ *      因此只有在 HttpParser::Parse 返回 kComplete 之后、从 Buffer 中取走这个请求之前可以访问
+ *   2. Content-Length 的请求体同样指向 Buffer; chunked 的请求体解码到 HttpParser 持有的内存中,
+ *      在下一次 Parse 之前有效
+ *   3. 对象在多个请求之间复用, headers 的容量不会释放, 稳定之后解析请求不再申请内存
+ */
+class HttpRequest {
+ public:
+  HttpRequest() = default;
+
+ public:
+  HttpMethod method() const;
+  // 请求方法的原文, 包括不认识的方法
+  std::string_view method_name() const;
+  // 请求行中的 request-target, 例如 "/index.html?a=1"
+  std::string_view target() const;
+  // target 中 '?' 之前的部分
+  std::string_view path() const;
+  // target 中 '?' 之后的部分, 不包括 '?'
+  std::string_view query() const;
+  // HTTP/1.x 中的 x
+  int version_minor() const;
+
+  size_t header_num() const;
+  HttpHeader header(const size_t index) const;
+  // 按名字查找请求头 (大小写不敏感), 没有时返回空的 string_view
+  std::string_view GetHeader(std::string_view name) const;
+  bool HasHeader(std::string_view name) const;
+
+  std::string_view body() const;
+  bool chunked() const;
+  // 是否保持连接: HTTP/1.1 默认保持, 除非 Connection 中有 close; HTTP/1.0 需要 Connection 中有 keep-alive
+  bool KeepAlive() const;
+
+ private:
+  // 相对于 Buffer::Peek() 的一段数据
+  struct Span {
+    uint32_t offset = 0;
+    uint32_t len = 0;
+  };
+  struct HeaderSpan {
+    Span name;
+    Span value;
+  };
+
+ private:
+  void Clear();
+  std::string_view View(const Span& span) const;
+
+ private:
+  friend class HttpParser;
+
+  const char* base_ = nullptr;
+  HttpMethod method_ = HttpMethod::kUnknown;
+  Span method_name_;
+  Span target_;
+  // target_ 中 '?' 的位置, 没有时等于 target_.len
+  uint32_t query_pos_ = 0;
+  int version_minor_ = 1;
+  std::vector<HeaderSpan> headers_;
+  std::string_view body_;
+  bool chunked_ = false;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HttpRequest);
+};
+
+const char* HttpMethodToString(const HttpMethod method);
+// 只比较 ASCII 字母的大小写, 用于请求头名字等
+bool EqualsIgnoreCase(std::string_view a, std::string_view b);
+// 逗号分隔的列表 (例如 "keep-alive, Upgrade") 中是否有 token, 大小写不敏感
+bool HasToken(std::string_view list, std::string_view token);
+
+}  // namespace net
@@ -0,0 +1,307 @@
+#include "net/http/http_response.h"
+
+#include <cstdio>
+
+#include "logger/log.h"
+#include "net/buffer.h"
+#include "net/file.h"
+#include "net/http/http_request.h"
+#include "net/http/http_stream.h"
+#include "net/http/websocket_codec.h"
+#include "net/http/websocket_connection.h"
+#include "net/tcp_connection.h"
+
+namespace net {
+
+HttpResponse::HttpResponse(const bool close_connection)
+    : status_message_(HttpStatusReason(200)), close_connection_(close_connection) {}
+
+void HttpResponse::SetStatusCode(const int status_code) {
+  status_code_ = status_code;
+  status_message_ = HttpStatusReason(status_code);
+}
+
+void HttpResponse::SetStatusMessage(std::string_view message) {
+  status_message_ = message;
+}
+
+void HttpResponse::SetContentType(std::string_view content_type) {
+  AddHeader("Content-Type", content_type);
+}
+
+void HttpResponse::AddHeader(std::string_view name, std::string_view value) {
+  headers_.emplace_back(name, value);
+}
+
+void HttpResponse::SetBody(std::string body) {
+  body_ = std::move(body);
+}
+
+void HttpResponse::SetCloseConnection(const bool on) {
+  close_connection_ = on;
+}
+
+void HttpResponse::SetKeepAliveHeader(const bool on) {
+  keep_alive_header_ = on;
+}
+
+void HttpResponse::AddBody(std::string data) {
+  segments_.emplace_back();
+  segments_.back().data = std::move(data);
+}
+
+void HttpResponse::AddSharedBody(std::shared_ptr<const void> holder, std::string_view data) {
+  segments_.emplace_back();
+  segments_.back().holder = std::move(holder);
+  segments_.back().shared = data;
+  zero_copy_body_ = true;
+}
+
+void HttpResponse::AddFileBody(std::shared_ptr<const File> file, const off_t offset, const size_t len) {
+  segments_.emplace_back();
+  segments_.back().file = std::move(file);
+  segments_.back().file_offset = offset;
+  segments_.back().file_len = len;
+  zero_copy_body_ = true;
+}
+
+void HttpResponse::SetPreformatted(std::shared_ptr<const void> holder, std::string_view message,
+                                   const size_t header_bytes) {
+  CHECK(message.compare(header_bytes, 2, "\r\n") == 0) << "preformatted header must be followed by an empty line";
+  preformatted_holder_ = std::move(holder);
+  preformatted_ = message;
+  preformatted_header_bytes_ = header_bytes;
+}
+
+std::shared_ptr<HttpStream> HttpResponse::StartStream() {
+  CHECK(BodyBytes() == 0 && preformatted_holder_ == nullptr) << "stream response can not have other body";
+  if (stream_ == nullptr) {
+    stream_ = std::make_shared<HttpStream>();
+  }
+  return stream_;
+}
+
+std::shared_ptr<WebSocketConnection> HttpResponse::UpgradeToWebSocket(const HttpRequest& request) {
+  CHECK(BodyBytes() == 0 && preformatted_holder_ == nullptr && stream_ == nullptr)
+      << "websocket upgrade response can not have body";
+  // 16 字节随机数的 base64 总是 24 个字符
+  std::string_view key = request.GetHeader("Sec-WebSocket-Key");
+  if (request.method() != HttpMethod::kGet || request.version_minor() < 1 ||
+      !HasToken(request.GetHeader("Upgrade"), "websocket") || !HasToken(request.GetHeader("Connection"), "upgrade") ||
+      key.size() != 24) {
+    SetStatusCode(400);
+    return nullptr;
+  }
+  if (request.GetHeader("Sec-WebSocket-Version") != "13") {
+    SetStatusCode(426);
+    AddHeader("Sec-WebSocket-Version", "13");
+    return nullptr;
+  }
+  SetStatusCode(101);
+  AddHeader("Upgrade", "websocket");
+  AddHeader("Connection", "Upgrade");
+  AddHeader("Sec-WebSocket-Accept", WebSocketAcceptKey(key));
+  SetCloseConnection(false);
+  if (websocket_ == nullptr) {
+    websocket_ = std::make_shared<WebSocketConnection>();
+  }
+  return websocket_;
+}
+
+void HttpResponse::AppendToBuffer(Buffer* const output, const bool with_body) const {
+  CHECK(!zero_copy_body_ && preformatted_holder_ == nullptr && stream_ == nullptr)
+      << "use SendTo for zero-copy, preformatted or stream response";
+  AppendHeaders(output, BodyBytes());
+  if (with_body) {
+    output->Append(body_);
+    for (const BodySegment& segment : segments_) {
+      output->Append(segment.data);
+    }
+  }
+}
+
+void HttpResponse::SendTo(TcpConnection* const conn, Buffer* const output, const bool with_body) const {
+  if (preformatted_holder_ != nullptr) {
+    const char* message = preformatted_.data();
+    const size_t header_bytes = preformatted_header_bytes_;
+    // 空行之后的部分
+    const size_t tail_bytes = with_body ? preformatted_.size() - header_bytes : 2;
+    if (output->ReadableBytes() > 0) {
+      conn->Send(output);
+    }
+    if (headers_.empty() && !close_connection_ && !keep_alive_header_) {
+      // 最常见的情况, 整个响应是一段共享内存
+      conn->Send(preformatted_holder_, message, header_bytes + tail_bytes);
+      return;
+    }
+    conn->Send(preformatted_holder_, message, header_bytes);
+    AppendHeaderLines(output);
+    AppendConnectionHeader(output);
+    output->Append("\r\n", 2);
+    if (tail_bytes > 2) {
+      conn->Send(output);
+      conn->Send(preformatted_holder_, message + header_bytes + 2, tail_bytes - 2);
+    }
+    return;
+  }
+
+  AppendHeaders(output, BodyBytes());
+  // 流式响应的响应体由 HttpStream 发送
+  if (!with_body || stream_ != nullptr) {
+    return;
+  }
+  output->Append(body_);
+  for (const BodySegment& segment : segments_) {
+    if (segment.holder == nullptr && segment.file == nullptr) {
+      output->Append(segment.data);
+      continue;
+    }
+    // 共享内存和文件之前的数据先交给连接, 保持顺序
+    if (output->ReadableBytes() > 0) {
+      conn->Send(output);
+    }
+    if (segment.file != nullptr) {
+      conn->SendFile(segment.file, segment.file_offset, segment.file_len);
+    } else {
+      conn->Send(segment.holder, segment.shared.data(), segment.shared.size());
+    }
+  }
+}
+
+int HttpResponse::status_code() const {
+  return status_code_;
+}
+
+std::string_view HttpResponse::GetHeader(std::string_view name) const {
+  for (const auto& header : headers_) {
+    if (EqualsIgnoreCase(header.first, name)) {
+      return header.second;
+    }
+  }
+  return std::string_view();
+}
+
+const std::string& HttpResponse::body() const {
+  return body_;
+}
+
+bool HttpResponse::close_connection() const {
+  return close_connection_;
+}
+
+const std::shared_ptr<HttpStream>& HttpResponse::stream() const {
+  return stream_;
+}
+
+const std::shared_ptr<WebSocketConnection>& HttpResponse::websocket() const {
+  return websocket_;
+}
+
+size_t HttpResponse::BodyBytes() const {
+  size_t bytes = body_.size();
+  for (const BodySegment& segment : segments_) {
+    if (segment.file != nullptr) {
+      bytes += segment.file_len;
+    } else if (segment.holder != nullptr) {
+      bytes += segment.shared.size();
+    } else {
+      bytes += segment.data.size();
+    }
+  }
+  return bytes;
+}
+
+void HttpResponse::AppendHeaders(Buffer* const output, const size_t content_length) const {
+  char line[64];
+  int n = std::snprintf(line, sizeof line, "HTTP/1.1 %d ", status_code_);
+  output->Append(line, n);
+  output->Append(status_message_);
+  output->Append("\r\n", 2);
+  AppendHeaderLines(output);
+  if (stream_ != nullptr) {
+    if (stream_->chunked()) {
+      output->Append(std::string_view("Transfer-Encoding: chunked\r\n"));
+    }
+  } else if (status_code_ >= 200 && status_code_ != 204 && status_code_ != 304) {
+    n = std::snprintf(line, sizeof line, "Content-Length: %zu\r\n", content_length);
+    output->Append(line, n);
+  }
+  AppendConnectionHeader(output);
+  output->Append("\r\n", 2);
+}
+
+void HttpResponse::AppendHeaderLines(Buffer* const output) const {
+  for (const std::pair<std::string, std::string>& header : headers_) {
+    output->Append(header.first);
+    output->Append(": ", 2);
+    output->Append(header.second);
+    output->Append("\r\n", 2);
+  }
+}
+
+void HttpResponse::AppendConnectionHeader(Buffer* const output) const {
+  if (close_connection_) {
+    output->Append(std::string_view("Connection: close\r\n"));
+  } else if (keep_alive_header_) {
+    output->Append(std::string_view("Connection: keep-alive\r\n"));
+  }
+}
+
+const char* HttpStatusReason(const int status_code) {
+  switch (status_code) {
+    case 100:
+      return "Continue";
+    case 101:
+      return "Switching Protocols";
+    case 200:
+      return "OK";
+    case 201:
+      return "Created";
+    case 204:
+      return "No Content";
+    case 206:
+      return "Partial Content";
+    case 301:
+      return "Moved Permanently";
+    case 302:
+      return "Found";
+    case 304:
+      return "Not Modified";
+    case 400:
+      return "Bad Request";
+    case 403:
+      return "Forbidden";
+    case 404:
+      return "Not Found";
+    case 405:
+      return "Method Not Allowed";
+    case 408:
+      return "Request Timeout";
+    case 411:
+      return "Length Required";
+    case 412:
+      return "Precondition Failed";
+    case 413:
+      return "Payload Too Large";
+    case 414:
+      return "URI Too Long";
+    case 416:
+      return "Range Not Satisfiable";
+    case 426:
+      return "Upgrade Required";
+    case 431:
+      return "Request Header Fields Too Large";
+    case 500:
+      return "Internal Server Error";
+    case 501:
+      return "Not Implemented";
+    case 503:
+      return "Service Unavailable";
+    case 505:
+      return "HTTP Version Not Supported";
+    default:
+      return "Unknown";
+  }
+}
+
+}  // namespace net
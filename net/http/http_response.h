@@ -0,0 +1,137 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+class Buffer;
+class File;
+class HttpRequest;
+class HttpStream;
+class TcpConnection;
+class WebSocketConnection;
+
+/**
+ * @brief HTTP 响应, 由 HttpServer 的回调填充之后序列化到连接的输出缓冲区
+ *
+ * @note
+ *   1. Content-Length 和 Connection 由 AppendToBuffer 根据 body 和最终的 close_connection 生成, 不需要手动添加;
+ *      1xx、204 和 304 响应没有响应体, 不生成 Content-Length
+ *   2. 响应体依次由 SetBody 设置的字符串和 AddBody / AddSharedBody / AddFileBody 追加的各段组成, 共享内存和文件
+ *      不经过拷贝, 文件用 sendfile 发送; 也可以把整个响应预先格式化好, 放在共享的只读内存中 (SetPreformatted).
+ *      带有共享内存或者文件的响应需要用 SendTo 发送
+ *   3. 响应体也可以是流式的 (StartStream), 由 HttpServer 把 HttpStream 绑定到连接上
+ *   4. UpgradeToWebSocket 把响应变成 WebSocket 握手的 101 响应, HttpServer 发送之后把连接交给 WebSocketConnection
+ */
+class HttpResponse {
+ public:
+  explicit HttpResponse(const bool close_connection);
+
+ public:
+  // 同时设置默认的原因短语
+  void SetStatusCode(const int status_code);
+  void SetStatusMessage(std::string_view message);
+  void SetContentType(std::string_view content_type);
+  void AddHeader(std::string_view name, std::string_view value);
+  void SetBody(std::string body);
+  void SetCloseConnection(const bool on);
+  // HTTP/1.0 默认不保持连接, 保持连接时需要 Connection: keep-alive. 由 HttpServer 根据请求设置, 关闭连接时不生效
+  void SetKeepAliveHeader(const bool on);
+  // 在响应体末尾追加一段数据
+  void AddBody(std::string data);
+  // 在响应体末尾追加一段共享的只读数据, holder 保证 data 在发送完之前有效
+  void AddSharedBody(std::shared_ptr<const void> holder, std::string_view data);
+  // 在响应体末尾追加文件中 [offset, offset + len) 的内容, 用 sendfile 发送
+  void AddFileBody(std::shared_ptr<const File> file, const off_t offset, const size_t len);
+  /**
+   * @brief 使用预先格式化好的完整响应, 状态码、响应头和响应体都不再生效
+   * @param holder 保证 message 在发送完之前有效
+   * @param message 完整的响应, 不包含 Connection
+   * @param header_bytes 状态行和响应头的长度, 不包含结束的空行, 之后紧跟着 "\r\n" 和响应体
+   * @note AddHeader 添加的响应头和 Connection 会插入到空行之前, 此时需要分三段发送
+   */
+  void SetPreformatted(std::shared_ptr<const void> holder, std::string_view message, const size_t header_bytes);
+  /**
+   * @brief 把响应变成流式响应: 响应头用 Transfer-Encoding: chunked 代替 Content-Length, 响应体通过返回的
+   *        HttpStream 在任何线程中写入, 见 HttpStream. 不能再设置其他响应体
+   */
+  std::shared_ptr<HttpStream> StartStream();
+  /**
+   * @brief 检查 request 是不是合法的 WebSocket 升级请求 (RFC 6455 4.2.1), 是则把响应变成 101 并返回新的连接,
+   *        否则把状态码设置为 400 (版本不是 13 时为 426) 并返回 nullptr. 不能再设置响应体
+   */
+  std::shared_ptr<WebSocketConnection> UpgradeToWebSocket(const HttpRequest& request);
+
+  /**
+   * @brief 把状态行、响应头和响应体追加到 output
+   * @param with_body HEAD 请求的响应只有响应头, Content-Length 仍然是响应体的长度
+   */
+  void AppendToBuffer(Buffer* const output, const bool with_body = true) const;
+
+  /**
+   * @brief 发送响应, 内存中的部分追加到 output, 遇到共享内存或者文件时先用 conn 发送 output 中的数据再发送它们,
+   *        以保持顺序. 没有共享内存和文件的响应和 AppendToBuffer 相同, 可以和其他响应合并发送
+   * @note 需要在 conn 所属的 IO 线程中调用
+   */
+  void SendTo(TcpConnection* const conn, Buffer* const output, const bool with_body = true) const;
+
+ public:
+  int status_code() const;
+  // 第一个名字为 name 的响应头 (大小写不敏感), 没有时返回空
+  std::string_view GetHeader(std::string_view name) const;
+  const std::string& body() const;
+  // 响应体的总长度, 包括 AddBody 等追加的各段
+  size_t BodyBytes() const;
+  bool close_connection() const;
+  // 不是流式响应时为空
+  const std::shared_ptr<HttpStream>& stream() const;
+  // 不是 WebSocket 升级响应时为空
+  const std::shared_ptr<WebSocketConnection>& websocket() const;
+
+ private:
+  // 响应体中 SetBody 之后的一段, file 和 holder 都为空时是 data
+  struct BodySegment {
+    std::string data;
+    std::shared_ptr<const void> holder;
+    std::string_view shared;
+    std::shared_ptr<const File> file;
+    off_t file_offset = 0;
+    size_t file_len = 0;
+  };
+
+ private:
+  // 追加状态行和响应头, 包括结束的空行
+  void AppendHeaders(Buffer* const output, const size_t content_length) const;
+  // 追加 AddHeader 添加的响应头
+  void AppendHeaderLines(Buffer* const output) const;
+  // 按 close_connection_ 和 keep_alive_header_ 追加 Connection, 不需要时什么都不追加
+  void AppendConnectionHeader(Buffer* const output) const;
+
+ private:
+  int status_code_ = 200;
+  std::string status_message_;
+  std::vector<std::pair<std::string, std::string>> headers_;
+  std::string body_;
+  bool close_connection_;
+  bool keep_alive_header_ = false;
+  std::vector<BodySegment> segments_;
+  // segments_ 中是否有共享内存或者文件
+  bool zero_copy_body_ = false;
+  std::shared_ptr<const void> preformatted_holder_;
+  std::string_view preformatted_;
+  size_t preformatted_header_bytes_ = 0;
+  std::shared_ptr<HttpStream> stream_;
+  std::shared_ptr<WebSocketConnection> websocket_;
+};
+
+// 常见状态码的原因短语, 不认识的状态码返回 "Unknown"
+const char* HttpStatusReason(const int status_code);
+
+}  // namespace net
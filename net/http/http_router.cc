@@ -0,0 +1,211 @@
+#include "net/http/http_router.h"
+
+#include <array>
+#include <utility>
+
+#include "logger/log.h"
+#include "net/http/http_response.h"
+
+namespace net {
+
+namespace {
+
+constexpr size_t kMethodNum = static_cast<size_t>(HttpMethod::kTrace) + 1;
+
+}  // namespace
+
+struct HttpRouter::Node {
+  // 静态节点的文本, 参数节点和通配节点为空
+  std::string prefix;
+  // 静态子节点的首字符, 和 children 一一对应
+  std::string indices;
+  std::vector<std::unique_ptr<Node>> children;
+  std::unique_ptr<Node> param_child;
+  std::unique_ptr<Node> wildcard_child;
+  // 参数节点和通配节点的参数名
+  std::string param_name;
+  // 各个方法对应的 handlers_ 下标, -1 表示没有
+  std::array<int, kMethodNum> handlers;
+
+  Node() {
+    handlers.fill(-1);
+  }
+};
+
+size_t HttpRouteParams::size() const {
+  return size_;
+}
+
+const HttpRouteParam& HttpRouteParams::operator[](const size_t index) const {
+  CHECK_LT(index, size_);
+  return params_[index];
+}
+
+std::string_view HttpRouteParams::Get(std::string_view name) const {
+  for (size_t i = 0; i < size_; ++i) {
+    if (params_[i].name == name) {
+      return params_[i].value;
+    }
+  }
+  return std::string_view();
+}
+
+HttpRouter::HttpRouter() : root_(std::make_unique<Node>()) {}
+
+HttpRouter::~HttpRouter() = default;
+
+void HttpRouter::Add(const HttpMethod method, std::string_view pattern, Handler handler) {
+  CHECK(method != HttpMethod::kUnknown);
+  CHECK(!pattern.empty() && pattern[0] == '/') << "route [" << pattern << "] must start with '/'";
+
+  Node* node = root_.get();
+  size_t param_num = 0;
+  std::string_view rest = pattern;
+  while (!rest.empty()) {
+    size_t special = rest.find_first_of(":*");
+    node = InsertStatic(node, rest.substr(0, special));
+    if (special == std::string_view::npos) {
+      break;
+    }
+    CHECK(special > 0 && rest[special - 1] == '/') << "route [" << pattern << "] param must be a whole segment";
+    size_t end = rest.find('/', special);
+    std::string_view name = rest.substr(special + 1, end == std::string_view::npos ? end : end - special - 1);
+    CHECK(!name.empty()) << "route [" << pattern << "] has an empty param name";
+    ++param_num;
+    CHECK_LE(param_num, HttpRouteParams::kMaxParams) << "route [" << pattern << "] has too many params";
+
+    std::unique_ptr<Node>& child = rest[special] == ':' ? node->param_child : node->wildcard_child;
+    if (child == nullptr) {
+      child = std::make_unique<Node>();
+      child->param_name = name;
+    }
+    CHECK(child->param_name == name) << "route [" << pattern << "] conflicts with param [" << child->param_name
+                                     << "]";
+    node = child.get();
+    if (rest[special] == '*') {
+      CHECK(end == std::string_view::npos) << "route [" << pattern << "] wildcard must be the last segment";
+      break;
+    }
+    rest = end == std::string_view::npos ? std::string_view() : rest.substr(end);
+  }
+
+  int& slot = node->handlers[static_cast<size_t>(method)];
+  CHECK_EQ(slot, -1) << "route [" << HttpMethodToString(method) << " " << pattern << "] already exists";
+  slot = static_cast<int>(handlers_.size());
+  handlers_.push_back(std::move(handler));
+}
+
+const HttpRouter::Handler* HttpRouter::Find(const HttpMethod method, std::string_view path,
+                                            HttpRouteParams* const params) const {
+  params->size_ = 0;
+  if (method == HttpMethod::kUnknown) {
+    return nullptr;
+  }
+  const Node* node = Match(root_.get(), path, method, params);
+  return node == nullptr ? nullptr : &handlers_[node->handlers[static_cast<size_t>(method)]];
+}
+
+bool HttpRouter::Dispatch(const HttpRequest& request, HttpResponse* const response) const {
+  HttpRouteParams params;
+  const Handler* handler = Find(request.method(), request.path(), &params);
+  if (handler == nullptr && request.method() == HttpMethod::kHead) {
+    // 没有单独注册 HEAD 时使用 GET 的处理函数, 响应体由 HttpServer 去掉
+    handler = Find(HttpMethod::kGet, request.path(), &params);
+  }
+  if (handler != nullptr) {
+    (*handler)(request, params, response);
+    return true;
+  }
+  // 换成任意方法再匹配一次, 区分 404 和 405
+  HttpRouteParams ignored;
+  response->SetStatusCode(Match(root_.get(), request.path(), HttpMethod::kUnknown, &ignored) == nullptr ? 404 : 405);
+  return false;
+}
+
+size_t HttpRouter::route_num() const {
+  return handlers_.size();
+}
+
+HttpRouter::Node* HttpRouter::InsertStatic(Node* node, std::string_view text) {
+  while (!text.empty()) {
+    size_t index = node->indices.find(text[0]);
+    if (index == std::string::npos) {
+      std::unique_ptr<Node> child = std::make_unique<Node>();
+      child->prefix = text;
+      node->indices.push_back(text[0]);
+      node->children.push_back(std::move(child));
+      return node->children.back().get();
+    }
+
+    std::unique_ptr<Node>& child = node->children[index];
+    size_t common = 0;
+    while (common < text.size() && common < child->prefix.size() && text[common] == child->prefix[common]) {
+      ++common;
+    }
+    if (common < child->prefix.size()) {
+      // 在公共前缀处拆分: child 变成新节点的子节点
+      std::unique_ptr<Node> split = std::make_unique<Node>();
+      split->prefix = child->prefix.substr(0, common);
+      child->prefix.erase(0, common);
+      split->indices.push_back(child->prefix[0]);
+      split->children.push_back(std::move(child));
+      child = std::move(split);
+    }
+    node = child.get();
+    text.remove_prefix(common);
+  }
+  return node;
+}
+
+const HttpRouter::Node* HttpRouter::Match(const Node* node, std::string_view path, const HttpMethod method,
+                                          HttpRouteParams* const params) {
+  if (path.empty() && HasHandler(node, method)) {
+    return node;
+  }
+
+  if (!path.empty()) {
+    size_t index = node->indices.find(path[0]);
+    if (index != std::string::npos) {
+      const Node* child = node->children[index].get();
+      if (path.compare(0, child->prefix.size(), child->prefix) == 0) {
+        const Node* result = Match(child, path.substr(child->prefix.size()), method, params);
+        if (result != nullptr) {
+          return result;
+        }
+      }
+    }
+  }
+
+  if (node->param_child != nullptr && params->size_ < HttpRouteParams::kMaxParams) {
+    std::string_view segment = path.substr(0, path.find('/'));
+    if (!segment.empty()) {
+      params->params_[params->size_++] = {node->param_child->param_name, segment};
+      const Node* result = Match(node->param_child.get(), path.substr(segment.size()), method, params);
+      if (result != nullptr) {
+        return result;
+      }
+      --params->size_;
+    }
+  }
+
+  const Node* wildcard = node->wildcard_child.get();
+  if (wildcard != nullptr && HasHandler(wildcard, method) && params->size_ < HttpRouteParams::kMaxParams) {
+    params->params_[params->size_++] = {wildcard->param_name, path};
+    return wildcard;
+  }
+  return nullptr;
+}
+
+bool HttpRouter::HasHandler(const Node* node, const HttpMethod method) {
+  if (method != HttpMethod::kUnknown) {
+    return node->handlers[static_cast<size_t>(method)] >= 0;
+  }
+  for (int handler : node->handlers) {
+    if (handler >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace net
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "net/http/http_request.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class HttpResponse;
+
+struct HttpRouteParam {
+  std::string_view name;
+  std::string_view value;
+};
+
+/**
+ * @brief 路由匹配得到的路径参数, 容量固定, 不申请内存
+ * @note name 指向 HttpRouter 中的路由, value 指向请求的 path
+ */
+class HttpRouteParams {
+ public:
+  static constexpr size_t kMaxParams = 8;
+
+ public:
+  size_t size() const;
+  const HttpRouteParam& operator[](const size_t index) const;
+  // 按名字查找, 没有时返回空的 string_view
+  std::string_view Get(std::string_view name) const;
+
+ private:
+  friend class HttpRouter;
+
+  HttpRouteParam params_[kMaxParams];
+  size_t size_ = 0;
+};
+
+/**
+ * @brief 按请求方法和 path 分发请求的路由表, 用压缩前缀树 (radix tree) 实现
+ *
+ * @note
+ *   1. 路由中的一个路径段可以是 ":name" (匹配一个非空的路径段) 或者 "*name" (匹配剩下的所有内容, 只能出现在最后),
+ *      例如 "/users/:id/posts"; "/static/" 后面接 "*filepath" 可以匹配目录下的任意文件
+ *   2. 优先级: 静态节点 > 参数节点 > 通配节点, 匹配失败时回溯, 例如 "/users/new" 和 "/users/:id" 可以共存
+ *   3. 查找的开销只和 path 的长度有关, 和路由的数量无关; 查找过程不申请内存, 参数以 string_view 的形式返回
+ *   4. 所有路由都需要在开始处理请求之前添加, 之后只读, 可以被多个 IO 线程同时使用
+ *   5. 固定的、没有参数的路由也可以用 StaticRouteTable 在编译期生成完美哈希表
+ */
+class HttpRouter {
+ public:
+  using Handler = std::function<void(const HttpRequest&, const HttpRouteParams&, HttpResponse*)>;
+
+ public:
+  HttpRouter();
+  ~HttpRouter();
+
+ public:
+  // pattern 不合法或者和已有的路由冲突时直接退出
+  void Add(const HttpMethod method, std::string_view pattern, Handler handler);
+
+  /**
+   * @brief 查找 method 和 path 对应的处理函数
+   * @return const Handler* 没有匹配的路由时返回 nullptr
+   */
+  const Handler* Find(const HttpMethod method, std::string_view path, HttpRouteParams* const params) const;
+
+  /**
+   * @brief 查找并调用处理函数, 没有匹配的路由时回复 404, path 匹配但是方法不匹配时回复 405
+   * @note HEAD 请求没有对应的路由时使用 GET 的路由
+   * @return bool 是否找到了路由
+   */
+  bool Dispatch(const HttpRequest& request, HttpResponse* const response) const;
+
+  size_t route_num() const;
+
+ private:
+  struct Node;
+
+ private:
+  // 插入一段静态文本, 返回文本结束处的节点
+  static Node* InsertStatic(Node* node, std::string_view text);
+  // method 为 HttpMethod::kUnknown 时匹配任意方法
+  static const Node* Match(const Node* node, std::string_view path, const HttpMethod method,
+                           HttpRouteParams* const params);
+  static bool HasHandler(const Node* node, const HttpMethod method);
+
+ private:
+  std::unique_ptr<Node> root_;
+  std::vector<Handler> handlers_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HttpRouter);
+};
+
+}  // namespace net
@@ -0,0 +1,80 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "net/http/http_router.h"
+#include "net/http/static_route_table.hpp"
+#include "util/time/timestamp.hpp"
+
+// HttpRouter 的查找开销随路由数量的变化: 分别注册 10 ~ 5000 条形如 "/api/vN/resourceM/:id/items" 的路由,
+// 轮流查找其中的每一条, 统计 ns/lookup; 最后对比编译期生成的 StaticRouteTable
+// 用法: http_router_bench [lookups]
+
+namespace {
+
+constexpr net::StaticRoute kStaticRoutes[] = {
+    {net::HttpMethod::kGet, "/"},
+    {net::HttpMethod::kGet, "/health"},
+    {net::HttpMethod::kGet, "/metrics"},
+    {net::HttpMethod::kGet, "/api/v1/status"},
+    {net::HttpMethod::kGet, "/api/v1/users"},
+    {net::HttpMethod::kPost, "/api/v1/users"},
+    {net::HttpMethod::kGet, "/api/v1/orders"},
+    {net::HttpMethod::kPost, "/api/v1/orders"},
+    {net::HttpMethod::kGet, "/favicon.ico"},
+    {net::HttpMethod::kGet, "/robots.txt"},
+};
+constexpr net::StaticRouteTable<10> kStaticTable(kStaticRoutes);
+static_assert(kStaticTable.valid(), "perfect hash must be found at compile time");
+
+std::string RoutePath(const int index, const std::string& id) {
+  return "/api/v" + std::to_string(index % 4) + "/resource" + std::to_string(index) + "/" + id + "/items";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int lookups = argc > 1 ? std::atoi(argv[1]) : 2000000;
+
+  for (int route_num : {10, 100, 1000, 5000}) {
+    net::HttpRouter router;
+    for (int i = 0; i < route_num; ++i) {
+      router.Add(net::HttpMethod::kGet, RoutePath(i, ":id"),
+                 [](const net::HttpRequest&, const net::HttpRouteParams&, net::HttpResponse*) {});
+    }
+    std::vector<std::string> paths;
+    for (int i = 0; i < route_num; ++i) {
+      paths.push_back(RoutePath(i, std::to_string(i * 7919)));
+    }
+
+    net::HttpRouteParams params;
+    uint64_t found = 0;
+    uint64_t start_ns = util::time::TimestampNanoSec();
+    for (int i = 0; i < lookups; ++i) {
+      found += router.Find(net::HttpMethod::kGet, paths[i % route_num], &params) != nullptr;
+    }
+    uint64_t cost_ns = util::time::TimestampNanoSec() - start_ns;
+    if (found != static_cast<uint64_t>(lookups)) {
+      std::printf("lookup fail: %lu of %d found\n", found, lookups);
+      return 1;
+    }
+    std::printf("radix tree, %5d routes: %.1f ns/lookup\n", route_num,
+                static_cast<double>(cost_ns) / static_cast<double>(lookups));
+  }
+
+  uint64_t found = 0;
+  uint64_t start_ns = util::time::TimestampNanoSec();
+  for (int i = 0; i < lookups; ++i) {
+    const net::StaticRoute& route = kStaticRoutes[i % kStaticTable.size()];
+    found += kStaticTable.Find(route.method, route.path) >= 0;
+  }
+  uint64_t cost_ns = util::time::TimestampNanoSec() - start_ns;
+  if (found != static_cast<uint64_t>(lookups)) {
+    std::printf("static lookup fail: %lu of %d found\n", found, lookups);
+    return 1;
+  }
+  std::printf("static route table, %zu routes: %.1f ns/lookup\n", kStaticTable.size(),
+              static_cast<double>(cost_ns) / static_cast<double>(lookups));
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include "net/http/http_router.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/buffer.h"
+#include "net/http/http_parser.h"
+#include "net/http/http_response.h"
+#include "net/http/static_route_table.hpp"
+
+namespace net {
+
+namespace {
+
+// 把自己的编号写到响应体中的处理函数
+HttpRouter::Handler Tag(const int tag) {
+  return [tag](const HttpRequest&, const HttpRouteParams&, HttpResponse* response) {
+    response->SetBody(std::to_string(tag));
+  };
+}
+
+int Lookup(const HttpRouter& router, const HttpMethod method, std::string_view path, HttpRouteParams* params) {
+  const HttpRouter::Handler* handler = router.Find(method, path, params);
+  if (handler == nullptr) {
+    return -1;
+  }
+  HttpResponse response(false);
+  HttpParser parser;
+  (*handler)(parser.request(), *params, &response);
+  return std::stoi(response.body());
+}
+
+constexpr StaticRoute kRoutes[] = {
+    {HttpMethod::kGet, "/"},
+    {HttpMethod::kGet, "/health"},
+    {HttpMethod::kGet, "/metrics"},
+    {HttpMethod::kPost, "/metrics"},
+    {HttpMethod::kGet, "/api/v1/status"},
+};
+constexpr StaticRouteTable<5> kTable(kRoutes);
+static_assert(kTable.valid(), "perfect hash must be found at compile time");
+static_assert(kTable.Find(HttpMethod::kGet, "/health") == 1, "static lookup");
+static_assert(kTable.Find(HttpMethod::kPost, "/metrics") == 3, "method is part of the key");
+static_assert(kTable.Find(HttpMethod::kPut, "/metrics") == -1, "method mismatch");
+static_assert(kTable.Find(HttpMethod::kGet, "/healt") == -1, "prefix is not a match");
+
+constexpr StaticRoute kDuplicateRoutes[] = {{HttpMethod::kGet, "/a"}, {HttpMethod::kGet, "/a"}};
+static_assert(!StaticRouteTable<2>(kDuplicateRoutes).valid(), "duplicate routes are rejected");
+
+}  // namespace
+
+TEST(HttpRouterTest, priority_and_backtracking) {
+  HttpRouter router;
+  router.Add(HttpMethod::kGet, "/users/new", Tag(1));
+  router.Add(HttpMethod::kGet, "/users/:id", Tag(2));
+  router.Add(HttpMethod::kGet, "/users/:id/posts/:post", Tag(3));
+  router.Add(HttpMethod::kGet, "/users/newest/posts", Tag(4));
+  router.Add(HttpMethod::kGet, "/static/*filepath", Tag(5));
+  router.Add(HttpMethod::kGet, "/", Tag(6));
+  router.Add(HttpMethod::kPost, "/users", Tag(7));
+  EXPECT_EQ(router.route_num(), 7u);
+
+  HttpRouteParams params;
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/users/new", &params), 1);
+  EXPECT_EQ(params.size(), 0u);
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/users/42", &params), 2);
+  ASSERT_EQ(params.size(), 1u);
+  EXPECT_EQ(params[0].name, "id");
+  EXPECT_EQ(params[0].value, "42");
+  // "/users/new" 静态节点之后没有 "/posts/:post", 回溯到参数节点
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/users/new/posts/7", &params), 3);
+  EXPECT_EQ(params.Get("id"), "new");
+  EXPECT_EQ(params.Get("post"), "7");
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/users/newest/posts", &params), 4);
+  // "/users/newe" 和静态节点 "newest" 共享前缀, 仍然匹配参数
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/users/newe", &params), 2);
+  EXPECT_EQ(params.Get("id"), "newe");
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/static/css/site.css", &params), 5);
+  EXPECT_EQ(params.Get("filepath"), "css/site.css");
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/static/", &params), 5);
+  EXPECT_EQ(params.Get("filepath"), "");
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/", &params), 6);
+  EXPECT_EQ(Lookup(router, HttpMethod::kPost, "/users", &params), 7);
+
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/users/", &params), -1);
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/users/1/posts", &params), -1);
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/static", &params), -1);
+  EXPECT_EQ(Lookup(router, HttpMethod::kDelete, "/users/1", &params), -1);
+  EXPECT_EQ(params.size(), 0u);
+}
+
+TEST(HttpRouterTest, params_point_into_path) {
+  HttpRouter router;
+  router.Add(HttpMethod::kGet, "/repos/:owner/:repo/issues/:number",
+             [](const HttpRequest&, const HttpRouteParams&, HttpResponse*) {});
+  std::string path = "/repos/torvalds/linux/issues/123";
+  HttpRouteParams params;
+  ASSERT_NE(router.Find(HttpMethod::kGet, path, &params), nullptr);
+  ASSERT_EQ(params.size(), 3u);
+  EXPECT_EQ(params[1].value, "linux");
+  EXPECT_EQ(params[1].value.data(), path.data() + 16);
+  EXPECT_EQ(params.Get("number"), "123");
+  EXPECT_EQ(params.Get("missing"), "");
+}
+
+TEST(HttpRouterTest, dispatch) {
+  HttpRouter router;
+  router.Add(HttpMethod::kGet, "/items/:id", [](const HttpRequest&, const HttpRouteParams& params, HttpResponse* r) {
+    r->SetBody(std::string(params.Get("id")));
+  });
+
+  HttpParser parser;
+  Buffer buffer;
+  auto dispatch = [&](const std::string& request, HttpResponse* response) {
+    buffer.RetrieveAll();
+    buffer.Append(request);
+    parser.Reset();
+    EXPECT_EQ(parser.Parse(buffer), HttpParser::Result::kComplete);
+    return router.Dispatch(parser.request(), response);
+  };
+
+  HttpResponse found(false);
+  EXPECT_TRUE(dispatch("GET /items/9?x=1 HTTP/1.1\r\n\r\n", &found));
+  EXPECT_EQ(found.status_code(), 200);
+  EXPECT_EQ(found.body(), "9");
+  HttpResponse head(false);
+  EXPECT_TRUE(dispatch("HEAD /items/10 HTTP/1.1\r\n\r\n", &head));
+  EXPECT_EQ(head.body(), "10");
+  HttpResponse not_allowed(false);
+  EXPECT_FALSE(dispatch("DELETE /items/9 HTTP/1.1\r\n\r\n", &not_allowed));
+  EXPECT_EQ(not_allowed.status_code(), 405);
+  HttpResponse not_found(false);
+  EXPECT_FALSE(dispatch("GET /users/9 HTTP/1.1\r\n\r\n", &not_found));
+  EXPECT_EQ(not_found.status_code(), 404);
+}
+
+TEST(HttpRouterTest, many_routes) {
+  HttpRouter router;
+  constexpr int kRouteNum = 3000;
+  for (int i = 0; i < kRouteNum; ++i) {
+    std::string id = std::to_string(i);
+    router.Add(HttpMethod::kGet, "/api/v" + std::to_string(i % 3) + "/resource" + id + "/:id", Tag(i));
+  }
+  HttpRouteParams params;
+  for (int i = 0; i < kRouteNum; ++i) {
+    std::string path = "/api/v" + std::to_string(i % 3) + "/resource" + std::to_string(i) + "/x";
+    ASSERT_EQ(Lookup(router, HttpMethod::kGet, path, &params), i) << path;
+    ASSERT_EQ(params.Get("id"), "x");
+  }
+  EXPECT_EQ(Lookup(router, HttpMethod::kGet, "/api/v1/resource0/x", &params), -1);
+}
+
+TEST(HttpRouterTest, static_route_table) {
+  for (size_t i = 0; i < kTable.size(); ++i) {
+    EXPECT_EQ(kTable.Find(kTable[i].method, kTable[i].path), static_cast<int>(i));
+  }
+  std::string path = "/api/v1/status";
+  EXPECT_EQ(kTable.Find(HttpMethod::kGet, path), 4);
+  EXPECT_EQ(kTable.Find(HttpMethod::kGet, "/api/v1/statu"), -1);
+  EXPECT_EQ(kTable.Find(HttpMethod::kUnknown, "/"), -1);
+}
+
+}  // namespace net
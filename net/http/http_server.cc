@@ -0,0 +1,286 @@
+#include "net/http/http_server.h"
+
+#include <algorithm>
+#include <any>
+#include <functional>
+
+#include "logger/log.h"
+#include "net/event_loop.h"
+#include "net/http/http_response.h"
+#include "net/http/http_stream.h"
+#include "net/tcp_connection.h"
+
+namespace net {
+
+namespace {
+
+// 空闲超时允许推迟的比例和上限, 大量连接的超时定时器可以合并成少量的唤醒
+constexpr double kIdleTimerSlackRatio = 0.1;
+constexpr double kMaxIdleTimerSlackSeconds = 1.0;
+
+void DefaultHttpCallback(const HttpRequest&, HttpResponse* response) {
+  response->SetStatusCode(404);
+  response->SetCloseConnection(true);
+}
+
+}  // namespace
+
+HttpServer::HttpServer(EventLoop* loop, const InetAddress& listen_addr, const std::string& name,
+                       const TcpServer::AcceptMode accept_mode)
+    : http_callback_(DefaultHttpCallback), server_(loop, listen_addr, name, false, accept_mode) {
+  server_.SetConnectionCallback(std::bind(&HttpServer::OnConnection, this, std::placeholders::_1));
+  server_.SetMessageCallback(std::bind(&HttpServer::OnMessage, this, std::placeholders::_1, std::placeholders::_2,
+                                       std::placeholders::_3));
+}
+
+HttpServer::~HttpServer() = default;
+
+void HttpServer::SetThreadNum(const int num_threads) {
+  server_.SetThreadNum(num_threads);
+}
+
+void HttpServer::SetHttpCallback(const HttpCallback& cb) {
+  http_callback_ = cb;
+}
+
+void HttpServer::SetLimits(const HttpLimits& limits) {
+  limits_ = limits;
+}
+
+void HttpServer::SetIdleTimeout(const double seconds) {
+  CHECK_GE(seconds, 0.0);
+  idle_timeout_seconds_ = seconds;
+}
+
+void HttpServer::SetHighWaterMark(const size_t bytes) {
+  CHECK_GT(bytes, 0u);
+  high_water_mark_ = bytes;
+}
+
+void HttpServer::SetWebSocketOptions(const WebSocketOptions& options) {
+  CHECK_GE(options.ping_interval_seconds, 0.0);
+  websocket_options_ = options;
+}
+
+void HttpServer::Start() {
+  server_.Start();
+}
+
+EventLoop* HttpServer::GetLoop() const {
+  return server_.GetLoop();
+}
+
+InetAddress HttpServer::listen_addr() const {
+  return server_.listen_addr();
+}
+
+size_t HttpServer::connection_num() const {
+  return server_.connection_num();
+}
+
+void HttpServer::OnConnection(const TcpConnectionPtr& conn) {
+  if (conn->Connected()) {
+    // 响应总是完整地写出, 由多段组成的响应 (例如 multipart/byteranges) 不应该被 Nagle 算法推迟到对端的延迟 ACK
+    conn->SetTcpNoDelay(true);
+    conn->SetHighWaterMarkCallback(
+        std::bind(&HttpServer::OnHighWaterMark, this, std::placeholders::_1, std::placeholders::_2), high_water_mark_);
+    conn->SetWriteCompleteCallback(std::bind(&HttpServer::OnWriteComplete, this, std::placeholders::_1));
+    SessionPtr session = std::make_shared<Session>(limits_);
+    session->last_active = util::time::TimestampMonotonicNanoSec();
+    conn->SetContext(session);
+    if (idle_timeout_seconds_ > 0) {
+      ArmIdleTimer(conn, session.get(), idle_timeout_seconds_);
+    }
+    return;
+  }
+
+  const SessionPtr* session = std::any_cast<SessionPtr>(conn->GetMutableContext());
+  if (session != nullptr) {
+    conn->GetLoop()->Cancel((*session)->idle_timer);
+    if ((*session)->stream != nullptr) {
+      (*session)->stream->Close();
+    }
+    if ((*session)->websocket != nullptr) {
+      (*session)->websocket->OnDisconnected();
+    }
+  }
+  conn->SetContext(std::any());
+}
+
+void HttpServer::OnMessage(const TcpConnectionPtr& conn, Buffer* buffer, util::time::Timestamp) {
+  Session* session = std::any_cast<SessionPtr>(conn->GetMutableContext())->get();
+  session->last_active = conn->GetLoop()->poll_return_monotonic_time();
+  session->input = buffer;
+  if (session->websocket != nullptr) {
+    session->websocket->OnData(buffer);
+    return;
+  }
+  if (session->closing) {
+    buffer->RetrieveAll();
+    return;
+  }
+  // 流式响应结束之前后续的请求留在输入缓冲区中
+  if (session->stream != nullptr) {
+    return;
+  }
+  ProcessRequests(conn, session, buffer);
+}
+
+void HttpServer::ProcessRequests(const TcpConnectionPtr& conn, Session* const session, Buffer* const buffer) {
+  HttpParser& parser = session->parser;
+  // 所有响应 (包括共享内存和文件) 先追加到输出队列, 处理完之后一次写出
+  conn->BeginBatch();
+  while (true) {
+    HttpParser::Result result = parser.Parse(*buffer);
+    if (result == HttpParser::Result::kIncomplete) {
+      break;
+    }
+    if (result == HttpParser::Result::kError) {
+      LOG_DEBUG << "HttpServer connection [" << conn->name() << "] parse request fail with error ["
+                << HttpParser::ErrorToString(parser.error()) << "]";
+      ReplyError(session, parser.error());
+      break;
+    }
+
+    const HttpRequest& request = parser.request();
+    const bool keep_alive = request.KeepAlive();
+    HttpResponse response(!keep_alive);
+    // 回调和 HTTP/1.0 的流式响应都可能改成关闭连接, Connection 在发送时按最终的结果生成
+    response.SetKeepAliveHeader(request.version_minor() == 0);
+    http_callback_(request, &response);
+    const bool with_body = request.method() != HttpMethod::kHead;
+    std::shared_ptr<HttpStream> stream = response.stream();
+    if (stream != nullptr) {
+      // HTTP/1.0 不支持 chunked, 用关闭连接表示响应体结束
+      const bool chunked = request.version_minor() > 0;
+      if (!chunked) {
+        response.SetCloseConnection(true);
+      }
+      stream->Attach(conn, chunked, with_body, high_water_mark_,
+                     std::bind(&HttpServer::OnStreamFinished, this, std::weak_ptr<TcpConnection>(conn)));
+      session->stream = stream;
+      session->close_after_stream = response.close_connection();
+    }
+    response.SendTo(conn.get(), &session->output, with_body);
+    // 回调返回之后 request 中的 string_view 才失效
+    buffer->Retrieve(parser.consumed_bytes());
+    parser.Reset();
+    if (response.websocket() != nullptr) {
+      // 101 响应必须在第一个 WebSocket 帧之前交给连接
+      conn->Send(&session->output);
+      conn->EndBatch();
+      conn->GetLoop()->Cancel(session->idle_timer);
+      session->websocket = response.websocket();
+      session->websocket->Attach(conn, websocket_options_);
+      // 和升级请求一起到达的帧
+      if (buffer->ReadableBytes() > 0) {
+        session->websocket->OnData(buffer);
+      }
+      return;
+    }
+    if (stream != nullptr) {
+      UpdateReading(conn, session);
+      break;
+    }
+    if (response.close_connection()) {
+      session->closing = true;
+      break;
+    }
+  }
+
+  if (session->closing) {
+    buffer->RetrieveAll();
+  }
+  if (session->output.ReadableBytes() > 0) {
+    conn->Send(&session->output);
+  }
+  if (session->closing) {
+    conn->Shutdown();
+  }
+  conn->EndBatch();
+}
+
+void HttpServer::OnHighWaterMark(const TcpConnectionPtr& conn, const size_t bytes) {
+  SessionPtr* session = std::any_cast<SessionPtr>(conn->GetMutableContext());
+  if (session == nullptr) {
+    return;
+  }
+  LOG_DEBUG << "HttpServer connection [" << conn->name() << "] output reaches high water mark with [" << bytes
+            << "] bytes, stop reading";
+  (*session)->output_blocked = true;
+  UpdateReading(conn, session->get());
+}
+
+void HttpServer::OnWriteComplete(const TcpConnectionPtr& conn) {
+  SessionPtr* session = std::any_cast<SessionPtr>(conn->GetMutableContext());
+  if (session == nullptr) {
+    return;
+  }
+  // 持续写出数据的连接 (例如很慢的流式响应) 不算空闲
+  (*session)->last_active = util::time::TimestampMonotonicNanoSec();
+  (*session)->output_blocked = false;
+  if ((*session)->stream != nullptr) {
+    (*session)->stream->OnDrained();
+  }
+  UpdateReading(conn, session->get());
+}
+
+void HttpServer::OnStreamFinished(const std::weak_ptr<TcpConnection>& weak_conn) {
+  TcpConnectionPtr conn = weak_conn.lock();
+  if (conn == nullptr || !conn->Connected()) {
+    return;
+  }
+  SessionPtr session = *std::any_cast<SessionPtr>(conn->GetMutableContext());
+  session->stream.reset();
+  if (session->close_after_stream) {
+    session->closing = true;
+    conn->Shutdown();
+    return;
+  }
+  UpdateReading(conn, session.get());
+  if (session->input != nullptr && session->input->ReadableBytes() > 0) {
+    ProcessRequests(conn, session.get(), session->input);
+  }
+}
+
+void HttpServer::UpdateReading(const TcpConnectionPtr& conn, Session* const session) {
+  const bool reading = session->stream == nullptr && !session->output_blocked;
+  if (reading && !conn->IsReading()) {
+    conn->StartRead();
+  } else if (!reading && conn->IsReading()) {
+    conn->StopRead();
+  }
+}
+
+void HttpServer::ReplyError(Session* const session, const HttpParser::Error error) {
+  HttpResponse response(true);
+  response.SetStatusCode(HttpParser::ErrorToStatusCode(error));
+  response.AppendToBuffer(&session->output);
+  session->closing = true;
+}
+
+void HttpServer::ArmIdleTimer(const TcpConnectionPtr& conn, Session* const session, const double delay_seconds) {
+  double slack = std::min(idle_timeout_seconds_ * kIdleTimerSlackRatio, kMaxIdleTimerSlackSeconds);
+  session->idle_timer = conn->GetLoop()->RunAfter(
+      delay_seconds, std::bind(&HttpServer::OnIdleTimer, this, std::weak_ptr<TcpConnection>(conn)), slack);
+}
+
+void HttpServer::OnIdleTimer(const std::weak_ptr<TcpConnection>& weak_conn) {
+  TcpConnectionPtr conn = weak_conn.lock();
+  // 半关闭 (kDisconnecting) 的连接在对端迟迟不关闭时同样需要超时
+  if (conn == nullptr || conn->Disconnected()) {
+    return;
+  }
+  Session* session = std::any_cast<SessionPtr>(conn->GetMutableContext())->get();
+  util::time::Timestamp idle_ns = util::time::TimestampMonotonicNanoSec() - session->last_active;
+  double remaining = idle_timeout_seconds_ - static_cast<double>(idle_ns) / util::time::kSeconds2NanoSeconds;
+  if (remaining > 0) {
+    // 期间有过活动, 按剩余的时间重新计时
+    ArmIdleTimer(conn, session, remaining);
+    return;
+  }
+  LOG_DEBUG << "HttpServer connection [" << conn->name() << "] idle timeout";
+  conn->ForceClose();
+}
+
+}  // namespace net
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "net/buffer.h"
+#include "net/callbacks.h"
+#include "net/http/http_parser.h"
+#include "net/http/websocket_connection.h"
+#include "net/tcp_server.h"
+#include "net/timer_id.hpp"
+#include "util/macros/macros.h"
+#include "util/time/timestamp.hpp"
+
+namespace net {
+
+class EventLoop;
+class HttpResponse;
+class HttpStream;
+
+/**
+ * @brief 基于 TcpServer 的 HTTP/1.1 服务端
+ *
+ * @note
+ *   1. 默认保持连接 (keep-alive), 除非请求要求关闭、回调设置了 SetCloseConnection 或者请求解析失败
+ *   2. 支持 pipelining: 一次读到的多个请求按顺序分发, 它们的响应先序列化到连接自己的输出缓冲区中;
+ *      处理期间连接处于合并发送模式 (TcpConnection::BeginBatch), 共享内存和文件的响应体 (见 HttpResponse::SendTo)
+ *      也只追加到输出队列, 全部处理完之后合并成一次写
+ *   3. 空闲超时: 每个连接只有一个定时器, 收到数据时只更新最后活跃时间, 不需要取消和重新添加定时器;
+ *      定时器到期时如果连接在期间活跃过, 再按剩余时间重新添加. 定时器允许一定的 slack 以便和其他定时器合并
+ *   4. 回调在连接所属的 IO 线程中同步执行, HttpRequest 中的 string_view 只在回调期间有效
+ *   5. 背压: 连接的输出积压超过高水位线时暂停读取, 不再处理这个连接后续的请求, 写空之后恢复.
+ *      流式响应 (HttpResponse::StartStream) 的生产者按同一个高水位线暂停和恢复, 见 HttpStream;
+ *      流结束之前连接暂停读取, pipelining 的后续请求留在输入缓冲区中, 结束之后再处理
+ *   6. 回调中调用 HttpResponse::UpgradeToWebSocket 之后, 发送完 101 响应连接就交给 WebSocketConnection,
+ *      之后收到的数据都按 WebSocket 帧解析, 空闲超时由 WebSocket 的心跳代替
+ */
+class HttpServer final {
+ public:
+  using HttpCallback = std::function<void(const HttpRequest&, HttpResponse*)>;
+
+ public:
+  HttpServer(EventLoop* loop, const InetAddress& listen_addr, const std::string& name,
+             const TcpServer::AcceptMode accept_mode = TcpServer::AcceptMode::kSingleAcceptor);
+  ~HttpServer();
+
+ public:
+  // 以下设置都需要在 Start 之前调用
+  void SetThreadNum(const int num_threads);
+  void SetHttpCallback(const HttpCallback& cb);
+  void SetLimits(const HttpLimits& limits);
+  // 连接空闲超过 seconds 秒之后关闭, 0 表示不超时
+  void SetIdleTimeout(const double seconds);
+  // 每个连接输出积压的上限, 默认 1MB
+  void SetHighWaterMark(const size_t bytes);
+  void SetWebSocketOptions(const WebSocketOptions& options);
+  void Start();
+
+ public:
+  EventLoop* GetLoop() const;
+  InetAddress listen_addr() const;
+  size_t connection_num() const;
+
+ private:
+  // 每个连接的 HTTP 状态, 通过 TcpConnection 的 context 保存
+  struct Session {
+    explicit Session(const HttpLimits& limits) : parser(limits) {}
+
+    HttpParser parser;
+    // 本次读事件中所有响应序列化到这里, 处理完之后一次发送
+    Buffer output;
+    // 单调时钟, 单位: 纳秒
+    util::time::Timestamp last_active = 0;
+    TimerId idle_timer;
+    // 已经决定关闭连接, 之后收到的数据直接丢弃
+    bool closing = false;
+    // 连接的输入缓冲区, 流式响应结束之后继续处理其中剩下的请求
+    Buffer* input = nullptr;
+    // 正在发送的流式响应
+    std::shared_ptr<HttpStream> stream;
+    bool close_after_stream = false;
+    // 输出积压超过了高水位线, 还没有写空
+    bool output_blocked = false;
+    // 升级之后的 WebSocket 连接, 之后的数据都交给它
+    std::shared_ptr<WebSocketConnection> websocket;
+  };
+  using SessionPtr = std::shared_ptr<Session>;
+
+ private:
+  void OnConnection(const TcpConnectionPtr& conn);
+  void OnMessage(const TcpConnectionPtr& conn, Buffer* buffer, util::time::Timestamp receive_time);
+  // 依次处理 buffer 中完整的请求, 遇到流式响应时停下
+  void ProcessRequests(const TcpConnectionPtr& conn, Session* const session, Buffer* const buffer);
+  void OnHighWaterMark(const TcpConnectionPtr& conn, const size_t bytes);
+  void OnWriteComplete(const TcpConnectionPtr& conn);
+  void OnStreamFinished(const std::weak_ptr<TcpConnection>& weak_conn);
+  // 没有流式响应并且输出没有积压时才读取
+  void UpdateReading(const TcpConnectionPtr& conn, Session* const session);
+  // 解析失败时回复对应的错误状态码并关闭连接
+  void ReplyError(Session* const session, const HttpParser::Error error);
+  void ArmIdleTimer(const TcpConnectionPtr& conn, Session* const session, const double delay_seconds);
+  void OnIdleTimer(const std::weak_ptr<TcpConnection>& weak_conn);
+
+ private:
+  HttpCallback http_callback_;
+  HttpLimits limits_;
+  double idle_timeout_seconds_ = 60.0;
+  size_t high_water_mark_ = 1024 * 1024;
+  WebSocketOptions websocket_options_;
+  // 最后声明, 最先析构: 析构时销毁剩下的连接, 其中的回调还能访问上面的成员
+  TcpServer server_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HttpServer);
+};
+
+}  // namespace net
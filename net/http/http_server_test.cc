@@ -0,0 +1,210 @@
+#include "net/http/http_server.h"
+
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/event_loop.h"
+#include "net/http/http_response.h"
+#include "net/http/http_test_util.hpp"
+#include "net/inet_address.h"
+
+namespace net {
+
+namespace {
+
+// 回显请求的 path, 用于检查 pipelining 的响应顺序
+void EchoPath(const HttpRequest& request, HttpResponse* response) {
+  response->SetContentType("text/plain");
+  response->SetBody(std::string(request.path()));
+}
+
+std::string PathResponse(const std::string& path, const bool close = false) {
+  return "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " + std::to_string(path.size()) + "\r\n" +
+         (close ? "Connection: close\r\n" : "") + "\r\n" + path;
+}
+
+// 回显 path 的服务, setup 可以修改其他设置
+void RunEchoPathServer(const std::function<void(HttpServer*)>& setup,
+                       const std::function<void(const InetAddress&)>& client) {
+  RunHttpServer(
+      "HttpServer",
+      [&setup](HttpServer* server) {
+        server->SetHttpCallback(EchoPath);
+        setup(server);
+      },
+      client);
+}
+
+}  // namespace
+
+TEST(HttpServerTest, keep_alive_and_pipelining) {
+  RunEchoPathServer([](HttpServer*) {}, [](const InetAddress& addr) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    // 三个请求一次写入, 第二个带请求体
+    ASSERT_TRUE(WriteAll(fd,
+                         "GET /first HTTP/1.1\r\nHost: a\r\n\r\n"
+                         "POST /second HTTP/1.1\r\nContent-Length: 4\r\n\r\nbody"
+                         "HEAD /third HTTP/1.1\r\n\r\n"));
+    std::string expected = PathResponse("/first") + PathResponse("/second");
+    std::string head = PathResponse("/third");
+    expected += head.substr(0, head.size() - 6);
+    EXPECT_EQ(ReadExactly(fd, expected.size()), expected);
+
+    // 连接仍然保持, 请求分成两次到达
+    ASSERT_TRUE(WriteAll(fd, "GET /fou"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(WriteAll(fd, "rth HTTP/1.1\r\n\r\n"));
+    expected = PathResponse("/fourth");
+    EXPECT_EQ(ReadExactly(fd, expected.size()), expected);
+
+    // Connection: close 之后的请求被丢弃
+    ASSERT_TRUE(WriteAll(fd, "GET /last HTTP/1.1\r\nConnection: close\r\n\r\nGET /ignored HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(ReadUntilClose(fd), PathResponse("/last", true));
+    ::close(fd);
+  });
+}
+
+TEST(HttpServerTest, http10) {
+  RunEchoPathServer([](HttpServer*) {}, [](const InetAddress& addr) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(WriteAll(fd, "GET /a HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n"));
+    std::string expected =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\nConnection: keep-alive\r\n\r\n/a";
+    EXPECT_EQ(ReadExactly(fd, expected.size()), expected);
+    // HTTP/1.0 默认不保持连接
+    ASSERT_TRUE(WriteAll(fd, "GET /b HTTP/1.0\r\n\r\n"));
+    EXPECT_EQ(ReadUntilClose(fd), PathResponse("/b", true));
+    ::close(fd);
+  });
+}
+
+TEST(HttpServerTest, http10_keep_alive_then_close) {
+  // 请求要求保持连接, 回调 (这里是默认的 404) 决定关闭时只有 Connection: close
+  RunHttpServer("HttpServer", [](HttpServer*) {}, [](const InetAddress& addr) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(WriteAll(fd, "GET /x HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"));
+    EXPECT_EQ(ReadUntilClose(fd), "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    ::close(fd);
+  });
+}
+
+TEST(HttpServerTest, pipelining_shared_body) {
+  std::shared_ptr<const std::string> cached = std::make_shared<const std::string>(1000, 'c');
+  RunEchoPathServer(
+      [&cached](HttpServer* server) {
+        server->SetHttpCallback([&cached](const HttpRequest& request, HttpResponse* response) {
+          if (request.path() != "/cached") {
+            EchoPath(request, response);
+            return;
+          }
+          response->AddSharedBody(cached, *cached);
+        });
+      },
+      [&cached](const InetAddress& addr) {
+        int fd = BlockingConnect(addr);
+        ASSERT_GE(fd, 0);
+        constexpr int kRequests = 10;
+        std::string requests;
+        std::string expected;
+        for (int i = 0; i < kRequests; ++i) {
+          requests += i % 2 == 0 ? "GET /cached HTTP/1.1\r\n\r\n" : "GET /copy HTTP/1.1\r\n\r\n";
+          expected += i % 2 == 0 ? "HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\n" + *cached : PathResponse("/copy");
+        }
+        struct tcp_info before;
+        socklen_t len = sizeof before;
+        ASSERT_EQ(::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &before, &len), 0);
+        ASSERT_TRUE(WriteAll(fd, requests));
+        EXPECT_EQ(ReadExactly(fd, expected.size()), expected);
+        struct tcp_info after;
+        ASSERT_EQ(::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &after, &len), 0);
+        // 共享内存的响应体不会各自触发一次写, 所有响应合并成一次写, 在一个数据报文中到达
+        EXPECT_EQ(after.tcpi_data_segs_in - before.tcpi_data_segs_in, 1u);
+        ::close(fd);
+      });
+}
+
+TEST(HttpServerTest, bad_request) {
+  RunEchoPathServer([](HttpServer*) {}, [](const InetAddress& addr) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    // 出错之前的请求正常响应
+    ASSERT_TRUE(WriteAll(fd, "GET /ok HTTP/1.1\r\n\r\nGET / HTTP/3.0\r\n\r\n"));
+    EXPECT_EQ(ReadUntilClose(fd),
+              PathResponse("/ok") + "HTTP/1.1 505 HTTP Version Not Supported\r\nContent-Length: 0\r\n"
+                                    "Connection: close\r\n\r\n");
+    ::close(fd);
+  });
+}
+
+TEST(HttpServerTest, idle_timeout) {
+  RunEchoPathServer([](HttpServer* server) { server->SetIdleTimeout(0.2); }, [](const InetAddress& addr) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    auto start = std::chrono::steady_clock::now();
+    // 每 100 毫秒发一个请求, 持续活跃的连接不会超时
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(WriteAll(fd, "GET /x HTTP/1.1\r\n\r\n"));
+      std::string expected = PathResponse("/x");
+      ASSERT_EQ(ReadExactly(fd, expected.size()), expected);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_EQ(ReadUntilClose(fd), "");
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(elapsed, 0.5);
+    EXPECT_LT(elapsed, 2.0);
+    ::close(fd);
+  });
+}
+
+TEST(HttpServerTest, destroy_with_half_closed_connection) {
+  for (int num_threads : {0, 1}) {
+    // 默认回调的 404、请求要求关闭以及解析失败, 都会在响应之后关闭写端
+    for (const char* request :
+         {"GET /x HTTP/1.1\r\n\r\n", "GET /x HTTP/1.1\r\nConnection: close\r\n\r\n", "GET / HTTP/3.0\r\n\r\n"}) {
+      std::atomic<bool> eof = {false};
+      std::string response;
+      int fd = -1;
+      {
+        EventLoop loop(Poller::PollerType::kEpollPoller);
+        HttpServer server(&loop, InetAddress(0, true), "HttpServer");
+        server.SetThreadNum(num_threads);
+        server.Start();
+
+        // 服务端发送完响应之后关闭写端, 客户端读到 EOF 之后不关闭连接
+        std::thread client_thread([&]() {
+          fd = BlockingConnect(server.listen_addr());
+          ASSERT_GE(fd, 0);
+          ASSERT_TRUE(WriteAll(fd, request));
+          response = ReadUntilClose(fd);
+          eof = true;
+        });
+        loop.RunEvery(0.005, [&]() {
+          if (eof) {
+            loop.Quit();
+          }
+        });
+        loop.Loop();
+        client_thread.join();
+        EXPECT_EQ(server.connection_num(), 1u);
+      }
+      EXPECT_EQ(response.substr(0, 9), "HTTP/1.1 ") << num_threads << " " << request;
+      ::close(fd);
+    }
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,185 @@
+#include "net/http/http_stream.h"
+
+#include <cstdio>
+#include <functional>
+#include <utility>
+
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+
+namespace net {
+
+namespace {
+
+// 绑定到连接之前使用的高水位线, 绑定之后使用 HttpServer 的设置
+constexpr size_t kDefaultHighWaterMark = 1024 * 1024;
+
+}  // namespace
+
+HttpStream::HttpStream() : high_water_mark_(kDefaultHighWaterMark) {}
+
+HttpStream::~HttpStream() = default;
+
+bool HttpStream::Write(std::string_view data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (finished_ || closed_) {
+    return false;
+  }
+  if (!data.empty() && with_body_) {
+    backlog_ += data.size();
+    if (loop_ == nullptr) {
+      pending_.emplace_back(data);
+    } else {
+      DeliverLocked(data);
+    }
+  }
+  if (backlog_ >= high_water_mark_) {
+    paused_ = true;
+    return false;
+  }
+  return true;
+}
+
+void HttpStream::Finish() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (finished_ || closed_) {
+    return;
+  }
+  finished_ = true;
+  // 没有绑定时由 Attach 结束
+  if (loop_ != nullptr) {
+    loop_->QueueInLoop(std::bind(&HttpStream::FinishInLoop, shared_from_this()));
+  }
+}
+
+void HttpStream::SetResumeCallback(const ResumeCallback& cb) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  resume_callback_ = cb;
+}
+
+bool HttpStream::closed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_;
+}
+
+size_t HttpStream::backlog() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return backlog_;
+}
+
+bool HttpStream::chunked() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return chunked_;
+}
+
+void HttpStream::Attach(const TcpConnectionPtr& conn, const bool chunked, const bool with_body,
+                        const size_t high_water_mark, const FinishCallback& finish_callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  conn_ = conn;
+  loop_ = conn->GetLoop();
+  chunked_ = chunked;
+  with_body_ = with_body;
+  high_water_mark_ = high_water_mark;
+  finish_callback_ = finish_callback;
+  std::vector<std::string> pending;
+  pending.swap(pending_);
+  if (with_body_) {
+    for (const std::string& data : pending) {
+      DeliverLocked(data);
+    }
+  } else {
+    backlog_ = 0;
+  }
+  if (finished_) {
+    loop_->QueueInLoop(std::bind(&HttpStream::FinishInLoop, shared_from_this()));
+  }
+}
+
+void HttpStream::OnDrained() {
+  TcpConnectionPtr conn = conn_.lock();
+  // 写空的通知是排队执行的, 期间可能又交给了连接新的数据
+  if (conn == nullptr || conn->output_bytes() > 0) {
+    return;
+  }
+  ResumeCallback resume;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    backlog_ -= undrained_;
+    undrained_ = 0;
+    if (paused_ && backlog_ < high_water_mark_ && !closed_) {
+      paused_ = false;
+      resume = resume_callback_;
+    }
+  }
+  if (resume) {
+    loop_->QueueInLoop(std::move(resume));
+  }
+}
+
+void HttpStream::Close() {
+  ResumeCallback resume;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    closed_ = true;
+    pending_.clear();
+    if (!finished_) {
+      resume = resume_callback_;
+    }
+  }
+  if (resume && loop_ != nullptr) {
+    loop_->QueueInLoop(std::move(resume));
+  }
+}
+
+void HttpStream::DeliverLocked(std::string_view data) {
+  std::string encoded;
+  if (chunked_) {
+    char size[32];
+    int n = std::snprintf(size, sizeof size, "%zx\r\n", data.size());
+    encoded.reserve(n + data.size() + 2);
+    encoded.append(size, n);
+    encoded.append(data);
+    encoded.append("\r\n", 2);
+  } else {
+    encoded.assign(data);
+  }
+  std::shared_ptr<const std::string> blob = std::make_shared<const std::string>(std::move(encoded));
+  loop_->QueueInLoop([self = shared_from_this(), blob = std::move(blob), bytes = data.size()]() {
+    self->DeliverInLoop(blob, bytes);
+  });
+}
+
+void HttpStream::DeliverInLoop(const std::shared_ptr<const std::string>& blob, const size_t bytes) {
+  TcpConnectionPtr conn = conn_.lock();
+  if (conn == nullptr || closed()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    undrained_ += bytes;
+  }
+  conn->Send(blob);
+}
+
+void HttpStream::FinishInLoop() {
+  FinishCallback finish_callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    finish_callback.swap(finish_callback_);
+  }
+  TcpConnectionPtr conn = conn_.lock();
+  if (conn != nullptr && chunked_ && with_body_) {
+    conn->Send(std::string("0\r\n\r\n"));
+  }
+  if (finish_callback) {
+    finish_callback();
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "net/callbacks.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class EventLoop;
+
+/**
+ * @brief 流式的 HTTP 响应体, 由 HttpResponse::StartStream 创建, 用 chunked 编码发送
+ *
+ * @note
+ *   1. Write / Finish 可以在任何线程中调用, 数据按调用顺序通过连接所属的 EventLoop::QueueInLoop 交给连接;
+ *      HttpServer 在回调返回之后才把流绑定到连接上, 之前写入的数据先暂存在流中
+ *   2. 背压: 已经写入但还没有写进内核的字节数 (backlog) 达到连接的高水位线时 Write 返回 false (数据仍然被接受),
+ *      生产者应该暂停, 等待 ResumeCallback. 连接的输出写空之后 (WriteCompleteCallback) 如果生产者被暂停过,
+ *      通过 EventLoop::QueueInLoop 在 IO 线程中调用 ResumeCallback. 每个慢客户端占用的内存因此不超过高水位线
+ *      加上一次 Write 的大小
+ *   3. 连接断开之后 closed() 为 true, Write 丢弃数据并返回 false, 同时会调用一次 ResumeCallback 让生产者退出
+ *   4. HTTP/1.0 不支持 chunked, 数据原样发送, Finish 之后关闭连接; HEAD 请求的响应丢弃所有数据
+ *   5. 流结束之前同一个连接上 pipelining 的后续请求不会被处理, 连接暂停读取
+ *
+ * @example
+ *   server.SetHttpCallback([&pool](const HttpRequest& request, HttpResponse* response) {
+ *     response->SetContentType("application/json");
+ *     std::shared_ptr<HttpStream> stream = response->StartStream();
+ *     std::shared_ptr<Exporter> exporter = std::make_shared<Exporter>(stream);
+ *     stream->SetResumeCallback([&pool, exporter]() { pool.Post([exporter]() { exporter->Run(); }); });
+ *     pool.Post([exporter]() { exporter->Run(); });  // Run 在 Write 返回 false 时返回, Finish 结束
+ *   });
+ */
+class HttpStream final : public std::enable_shared_from_this<HttpStream> {
+ public:
+  using ResumeCallback = std::function<void()>;
+  using FinishCallback = std::function<void()>;
+
+ public:
+  HttpStream();
+  ~HttpStream();
+
+ public:
+  /**
+   * @brief 写入一段数据, 编码成一个 chunk; 空数据被忽略 (空 chunk 表示结束)
+   * @return bool backlog 没有达到高水位线并且连接没有断开时返回 true, 否则生产者应该等待 ResumeCallback
+   */
+  bool Write(std::string_view data);
+  // 结束响应体, 之后的 Write 被忽略
+  void Finish();
+  // 在连接所属的 IO 线程中调用, 不要在其中阻塞
+  void SetResumeCallback(const ResumeCallback& cb);
+  bool closed() const;
+  // 已经写入但还没有写进内核的字节数
+  size_t backlog() const;
+  // 是否使用 chunked 编码, Attach 之前总是 true
+  bool chunked() const;
+
+ public:
+  /**
+   * @brief 仅供 HttpServer 使用, 在 IO 线程中发送响应头之前调用. 暂存的数据通过 QueueInLoop 交给连接,
+   *        总是在同一次事件处理中发送的响应头之后
+   * @param chunked 为 false 时数据原样发送 (HTTP/1.0)
+   * @param with_body 为 false 时丢弃所有数据 (HEAD)
+   * @param finish_callback 结束标记交给连接之后在 IO 线程中调用
+   */
+  void Attach(const TcpConnectionPtr& conn, const bool chunked, const bool with_body, const size_t high_water_mark,
+              const FinishCallback& finish_callback);
+  // 仅供 HttpServer 使用, 连接的输出写空时在 IO 线程中调用
+  void OnDrained();
+  // 仅供 HttpServer 使用, 连接断开时在 IO 线程中调用
+  void Close();
+
+ private:
+  // 调用者持有 mutex_, 把 data 编码之后交给连接
+  void DeliverLocked(std::string_view data);
+  void DeliverInLoop(const std::shared_ptr<const std::string>& blob, const size_t bytes);
+  void FinishInLoop();
+
+ private:
+  mutable std::mutex mutex_;
+  // 绑定到连接之前写入的数据
+  std::vector<std::string> pending_;
+  std::weak_ptr<TcpConnection> conn_;
+  EventLoop* loop_ = nullptr;
+  bool chunked_ = true;
+  bool with_body_ = true;
+  size_t high_water_mark_;
+  size_t backlog_ = 0;
+  // Write 返回过 false, 写空之后需要 ResumeCallback
+  bool paused_ = false;
+  bool finished_ = false;
+  bool closed_ = false;
+  ResumeCallback resume_callback_;
+  FinishCallback finish_callback_;
+
+  // 已经交给连接但还没有确认写进内核的字节数, 只在 IO 线程中修改
+  size_t undrained_ = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HttpStream);
+};
+
+}  // namespace net
@@ -0,0 +1,260 @@
+#include "net/http/http_stream.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/event_loop.h"
+#include "net/http/http_response.h"
+#include "net/http/http_server.h"
+#include "net/http/http_test_util.hpp"
+#include "net/inet_address.h"
+
+namespace net {
+
+namespace {
+
+// 读取一个 chunked 响应体, 格式错误时返回 false
+bool ReadChunkedBody(const int fd, std::string* const body) {
+  body->clear();
+  while (true) {
+    std::string line = ReadUntil(fd, "\r\n");
+    if (line.size() < 3) {
+      return false;
+    }
+    size_t size = std::stoul(line, nullptr, 16);
+    if (size == 0) {
+      return ReadExactly(fd, 2) == "\r\n";
+    }
+    std::string chunk = ReadExactly(fd, size + 2);
+    if (chunk.size() != size + 2 || chunk.compare(size, 2, "\r\n") != 0) {
+      return false;
+    }
+    body->append(chunk, 0, size);
+  }
+}
+
+// 在自己的线程中写入 total 字节, Write 返回 false 时等待 ResumeCallback
+class Producer {
+ public:
+  Producer(std::shared_ptr<HttpStream> stream, const size_t total, const size_t chunk_bytes)
+      : stream_(std::move(stream)), total_(total), chunk_bytes_(chunk_bytes) {}
+
+  ~Producer() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  void Start() {
+    stream_->SetResumeCallback([this]() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      resumed_ = true;
+      cv_.notify_one();
+    });
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  void Join() {
+    thread_.join();
+  }
+
+  size_t max_backlog() const {
+    return max_backlog_;
+  }
+  size_t pauses() const {
+    return pauses_;
+  }
+  bool saw_closed() const {
+    return saw_closed_;
+  }
+
+ private:
+  void Run() {
+    size_t written = 0;
+    while (written < total_) {
+      std::string chunk(std::min(chunk_bytes_, total_ - written), '\0');
+      for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<char>('a' + (written + i) % 26);
+      }
+      written += chunk.size();
+      // 绑定到连接之前使用默认的高水位线, 第一次恢复之后才使用 HttpServer 的设置
+      if (pauses_ > 0) {
+        max_backlog_ = std::max(max_backlog_, stream_->backlog() + chunk.size());
+      }
+      if (stream_->Write(chunk)) {
+        continue;
+      }
+      ++pauses_;
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return resumed_; });
+      resumed_ = false;
+      if (stream_->closed()) {
+        saw_closed_ = true;
+        return;
+      }
+    }
+    stream_->Finish();
+  }
+
+ private:
+  std::shared_ptr<HttpStream> stream_;
+  const size_t total_;
+  const size_t chunk_bytes_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool resumed_ = false;
+  size_t max_backlog_ = 0;
+  size_t pauses_ = 0;
+  bool saw_closed_ = false;
+};
+
+std::string Expected(const size_t total) {
+  std::string data(total, '\0');
+  for (size_t i = 0; i < total; ++i) {
+    data[i] = static_cast<char>('a' + i % 26);
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(HttpStreamTest, chunked_and_pipelining) {
+  std::vector<std::thread> producers;
+  RunHttpServer(
+      "HttpStreamServer",
+      [&producers](HttpServer* server) {
+        server->SetHttpCallback([&producers](const HttpRequest& request, HttpResponse* response) {
+          if (request.path() != "/stream") {
+            response->SetBody(std::string(request.path()));
+            return;
+          }
+          response->SetContentType("text/plain");
+          std::shared_ptr<HttpStream> stream = response->StartStream();
+          // 回调返回之前写入的数据先暂存
+          stream->Write("first\n");
+          producers.emplace_back([stream]() {
+            for (int i = 0; i < 100; ++i) {
+              stream->Write("line " + std::to_string(i) + "\n");
+            }
+            stream->Write("");
+            stream->Finish();
+            EXPECT_FALSE(stream->Write("after finish"));
+          });
+        });
+      },
+      [](const InetAddress& addr) {
+        std::string expected = "first\n";
+        for (int i = 0; i < 100; ++i) {
+          expected += "line " + std::to_string(i) + "\n";
+        }
+        int fd = BlockingConnect(addr);
+        ASSERT_GE(fd, 0);
+        // 流结束之前不处理后面的请求
+        ASSERT_TRUE(WriteAll(fd, "GET /stream HTTP/1.1\r\n\r\nGET /after HTTP/1.1\r\n\r\n"));
+        std::string header = ReadUntil(fd, "\r\n\r\n");
+        EXPECT_EQ(header.substr(0, 17), "HTTP/1.1 200 OK\r\n");
+        EXPECT_NE(header.find("\r\nTransfer-Encoding: chunked\r\n"), std::string::npos);
+        EXPECT_EQ(header.find("Content-Length"), std::string::npos);
+        std::string body;
+        ASSERT_TRUE(ReadChunkedBody(fd, &body));
+        EXPECT_EQ(body, expected);
+        EXPECT_EQ(ReadUntil(fd, "\r\n\r\n").find("Content-Length: 6"), 17u);
+        EXPECT_EQ(ReadExactly(fd, 6), "/after");
+
+        // HEAD 只有响应头
+        ASSERT_TRUE(WriteAll(fd, "HEAD /stream HTTP/1.1\r\n\r\nGET /next HTTP/1.1\r\n\r\n"));
+        header = ReadUntil(fd, "\r\n\r\n");
+        EXPECT_NE(header.find("\r\nTransfer-Encoding: chunked\r\n"), std::string::npos);
+        EXPECT_EQ(ReadUntil(fd, "\r\n\r\n").substr(0, 17), "HTTP/1.1 200 OK\r\n");
+        EXPECT_EQ(ReadExactly(fd, 5), "/next");
+        ::close(fd);
+
+        // HTTP/1.0 没有 chunked, 关闭连接表示结束
+        fd = BlockingConnect(addr);
+        ASSERT_GE(fd, 0);
+        // 即使请求要求保持连接, 也只有 Connection: close
+        ASSERT_TRUE(WriteAll(fd, "GET /stream HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"));
+        std::string response = ReadUntilClose(fd);
+        size_t header_end = response.find("\r\n\r\n");
+        ASSERT_NE(header_end, std::string::npos);
+        EXPECT_EQ(response.find("Transfer-Encoding"), std::string::npos);
+        EXPECT_NE(response.find("Connection: close"), std::string::npos);
+        EXPECT_EQ(response.find("keep-alive"), std::string::npos);
+        EXPECT_EQ(response.substr(header_end + 4), expected);
+        ::close(fd);
+      });
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+}
+
+TEST(HttpStreamTest, backpressure) {
+  static constexpr size_t kHighWaterMark = 256 * 1024;
+  static constexpr size_t kChunkBytes = 16 * 1024;
+  static constexpr size_t kTotal = 16 * 1024 * 1024;
+  std::unique_ptr<Producer> producer;
+  RunHttpServer(
+      "HttpStreamServer",
+      [&producer](HttpServer* server) {
+        server->SetHighWaterMark(kHighWaterMark);
+        server->SetHttpCallback([&producer](const HttpRequest&, HttpResponse* response) {
+          producer = std::make_unique<Producer>(response->StartStream(), kTotal, kChunkBytes);
+          producer->Start();
+        });
+      },
+      [](const InetAddress& addr) {
+        int fd = BlockingConnect(addr);
+        ASSERT_GE(fd, 0);
+        int rcvbuf = 64 * 1024;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+        ASSERT_TRUE(WriteAll(fd, "GET /export HTTP/1.1\r\n\r\n"));
+        // 慢客户端: 先不读, 生产者应该被暂停而不是把数据堆在内存里
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ReadUntil(fd, "\r\n\r\n");
+        std::string body;
+        ASSERT_TRUE(ReadChunkedBody(fd, &body));
+        EXPECT_TRUE(body == Expected(kTotal));
+        ::close(fd);
+      });
+  producer->Join();
+  EXPECT_GT(producer->pauses(), 0u);
+  EXPECT_LE(producer->max_backlog(), kHighWaterMark + kChunkBytes);
+  EXPECT_FALSE(producer->saw_closed());
+}
+
+TEST(HttpStreamTest, client_disconnect) {
+  std::unique_ptr<Producer> producer;
+  RunHttpServer(
+      "HttpStreamServer",
+      [&producer](HttpServer* server) {
+        server->SetHighWaterMark(64 * 1024);
+        server->SetHttpCallback([&producer](const HttpRequest&, HttpResponse* response) {
+          // 无穷无尽的数据, 只有连接断开才能让生产者退出
+          producer = std::make_unique<Producer>(response->StartStream(), SIZE_MAX, 16 * 1024);
+          producer->Start();
+        });
+      },
+      [](const InetAddress& addr) {
+        int fd = BlockingConnect(addr);
+        ASSERT_GE(fd, 0);
+        ASSERT_TRUE(WriteAll(fd, "GET /forever HTTP/1.1\r\n\r\n"));
+        EXPECT_EQ(ReadUntil(fd, "\r\n\r\n").substr(0, 17), "HTTP/1.1 200 OK\r\n");
+        EXPECT_EQ(ReadExactly(fd, 100 * 1024).size(), 100u * 1024);
+        ::close(fd);
+      });
+  producer->Join();
+  EXPECT_TRUE(producer->saw_closed());
+}
+
+}  // namespace net
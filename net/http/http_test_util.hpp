@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/http/http_server.h"
+#include "net/http/websocket_codec.h"
+#include "net/inet_address.h"
+#include "net/test_util.hpp"
+#include "util/macros/macros.h"
+
+// 只供单元测试使用
+
+namespace net {
+
+// 读到响应头结束的空行为止
+inline std::string ReadHeader(const int fd) {
+  return ReadUntil(fd, "\r\n\r\n");
+}
+
+// RFC 6455 1.3 中的例子, 对应的 Sec-WebSocket-Accept 是 "s3pPLMBiTxaQ9kYGzzhZRbK+xOo="
+constexpr char kWebSocketKey[] = "dGhlIHNhbXBsZSBub25jZQ==";
+
+inline std::string UpgradeRequest(std::string_view path) {
+  return "GET " + std::string(path) +
+         " HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: keep-alive, Upgrade\r\n"
+         "Sec-WebSocket-Key: " +
+         kWebSocketKey + "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+}
+
+// 客户端发送的帧必须有掩码
+inline std::string ClientFrame(const WebSocketOpcode opcode, std::string_view payload, const bool fin = true) {
+  static const uint8_t kMaskKey[4] = {0x12, 0x34, 0x56, 0x78};
+  Buffer buffer;
+  AppendWebSocketFrame(&buffer, opcode, payload, fin, kMaskKey);
+  return buffer.RetrieveAllAsString();
+}
+
+// 读取服务端的一帧, 连接关闭时返回 false
+inline bool ReadFrame(const int fd, WebSocketOpcode* const opcode, std::string* const payload) {
+  Buffer buffer;
+  WebSocketParser parser(64 * 1024 * 1024, false);
+  std::string header = ReadExactly(fd, 2);
+  if (header.size() != 2) {
+    return false;
+  }
+  buffer.Append(header);
+  uint64_t len = header[1] & 0x7f;
+  if (len >= 126) {
+    std::string extended = ReadExactly(fd, len == 126 ? 2 : 8);
+    buffer.Append(extended);
+    len = 0;
+    for (char c : extended) {
+      len = (len << 8) | static_cast<uint8_t>(c);
+    }
+  }
+  // 服务端的帧没有掩码
+  buffer.Append(ReadExactly(fd, len));
+  if (parser.Parse(&buffer) != WebSocketParser::Result::kComplete) {
+    return false;
+  }
+  *opcode = parser.frame().opcode;
+  payload->assign(parser.frame().payload);
+  return true;
+}
+
+/**
+ * @brief 在当前线程中运行的 HTTP 服务, Run 在客户端线程中执行 client, 结束后等待所有连接都被移除再返回
+ *
+ * @note 需要和服务共享 EventLoop 的对象 (例如 StaticFileHandler) 在它之后构造, 先于 EventLoop 析构
+ */
+class HttpTestServer final {
+ public:
+  explicit HttpTestServer(const std::string& name, const int num_threads = 1)
+      : loop_(Poller::PollerType::kEpollPoller), server_(&loop_, InetAddress(0, true), name) {
+    server_.SetThreadNum(num_threads);
+  }
+
+ public:
+  EventLoop* loop() { return &loop_; }
+  HttpServer* server() { return &server_; }
+
+  void Run(const std::function<void(const InetAddress&)>& client) {
+    server_.Start();
+    std::atomic<bool> client_done = {false};
+    std::thread client_thread([&]() {
+      client(server_.listen_addr());
+      client_done = true;
+    });
+    TimerId timer = loop_.RunEvery(0.005, [&]() {
+      if (client_done && server_.connection_num() == 0) {
+        loop_.Quit();
+      }
+    });
+    loop_.Loop();
+    loop_.Cancel(timer);
+    client_thread.join();
+  }
+
+ private:
+  EventLoop loop_;
+  HttpServer server_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HttpTestServer);
+};
+
+// 启动一个单 IO 线程的 HTTP 服务, setup 在 Start 之前配置服务
+inline void RunHttpServer(const std::string& name, const std::function<void(HttpServer*)>& setup,
+                          const std::function<void(const InetAddress&)>& client) {
+  HttpTestServer http(name);
+  setup(http.server());
+  http.Run(client);
+}
+
+}  // namespace net
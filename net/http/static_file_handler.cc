@@ -0,0 +1,750 @@
+#include "net/http/static_file_handler.h"
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <utility>
+
+#include "logger/log.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/file.h"
+#include "net/http/compression_cache.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+
+namespace net {
+
+namespace {
+
+// 会改变目录中文件内容或者让文件名指向另一个文件的事件
+constexpr uint32_t kWatchMask =
+    IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+struct MimeType {
+  const char* extension;
+  const char* type;
+};
+
+constexpr MimeType kMimeTypes[] = {
+    {"html", "text/html; charset=utf-8"},
+    {"htm", "text/html; charset=utf-8"},
+    {"css", "text/css; charset=utf-8"},
+    {"js", "text/javascript; charset=utf-8"},
+    {"mjs", "text/javascript; charset=utf-8"},
+    {"json", "application/json"},
+    {"txt", "text/plain; charset=utf-8"},
+    {"xml", "application/xml"},
+    {"svg", "image/svg+xml"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"webp", "image/webp"},
+    {"avif", "image/avif"},
+    {"ico", "image/x-icon"},
+    {"wasm", "application/wasm"},
+    {"pdf", "application/pdf"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"mp4", "video/mp4"},
+    {"webm", "video/webm"},
+    {"mp3", "audio/mpeg"},
+};
+
+const char* MimeTypeOf(std::string_view path) {
+  size_t dot = path.rfind('.');
+  if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos) {
+    return "application/octet-stream";
+  }
+  std::string_view extension = path.substr(dot + 1);
+  for (const MimeType& mime : kMimeTypes) {
+    if (EqualsIgnoreCase(extension, mime.extension)) {
+      return mime.type;
+    }
+  }
+  return "application/octet-stream";
+}
+
+int HexValue(const char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+/**
+ * @brief 把请求的路径转换成相对于 root 的文件路径: percent 解码, 去掉开头的 '/', 目录补上 index_file
+ * @return bool 路径包含 "..", "." 路径段、空字符或者非法的 percent 编码时返回 false
+ */
+bool NormalizePath(std::string_view path, const std::string& index_file, std::string* const key) {
+  key->clear();
+  for (size_t i = 0; i < path.size(); ++i) {
+    char c = path[i];
+    if (c == '%') {
+      int high = i + 2 < path.size() ? HexValue(path[i + 1]) : -1;
+      int low = high >= 0 ? HexValue(path[i + 2]) : -1;
+      if (low < 0) {
+        return false;
+      }
+      c = static_cast<char>(high * 16 + low);
+      i += 2;
+    }
+    if (c == '\0' || c == '\\') {
+      return false;
+    }
+    key->push_back(c);
+  }
+
+  size_t start = key->find_first_not_of('/');
+  key->erase(0, start == std::string::npos ? key->size() : start);
+  size_t segment = 0;
+  while (segment <= key->size()) {
+    size_t end = key->find('/', segment);
+    if (end == std::string::npos) {
+      end = key->size();
+    }
+    std::string_view name(key->data() + segment, end - segment);
+    if (name == "." || name == ".." || (name.empty() && end < key->size())) {
+      return false;
+    }
+    segment = end + 1;
+  }
+  if (key->empty() || key->back() == '/') {
+    key->append(index_file);
+  }
+  return true;
+}
+
+std::string FormatHttpDate(const time_t t) {
+  struct tm tm;
+  ::gmtime_r(&t, &tm);
+  char buf[64];
+  size_t n = std::strftime(buf, sizeof buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  return std::string(buf, n);
+}
+
+// 只支持 RFC 7231 推荐的 IMF-fixdate 格式, 解析失败时返回 -1
+time_t ParseHttpDate(std::string_view date) {
+  std::string str(date);
+  struct tm tm;
+  std::memset(&tm, 0, sizeof tm);
+  const char* end = ::strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  if (end == nullptr || *end != '\0') {
+    return -1;
+  }
+  return ::timegm(&tm);
+}
+
+std::string MakeETag(const struct stat& st) {
+  char buf[80];
+  int n = std::snprintf(buf, sizeof buf, "\"%lx-%lx-%lx\"", static_cast<unsigned long>(st.st_ino),
+                        static_cast<unsigned long>(st.st_size),
+                        static_cast<unsigned long>(st.st_mtim.tv_sec * 1000000000L + st.st_mtim.tv_nsec));
+  return std::string(buf, n);
+}
+
+// If-None-Match 使用弱比较, 去掉 "W/" 前缀之后比较
+bool ETagMatches(std::string_view if_none_match, std::string_view etag) {
+  size_t pos = 0;
+  while (pos < if_none_match.size()) {
+    size_t comma = if_none_match.find(',', pos);
+    if (comma == std::string_view::npos) {
+      comma = if_none_match.size();
+    }
+    std::string_view tag = if_none_match.substr(pos, comma - pos);
+    size_t begin = tag.find_first_not_of(" \t");
+    size_t end = tag.find_last_not_of(" \t");
+    tag = begin == std::string_view::npos ? std::string_view() : tag.substr(begin, end - begin + 1);
+    if (tag.substr(0, 2) == "W/") {
+      tag.remove_prefix(2);
+    }
+    if (tag == "*" || tag == etag) {
+      return true;
+    }
+    pos = comma + 1;
+  }
+  return false;
+}
+
+bool NotModified(const HttpRequest& request, std::string_view etag, const time_t mtime) {
+  if (request.HasHeader("If-None-Match")) {
+    return ETagMatches(request.GetHeader("If-None-Match"), etag);
+  }
+  if (request.HasHeader("If-Modified-Since")) {
+    time_t since = ParseHttpDate(request.GetHeader("If-Modified-Since"));
+    return since >= 0 && mtime <= since;
+  }
+  return false;
+}
+
+void ReplyNotModified(std::string_view etag, std::string_view last_modified, HttpResponse* const response) {
+  response->SetStatusCode(304);
+  response->AddHeader("ETag", etag);
+  response->AddHeader("Last-Modified", last_modified);
+}
+
+// If-Range 只使用强比较: 弱 ETag 永远不匹配, 日期必须和 Last-Modified 完全相同
+bool IfRangeMatches(const HttpRequest& request, std::string_view etag, std::string_view last_modified) {
+  if (!request.HasHeader("If-Range")) {
+    return true;
+  }
+  std::string_view value = request.GetHeader("If-Range");
+  if (!value.empty() && (value[0] == '"' || value.substr(0, 2) == "W/")) {
+    return value == etag;
+  }
+  return value == last_modified;
+}
+
+std::string ContentRange(const ByteRange& range, const size_t size) {
+  char buf[80];
+  int n = std::snprintf(buf, sizeof buf, "bytes %zu-%zu/%zu", range.offset, range.offset + range.len - 1, size);
+  return std::string(buf, n);
+}
+
+// 用 pread 读出整个文件, 不改变 fd 的偏移. 读的过程中文件被修改 (fstat 和 st 不一致) 时返回 false
+bool ReadUnchanged(const int fd, const struct stat& st, std::string* const data) {
+  const size_t size = static_cast<size_t>(st.st_size);
+  data->resize(size);
+  size_t received = 0;
+  while (received < size) {
+    ssize_t n = ::pread(fd, &(*data)[received], size - received, static_cast<off_t>(received));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    received += n;
+  }
+  struct stat now;
+  return ::fstat(fd, &now) == 0 && now.st_size == st.st_size && now.st_mtim.tv_sec == st.st_mtim.tv_sec &&
+         now.st_mtim.tv_nsec == st.st_mtim.tv_nsec;
+}
+
+// 打开预压缩文件, 不是普通文件或者比原文件旧 (原文件更新之后没有重新生成) 时返回 -1
+int OpenPrecompressed(const std::string& path, const time_t mtime, struct stat* const st) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  if (::fstat(fd, st) < 0 || !S_ISREG(st->st_mode) || st->st_mtim.tv_sec < mtime) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// 压缩响应的 ETag: 在原文件的 ETag 中加上编码, 例如 "1a-2b-3c-br"
+std::string EncodedETag(std::string_view etag, const ContentEncoding encoding) {
+  std::string encoded(etag.substr(0, etag.size() - 1));
+  encoded += '-';
+  encoded += ContentEncodingName(encoding);
+  encoded += '"';
+  return encoded;
+}
+
+// 把完整的响应格式化到 message, header_bytes 是不包含空行的响应头长度
+void Preformat(const HttpResponse& response, std::string* const message, size_t* const header_bytes) {
+  Buffer buffer;
+  response.AppendToBuffer(&buffer);
+  *message = buffer.RetrieveAllAsString();
+  *header_bytes = message->size() - response.body().size() - 2;
+}
+
+}  // namespace
+
+StaticFileHandler::StaticFileHandler(EventLoop* loop, const std::string& root, const StaticFileOptions& options)
+    : loop_(loop),
+      root_(root),
+      options_(options),
+      inotify_fd_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+      inotify_channel_(loop, inotify_fd_) {
+  loop_->AssertInLoopThread();
+  std::random_device random;
+  char boundary[32];
+  int n = std::snprintf(boundary, sizeof boundary, "%08x%08x", random(), random());
+  boundary_.assign(boundary, n);
+  if (inotify_fd_ < 0) {
+    LOG_ERROR << "StaticFileHandler inotify_init1 fail with error [" << ::strerror(errno)
+              << "], file cache is disabled";
+    return;
+  }
+  inotify_channel_.SetReadCallback(std::bind(&StaticFileHandler::HandleRead, this, std::placeholders::_1));
+  inotify_channel_.EnableReading();
+}
+
+StaticFileHandler::~StaticFileHandler() {
+  loop_->AssertInLoopThread();
+  if (inotify_fd_ >= 0) {
+    inotify_channel_.DisableAll();
+    inotify_channel_.Remove();
+    ::close(inotify_fd_);
+  }
+}
+
+void StaticFileHandler::Serve(const HttpRequest& request, std::string_view path, HttpResponse* const response) {
+  if (request.method() != HttpMethod::kGet && request.method() != HttpMethod::kHead) {
+    response->SetStatusCode(405);
+    response->AddHeader("Allow", "GET, HEAD");
+    return;
+  }
+  std::string key;
+  if (!NormalizePath(path, options_.index_file, &key)) {
+    response->SetStatusCode(400);
+    return;
+  }
+
+  Resource resource;
+  resource.key = key;
+  resource.entry = Lookup(key);
+  if (resource.entry != nullptr) {
+    resource.etag = resource.entry->etag;
+    resource.last_modified = resource.entry->last_modified;
+    resource.mtime = resource.entry->mtime;
+    resource.size = resource.entry->message.size() - resource.entry->header_bytes - 2;
+    Reply(request, resource, response);
+    return;
+  }
+
+  const std::string file_path = root_ + "/" + key;
+  int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || ::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+    int saved_errno = fd < 0 ? errno : 0;
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    response->SetStatusCode(saved_errno == EACCES ? 403 : 404);
+    return;
+  }
+  std::shared_ptr<File> file = std::make_shared<File>(fd, static_cast<size_t>(st.st_size));
+  std::string etag = MakeETag(st);
+  std::string last_modified = FormatHttpDate(st.st_mtim.tv_sec);
+  resource.mtime = st.st_mtim.tv_sec;
+  resource.size = file->size();
+
+  // 在 open 和添加 inotify 监视之间被修改过的文件不缓存, 之后的修改都会收到事件
+  std::string body;
+  const size_t dir_end = key.rfind('/');
+  uint64_t generation = 0;
+  if (file->size() <= options_.max_cached_file_bytes &&
+      WatchDirectory(dir_end == std::string::npos ? std::string() : key.substr(0, dir_end + 1), &generation) &&
+      ReadUnchanged(fd, st, &body)) {
+    HttpResponse header(false);
+    AddFileHeaders(key, etag, last_modified, &header);
+    header.SetBody(std::move(body));
+    std::shared_ptr<Entry> cached = std::make_shared<Entry>();
+    cached->key = key;
+    Preformat(header, &cached->message, &cached->header_bytes);
+    cached->etag = std::move(etag);
+    cached->last_modified = std::move(last_modified);
+    cached->mtime = st.st_mtim.tv_sec;
+    cached->bytes = cached->message.size();
+    if (Negotiable(key)) {
+      LoadPrecompressed(cached.get());
+      cached->content_digest = CompressionCache::Digest(header.body());
+    }
+    Insert(cached, generation);
+    resource.entry = cached;
+    resource.etag = cached->etag;
+    resource.last_modified = cached->last_modified;
+    Reply(request, resource, response);
+    return;
+  }
+
+  // 不缓存的文件用 sendfile 发送
+  resource.file = std::move(file);
+  resource.etag = etag;
+  resource.last_modified = last_modified;
+  Reply(request, resource, response);
+}
+
+void StaticFileHandler::Reply(const HttpRequest& request, const Resource& resource,
+                              HttpResponse* const response) {
+  // Range 总是针对原始内容, 不协商编码
+  const bool has_range = request.method() == HttpMethod::kGet && request.HasHeader("Range");
+  if (!has_range && request.HasHeader("Accept-Encoding") && Negotiable(resource.key) &&
+      ReplyEncoded(request, resource, response)) {
+    return;
+  }
+  if (ReplyIfNotModified(request, resource, resource.etag, response)) {
+    return;
+  }
+
+  // Range 只对 GET 有效, If-Range 不匹配时说明客户端手上的部分已经过期, 回复整个文件
+  if (has_range && IfRangeMatches(request, resource.etag, resource.last_modified)) {
+    std::vector<ByteRange> ranges;
+    RangeResult result = ParseRange(request.GetHeader("Range"), resource.size, &ranges, options_.max_ranges);
+    if (result == RangeResult::kNotSatisfiable) {
+      response->SetStatusCode(416);
+      response->AddHeader("Content-Range", "bytes */" + std::to_string(resource.size));
+      return;
+    }
+    if (result == RangeResult::kSatisfiable) {
+      ReplyRanges(resource, ranges, response);
+      return;
+    }
+  }
+
+  if (resource.entry != nullptr) {
+    response->SetPreformatted(resource.entry, resource.entry->message, resource.entry->header_bytes);
+    return;
+  }
+  AddFileHeaders(resource.key, resource.etag, resource.last_modified, response);
+  response->AddFileBody(resource.file, 0, resource.size);
+}
+
+bool StaticFileHandler::ReplyEncoded(const HttpRequest& request, const Resource& resource,
+                                     HttpResponse* const response) {
+  const AcceptedEncodings accepted = ParseAcceptEncoding(request.GetHeader("Accept-Encoding"));
+  // 预压缩文件优先, 它们通常是离线用最高的压缩级别生成的
+  for (size_t i = 0; i < accepted.size; ++i) {
+    const ContentEncoding encoding = accepted.encodings[i];
+    if (resource.entry != nullptr) {
+      const Entry::Variant& variant = resource.entry->encoded[static_cast<size_t>(encoding)];
+      if (variant.message.empty()) {
+        continue;
+      }
+      if (!ReplyIfNotModified(request, resource, variant.etag, response)) {
+        response->SetPreformatted(resource.entry, variant.message, variant.header_bytes);
+      }
+    } else {
+      struct stat st;
+      int fd = options_.precompressed ? OpenPrecompressed(root_ + "/" + std::string(resource.key) +
+                                                              ContentEncodingSuffix(encoding),
+                                                          resource.mtime, &st)
+                                      : -1;
+      if (fd < 0) {
+        continue;
+      }
+      std::shared_ptr<File> file = std::make_shared<File>(fd, static_cast<size_t>(st.st_size));
+      const std::string etag = MakeETag(st);
+      if (!ReplyIfNotModified(request, resource, etag, response)) {
+        AddEncodedHeaders(resource.key, encoding, etag, resource.last_modified, response);
+        response->AddFileBody(std::move(file), 0, static_cast<size_t>(st.st_size));
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.precompressed;
+    return true;
+  }
+
+  if (resource.entry == nullptr || options_.compression == nullptr) {
+    return false;
+  }
+  const Entry& entry = *resource.entry;
+  bool known = false;
+  for (size_t i = 0; i < accepted.size; ++i) {
+    const ContentEncoding encoding = accepted.encodings[i];
+    std::shared_ptr<const std::string> compressed =
+        options_.compression->Find(entry.content_digest, encoding, i == 0 ? &known : nullptr);
+    if (compressed == nullptr) {
+      continue;
+    }
+    const std::string etag = EncodedETag(entry.etag, encoding);
+    if (!ReplyIfNotModified(request, resource, etag, response)) {
+      AddEncodedHeaders(resource.key, encoding, etag, resource.last_modified, response);
+      response->AddSharedBody(compressed, *compressed);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.compressed;
+    return true;
+  }
+  if (!known && accepted.size > 0) {
+    // 缓存项保证压缩期间内容有效, 本次先回复原始内容
+    std::string_view body(entry.message.data() + entry.header_bytes + 2, resource.size);
+    options_.compression->CompressAsync(entry.content_digest, accepted.encodings[0], resource.entry, body);
+  }
+  return false;
+}
+
+bool StaticFileHandler::ReplyIfNotModified(const HttpRequest& request, const Resource& resource,
+                                           std::string_view etag, HttpResponse* const response) {
+  if (!NotModified(request, etag, resource.mtime)) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.not_modified;
+  }
+  ReplyNotModified(etag, resource.last_modified, response);
+  if (Negotiable(resource.key)) {
+    response->AddHeader("Vary", "Accept-Encoding");
+  }
+  return true;
+}
+
+void StaticFileHandler::ReplyRanges(const Resource& resource, const std::vector<ByteRange>& ranges,
+                                    HttpResponse* const response) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.range_requests;
+  }
+  response->SetStatusCode(206);
+  if (ranges.size() == 1) {
+    AddFileHeaders(resource.key, resource.etag, resource.last_modified, response);
+    response->AddHeader("Content-Range", ContentRange(ranges[0], resource.size));
+    AddRangeBody(resource, ranges[0], response);
+    return;
+  }
+
+  // multipart/byteranges: 每一段之前是一个很小的 boundary 和段头, 段的内容仍然是共享内存或者 sendfile
+  response->SetContentType("multipart/byteranges; boundary=" + boundary_);
+  AddValidatorHeaders(resource.etag, resource.last_modified, response);
+  const std::string part_header =
+      "\r\n--" + boundary_ + "\r\nContent-Type: " + MimeTypeOf(resource.key) + "\r\nContent-Range: ";
+  for (const ByteRange& range : ranges) {
+    response->AddBody(part_header + ContentRange(range, resource.size) + "\r\n\r\n");
+    AddRangeBody(resource, range, response);
+  }
+  response->AddBody("\r\n--" + boundary_ + "--\r\n");
+}
+
+void StaticFileHandler::AddRangeBody(const Resource& resource, const ByteRange& range,
+                                     HttpResponse* const response) {
+  if (resource.entry != nullptr) {
+    const Entry& entry = *resource.entry;
+    std::string_view body(entry.message.data() + entry.header_bytes + 2, resource.size);
+    response->AddSharedBody(resource.entry, body.substr(range.offset, range.len));
+  } else {
+    response->AddFileBody(resource.file, static_cast<off_t>(range.offset), range.len);
+  }
+}
+
+void StaticFileHandler::AddFileHeaders(std::string_view key, std::string_view etag, std::string_view last_modified,
+                                       HttpResponse* const response) const {
+  response->SetContentType(MimeTypeOf(key));
+  if (Negotiable(key)) {
+    response->AddHeader("Vary", "Accept-Encoding");
+  }
+  AddValidatorHeaders(etag, last_modified, response);
+}
+
+void StaticFileHandler::AddEncodedHeaders(std::string_view key, const ContentEncoding encoding,
+                                          std::string_view etag, std::string_view last_modified,
+                                          HttpResponse* const response) const {
+  // 压缩的内容不支持 Range, 不添加 Accept-Ranges
+  response->SetContentType(MimeTypeOf(key));
+  response->AddHeader("Content-Encoding", ContentEncodingName(encoding));
+  response->AddHeader("Vary", "Accept-Encoding");
+  response->AddHeader("ETag", etag);
+  response->AddHeader("Last-Modified", last_modified);
+  if (!options_.cache_control.empty()) {
+    response->AddHeader("Cache-Control", options_.cache_control);
+  }
+}
+
+void StaticFileHandler::AddValidatorHeaders(std::string_view etag, std::string_view last_modified,
+                                            HttpResponse* const response) const {
+  response->AddHeader("Accept-Ranges", "bytes");
+  response->AddHeader("ETag", etag);
+  response->AddHeader("Last-Modified", last_modified);
+  if (!options_.cache_control.empty()) {
+    response->AddHeader("Cache-Control", options_.cache_control);
+  }
+}
+
+StaticFileHandler::Stats StaticFileHandler::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+size_t StaticFileHandler::cached_file_num() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t StaticFileHandler::cached_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+bool StaticFileHandler::Negotiable(std::string_view key) const {
+  return (options_.precompressed || options_.compression != nullptr) && IsCompressibleType(MimeTypeOf(key));
+}
+
+void StaticFileHandler::LoadPrecompressed(Entry* const entry) const {
+  if (!options_.precompressed) {
+    return;
+  }
+  for (ContentEncoding encoding : {ContentEncoding::kGzip, ContentEncoding::kBrotli}) {
+    struct stat st;
+    int fd = OpenPrecompressed(root_ + "/" + entry->key + ContentEncodingSuffix(encoding), entry->mtime, &st);
+    if (fd < 0) {
+      continue;
+    }
+    // 预压缩文件和原文件在同一个目录, 已经被监视, 读的过程中没有变化就可以缓存
+    std::string body;
+    if (static_cast<size_t>(st.st_size) <= options_.max_cached_file_bytes && ReadUnchanged(fd, st, &body)) {
+      Entry::Variant& variant = entry->encoded[static_cast<size_t>(encoding)];
+      variant.etag = MakeETag(st);
+      HttpResponse header(false);
+      AddEncodedHeaders(entry->key, encoding, variant.etag, entry->last_modified, &header);
+      header.SetBody(std::move(body));
+      Preformat(header, &variant.message, &variant.header_bytes);
+      entry->bytes += variant.message.size();
+    }
+    ::close(fd);
+  }
+}
+
+StaticFileHandler::EntryPtr StaticFileHandler::Lookup(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return *it->second;
+}
+
+void StaticFileHandler::Insert(const EntryPtr& entry, const uint64_t generation) {
+  if (entry->bytes > options_.max_cache_bytes) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  // 读文件期间处理过 inotify 事件, 读到的内容可能已经过期, 这次只回复不缓存
+  if (generation != generation_) {
+    return;
+  }
+  // 其他线程可能已经缓存了同一个文件, 用新的替换
+  RemoveLocked(entry->key);
+  while (!lru_.empty() && cached_bytes_ + entry->bytes > options_.max_cache_bytes) {
+    RemoveLocked(lru_.back()->key);
+    ++stats_.evictions;
+  }
+  lru_.push_front(entry);
+  entries_.emplace(entry->key, lru_.begin());
+  cached_bytes_ += entry->bytes;
+}
+
+bool StaticFileHandler::WatchDirectory(const std::string& dir, uint64_t* const generation) {
+  if (inotify_fd_ < 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  *generation = generation_;
+  if (watched_.count(dir) > 0) {
+    return true;
+  }
+  const std::string dir_path = root_ + "/" + dir;
+  int wd = ::inotify_add_watch(inotify_fd_, dir_path.c_str(), kWatchMask);
+  if (wd < 0) {
+    LOG_WARN << "StaticFileHandler watch [" << dir_path << "] fail with error [" << ::strerror(errno) << "]";
+    return false;
+  }
+  watch_dirs_[wd] = dir;
+  watched_[dir] = wd;
+  return true;
+}
+
+void StaticFileHandler::RemoveLocked(const std::string& key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return;
+  }
+  cached_bytes_ -= (*it->second)->bytes;
+  lru_.erase(it->second);
+  entries_.erase(it);
+}
+
+void StaticFileHandler::RemovePrefixLocked(const std::string& prefix) {
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    const std::string& key = (*it)->key;
+    ++it;
+    if (key.compare(0, prefix.size(), prefix) == 0) {
+      RemoveLocked(key);
+      ++stats_.invalidations;
+    }
+  }
+}
+
+void StaticFileHandler::HandleRead(util::time::Timestamp) {
+  alignas(struct inotify_event) char buf[4096];
+  while (true) {
+    ssize_t n = ::read(inotify_fd_, buf, sizeof buf);
+    if (n <= 0) {
+      if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        LOG_ERROR << "StaticFileHandler read inotify fail with error [" << ::strerror(errno) << "]";
+      }
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    for (char* p = buf; p < buf + n;) {
+      const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        // 丢失了事件, 无法知道哪些文件变了
+        LOG_WARN << "StaticFileHandler inotify queue overflow, drop all cached files";
+        stats_.invalidations += entries_.size();
+        lru_.clear();
+        entries_.clear();
+        cached_bytes_ = 0;
+        continue;
+      }
+      auto dir = watch_dirs_.find(event->wd);
+      if (dir == watch_dirs_.end()) {
+        continue;
+      }
+      if (event->mask & IN_IGNORED) {
+        // 目录被删除或者移走, 内核已经移除了监视
+        RemovePrefixLocked(dir->second);
+        watched_.erase(dir->second);
+        watch_dirs_.erase(dir);
+        continue;
+      }
+      if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        // 移走的目录之后的事件已经和原来的路径无关, 之后再缓存同名目录下的文件时重新监视
+        RemovePrefixLocked(dir->second);
+        ::inotify_rm_watch(inotify_fd_, event->wd);
+        watched_.erase(dir->second);
+        watch_dirs_.erase(dir);
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+      // 子目录的变化影响其下所有的文件
+      std::string key = dir->second + event->name;
+      if (event->mask & IN_ISDIR) {
+        RemovePrefixLocked(key + "/");
+        continue;
+      }
+      if (entries_.count(key) > 0) {
+        RemoveLocked(key);
+        ++stats_.invalidations;
+      }
+      // 预压缩文件保存在原文件的缓存项中, 它的变化 (包括新建) 也让原文件的缓存项失效
+      for (ContentEncoding encoding : {ContentEncoding::kGzip, ContentEncoding::kBrotli}) {
+        std::string_view suffix = ContentEncodingSuffix(encoding);
+        if (key.size() > suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0) {
+          std::string original = key.substr(0, key.size() - suffix.size());
+          if (entries_.count(original) > 0) {
+            RemoveLocked(original);
+            ++stats_.invalidations;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "net/channel.h"
+#include "net/http/compression_cache.h"
+#include "net/http/content_encoding.h"
+#include "net/http/http_range.h"
+#include "util/macros/macros.h"
+#include "util/time/timestamp.hpp"
+
+namespace net {
+
+class EventLoop;
+class File;
+class HttpRequest;
+class HttpResponse;
+
+struct StaticFileOptions {
+  // 不大于这个大小的文件放入内存缓存, 更大的文件每次打开并用 sendfile 发送
+  size_t max_cached_file_bytes = 64 * 1024;
+  // 缓存的总大小上限, 包括预先格式化的响应头
+  size_t max_cache_bytes = 64 * 1024 * 1024;
+  // 请求目录时返回的文件
+  std::string index_file = "index.html";
+  // 非空时添加 Cache-Control 响应头
+  std::string cache_control;
+  // 一个请求最多的 Range 范围数 (合并之后), 超过时回复整个文件
+  size_t max_ranges = 16;
+  // 对可压缩的文件协商 Accept-Encoding 时, 使用同目录下预压缩的 ".br" / ".gz" 文件 (不比原文件旧)
+  bool precompressed = true;
+  // 非空时, 没有预压缩文件的缓存文件在它的后台线程池中按需压缩; 需要比 StaticFileHandler 活得更久
+  CompressionCache* compression = nullptr;
+};
+
+/**
+ * @brief 静态文件服务, 处理 root 目录下文件的 GET / HEAD 请求
+ *
+ * @note
+ *   1. 小文件放入 LRU 缓存. 每个缓存项把预先格式化好的响应头和文件内容放在同一块共享内存中, 命中时整个响应
+ *      就是一段共享内存, 通过 HttpResponse::SetPreformatted 零拷贝地交给连接的输出队列, 不需要任何系统调用;
+ *      发送期间缓存项被淘汰或者失效也不影响正在发送的数据
+ *   2. 没有命中缓存或者太大的文件每次 open + fstat, 响应体用 sendfile 发送
+ *   3. ETag 由 inode、大小和修改时间生成. 请求带有 If-None-Match (优先) 或者 If-Modified-Since 并且匹配时回复 304,
+ *      命中缓存时完全不访问文件系统
+ *   4. 缓存项的失效依赖 inotify: 缓存文件时监视它所在的目录, inotify fd 通过 loop 上的 Channel 读取事件,
+ *      文件被修改、删除、替换 (rename 覆盖) 时移除对应的缓存项, 事件队列溢出时清空整个缓存
+ *   5. 支持 Range 和 If-Range. 单个范围回复 206 和 Content-Range; 多个范围回复 multipart/byteranges, 每一段之前的
+ *      boundary 和段头是很小的内存数据, 段的内容是缓存项的一段共享内存或者文件的一段 sendfile, 不会读入用户态
+ *   6. 可压缩的文件 (文本、JSON、JS、SVG 等) 按照 Accept-Encoding 协商编码: 优先使用预压缩文件, 缓存文件的预压缩
+ *      文件和原文件放在同一个缓存项中, 预压缩文件变化时原文件的缓存项一起失效; 其次使用 CompressionCache 中按需
+ *      压缩的结果, 还没有结果时提交后台压缩并先回复原始内容, 从不在 IO 线程中压缩. 压缩的响应有自己的 ETag,
+ *      Range 请求总是针对原始内容
+ *   7. Serve 可以在多个 IO 线程中同时调用, 缓存由一把锁保护, 锁内只做查表和调整 LRU 链表
+ *      读文件期间处理过 inotify 事件时读到的内容不放入缓存, 以免另一个线程在失效之后放入旧内容
+ *   8. 需要在 loop 所属的线程中构造和析构
+ *
+ * @example
+ *   StaticFileHandler files(&loop, "/var/www");
+ *   router.Add(HttpMethod::kGet, "/static/" "*filepath", [&](const HttpRequest& request,
+ *              const HttpRouteParams& params, HttpResponse* response) {
+ *     files.Serve(request, params.Get("filepath"), response);
+ *   });
+ */
+class StaticFileHandler final {
+ public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t not_modified = 0;
+    // 回复 206 的次数
+    uint64_t range_requests = 0;
+    // 回复预压缩文件的次数
+    uint64_t precompressed = 0;
+    // 回复按需压缩结果的次数
+    uint64_t compressed = 0;
+    // inotify 事件导致移除的缓存项数量
+    uint64_t invalidations = 0;
+    uint64_t evictions = 0;
+  };
+
+ public:
+  StaticFileHandler(EventLoop* loop, const std::string& root, const StaticFileOptions& options = StaticFileOptions());
+  ~StaticFileHandler();
+
+ public:
+  /**
+   * @brief 回复 root 下 path 对应的文件
+   * @param path 相对于 root 的路径, 可以带有 percent 编码, 以 '/' 结尾时返回目录下的 index_file;
+   *             包含 ".." 路径段时回复 400
+   */
+  void Serve(const HttpRequest& request, std::string_view path, HttpResponse* const response);
+
+ public:
+  Stats stats() const;
+  size_t cached_file_num() const;
+  size_t cached_bytes() const;
+
+ private:
+  struct Entry {
+    // 相对于 root 的路径
+    std::string key;
+    // 完整的 200 响应, 响应头之后是空行和文件内容
+    std::string message;
+    size_t header_bytes = 0;
+    std::string etag;
+    std::string last_modified;
+    time_t mtime = 0;
+    // 预压缩文件对应的完整 200 响应, 下标是 ContentEncoding, 没有预压缩文件时 message 为空
+    struct Variant {
+      std::string message;
+      size_t header_bytes = 0;
+      std::string etag;
+    };
+    Variant encoded[kContentEncodingNum];
+    // 文件内容的摘要, 按需压缩的结果以它为 key
+    ContentDigest content_digest;
+    // 计入缓存大小的字节数
+    size_t bytes = 0;
+  };
+  using EntryPtr = std::shared_ptr<const Entry>;
+  using LruList = std::list<EntryPtr>;
+
+  // 一次请求选中的文件, entry 和 file 有且只有一个非空
+  struct Resource {
+    std::string_view key;
+    EntryPtr entry;
+    std::shared_ptr<const File> file;
+    std::string_view etag;
+    std::string_view last_modified;
+    time_t mtime = 0;
+    size_t size = 0;
+  };
+
+ private:
+  // 处理条件请求和 Range, 回复 resource
+  void Reply(const HttpRequest& request, const Resource& resource, HttpResponse* const response);
+  // 回复压缩的内容, 没有可用的压缩结果时返回 false
+  bool ReplyEncoded(const HttpRequest& request, const Resource& resource, HttpResponse* const response);
+  // 条件请求匹配时回复 304 并返回 true
+  bool ReplyIfNotModified(const HttpRequest& request, const Resource& resource, std::string_view etag,
+                          HttpResponse* const response);
+  void ReplyRanges(const Resource& resource, const std::vector<ByteRange>& ranges, HttpResponse* const response);
+  static void AddRangeBody(const Resource& resource, const ByteRange& range, HttpResponse* const response);
+  void AddFileHeaders(std::string_view key, std::string_view etag, std::string_view last_modified,
+                      HttpResponse* const response) const;
+  void AddEncodedHeaders(std::string_view key, const ContentEncoding encoding, std::string_view etag,
+                         std::string_view last_modified, HttpResponse* const response) const;
+  void AddValidatorHeaders(std::string_view etag, std::string_view last_modified, HttpResponse* const response) const;
+  // key 是否需要协商 Accept-Encoding
+  bool Negotiable(std::string_view key) const;
+  // 把预压缩文件读入缓存项
+  void LoadPrecompressed(Entry* const entry) const;
+  EntryPtr Lookup(const std::string& key);
+  // generation 是读文件之前由 WatchDirectory 得到的失效代数, 期间处理过 inotify 事件时不缓存
+  void Insert(const EntryPtr& entry, const uint64_t generation);
+  // 返回 false 时说明 inotify 不可用, 文件不能缓存; 成功时通过 generation 返回当前的失效代数
+  bool WatchDirectory(const std::string& dir, uint64_t* const generation);
+  // 调用者持有 mutex_
+  void RemoveLocked(const std::string& key);
+  void RemovePrefixLocked(const std::string& prefix);
+  void HandleRead(util::time::Timestamp receive_time);
+
+ private:
+  EventLoop* loop_;
+  const std::string root_;
+  const StaticFileOptions options_;
+  // multipart/byteranges 的分隔符
+  std::string boundary_;
+  const int inotify_fd_;
+  Channel inotify_channel_;
+
+  mutable std::mutex mutex_;
+  // 头部是最近使用的
+  LruList lru_;
+  std::unordered_map<std::string, LruList::iterator> entries_;
+  size_t cached_bytes_ = 0;
+  // inotify watch descriptor 和被监视的目录 (相对于 root, 为空或者以 '/' 结尾)
+  std::unordered_map<int, std::string> watch_dirs_;
+  std::unordered_map<std::string, int> watched_;
+  // 失效代数, 每次处理 inotify 事件时加一. 其他 IO 线程读完文件之后、缓存之前文件被修改并且事件已经处理时,
+  // 缓存中还没有这个文件, 事件不会移除任何缓存项, 需要靠它拒绝缓存读到的旧内容
+  uint64_t generation_ = 0;
+  Stats stats_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(StaticFileHandler);
+};
+
+}  // namespace net
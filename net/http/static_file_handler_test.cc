@@ -0,0 +1,381 @@
+#include "net/http/static_file_handler.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "net/event_loop.h"
+#include "net/http/compression_cache.h"
+#include "net/http/http_response.h"
+#include "net/http/http_server.h"
+#include "net/http/http_test_util.hpp"
+#include "net/inet_address.h"
+#include "util/threadpool.h"
+
+namespace net {
+
+namespace {
+
+struct Response {
+  std::string header;
+  std::string body;
+};
+
+// 读取一个响应, 响应体的长度由 Content-Length 决定, HEAD 请求的响应没有响应体
+Response ReadResponse(const int fd, const bool head = false) {
+  Response response;
+  std::string header = ReadHeader(fd);
+  if (header.size() < 4 || header.compare(header.size() - 4, 4, "\r\n\r\n") != 0) {
+    return response;
+  }
+  size_t pos = header.find("Content-Length: ");
+  size_t len = pos == std::string::npos || head ? 0 : std::stoul(header.substr(pos + 16));
+  response.header = std::move(header);
+  response.body = ReadExactly(fd, len);
+  return response;
+}
+
+std::string HeaderValue(const std::string& header, const std::string& name) {
+  size_t pos = header.find("\r\n" + name + ": ");
+  if (pos == std::string::npos) {
+    return "";
+  }
+  pos += name.size() + 4;
+  return header.substr(pos, header.find("\r\n", pos) - pos);
+}
+
+class TempDir {
+ public:
+  TempDir() {
+    char path[] = "/tmp/static_file_handler_test.XXXXXX";
+    path_ = ::mkdtemp(path);
+  }
+  ~TempDir() {
+    std::filesystem::remove_all(path_);
+  }
+
+  const std::string& path() const {
+    return path_;
+  }
+
+  void Write(const std::string& name, const std::string& content) const {
+    std::filesystem::path file = std::filesystem::path(path_) / name;
+    std::filesystem::create_directories(file.parent_path());
+    std::ofstream(file, std::ios::binary | std::ios::trunc) << content;
+  }
+
+ private:
+  std::string path_;
+};
+
+/**
+ * @brief 在 root 上启动静态文件服务, 在客户端线程中执行 client, 结束后等待所有连接都被移除再退出
+ */
+void RunStaticFileServer(const std::string& root, const StaticFileOptions& options,
+                         const std::function<void(const InetAddress&, StaticFileHandler*)>& client) {
+  HttpTestServer http("StaticFileServer");
+  StaticFileHandler files(http.loop(), root, options);
+  http.server()->SetHttpCallback([&files](const HttpRequest& request, HttpResponse* response) {
+    files.Serve(request, request.path(), response);
+  });
+  http.Run([&files, &client](const InetAddress& addr) { client(addr, &files); });
+}
+
+}  // namespace
+
+TEST(StaticFileHandlerTest, cache_and_conditional_get) {
+  TempDir dir;
+  dir.Write("index.html", "<h1>hello</h1>");
+  dir.Write("css/site.css", "body { color: red; }");
+  RunStaticFileServer(dir.path(), StaticFileOptions(), [](const InetAddress& addr, StaticFileHandler* files) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(WriteAll(fd, "GET / HTTP/1.1\r\n\r\n"));
+    Response first = ReadResponse(fd);
+    EXPECT_EQ(first.header.substr(0, 17), "HTTP/1.1 200 OK\r\n");
+    EXPECT_EQ(first.body, "<h1>hello</h1>");
+    EXPECT_EQ(HeaderValue(first.header, "Content-Type"), "text/html; charset=utf-8");
+    std::string etag = HeaderValue(first.header, "ETag");
+    std::string last_modified = HeaderValue(first.header, "Last-Modified");
+    ASSERT_FALSE(etag.empty());
+    ASSERT_FALSE(last_modified.empty());
+
+    // 第二次命中缓存, 响应完全相同
+    ASSERT_TRUE(WriteAll(fd, "GET /index.html HTTP/1.1\r\n\r\nHEAD /css/site.css HTTP/1.1\r\n\r\n"));
+    Response second = ReadResponse(fd);
+    EXPECT_EQ(second.header, first.header);
+    EXPECT_EQ(second.body, first.body);
+    Response head = ReadResponse(fd, true);
+    EXPECT_EQ(HeaderValue(head.header, "Content-Length"), "20");
+    EXPECT_EQ(HeaderValue(head.header, "Content-Type"), "text/css; charset=utf-8");
+
+    ASSERT_TRUE(WriteAll(fd, "GET /index.html HTTP/1.1\r\nIf-None-Match: \"x\", W/" + etag + "\r\n\r\n"));
+    Response not_modified = ReadResponse(fd);
+    EXPECT_EQ(not_modified.header.substr(0, 27), "HTTP/1.1 304 Not Modified\r\n");
+    EXPECT_EQ(HeaderValue(not_modified.header, "ETag"), etag);
+    EXPECT_EQ(not_modified.header.find("Content-Length"), std::string::npos);
+    ASSERT_TRUE(WriteAll(fd, "GET /index.html HTTP/1.1\r\nIf-Modified-Since: " + last_modified + "\r\n\r\n"));
+    EXPECT_EQ(ReadResponse(fd).header.substr(0, 12), "HTTP/1.1 304");
+    ASSERT_TRUE(WriteAll(fd, "GET /index.html HTTP/1.1\r\nIf-None-Match: \"x\"\r\n\r\n"));
+    EXPECT_EQ(ReadResponse(fd).body, "<h1>hello</h1>");
+
+    // HTTP/1.0 的响应需要在预先格式化的响应头中插入 Connection
+    ASSERT_TRUE(WriteAll(fd, "GET /index.html HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"));
+    Response http10 = ReadResponse(fd);
+    EXPECT_EQ(HeaderValue(http10.header, "Connection"), "keep-alive");
+    EXPECT_EQ(http10.body, "<h1>hello</h1>");
+    ::close(fd);
+
+    StaticFileHandler::Stats stats = files->stats();
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.hits, 5u);
+    EXPECT_EQ(stats.not_modified, 2u);
+    EXPECT_EQ(files->cached_file_num(), 2u);
+  });
+}
+
+TEST(StaticFileHandlerTest, inotify_invalidation) {
+  TempDir dir;
+  dir.Write("a.txt", "version 1");
+  dir.Write("sub/b.txt", "bbb");
+  RunStaticFileServer(dir.path(), StaticFileOptions(), [&dir](const InetAddress& addr, StaticFileHandler* files) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(WriteAll(fd, "GET /a.txt HTTP/1.1\r\n\r\nGET /sub/b.txt HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(ReadResponse(fd).body, "version 1");
+    EXPECT_EQ(ReadResponse(fd).body, "bbb");
+    ASSERT_EQ(files->cached_file_num(), 2u);
+
+    dir.Write("a.txt", "version 2!");
+    ASSERT_TRUE(WaitFor([files]() { return files->cached_file_num() == 1; }));
+    ASSERT_TRUE(WriteAll(fd, "GET /a.txt HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(ReadResponse(fd).body, "version 2!");
+
+    // 替换整个子目录
+    std::filesystem::rename(dir.path() + "/sub", dir.path() + "/old");
+    dir.Write("sub/b.txt", "new b");
+    ASSERT_TRUE(WaitFor([files]() { return files->cached_file_num() == 1; }));
+    ASSERT_TRUE(WriteAll(fd, "GET /sub/b.txt HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(ReadResponse(fd).body, "new b");
+    dir.Write("sub/b.txt", "newer b");
+    ASSERT_TRUE(WaitFor([files]() { return files->cached_file_num() == 1; }));
+    ASSERT_TRUE(WriteAll(fd, "GET /sub/b.txt HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(ReadResponse(fd).body, "newer b");
+
+    std::filesystem::remove(dir.path() + "/a.txt");
+    ASSERT_TRUE(WaitFor([files]() { return files->cached_file_num() == 1; }));
+    ASSERT_TRUE(WriteAll(fd, "GET /a.txt HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(ReadResponse(fd).header.substr(0, 12), "HTTP/1.1 404");
+    EXPECT_GE(files->stats().invalidations, 3u);
+    ::close(fd);
+  });
+}
+
+TEST(StaticFileHandlerTest, large_file_and_eviction) {
+  TempDir dir;
+  std::string large(300 * 1024, '\0');
+  for (size_t i = 0; i < large.size(); ++i) {
+    large[i] = static_cast<char>('a' + i % 26);
+  }
+  dir.Write("large.bin", large);
+  for (int i = 0; i < 4; ++i) {
+    dir.Write("small" + std::to_string(i) + ".txt", std::string(1000, static_cast<char>('0' + i)));
+  }
+  StaticFileOptions options;
+  options.max_cached_file_bytes = 4096;
+  options.max_cache_bytes = 3 * 1250;
+  RunStaticFileServer(dir.path(), options, [&large, &options](const InetAddress& addr, StaticFileHandler* files) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    // 大文件用 sendfile 发送, 不缓存
+    ASSERT_TRUE(WriteAll(fd, "GET /large.bin HTTP/1.1\r\n\r\nGET /large.bin HTTP/1.1\r\n\r\n"));
+    Response response = ReadResponse(fd);
+    EXPECT_EQ(HeaderValue(response.header, "Content-Type"), "application/octet-stream");
+    EXPECT_TRUE(response.body == large);
+    EXPECT_TRUE(ReadResponse(fd).body == large);
+    EXPECT_EQ(files->cached_file_num(), 0u);
+
+    // 缓存只能放下 3 个小文件, 最久没有使用的被淘汰
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(WriteAll(fd, "GET /small" + std::to_string(i) + ".txt HTTP/1.1\r\n\r\n"));
+      EXPECT_EQ(ReadResponse(fd).body, std::string(1000, static_cast<char>('0' + i)));
+    }
+    EXPECT_EQ(files->cached_file_num(), 3u);
+    EXPECT_LE(files->cached_bytes(), options.max_cache_bytes);
+    EXPECT_EQ(files->stats().evictions, 1u);
+    ::close(fd);
+  });
+}
+
+TEST(StaticFileHandlerTest, ranges) {
+  TempDir dir;
+  std::string content(100 * 1024, '\0');
+  for (size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>('A' + i % 26);
+  }
+  // 同样的内容分别走缓存 (共享内存) 和 sendfile 两条路径
+  dir.Write("small.txt", content.substr(0, 1000));
+  dir.Write("large.txt", content);
+  StaticFileOptions options;
+  options.max_cached_file_bytes = 4096;
+  RunStaticFileServer(dir.path(), options, [&content](const InetAddress& addr, StaticFileHandler* files) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    for (const std::string name : {"small.txt", "large.txt"}) {
+      const size_t size = name == "small.txt" ? 1000 : content.size();
+      const std::string request = "GET /" + name + " HTTP/1.1\r\n";
+      ASSERT_TRUE(WriteAll(fd, request + "\r\n"));
+      Response full = ReadResponse(fd);
+      EXPECT_EQ(HeaderValue(full.header, "Accept-Ranges"), "bytes");
+      std::string etag = HeaderValue(full.header, "ETag");
+
+      ASSERT_TRUE(WriteAll(fd, request + "Range: bytes=10-19\r\n\r\n"));
+      Response single = ReadResponse(fd);
+      EXPECT_EQ(single.header.substr(0, 28), "HTTP/1.1 206 Partial Content") << name;
+      EXPECT_EQ(HeaderValue(single.header, "Content-Range"), "bytes 10-19/" + std::to_string(size));
+      EXPECT_EQ(single.body, content.substr(10, 10));
+
+      ASSERT_TRUE(WriteAll(fd, request + "Range: bytes=-5\r\nIf-Range: " + etag + "\r\n\r\n"));
+      EXPECT_EQ(ReadResponse(fd).body, content.substr(size - 5, 5));
+
+      // If-Range 不匹配时回复整个文件
+      ASSERT_TRUE(WriteAll(fd, request + "Range: bytes=0-1\r\nIf-Range: \"stale\"\r\n\r\n"));
+      Response stale = ReadResponse(fd);
+      EXPECT_EQ(stale.header.substr(0, 12), "HTTP/1.1 200");
+      EXPECT_EQ(stale.body.size(), size);
+
+      ASSERT_TRUE(WriteAll(fd, request + "Range: bytes=" + std::to_string(size) + "-\r\n\r\n"));
+      Response unsatisfiable = ReadResponse(fd);
+      EXPECT_EQ(unsatisfiable.header.substr(0, 12), "HTTP/1.1 416");
+      EXPECT_EQ(HeaderValue(unsatisfiable.header, "Content-Range"), "bytes */" + std::to_string(size));
+
+      ASSERT_TRUE(WriteAll(fd, request + "Range: bytes=900-909, 0-4\r\n\r\n"));
+      Response multi = ReadResponse(fd);
+      std::string content_type = HeaderValue(multi.header, "Content-Type");
+      ASSERT_EQ(content_type.substr(0, 31), "multipart/byteranges; boundary=");
+      std::string boundary = content_type.substr(31);
+      std::string expected = "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\n"
+                             "Content-Range: bytes 0-4/" + std::to_string(size) + "\r\n\r\n" + content.substr(0, 5) +
+                             "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\n"
+                             "Content-Range: bytes 900-909/" + std::to_string(size) + "\r\n\r\n" +
+                             content.substr(900, 10) + "\r\n--" + boundary + "--\r\n";
+      EXPECT_EQ(multi.body, expected) << name;
+    }
+    ::close(fd);
+    EXPECT_EQ(files->stats().range_requests, 6u);
+    EXPECT_EQ(files->cached_file_num(), 1u);
+  });
+}
+
+TEST(StaticFileHandlerTest, content_encoding) {
+  TempDir dir;
+  std::string script;
+  for (int i = 0; i < 200; ++i) {
+    script += "console.log(" + std::to_string(i) + ");\n";
+  }
+  // 预压缩文件的内容不会被检查, 用容易辨认的内容代替真正的压缩数据
+  dir.Write("app.js", script);
+  dir.Write("app.js.br", "precompressed br");
+  dir.Write("big.css", std::string(8192, 'c'));
+  dir.Write("big.css.gz", "precompressed gz");
+  dir.Write("data.json", "[" + script + "]");
+  dir.Write("logo.png", script);
+
+  util::ThreadPool pool("static_file_compression", 1);
+  CompressionCache compression(&pool);
+  StaticFileOptions options;
+  options.max_cached_file_bytes = 4096;
+  options.compression = &compression;
+  RunStaticFileServer(dir.path(), options, [&](const InetAddress& addr, StaticFileHandler* files) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    auto get = [fd](const std::string& path, const std::string& headers) {
+      EXPECT_TRUE(WriteAll(fd, "GET " + path + " HTTP/1.1\r\n" + headers + "\r\n"));
+      return ReadResponse(fd);
+    };
+
+    // 缓存文件的预压缩文件
+    Response identity = get("/app.js", "");
+    EXPECT_EQ(identity.body, script);
+    EXPECT_EQ(HeaderValue(identity.header, "Vary"), "Accept-Encoding");
+    EXPECT_TRUE(HeaderValue(identity.header, "Content-Encoding").empty());
+    Response br = get("/app.js", "Accept-Encoding: gzip, br\r\n");
+    EXPECT_EQ(br.body, "precompressed br");
+    EXPECT_EQ(HeaderValue(br.header, "Content-Encoding"), "br");
+    EXPECT_EQ(HeaderValue(br.header, "Vary"), "Accept-Encoding");
+    std::string br_etag = HeaderValue(br.header, "ETag");
+    EXPECT_NE(br_etag, HeaderValue(identity.header, "ETag"));
+    Response not_modified = get("/app.js", "Accept-Encoding: br\r\nIf-None-Match: " + br_etag + "\r\n");
+    EXPECT_EQ(not_modified.header.substr(0, 12), "HTTP/1.1 304");
+    EXPECT_EQ(HeaderValue(not_modified.header, "ETag"), br_etag);
+    EXPECT_EQ(get("/app.js", "Accept-Encoding: br;q=0\r\n").body, script);
+
+    // 不缓存的大文件的预压缩文件用 sendfile 发送
+    Response gz = get("/big.css", "Accept-Encoding: gzip\r\n");
+    EXPECT_EQ(gz.body, "precompressed gz");
+    EXPECT_EQ(HeaderValue(gz.header, "Content-Encoding"), "gzip");
+    EXPECT_EQ(get("/big.css", "Accept-Encoding: br\r\n").body, std::string(8192, 'c'));
+
+    // 没有预压缩文件时第一次回复原始内容, 后台压缩完成之后回复压缩结果
+    EXPECT_EQ(get("/data.json", "Accept-Encoding: gzip\r\n").body, "[" + script + "]");
+    EXPECT_EQ(get("/app.js", "Accept-Encoding: gzip\r\n").body, script);
+    ASSERT_TRUE(WaitFor([&compression]() { return compression.size() == 2; }));
+    std::string expected;
+    ASSERT_TRUE(Compress(ContentEncoding::kGzip, "[" + script + "]", CompressionOptions().gzip_level, &expected));
+    Response compressed = get("/data.json", "Accept-Encoding: gzip\r\n");
+    EXPECT_TRUE(compressed.body == expected);
+    EXPECT_EQ(HeaderValue(compressed.header, "Content-Encoding"), "gzip");
+    EXPECT_NE(HeaderValue(compressed.header, "ETag").find("-gzip\""), std::string::npos);
+    EXPECT_EQ(HeaderValue(get("/app.js", "Accept-Encoding: gzip\r\n").header, "Content-Encoding"), "gzip");
+
+    // Range 和不可压缩的类型总是回复原始内容
+    Response range = get("/data.json", "Accept-Encoding: gzip\r\nRange: bytes=0-0\r\n");
+    EXPECT_EQ(range.body, "[");
+    Response image = get("/logo.png", "Accept-Encoding: gzip, br\r\n");
+    EXPECT_EQ(image.body, script);
+    EXPECT_TRUE(HeaderValue(image.header, "Vary").empty());
+
+    // 预压缩文件的变化让原文件的缓存项失效
+    size_t invalidations = files->stats().invalidations;
+    dir.Write("app.js.br", "new br");
+    ASSERT_TRUE(WaitFor([files, invalidations]() { return files->stats().invalidations > invalidations; }));
+    EXPECT_EQ(get("/app.js", "Accept-Encoding: br\r\n").body, "new br");
+    ::close(fd);
+
+    StaticFileHandler::Stats stats = files->stats();
+    EXPECT_EQ(stats.precompressed, 4u);
+    EXPECT_EQ(stats.compressed, 2u);
+  });
+}
+
+TEST(StaticFileHandlerTest, bad_requests) {
+  TempDir dir;
+  dir.Write("a.txt", "a");
+  dir.Write("dir/x", "x");
+  RunStaticFileServer(dir.path(), StaticFileOptions(), [](const InetAddress& addr, StaticFileHandler*) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    const char* const kCases[][2] = {
+        {"GET /../etc/passwd HTTP/1.1\r\n\r\n", "HTTP/1.1 400"},
+        {"GET /dir/%2e%2e/a.txt HTTP/1.1\r\n\r\n", "HTTP/1.1 400"},
+        {"GET /a.txt%00 HTTP/1.1\r\n\r\n", "HTTP/1.1 400"},
+        {"GET /missing HTTP/1.1\r\n\r\n", "HTTP/1.1 404"},
+        {"GET /dir HTTP/1.1\r\n\r\n", "HTTP/1.1 404"},
+        {"POST /a.txt HTTP/1.1\r\n\r\n", "HTTP/1.1 405"},
+        {"GET /%61.txt HTTP/1.1\r\n\r\n", "HTTP/1.1 200"},
+    };
+    for (const auto& test_case : kCases) {
+      ASSERT_TRUE(WriteAll(fd, test_case[0]));
+      EXPECT_EQ(ReadResponse(fd).header.substr(0, 12), test_case[1]) << test_case[0];
+    }
+    ::close(fd);
+  });
+}
+
+}  // namespace net
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "net/http/http_request.h"
+
+namespace net {
+
+struct StaticRoute {
+  HttpMethod method = HttpMethod::kUnknown;
+  std::string_view path;
+};
+
+/**
+ * @brief 编译期生成的静态路由表, 用完美哈希把 (method, path) 映射到路由在表中的下标
+ *
+ * @note
+ *   1. 使用 hash-and-displace 构造: 先用哈希值把路由分到 N 个桶里, 再从大到小依次为每个桶寻找一个位移 d,
+ *      使桶内所有路由的 mix(hash + d) 都落在空的槽位上. 查找时只计算一次哈希, 再比较一次字符串
+ *   2. 槽位数是不小于 2N 的 2 的幂, 构造在编译期完成, 运行时没有任何初始化开销
+ *   3. 只支持没有参数的固定路径, 带参数的路由使用 HttpRouter
+ *
+ * @example
+ *   constexpr StaticRoute kRoutes[] = {{HttpMethod::kGet, "/"}, {HttpMethod::kGet, "/health"}};
+ *   constexpr StaticRouteTable<2> kTable(kRoutes);
+ *   static_assert(kTable.Find(HttpMethod::kGet, "/health") == 1);
+ *   switch (kTable.Find(request.method(), request.path())) {
+ *     case 0: ...
+ *   }
+ */
+template <size_t N>
+class StaticRouteTable {
+ public:
+  static_assert(N > 0, "empty route table");
+
+  constexpr explicit StaticRouteTable(const StaticRoute (&routes)[N]) : routes_(), displacements_(), slots_() {
+    for (size_t i = 0; i < N; ++i) {
+      routes_[i] = routes[i];
+    }
+    Build();
+  }
+
+ public:
+  // 返回路由的下标, 没有时返回 -1
+  constexpr int Find(const HttpMethod method, std::string_view path) const {
+    uint64_t hash = Hash(method, path);
+    size_t slot = Slot(hash, displacements_[hash % N]);
+    int index = slots_[slot];
+    if (index < 0 || routes_[index].method != method || routes_[index].path != path) {
+      return -1;
+    }
+    return index;
+  }
+
+  // 有重复的路由或者没有找到完美哈希时为 false
+  constexpr bool valid() const {
+    return valid_;
+  }
+
+  constexpr size_t size() const {
+    return N;
+  }
+
+  constexpr const StaticRoute& operator[](const size_t index) const {
+    return routes_[index];
+  }
+
+ private:
+  static constexpr size_t SlotCount() {
+    size_t count = 1;
+    while (count < 2 * N) {
+      count <<= 1;
+    }
+    return count;
+  }
+
+  // FNV-1a, 方法作为第一个字节参与计算
+  static constexpr uint64_t Hash(const HttpMethod method, std::string_view path) {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ static_cast<uint64_t>(method);
+    hash *= 0x100000001b3ULL;
+    for (char c : path) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  // murmur3 的 fmix64, 让不同的位移得到相互独立的槽位
+  static constexpr size_t Slot(const uint64_t hash, const uint32_t displacement) {
+    uint64_t x = hash + displacement * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x & (kSlots - 1));
+  }
+
+  constexpr void Build() {
+    for (int& slot : slots_) {
+      slot = -1;
+    }
+    // 按桶做计数排序, 桶 b 中的路由是 members[offsets[b], offsets[b + 1])
+    std::array<uint64_t, N> hashes = {};
+    std::array<size_t, N + 1> offsets = {};
+    for (size_t i = 0; i < N; ++i) {
+      hashes[i] = Hash(routes_[i].method, routes_[i].path);
+      ++offsets[hashes[i] % N + 1];
+    }
+    size_t max_bucket_size = 0;
+    for (size_t bucket = 0; bucket < N; ++bucket) {
+      max_bucket_size = offsets[bucket + 1] > max_bucket_size ? offsets[bucket + 1] : max_bucket_size;
+      offsets[bucket + 1] += offsets[bucket];
+    }
+    std::array<size_t, N> members = {};
+    std::array<size_t, N> filled = {};
+    for (size_t i = 0; i < N; ++i) {
+      size_t bucket = hashes[i] % N;
+      members[offsets[bucket] + filled[bucket]++] = i;
+    }
+    // 重复的路由哈希值相同, 只需要在桶内检查
+    for (size_t bucket = 0; bucket < N && valid_; ++bucket) {
+      for (size_t i = offsets[bucket]; i < offsets[bucket + 1] && valid_; ++i) {
+        for (size_t j = offsets[bucket]; j < i && valid_; ++j) {
+          const StaticRoute& a = routes_[members[i]];
+          const StaticRoute& b = routes_[members[j]];
+          valid_ = a.method != b.method || a.path != b.path;
+        }
+      }
+    }
+
+    // 大的桶约束多, 先放
+    std::array<size_t, N> taken = {};
+    for (size_t size = max_bucket_size; size > 0 && valid_; --size) {
+      for (size_t bucket = 0; bucket < N && valid_; ++bucket) {
+        if (offsets[bucket + 1] - offsets[bucket] == size) {
+          valid_ = PlaceBucket(bucket, &members[offsets[bucket]], size, hashes, &taken);
+        }
+      }
+    }
+  }
+
+  constexpr bool PlaceBucket(const size_t bucket, const size_t* members, const size_t size,
+                             const std::array<uint64_t, N>& hashes, std::array<size_t, N>* const taken) {
+    for (uint32_t displacement = 0; displacement < kMaxDisplacement; ++displacement) {
+      bool ok = true;
+      for (size_t i = 0; i < size && ok; ++i) {
+        (*taken)[i] = Slot(hashes[members[i]], displacement);
+        ok = slots_[(*taken)[i]] < 0;
+        for (size_t j = 0; j < i && ok; ++j) {
+          ok = (*taken)[j] != (*taken)[i];
+        }
+      }
+      if (!ok) {
+        continue;
+      }
+      displacements_[bucket] = displacement;
+      for (size_t i = 0; i < size; ++i) {
+        slots_[(*taken)[i]] = static_cast<int>(members[i]);
+      }
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  static constexpr size_t kSlots = SlotCount();
+  static constexpr uint32_t kMaxDisplacement = 1 << 16;
+
+  std::array<StaticRoute, N> routes_;
+  std::array<uint32_t, N> displacements_;
+  std::array<int, kSlots> slots_;
+  bool valid_ = true;
+};
+
+}  // namespace net
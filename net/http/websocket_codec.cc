@@ -0,0 +1,240 @@
+#include "net/http/websocket_codec.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include <cstring>
+
+#include "logger/log.h"
+#include "net/buffer.h"
+
+namespace net {
+
+namespace {
+
+// RFC 6455 1.3 中固定的 GUID
+constexpr std::string_view kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+// 控制帧的负载不能超过 125 字节
+constexpr size_t kMaxControlPayload = 125;
+
+bool IsKnownOpcode(const uint8_t opcode) {
+  return opcode <= 0x2 || (opcode >= 0x8 && opcode <= 0xa);
+}
+
+bool IsControlOpcode(const uint8_t opcode) {
+  return (opcode & 0x8) != 0;
+}
+
+// 帧头的长度: 2 字节加上扩展长度和掩码
+size_t FrameHeaderBytes(const size_t payload_len, const bool masked) {
+  size_t bytes = 2;
+  if (payload_len > 0xffff) {
+    bytes += 8;
+  } else if (payload_len > kMaxControlPayload) {
+    bytes += 2;
+  }
+  return masked ? bytes + 4 : bytes;
+}
+
+// 把帧头写到 out, 返回写入的字节数, out 至少有 FrameHeaderBytes 字节
+size_t WriteFrameHeader(char* const out, const WebSocketOpcode opcode, const size_t payload_len, const bool fin,
+                        const uint8_t* mask_key) {
+  uint8_t* p = reinterpret_cast<uint8_t*>(out);
+  p[0] = static_cast<uint8_t>((fin ? 0x80 : 0) | static_cast<uint8_t>(opcode));
+  const uint8_t mask_bit = mask_key != nullptr ? 0x80 : 0;
+  size_t n = 2;
+  if (payload_len > 0xffff) {
+    p[1] = mask_bit | 127;
+    for (int i = 0; i < 8; ++i) {
+      p[2 + i] = static_cast<uint8_t>(static_cast<uint64_t>(payload_len) >> (56 - 8 * i));
+    }
+    n += 8;
+  } else if (payload_len > kMaxControlPayload) {
+    p[1] = mask_bit | 126;
+    p[2] = static_cast<uint8_t>(payload_len >> 8);
+    p[3] = static_cast<uint8_t>(payload_len);
+    n += 2;
+  } else {
+    p[1] = static_cast<uint8_t>(mask_bit | payload_len);
+  }
+  if (mask_key != nullptr) {
+    std::memcpy(p + n, mask_key, 4);
+    n += 4;
+  }
+  return n;
+}
+
+}  // namespace
+
+WebSocketParser::WebSocketParser(const size_t max_payload_bytes, const bool require_mask)
+    : max_payload_bytes_(max_payload_bytes), require_mask_(require_mask) {}
+
+WebSocketParser::Result WebSocketParser::Parse(Buffer* const buffer) {
+  const size_t readable = buffer->ReadableBytes();
+  if (readable < 2) {
+    return Result::kIncomplete;
+  }
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(buffer->Peek());
+  const bool fin = (p[0] & 0x80) != 0;
+  const uint8_t opcode = p[0] & 0x0f;
+  const bool masked = (p[1] & 0x80) != 0;
+  // RSV1-3 只有协商了扩展才能使用
+  if ((p[0] & 0x70) != 0 || !IsKnownOpcode(opcode) || masked != require_mask_) {
+    return Fail(Error::kProtocolError);
+  }
+  uint64_t payload_len = p[1] & 0x7f;
+  if (IsControlOpcode(opcode) && (!fin || payload_len > kMaxControlPayload)) {
+    return Fail(Error::kProtocolError);
+  }
+  size_t header_bytes = 2;
+  if (payload_len == 126) {
+    header_bytes += 2;
+    if (readable < header_bytes) {
+      return Result::kIncomplete;
+    }
+    payload_len = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+  } else if (payload_len == 127) {
+    header_bytes += 8;
+    if (readable < header_bytes) {
+      return Result::kIncomplete;
+    }
+    payload_len = 0;
+    for (int i = 0; i < 8; ++i) {
+      payload_len = (payload_len << 8) | p[2 + i];
+    }
+    // 最高位必须为 0
+    if ((payload_len >> 63) != 0) {
+      return Fail(Error::kProtocolError);
+    }
+  }
+  if (payload_len > max_payload_bytes_) {
+    return Fail(Error::kMessageTooBig);
+  }
+  const size_t mask_offset = header_bytes;
+  if (masked) {
+    header_bytes += 4;
+  }
+  if (readable < header_bytes + payload_len) {
+    return Result::kIncomplete;
+  }
+
+  char* payload = buffer->MutablePeek() + header_bytes;
+  if (masked) {
+    uint8_t mask_key[4];
+    std::memcpy(mask_key, p + mask_offset, 4);
+    WebSocketMask(payload, payload_len, mask_key);
+  }
+  frame_.fin = fin;
+  frame_.opcode = static_cast<WebSocketOpcode>(opcode);
+  frame_.payload = std::string_view(payload, payload_len);
+  consumed_bytes_ = header_bytes + payload_len;
+  return Result::kComplete;
+}
+
+const WebSocketFrame& WebSocketParser::frame() const {
+  return frame_;
+}
+
+size_t WebSocketParser::consumed_bytes() const {
+  return consumed_bytes_;
+}
+
+WebSocketParser::Error WebSocketParser::error() const {
+  return error_;
+}
+
+WebSocketCloseCode WebSocketParser::ErrorToCloseCode(const Error error) {
+  switch (error) {
+    case Error::kMessageTooBig:
+      return WebSocketCloseCode::kMessageTooBig;
+    case Error::kProtocolError:
+    case Error::kNone:
+      break;
+  }
+  return WebSocketCloseCode::kProtocolError;
+}
+
+WebSocketParser::Result WebSocketParser::Fail(const Error error) {
+  error_ = error;
+  return Result::kError;
+}
+
+void WebSocketMask(char* const data, const size_t len, const uint8_t mask_key[4]) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // 4 字节的掩码重复 4 次, 按内存顺序异或, 和字节序无关
+  uint32_t key32 = 0;
+  std::memcpy(&key32, mask_key, 4);
+  const __m128i key = _mm_set1_epi32(static_cast<int>(key32));
+  for (; i + 64 <= len; i += 64) {
+    __m128i* p = reinterpret_cast<__m128i*>(data + i);
+    _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), key));
+    _mm_storeu_si128(p + 1, _mm_xor_si128(_mm_loadu_si128(p + 1), key));
+    _mm_storeu_si128(p + 2, _mm_xor_si128(_mm_loadu_si128(p + 2), key));
+    _mm_storeu_si128(p + 3, _mm_xor_si128(_mm_loadu_si128(p + 3), key));
+  }
+  for (; i + 16 <= len; i += 16) {
+    __m128i* p = reinterpret_cast<__m128i*>(data + i);
+    _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), key));
+  }
+#endif
+  // i 总是 4 的倍数, 掩码的相位不变
+  for (; i < len; ++i) {
+    data[i] = static_cast<char>(data[i] ^ mask_key[i & 3]);
+  }
+}
+
+void AppendWebSocketFrame(Buffer* const output, const WebSocketOpcode opcode, std::string_view payload,
+                          const bool fin, const uint8_t* mask_key) {
+  const size_t header_bytes = FrameHeaderBytes(payload.size(), mask_key != nullptr);
+  output->EnsureWritableBytes(header_bytes + payload.size());
+  char* begin = output->BeginWrite();
+  WriteFrameHeader(begin, opcode, payload.size(), fin, mask_key);
+  if (!payload.empty()) {
+    std::memcpy(begin + header_bytes, payload.data(), payload.size());
+  }
+  if (mask_key != nullptr) {
+    WebSocketMask(begin + header_bytes, payload.size(), mask_key);
+  }
+  output->HasWritten(header_bytes + payload.size());
+}
+
+std::shared_ptr<const std::string> EncodeWebSocketFrame(const WebSocketOpcode opcode, std::string_view payload) {
+  const size_t header_bytes = FrameHeaderBytes(payload.size(), false);
+  std::string frame(header_bytes + payload.size(), '\0');
+  WriteFrameHeader(&frame[0], opcode, payload.size(), true, nullptr);
+  if (!payload.empty()) {
+    std::memcpy(&frame[header_bytes], payload.data(), payload.size());
+  }
+  return std::make_shared<const std::string>(std::move(frame));
+}
+
+std::string EncodeWebSocketClosePayload(const uint16_t code, std::string_view reason) {
+  // 关闭帧是控制帧, 原因过长时截断
+  reason = reason.substr(0, kMaxControlPayload - 2);
+  std::string payload;
+  payload.reserve(2 + reason.size());
+  payload.push_back(static_cast<char>(code >> 8));
+  payload.push_back(static_cast<char>(code & 0xff));
+  payload.append(reason);
+  return payload;
+}
+
+std::string WebSocketAcceptKey(std::string_view key) {
+  std::string input;
+  input.reserve(key.size() + kWebSocketGuid.size());
+  input.append(key);
+  input.append(kWebSocketGuid);
+  unsigned char digest[SHA_DIGEST_LENGTH];
+  SHA1(reinterpret_cast<const unsigned char*>(input.data()), input.size(), digest);
+  // 20 字节的 base64 是 28 个字符, EVP_EncodeBlock 还会写入结尾的 '\0'
+  char encoded[32];
+  int n = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(encoded), digest, SHA_DIGEST_LENGTH);
+  CHECK_EQ(n, 28);
+  return std::string(encoded, n);
+}
+
+}  // namespace net
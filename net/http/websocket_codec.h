@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "util/macros/macros.h"
+
+namespace net {
+
+class Buffer;
+
+// RFC 6455 5.2 中的 opcode
+enum class WebSocketOpcode : uint8_t {
+  kContinuation = 0x0,
+  kText = 0x1,
+  kBinary = 0x2,
+  kClose = 0x8,
+  kPing = 0x9,
+  kPong = 0xa,
+};
+
+// RFC 6455 7.4.1 中常用的关闭码, 对端发来的关闭码可能不在其中
+enum class WebSocketCloseCode : uint16_t {
+  kNormal = 1000,
+  kGoingAway = 1001,
+  kProtocolError = 1002,
+  kUnsupportedData = 1003,
+  // 以下两个只用于本地表示, 不能出现在关闭帧中: 关闭帧没有关闭码、没有收到关闭帧连接就断开了
+  kNoStatus = 1005,
+  kAbnormal = 1006,
+  kInvalidPayload = 1007,
+  kPolicyViolation = 1008,
+  kMessageTooBig = 1009,
+};
+
+// 一个 WebSocket 帧, payload 指向 Buffer 中已经去掉掩码的数据
+struct WebSocketFrame {
+  bool fin = true;
+  WebSocketOpcode opcode = WebSocketOpcode::kText;
+  std::string_view payload;
+};
+
+/**
+ * @brief WebSocket 帧解析器
+ *
+ * @note
+ *   1. 直接在 Buffer 的可读数据上解析, 帧不完整时返回 kIncomplete, 不修改 Buffer; 收到完整的帧之后原地去掉掩码
+ *      (见 WebSocketMask), 返回 kComplete, frame().payload 指向 Buffer. 调用方处理完之后必须 Retrieve
+ *      consumed_bytes() 字节, 否则再次 Parse 会把负载又异或一遍
+ *   2. 不支持扩展, RSV 位不为 0、未知的 opcode、分片或者超过 125 字节的控制帧都是协议错误;
+ *      作为服务端要求客户端的帧都有掩码
+ *   3. 负载超过 max_payload_bytes 时在收到负载之前就返回 kError, 不会为过大的帧缓存数据
+ *   4. 只解析单个帧, 分片消息的拼接由调用方负责
+ */
+class WebSocketParser {
+ public:
+  enum class Result {
+    kIncomplete = 0,
+    kComplete = 1,
+    kError = 2,
+  };
+
+  enum class Error {
+    kNone = 0,
+    kProtocolError = 1,
+    kMessageTooBig = 2,
+  };
+
+ public:
+  explicit WebSocketParser(const size_t max_payload_bytes, const bool require_mask = true);
+
+ public:
+  Result Parse(Buffer* const buffer);
+
+ public:
+  const WebSocketFrame& frame() const;
+  // 当前帧在 Buffer 中占用的字节数, 只在 kComplete 之后有意义
+  size_t consumed_bytes() const;
+  Error error() const;
+  // error 对应的关闭码
+  static WebSocketCloseCode ErrorToCloseCode(const Error error);
+
+ private:
+  Result Fail(const Error error);
+
+ private:
+  const size_t max_payload_bytes_;
+  const bool require_mask_;
+  WebSocketFrame frame_;
+  size_t consumed_bytes_ = 0;
+  Error error_ = Error::kNone;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(WebSocketParser);
+};
+
+/**
+ * @brief 用 4 字节的 mask_key 对 data 原地加掩码 (去掉掩码是同一个操作)
+ * @note 支持 SSE2 时每次异或 16 字节, 收到的每个字节都要经过这里, 是 WebSocket 接收的热点
+ */
+void WebSocketMask(char* const data, const size_t len, const uint8_t mask_key[4]);
+
+/**
+ * @brief 把一帧追加到 output
+ * @param mask_key 服务端发送的帧没有掩码 (nullptr); 客户端发送的帧必须有掩码
+ */
+void AppendWebSocketFrame(Buffer* const output, const WebSocketOpcode opcode, std::string_view payload,
+                          const bool fin = true, const uint8_t* mask_key = nullptr);
+
+/**
+ * @brief 把一个完整的消息编码成共享的只读内存, 用 WebSocketConnection::SendFrame 发送.
+ *        广播时只编码一次, 所有连接发送同一份内存
+ */
+std::shared_ptr<const std::string> EncodeWebSocketFrame(const WebSocketOpcode opcode, std::string_view payload);
+
+// 关闭帧的负载: 网络字节序的关闭码加上原因
+std::string EncodeWebSocketClosePayload(const uint16_t code, std::string_view reason);
+
+// 握手时根据 Sec-WebSocket-Key 计算 Sec-WebSocket-Accept: base64(SHA-1(key + GUID))
+std::string WebSocketAcceptKey(std::string_view key);
+
+}  // namespace net
@@ -0,0 +1,145 @@
+#include "net/http/websocket_codec.h"
+
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "net/buffer.h"
+
+namespace net {
+
+namespace {
+
+const uint8_t kMaskKey[4] = {0x37, 0xfa, 0x21, 0x3d};
+
+std::string RandomString(const size_t len, std::mt19937* const random) {
+  std::string data(len, '\0');
+  for (char& c : data) {
+    c = static_cast<char>((*random)());
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(WebSocketCodecTest, accept_key) {
+  // RFC 6455 1.3 中的例子
+  EXPECT_EQ(WebSocketAcceptKey("dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(WebSocketCodecTest, mask) {
+  std::mt19937 random(1);
+  // 覆盖 SSE2 的 64 字节、16 字节和剩下的逐字节部分, 以及没有对齐的起始地址
+  for (size_t len : {0, 1, 3, 15, 16, 17, 63, 64, 65, 100, 1000, 4099}) {
+    for (size_t offset : {0, 1, 7}) {
+      std::string data = RandomString(len + offset, &random);
+      std::string expected = data;
+      for (size_t i = 0; i < len; ++i) {
+        expected[offset + i] = static_cast<char>(expected[offset + i] ^ kMaskKey[i % 4]);
+      }
+      WebSocketMask(&data[offset], len, kMaskKey);
+      EXPECT_TRUE(data == expected) << "len " << len << " offset " << offset;
+    }
+  }
+}
+
+TEST(WebSocketCodecTest, parse) {
+  std::mt19937 random(2);
+  WebSocketParser parser(1024 * 1024);
+  Buffer buffer;
+  // 7 位、16 位和 64 位长度
+  for (size_t len : {0, 5, 125, 126, 1000, 65535, 65536, 200000}) {
+    std::string payload = RandomString(len, &random);
+    AppendWebSocketFrame(&buffer, WebSocketOpcode::kBinary, payload, true, kMaskKey);
+    const size_t frame_bytes = buffer.ReadableBytes();
+    // 逐步截断时都是 kIncomplete, 并且不会修改数据
+    for (size_t cut : {size_t(1), size_t(2), frame_bytes / 2, frame_bytes - 1}) {
+      if (cut >= frame_bytes) {
+        continue;
+      }
+      Buffer partial;
+      partial.Append(buffer.Peek(), cut);
+      EXPECT_EQ(parser.Parse(&partial), WebSocketParser::Result::kIncomplete) << len << " " << cut;
+      EXPECT_EQ(partial.ToStringView(), buffer.ToStringView().substr(0, cut));
+    }
+    ASSERT_EQ(parser.Parse(&buffer), WebSocketParser::Result::kComplete) << len;
+    EXPECT_TRUE(parser.frame().fin);
+    EXPECT_EQ(parser.frame().opcode, WebSocketOpcode::kBinary);
+    EXPECT_TRUE(parser.frame().payload == payload) << len;
+    EXPECT_EQ(parser.consumed_bytes(), frame_bytes);
+    buffer.Retrieve(parser.consumed_bytes());
+  }
+
+  // 同一个 Buffer 中的多个帧
+  AppendWebSocketFrame(&buffer, WebSocketOpcode::kText, "hel", false, kMaskKey);
+  AppendWebSocketFrame(&buffer, WebSocketOpcode::kPing, "", true, kMaskKey);
+  AppendWebSocketFrame(&buffer, WebSocketOpcode::kContinuation, "lo", true, kMaskKey);
+  ASSERT_EQ(parser.Parse(&buffer), WebSocketParser::Result::kComplete);
+  EXPECT_FALSE(parser.frame().fin);
+  EXPECT_EQ(parser.frame().payload, "hel");
+  buffer.Retrieve(parser.consumed_bytes());
+  ASSERT_EQ(parser.Parse(&buffer), WebSocketParser::Result::kComplete);
+  EXPECT_EQ(parser.frame().opcode, WebSocketOpcode::kPing);
+  EXPECT_TRUE(parser.frame().payload.empty());
+  buffer.Retrieve(parser.consumed_bytes());
+  ASSERT_EQ(parser.Parse(&buffer), WebSocketParser::Result::kComplete);
+  EXPECT_EQ(parser.frame().opcode, WebSocketOpcode::kContinuation);
+  EXPECT_EQ(parser.frame().payload, "lo");
+  buffer.Retrieve(parser.consumed_bytes());
+  EXPECT_EQ(parser.Parse(&buffer), WebSocketParser::Result::kIncomplete);
+}
+
+TEST(WebSocketCodecTest, parse_error) {
+  struct {
+    const char* name;
+    std::string frame;
+    WebSocketParser::Error error;
+  } const kCases[] = {
+      {"no mask", std::string("\x81\x01x", 3), WebSocketParser::Error::kProtocolError},
+      {"rsv1", std::string("\xc1\x80\0\0\0\0", 6), WebSocketParser::Error::kProtocolError},
+      {"unknown opcode", std::string("\x83\x80\0\0\0\0", 6), WebSocketParser::Error::kProtocolError},
+      {"fragmented ping", std::string("\x09\x80\0\0\0\0", 6), WebSocketParser::Error::kProtocolError},
+      {"long ping", std::string("\x89\xfe\0\x7e", 4), WebSocketParser::Error::kProtocolError},
+      {"64-bit msb", std::string("\x82\xff\x80\0\0\0\0\0\0\0", 10), WebSocketParser::Error::kProtocolError},
+      // 只有帧头就能判断过大
+      {"too big", std::string("\x82\xff\0\0\0\0\0\x10\0\x01", 10), WebSocketParser::Error::kMessageTooBig},
+  };
+  for (const auto& test_case : kCases) {
+    WebSocketParser parser(1024 * 1024);
+    Buffer buffer;
+    buffer.Append(test_case.frame);
+    EXPECT_EQ(parser.Parse(&buffer), WebSocketParser::Result::kError) << test_case.name;
+    EXPECT_EQ(parser.error(), test_case.error) << test_case.name;
+  }
+  EXPECT_EQ(WebSocketParser::ErrorToCloseCode(WebSocketParser::Error::kMessageTooBig),
+            WebSocketCloseCode::kMessageTooBig);
+
+  // 客户端一侧解析服务端没有掩码的帧
+  WebSocketParser client(1024, false);
+  Buffer buffer;
+  buffer.Append(*EncodeWebSocketFrame(WebSocketOpcode::kText, "hello"));
+  ASSERT_EQ(client.Parse(&buffer), WebSocketParser::Result::kComplete);
+  EXPECT_EQ(client.frame().payload, "hello");
+}
+
+TEST(WebSocketCodecTest, encode) {
+  // 服务端的帧没有掩码, 长度按 7 位、16 位、64 位编码
+  EXPECT_EQ(*EncodeWebSocketFrame(WebSocketOpcode::kText, "hi"), std::string("\x81\x02hi", 4));
+  std::string frame = *EncodeWebSocketFrame(WebSocketOpcode::kBinary, std::string(300, 'a'));
+  EXPECT_EQ(frame.substr(0, 4), std::string("\x82\x7e\x01\x2c", 4));
+  EXPECT_EQ(frame.size(), 304u);
+  frame = *EncodeWebSocketFrame(WebSocketOpcode::kBinary, std::string(70000, 'a'));
+  EXPECT_EQ(frame.substr(0, 10), std::string("\x82\x7f\0\0\0\0\0\x01\x11\x70", 10));
+  EXPECT_EQ(frame.size(), 70010u);
+
+  Buffer buffer;
+  AppendWebSocketFrame(&buffer, WebSocketOpcode::kText, "hi", true, kMaskKey);
+  EXPECT_EQ(buffer.RetrieveAsString(6), std::string("\x81\x82\x37\xfa\x21\x3d", 6));
+  EXPECT_EQ(buffer.RetrieveAllAsString(), std::string({static_cast<char>('h' ^ 0x37), static_cast<char>('i' ^ 0xfa)}));
+
+  EXPECT_EQ(EncodeWebSocketClosePayload(1000, "bye"), std::string("\x03\xe8" "bye", 5));
+  // 原因过长时截断到控制帧的上限
+  EXPECT_EQ(EncodeWebSocketClosePayload(1001, std::string(200, 'x')).size(), 125u);
+}
+
+}  // namespace net
@@ -0,0 +1,296 @@
+#include "net/http/websocket_connection.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "logger/log.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+
+namespace net {
+
+namespace {
+
+// 心跳定时器允许推迟的比例和上限, 和 HttpServer 的空闲超时一样, 大量连接的定时器可以合并成少量的唤醒
+constexpr double kPingTimerSlackRatio = 0.1;
+constexpr double kMaxPingTimerSlackSeconds = 1.0;
+
+}  // namespace
+
+WebSocketConnection::WebSocketConnection() = default;
+
+WebSocketConnection::~WebSocketConnection() = default;
+
+void WebSocketConnection::SetMessageCallback(const MessageCallback& cb) {
+  message_callback_ = cb;
+}
+
+void WebSocketConnection::SetCloseCallback(const CloseCallback& cb) {
+  close_callback_ = cb;
+}
+
+void WebSocketConnection::SendText(std::string_view text) {
+  SendFrame(EncodeWebSocketFrame(WebSocketOpcode::kText, text));
+}
+
+void WebSocketConnection::SendBinary(std::string_view data) {
+  SendFrame(EncodeWebSocketFrame(WebSocketOpcode::kBinary, data));
+}
+
+void WebSocketConnection::SendFrame(std::shared_ptr<const std::string> frame) {
+  bool in_loop = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    in_loop = loop_ != nullptr && loop_->IsInLoopThread();
+  }
+  // 广播时 IO 线程中逐个发给本线程的连接, 直接发送, 不需要为每个连接构造任务
+  if (in_loop) {
+    SendFrameInLoop(frame);
+    return;
+  }
+  RunInLoop([self = shared_from_this(), frame = std::move(frame)]() { self->SendFrameInLoop(frame); });
+}
+
+void WebSocketConnection::Close(const uint16_t code, std::string_view reason) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    closed_ = true;
+  }
+  RunInLoop([self = shared_from_this(), code, reason = std::string(reason)]() { self->CloseInLoop(code, reason); });
+}
+
+bool WebSocketConnection::closed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_;
+}
+
+EventLoop* WebSocketConnection::GetLoop() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return loop_;
+}
+
+void WebSocketConnection::Attach(const TcpConnectionPtr& conn, const WebSocketOptions& options) {
+  conn_ = conn;
+  options_ = options;
+  parser_ = std::make_unique<WebSocketParser>(options.max_message_bytes);
+  EventLoop* loop = conn->GetLoop();
+  if (options.ping_interval_seconds > 0) {
+    double slack = std::min(options.ping_interval_seconds * kPingTimerSlackRatio, kMaxPingTimerSlackSeconds);
+    std::weak_ptr<WebSocketConnection> weak_self = shared_from_this();
+    ping_timer_ = loop->RunEvery(
+        options.ping_interval_seconds,
+        [weak_self]() {
+          WebSocketConnectionPtr self = weak_self.lock();
+          if (self != nullptr) {
+            self->OnPingTimer();
+          }
+        },
+        slack);
+  }
+  std::vector<std::function<void()>> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loop_ = loop;
+    pending.swap(pending_);
+  }
+  // 之后其他线程的调用都排在这些之后
+  for (const std::function<void()>& cb : pending) {
+    cb();
+  }
+}
+
+void WebSocketConnection::OnData(Buffer* const buffer) {
+  received_ = true;
+  while (true) {
+    WebSocketParser::Result result = parser_->Parse(buffer);
+    if (result == WebSocketParser::Result::kIncomplete) {
+      break;
+    }
+    if (result == WebSocketParser::Result::kError) {
+      WebSocketCloseCode code = WebSocketParser::ErrorToCloseCode(parser_->error());
+      LOG_DEBUG << "WebSocket parse frame fail, close with code [" << static_cast<uint16_t>(code) << "]";
+      buffer->RetrieveAll();
+      ShutdownInLoop(static_cast<uint16_t>(code));
+      break;
+    }
+    // 回调返回之后 payload 才失效
+    const bool more = HandleFrame(parser_->frame());
+    buffer->Retrieve(parser_->consumed_bytes());
+    if (!more) {
+      buffer->RetrieveAll();
+      break;
+    }
+  }
+}
+
+void WebSocketConnection::OnDisconnected() {
+  if (loop_ != nullptr) {
+    loop_->Cancel(ping_timer_);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    pending_.clear();
+  }
+  // 回调中通常持有自己的 shared_ptr, 清空以免循环引用
+  CloseCallback close_callback;
+  close_callback.swap(close_callback_);
+  message_callback_ = nullptr;
+  if (close_callback) {
+    close_callback(shared_from_this(), close_code_);
+  }
+}
+
+void WebSocketConnection::RunInLoop(std::function<void()> cb) {
+  EventLoop* loop = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loop_ == nullptr) {
+      pending_.push_back(std::move(cb));
+      return;
+    }
+    loop = loop_;
+  }
+  loop->RunInLoop(std::move(cb));
+}
+
+void WebSocketConnection::SendFrameInLoop(const std::shared_ptr<const std::string>& frame) {
+  TcpConnectionPtr conn = conn_.lock();
+  if (conn == nullptr || !conn->Connected() || close_sent_) {
+    return;
+  }
+  if (conn->output_bytes() + frame->size() > options_.max_queued_bytes) {
+    LOG_WARN << "WebSocket connection [" << conn->name() << "] is too slow with [" << conn->output_bytes()
+             << "] bytes queued, close it";
+    conn->ForceClose();
+    return;
+  }
+  conn->Send(frame);
+}
+
+void WebSocketConnection::SendControlInLoop(const WebSocketOpcode opcode, std::string_view payload) {
+  TcpConnectionPtr conn = conn_.lock();
+  if (conn == nullptr || !conn->Connected()) {
+    return;
+  }
+  Buffer frame(payload.size() + 16);
+  AppendWebSocketFrame(&frame, opcode, payload);
+  conn->Send(&frame);
+}
+
+void WebSocketConnection::CloseInLoop(const uint16_t code, const std::string& reason) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  if (close_sent_) {
+    return;
+  }
+  close_sent_ = true;
+  // 1005 表示关闭帧中没有关闭码
+  if (code == static_cast<uint16_t>(WebSocketCloseCode::kNoStatus)) {
+    SendControlInLoop(WebSocketOpcode::kClose, "");
+  } else {
+    SendControlInLoop(WebSocketOpcode::kClose, EncodeWebSocketClosePayload(code, reason));
+  }
+}
+
+void WebSocketConnection::ShutdownInLoop(const uint16_t code) {
+  CloseInLoop(code, "");
+  TcpConnectionPtr conn = conn_.lock();
+  if (conn != nullptr) {
+    conn->Shutdown();
+  }
+}
+
+bool WebSocketConnection::HandleFrame(const WebSocketFrame& frame) {
+  const bool in_fragments = fragments_opcode_ != WebSocketOpcode::kContinuation;
+  WebSocketCloseCode error = WebSocketCloseCode::kProtocolError;
+  switch (frame.opcode) {
+    case WebSocketOpcode::kText:
+    case WebSocketOpcode::kBinary:
+      if (in_fragments) {
+        break;
+      }
+      if (!frame.fin) {
+        fragments_opcode_ = frame.opcode;
+        fragments_.assign(frame.payload);
+        return true;
+      }
+      if (message_callback_) {
+        message_callback_(shared_from_this(), frame.payload, frame.opcode == WebSocketOpcode::kBinary);
+      }
+      return true;
+    case WebSocketOpcode::kContinuation:
+      if (!in_fragments) {
+        break;
+      }
+      if (fragments_.size() + frame.payload.size() > options_.max_message_bytes) {
+        error = WebSocketCloseCode::kMessageTooBig;
+        break;
+      }
+      fragments_.append(frame.payload);
+      if (frame.fin) {
+        const bool binary = fragments_opcode_ == WebSocketOpcode::kBinary;
+        fragments_opcode_ = WebSocketOpcode::kContinuation;
+        if (message_callback_) {
+          message_callback_(shared_from_this(), fragments_, binary);
+        }
+        fragments_.clear();
+      }
+      return true;
+    case WebSocketOpcode::kPing:
+      if (!close_sent_) {
+        SendControlInLoop(WebSocketOpcode::kPong, frame.payload);
+      }
+      return true;
+    case WebSocketOpcode::kPong:
+      // 收到任何数据都已经算作活跃
+      return true;
+    case WebSocketOpcode::kClose: {
+      if (frame.payload.size() == 1) {
+        break;
+      }
+      close_code_ = static_cast<uint16_t>(WebSocketCloseCode::kNoStatus);
+      if (frame.payload.size() >= 2) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(frame.payload.data());
+        close_code_ = static_cast<uint16_t>((p[0] << 8) | p[1]);
+      }
+      // 回复同样的关闭码, 然后由服务端关闭 TCP 连接
+      ShutdownInLoop(close_code_);
+      return false;
+    }
+  }
+
+  LOG_DEBUG << "WebSocket receive unexpected frame with opcode [" << static_cast<int>(frame.opcode) << "]";
+  ShutdownInLoop(static_cast<uint16_t>(error));
+  return false;
+}
+
+void WebSocketConnection::OnPingTimer() {
+  TcpConnectionPtr conn = conn_.lock();
+  if (conn == nullptr || !conn->Connected()) {
+    return;
+  }
+  if (received_) {
+    received_ = false;
+    ping_sent_ = false;
+    return;
+  }
+  if (ping_sent_) {
+    LOG_DEBUG << "WebSocket connection [" << conn->name() << "] ping timeout";
+    conn->ForceClose();
+    return;
+  }
+  ping_sent_ = true;
+  SendControlInLoop(WebSocketOpcode::kPing, "");
+}
+
+}  // namespace net
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "net/callbacks.h"
+#include "net/http/websocket_codec.h"
+#include "net/timer_id.hpp"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class Buffer;
+class EventLoop;
+
+// HttpServer 对所有 WebSocket 连接使用的设置
+struct WebSocketOptions {
+  // 一个消息 (所有分片合计) 的最大长度, 超过时以 1009 关闭
+  size_t max_message_bytes = 1024 * 1024;
+  // 连续 ping_interval_seconds 没有收到任何数据时发送 ping, 再过一个间隔仍然没有数据时关闭连接; 0 表示不发送
+  double ping_interval_seconds = 30.0;
+  // 输出积压的上限, 超过时认为是慢消费者, 直接关闭连接, 广播时不会为它无限堆积内存
+  size_t max_queued_bytes = 4 * 1024 * 1024;
+};
+
+class WebSocketConnection;
+using WebSocketConnectionPtr = std::shared_ptr<WebSocketConnection>;
+
+/**
+ * @brief 升级之后的一个 WebSocket 连接 (RFC 6455 服务端), 由 HttpResponse::UpgradeToWebSocket 创建
+ *
+ * @note
+ *   1. 回调在 UpgradeToWebSocket 之后、HttpCallback 返回之前设置, 之后在连接所属的 IO 线程中执行;
+ *      MessageCallback 中的 message 只在回调期间有效, 没有分片的消息直接指向输入缓冲区, 不经过拷贝
+ *   2. Send* / Close 可以在任何线程中调用, 在 IO 线程中直接交给 TcpConnection, 否则通过 QueueInLoop;
+ *      HttpServer 在回调返回之后才把它绑定到连接上, 之前发送的数据先暂存, 绑定时按顺序发送
+ *   3. 每个连接的发送队列就是 TcpConnection 的输出队列, SendFrame 发送的共享内存不经过拷贝.
+ *      广播时用 EncodeWebSocketFrame 编码一次, 同一份内存发给所有连接. 输出积压超过 max_queued_bytes 时关闭连接
+ *      在多个 IO 线程之间按主题广播见 BroadcastHub
+ *   4. 心跳: 每个连接一个 EventLoop::RunEvery 定时器, 收到任何数据都算活跃, 空闲一个间隔之后发送 ping,
+ *      再空闲一个间隔关闭连接
+ *   5. 关闭握手: 收到关闭帧时回复关闭帧然后关闭写端; 主动 Close 时先发送关闭帧, 等待对端关闭.
+ *      连接断开时调用一次 CloseCallback, 参数是对端的关闭码, 没有收到关闭帧时是 1006
+ *   6. 文本消息不检查 UTF-8, 不支持扩展 (例如 permessage-deflate) 和子协议协商
+ */
+class WebSocketConnection final : public std::enable_shared_from_this<WebSocketConnection> {
+ public:
+  using MessageCallback = std::function<void(const WebSocketConnectionPtr&, std::string_view message, bool binary)>;
+  using CloseCallback = std::function<void(const WebSocketConnectionPtr&, uint16_t code)>;
+
+ public:
+  WebSocketConnection();
+  ~WebSocketConnection();
+
+ public:
+  void SetMessageCallback(const MessageCallback& cb);
+  void SetCloseCallback(const CloseCallback& cb);
+
+  void SendText(std::string_view text);
+  void SendBinary(std::string_view data);
+  // 发送 EncodeWebSocketFrame 编码好的帧
+  void SendFrame(std::shared_ptr<const std::string> frame);
+  // 发起关闭握手, 之后的发送被忽略
+  void Close(const uint16_t code = static_cast<uint16_t>(WebSocketCloseCode::kNormal), std::string_view reason = "");
+  // 连接已经断开或者已经开始关闭握手
+  bool closed() const;
+  // 绑定之前为 nullptr
+  EventLoop* GetLoop() const;
+
+ public:
+  // 仅供 HttpServer 使用, 在 IO 线程中发送 101 响应之后调用
+  void Attach(const TcpConnectionPtr& conn, const WebSocketOptions& options);
+  // 仅供 HttpServer 使用, 处理 buffer 中完整的帧
+  void OnData(Buffer* const buffer);
+  // 仅供 HttpServer 使用, 连接断开时在 IO 线程中调用
+  void OnDisconnected();
+
+ private:
+  // 绑定之前暂存 cb, 之后在 IO 线程中执行
+  void RunInLoop(std::function<void()> cb);
+  void SendFrameInLoop(const std::shared_ptr<const std::string>& frame);
+  void SendControlInLoop(const WebSocketOpcode opcode, std::string_view payload);
+  void CloseInLoop(const uint16_t code, const std::string& reason);
+  // 发送 (或者回复) 关闭帧之后关闭写端, 不再等待对端
+  void ShutdownInLoop(const uint16_t code);
+  // 处理一个完整的帧, 返回 false 时停止解析
+  bool HandleFrame(const WebSocketFrame& frame);
+  void OnPingTimer();
+
+ private:
+  mutable std::mutex mutex_;
+  EventLoop* loop_ = nullptr;
+  // 绑定之前调用的 RunInLoop
+  std::vector<std::function<void()>> pending_;
+  bool closed_ = false;
+
+  // 以下只在 IO 线程中访问
+  std::weak_ptr<TcpConnection> conn_;
+  WebSocketOptions options_;
+  std::unique_ptr<WebSocketParser> parser_;
+  MessageCallback message_callback_;
+  CloseCallback close_callback_;
+  // 正在拼接的分片消息
+  std::string fragments_;
+  WebSocketOpcode fragments_opcode_ = WebSocketOpcode::kContinuation;
+  bool close_sent_ = false;
+  uint16_t close_code_ = static_cast<uint16_t>(WebSocketCloseCode::kAbnormal);
+  TimerId ping_timer_;
+  // 上一次心跳之后是否收到过数据, 以及是否已经发送了 ping
+  bool received_ = false;
+  bool ping_sent_ = false;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(WebSocketConnection);
+};
+
+}  // namespace net
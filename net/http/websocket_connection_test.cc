@@ -0,0 +1,292 @@
+#include "net/http/websocket_connection.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/http/http_response.h"
+#include "net/http/http_server.h"
+#include "net/http/http_test_util.hpp"
+#include "net/inet_address.h"
+
+namespace net {
+
+namespace {
+
+uint16_t CloseCode(const std::string& payload) {
+  return static_cast<uint16_t>((static_cast<uint8_t>(payload[0]) << 8) | static_cast<uint8_t>(payload[1]));
+}
+
+// 回显收到的消息, 记录每个连接关闭时的关闭码
+class EchoService {
+ public:
+  void Setup(HttpServer* const server, const WebSocketOptions& options = WebSocketOptions()) {
+    server->SetWebSocketOptions(options);
+    server->SetHttpCallback([this](const HttpRequest& request, HttpResponse* response) {
+      if (request.path() != "/ws") {
+        response->SetStatusCode(404);
+        return;
+      }
+      WebSocketConnectionPtr ws = response->UpgradeToWebSocket(request);
+      if (ws == nullptr) {
+        return;
+      }
+      ws->SetMessageCallback([](const WebSocketConnectionPtr& conn, std::string_view message, bool binary) {
+        if (message == "quit") {
+          conn->Close(4000, "bye");
+        } else if (binary) {
+          conn->SendBinary(message);
+        } else {
+          conn->SendText(message);
+        }
+      });
+      ws->SetCloseCallback([this](const WebSocketConnectionPtr& conn, uint16_t code) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        close_codes_.push_back(code);
+        EXPECT_TRUE(conn->closed());
+      });
+      // 绑定到连接之前发送的消息
+      ws->SendText("welcome");
+      std::lock_guard<std::mutex> lock(mutex_);
+      connections_.push_back(ws);
+    });
+  }
+
+  std::vector<WebSocketConnectionPtr> connections() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connections_;
+  }
+  std::vector<uint16_t> close_codes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return close_codes_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<WebSocketConnectionPtr> connections_;
+  std::vector<uint16_t> close_codes_;
+};
+
+// 完成握手并读取欢迎消息
+int Connect(const InetAddress& addr, const std::string& extra = "") {
+  int fd = BlockingConnect(addr);
+  if (fd < 0 || !WriteAll(fd, UpgradeRequest("/ws") + extra)) {
+    return -1;
+  }
+  std::string header = ReadHeader(fd);
+  EXPECT_EQ(header.substr(0, 34), "HTTP/1.1 101 Switching Protocols\r\n");
+  EXPECT_NE(header.find("\r\nSec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"), std::string::npos);
+  EXPECT_EQ(header.find("Content-Length"), std::string::npos);
+  WebSocketOpcode opcode;
+  std::string payload;
+  EXPECT_TRUE(ReadFrame(fd, &opcode, &payload));
+  EXPECT_EQ(payload, "welcome");
+  return fd;
+}
+
+}  // namespace
+
+TEST(WebSocketConnectionTest, handshake) {
+  EchoService service;
+  RunHttpServer("WebSocketServer", [&service](HttpServer* server) { service.Setup(server); },
+                [](const InetAddress& addr) {
+                  auto reply = [&addr](const std::string& request) {
+                    int fd = BlockingConnect(addr);
+                    EXPECT_TRUE(WriteAll(fd, request));
+                    std::string header = ReadHeader(fd);
+                    ::close(fd);
+                    return header;
+                  };
+                  EXPECT_EQ(reply("GET /ws HTTP/1.1\r\n\r\n").substr(0, 24), "HTTP/1.1 400 Bad Request");
+                  std::string request = UpgradeRequest("/ws");
+                  request.replace(request.find("Version: 13"), 11, "Version: 8");
+                  std::string header = reply(request);
+                  EXPECT_EQ(header.substr(0, 29), "HTTP/1.1 426 Upgrade Required");
+                  EXPECT_NE(header.find("\r\nSec-WebSocket-Version: 13\r\n"), std::string::npos);
+                  request = UpgradeRequest("/ws");
+                  request.replace(0, 3, "POST");
+                  EXPECT_EQ(reply(request).substr(0, 24), "HTTP/1.1 400 Bad Request");
+                });
+  EXPECT_TRUE(service.connections().empty());
+}
+
+TEST(WebSocketConnectionTest, echo_and_close) {
+  EchoService service;
+  RunHttpServer("WebSocketServer", [&service](HttpServer* server) { service.Setup(server); },
+                [](const InetAddress& addr) {
+                  // 和升级请求一起到达的帧
+                  int fd = Connect(addr, ClientFrame(WebSocketOpcode::kText, "first"));
+                  ASSERT_GE(fd, 0);
+                  WebSocketOpcode opcode;
+                  std::string payload;
+                  ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                  EXPECT_EQ(opcode, WebSocketOpcode::kText);
+                  EXPECT_EQ(payload, "first");
+
+                  // 分片的消息中间插入 ping, 先收到 pong
+                  ASSERT_TRUE(WriteAll(fd, ClientFrame(WebSocketOpcode::kText, "hel", false) +
+                                               ClientFrame(WebSocketOpcode::kPing, "p") +
+                                               ClientFrame(WebSocketOpcode::kContinuation, "lo")));
+                  ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                  EXPECT_EQ(opcode, WebSocketOpcode::kPong);
+                  EXPECT_EQ(payload, "p");
+                  ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                  EXPECT_EQ(payload, "hello");
+
+                  std::string large(200000, '\0');
+                  for (size_t i = 0; i < large.size(); ++i) {
+                    large[i] = static_cast<char>(i * 7);
+                  }
+                  ASSERT_TRUE(WriteAll(fd, ClientFrame(WebSocketOpcode::kBinary, large)));
+                  ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                  EXPECT_EQ(opcode, WebSocketOpcode::kBinary);
+                  EXPECT_TRUE(payload == large);
+
+                  // 客户端发起关闭, 服务端回复同样的关闭码之后关闭连接
+                  std::string close = ClientFrame(WebSocketOpcode::kClose, EncodeWebSocketClosePayload(1000, ""));
+                  ASSERT_TRUE(WriteAll(fd, close));
+                  ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                  EXPECT_EQ(opcode, WebSocketOpcode::kClose);
+                  EXPECT_EQ(CloseCode(payload), 1000);
+                  EXPECT_TRUE(ReadEof(fd));
+                  ::close(fd);
+
+                  // 服务端发起关闭
+                  fd = Connect(addr);
+                  ASSERT_GE(fd, 0);
+                  ASSERT_TRUE(WriteAll(fd, ClientFrame(WebSocketOpcode::kText, "quit")));
+                  ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                  EXPECT_EQ(opcode, WebSocketOpcode::kClose);
+                  EXPECT_EQ(CloseCode(payload), 4000);
+                  EXPECT_EQ(payload.substr(2), "bye");
+                  ASSERT_TRUE(WriteAll(fd, ClientFrame(WebSocketOpcode::kClose, payload)));
+                  EXPECT_TRUE(ReadEof(fd));
+                  ::close(fd);
+                });
+  std::vector<uint16_t> close_codes = service.close_codes();
+  std::sort(close_codes.begin(), close_codes.end());
+  EXPECT_EQ(close_codes, std::vector<uint16_t>({1000, 4000}));
+}
+
+TEST(WebSocketConnectionTest, protocol_error) {
+  EchoService service;
+  WebSocketOptions options;
+  options.max_message_bytes = 1000;
+  RunHttpServer("WebSocketServer", [&service, &options](HttpServer* server) { service.Setup(server, options); },
+                [](const InetAddress& addr) {
+                  struct {
+                    std::string frames;
+                    uint16_t code;
+                  } const kCases[] = {
+                      // 没有掩码
+                      {std::string("\x81\x01x", 3), 1002},
+                      // 没有开始的分片
+                      {ClientFrame(WebSocketOpcode::kContinuation, "x"), 1002},
+                      // 分片没有结束又开始新的消息
+                      {ClientFrame(WebSocketOpcode::kText, "x", false) + ClientFrame(WebSocketOpcode::kText, "y"),
+                       1002},
+                      {ClientFrame(WebSocketOpcode::kBinary, std::string(1001, 'a')), 1009},
+                      // 每个分片都不大, 合计超过上限
+                      {ClientFrame(WebSocketOpcode::kText, std::string(600, 'a'), false) +
+                           ClientFrame(WebSocketOpcode::kContinuation, std::string(600, 'a')),
+                       1009},
+                  };
+                  for (const auto& test_case : kCases) {
+                    int fd = Connect(addr);
+                    ASSERT_GE(fd, 0);
+                    ASSERT_TRUE(WriteAll(fd, test_case.frames));
+                    WebSocketOpcode opcode;
+                    std::string payload;
+                    ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                    EXPECT_EQ(opcode, WebSocketOpcode::kClose);
+                    EXPECT_EQ(CloseCode(payload), test_case.code);
+                    EXPECT_TRUE(ReadEof(fd));
+                    ::close(fd);
+                  }
+                });
+  // 对端没有发送关闭帧
+  EXPECT_EQ(service.close_codes(), std::vector<uint16_t>(5, 1006));
+}
+
+TEST(WebSocketConnectionTest, keepalive) {
+  EchoService service;
+  WebSocketOptions options;
+  options.ping_interval_seconds = 0.05;
+  RunHttpServer("WebSocketServer", [&service, &options](HttpServer* server) { service.Setup(server, options); },
+                [](const InetAddress& addr) {
+                  int fd = Connect(addr);
+                  ASSERT_GE(fd, 0);
+                  // 回复 pong 的连接一直保持
+                  WebSocketOpcode opcode;
+                  std::string payload;
+                  for (int i = 0; i < 3; ++i) {
+                    ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                    EXPECT_EQ(opcode, WebSocketOpcode::kPing);
+                    ASSERT_TRUE(WriteAll(fd, ClientFrame(WebSocketOpcode::kPong, payload)));
+                  }
+                  // 不再回复, 下一个间隔关闭连接
+                  auto start = std::chrono::steady_clock::now();
+                  ASSERT_TRUE(ReadFrame(fd, &opcode, &payload));
+                  EXPECT_EQ(opcode, WebSocketOpcode::kPing);
+                  EXPECT_TRUE(ReadEof(fd));
+                  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+                  ::close(fd);
+                });
+  EXPECT_EQ(service.close_codes(), std::vector<uint16_t>({1006}));
+}
+
+TEST(WebSocketConnectionTest, broadcast_and_slow_consumer) {
+  EchoService service;
+  WebSocketOptions options;
+  options.max_queued_bytes = 256 * 1024;
+  RunHttpServer("WebSocketServer", [&service, &options](HttpServer* server) { service.Setup(server, options); },
+                [&service](const InetAddress& addr) {
+                  int fast = Connect(addr);
+                  int slow = Connect(addr);
+                  ASSERT_GE(fast, 0);
+                  ASSERT_GE(slow, 0);
+                  int rcvbuf = 16 * 1024;
+                  ::setsockopt(slow, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+                  std::vector<WebSocketConnectionPtr> connections = service.connections();
+                  ASSERT_EQ(connections.size(), 2u);
+
+                  // 在其他线程中广播, 同一帧编码一次, 发给所有连接
+                  std::shared_ptr<const std::string> frame =
+                      EncodeWebSocketFrame(WebSocketOpcode::kBinary, std::string(16 * 1024, 'n'));
+                  constexpr int kFrames = 1024;
+                  std::thread reader([fast]() {
+                    WebSocketOpcode opcode;
+                    std::string payload;
+                    for (int i = 0; i < kFrames; ++i) {
+                      ASSERT_TRUE(ReadFrame(fast, &opcode, &payload));
+                      EXPECT_EQ(payload.size(), 16u * 1024);
+                    }
+                  });
+                  for (int i = 0; i < kFrames; ++i) {
+                    for (const WebSocketConnectionPtr& ws : connections) {
+                      ws->SendFrame(frame);
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                  }
+                  reader.join();
+                  // 不读数据的连接积压超过上限之后被关闭, 不影响其他连接
+                  EXPECT_TRUE(connections[1]->closed());
+                  EXPECT_FALSE(connections[0]->closed());
+                  ::close(slow);
+                  ::close(fast);
+                });
+  std::vector<uint16_t> close_codes = service.close_codes();
+  EXPECT_EQ(close_codes, std::vector<uint16_t>({1006, 1006}));
+}
+
+}  // namespace net
@@ -0,0 +1,89 @@
+#include "net/inet_address.h"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+
+#include "logger/log.h"
+
+namespace net {
+
+static_assert(offsetof(sockaddr_in, sin_family) == offsetof(sockaddr_in6, sin6_family),
+              "sin_family and sin6_family must be at the same offset");
+
+InetAddress::InetAddress(const uint16_t port, const bool loopback_only, const bool ipv6) {
+  if (ipv6) {
+    ::memset(&addr6_, 0, sizeof addr6_);
+    addr6_.sin6_family = AF_INET6;
+    addr6_.sin6_addr = loopback_only ? in6addr_loopback : in6addr_any;
+    addr6_.sin6_port = htons(port);
+  } else {
+    ::memset(&addr_, 0, sizeof addr_);
+    addr_.sin_family = AF_INET;
+    addr_.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+    addr_.sin_port = htons(port);
+  }
+}
+
+InetAddress::InetAddress(const std::string& ip, const uint16_t port) {
+  if (ip.find(':') != std::string::npos) {
+    ::memset(&addr6_, 0, sizeof addr6_);
+    addr6_.sin6_family = AF_INET6;
+    addr6_.sin6_port = htons(port);
+    if (::inet_pton(AF_INET6, ip.c_str(), &addr6_.sin6_addr) <= 0) {
+      LOG_ERROR << "invalid ipv6 address [" << ip << "]";
+    }
+  } else {
+    ::memset(&addr_, 0, sizeof addr_);
+    addr_.sin_family = AF_INET;
+    addr_.sin_port = htons(port);
+    if (::inet_pton(AF_INET, ip.c_str(), &addr_.sin_addr) <= 0) {
+      LOG_ERROR << "invalid ipv4 address [" << ip << "]";
+    }
+  }
+}
+
+InetAddress::InetAddress(const struct sockaddr_in& addr) : addr_(addr) {
+}
+
+InetAddress::InetAddress(const struct sockaddr_in6& addr) : addr6_(addr) {
+}
+
+sa_family_t InetAddress::family() const {
+  return addr_.sin_family;
+}
+
+std::string InetAddress::ToIp() const {
+  char buf[INET6_ADDRSTRLEN] = {0};
+  if (family() == AF_INET6) {
+    ::inet_ntop(AF_INET6, &addr6_.sin6_addr, buf, sizeof buf);
+  } else {
+    ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof buf);
+  }
+  return buf;
+}
+
+std::string InetAddress::ToIpPort() const {
+  if (family() == AF_INET6) {
+    return "[" + ToIp() + "]:" + std::to_string(port());
+  }
+  return ToIp() + ":" + std::to_string(port());
+}
+
+uint16_t InetAddress::port() const {
+  return ntohs(addr_.sin_port);
+}
+
+const struct sockaddr* InetAddress::GetSockAddr() const {
+  return reinterpret_cast<const struct sockaddr*>(&addr6_);
+}
+
+socklen_t InetAddress::GetSockLen() const {
+  return family() == AF_INET6 ? sizeof addr6_ : sizeof addr_;
+}
+
+void InetAddress::SetSockAddrInet6(const struct sockaddr_in6& addr6) {
+  addr6_ = addr6;
+}
+
+}  // namespace net
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include <cstdint>
+#include <string>
+
+namespace net {
+
+/**
+ * @brief 对 sockaddr_in / sockaddr_in6 的简单封装, 可以直接拷贝
+ */
+class InetAddress {
+ public:
+  /**
+   * @brief 监听本机所有地址 (或只监听回环地址) 的 port 端口, 常用于 TcpServer
+   *
+   * @param port
+   * @param loopback_only
+   * @param ipv6
+   */
+  explicit InetAddress(const uint16_t port = 0, const bool loopback_only = false, const bool ipv6 = false);
+  // ip 格式为 "1.2.3.4" 或者 "::1"
+  InetAddress(const std::string& ip, const uint16_t port);
+  explicit InetAddress(const struct sockaddr_in& addr);
+  // addr 也可以是 getsockname / accept 等返回的 IPv4 地址, 根据 family 解析
+  explicit InetAddress(const struct sockaddr_in6& addr);
+
+ public:
+  sa_family_t family() const;
+  std::string ToIp() const;
+  std::string ToIpPort() const;
+  uint16_t port() const;
+
+  const struct sockaddr* GetSockAddr() const;
+  socklen_t GetSockLen() const;
+  void SetSockAddrInet6(const struct sockaddr_in6& addr6);
+
+ private:
+  union {
+    struct sockaddr_in addr_;
+    struct sockaddr_in6 addr6_;
+  };
+};
+
+}  // namespace net
@@ -0,0 +1,348 @@
+#include "net/output_queue.h"
+
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "logger/log.h"
+
+namespace net {
+
+OutputQueue::~OutputQueue() {
+  ClosePipe();
+}
+
+void OutputQueue::Append(const void* data, const size_t len) {
+  if (len == 0) {
+    return;
+  }
+  if (slices_.empty() || !slices_.back().is_owned() || slices_.back().owned.size() + len > kMaxOwnedSliceBytes) {
+    slices_.emplace_back();
+  }
+  slices_.back().owned.append(static_cast<const char*>(data), len);
+  bytes_ += len;
+}
+
+void OutputQueue::Append(std::shared_ptr<const void> holder, const void* data, const size_t len) {
+  if (len < kMinSharedBytes) {
+    Append(data, len);
+    return;
+  }
+  CHECK(holder != nullptr);
+  slices_.emplace_back();
+  Slice& slice = slices_.back();
+  slice.holder = std::move(holder);
+  slice.shared_data = static_cast<const char*>(data);
+  slice.shared_len = len;
+  bytes_ += len;
+}
+
+void OutputQueue::Append(std::shared_ptr<const std::string> blob) {
+  const void* data = blob->data();
+  const size_t len = blob->size();
+  Append(std::shared_ptr<const void>(std::move(blob)), data, len);
+}
+
+void OutputQueue::AppendFile(std::shared_ptr<const File> file, const off_t offset, const size_t len) {
+  if (len == 0) {
+    return;
+  }
+  CHECK(file != nullptr);
+  CHECK_GE(offset, 0);
+  slices_.emplace_back();
+  Slice& slice = slices_.back();
+  slice.file = std::move(file);
+  slice.file_offset = offset;
+  slice.file_len = len;
+  bytes_ += len;
+}
+
+ssize_t OutputQueue::WriteTo(const int fd, const size_t max_bytes, int* const saved_errno) {
+  size_t total = 0;
+  while (!slices_.empty() && total < max_bytes) {
+    size_t attempted = 0;
+    ssize_t n = slices_.front().is_file() ? WriteFile(fd, max_bytes - total, &attempted, saved_errno)
+                                          : WriteMemory(fd, &attempted, saved_errno);
+    if (n < 0) {
+      return total > 0 ? static_cast<ssize_t>(total) : -1;
+    }
+    total += n;
+    Consume(static_cast<size_t>(n));
+    // 没有写完说明内核缓冲区已经满了
+    if (static_cast<size_t>(n) < attempted) {
+      break;
+    }
+  }
+  return static_cast<ssize_t>(total);
+}
+
+void OutputQueue::Clear() {
+  slices_.clear();
+  bytes_ = 0;
+  // pipe 中残留的数据属于被丢弃的文件数据片
+  ClosePipe();
+}
+
+size_t OutputQueue::bytes() const {
+  return bytes_;
+}
+
+bool OutputQueue::empty() const {
+  return bytes_ == 0;
+}
+
+size_t OutputQueue::slice_num() const {
+  return slices_.size();
+}
+
+ssize_t OutputQueue::WriteMemory(const int fd, size_t* const attempted, int* const saved_errno) {
+  size_t iovcnt = 0;
+  *attempted = 0;
+  for (const Slice& slice : slices_) {
+    if (iovcnt == kMaxIovecs || slice.is_file()) {
+      break;
+    }
+    *attempted += slice.size() - slice.offset;
+    ++iovcnt;
+  }
+
+  const bool is_socket = IsSocket(fd);
+  bool zerocopy = is_socket && zerocopy_min_bytes_ > 0 && *attempted >= zerocopy_min_bytes_;
+  if (zerocopy) {
+    ShareOwnedSlices(iovcnt);
+  }
+  struct iovec iov[kMaxIovecs];
+  for (size_t i = 0; i < iovcnt; ++i) {
+    const Slice& slice = slices_[i];
+    iov[i].iov_base = const_cast<char*>(slice.data() + slice.offset);
+    iov[i].iov_len = slice.size() - slice.offset;
+  }
+
+  ssize_t n = 0;
+  if (is_socket) {
+    // 用 sendmsg 而不是 writev, 以便通过 MSG_NOSIGNAL 避免对端关闭时收到 SIGPIPE
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof msg);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    n = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (zerocopy ? MSG_ZEROCOPY : 0));
+    if (n < 0 && zerocopy && errno == ENOBUFS) {
+      // 超过了 optmem_max 限制, 这次退化为普通发送
+      zerocopy = false;
+      n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    }
+  } else {
+    n = ::writev(fd, iov, static_cast<int>(iovcnt));
+  }
+  if (n < 0) {
+    *saved_errno = errno;
+  } else if (n > 0 && zerocopy) {
+    RecordZeroCopySend(static_cast<size_t>(n));
+  }
+  return n;
+}
+
+ssize_t OutputQueue::WriteFile(const int fd, const size_t max_bytes, size_t* const attempted,
+                               int* const saved_errno) {
+  const Slice& slice = slices_.front();
+  if (!IsSocket(fd)) {
+    return SpliceFile(fd, slice, max_bytes, attempted, saved_errno);
+  }
+
+  off_t offset = slice.file_offset + static_cast<off_t>(slice.offset);
+  *attempted = std::min(slice.file_len - slice.offset, max_bytes);
+  ssize_t n = ::sendfile(fd, slice.file->fd(), &offset, *attempted);
+  if (n < 0) {
+    *saved_errno = errno;
+  } else if (n == 0) {
+    // 文件在发送过程中被截断了, 已经承诺的长度无法再满足
+    *saved_errno = ENODATA;
+    n = -1;
+  }
+  return n;
+}
+
+/**
+ * @brief fd 不是 socket 时, 先把文件内容 splice 到内部的 pipe, 再从 pipe splice 到 fd, 数据同样不经过用户态
+ *
+ * @note 从文件读入 pipe 的数据可能没有全部写到 fd, 剩下的 pipe_bytes_ 字节留在 pipe 中, 下次优先写出;
+ *       只有写到 fd 的字节才算作已经发送
+ */
+ssize_t OutputQueue::SpliceFile(const int fd, const Slice& slice, const size_t max_bytes, size_t* const attempted,
+                                int* const saved_errno) {
+  if (pipe_fds_[0] < 0 && ::pipe2(pipe_fds_, O_NONBLOCK | O_CLOEXEC) < 0) {
+    *saved_errno = errno;
+    return -1;
+  }
+
+  const size_t remaining = slice.file_len - slice.offset;
+  if (pipe_bytes_ < remaining) {
+    loff_t offset = slice.file_offset + static_cast<loff_t>(slice.offset + pipe_bytes_);
+    size_t len = std::min(remaining - pipe_bytes_, max_bytes);
+    ssize_t n = ::splice(slice.file->fd(), &offset, pipe_fds_[1], nullptr, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n > 0) {
+      pipe_bytes_ += n;
+    } else if (n == 0) {
+      *saved_errno = ENODATA;
+      return -1;
+    } else if (errno != EAGAIN) {
+      // pipe 已满时返回 EAGAIN, 先把 pipe 中的数据写出
+      *saved_errno = errno;
+      return -1;
+    }
+  }
+
+  *attempted = pipe_bytes_;
+  ssize_t n = ::splice(pipe_fds_[0], nullptr, fd, nullptr, pipe_bytes_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (n < 0) {
+    *saved_errno = errno;
+    return -1;
+  }
+  pipe_bytes_ -= n;
+  return n;
+}
+
+void OutputQueue::EnableZeroCopy(const size_t min_bytes) {
+  CHECK_GT(min_bytes, 0UL);
+  zerocopy_min_bytes_ = min_bytes;
+}
+
+size_t OutputQueue::HandleErrorQueue(const int fd) {
+  size_t notifications = 0;
+  while (true) {
+    char control[128];
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof msg);
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    if (::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        LOG_ERROR << "recvmsg MSG_ERRQUEUE fd [" << fd << "] fail with error [" << ::strerror(errno) << "]";
+      }
+      break;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+            (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+        continue;
+      }
+      struct sock_extended_err serr;
+      ::memcpy(&serr, CMSG_DATA(cmsg), sizeof serr);
+      if (serr.ee_errno != 0 || serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      // 一条通知可能合并了一段连续序号 [ee_info, ee_data] 的完成
+      CompleteZeroCopy(serr.ee_info, serr.ee_data, (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+      ++notifications;
+    }
+  }
+  return notifications;
+}
+
+bool OutputQueue::zerocopy_enabled() const {
+  return zerocopy_min_bytes_ > 0;
+}
+
+size_t OutputQueue::zerocopy_pending() const {
+  return zerocopy_pending_.size();
+}
+
+const OutputQueue::ZeroCopyStats& OutputQueue::zerocopy_stats() const {
+  return zerocopy_stats_;
+}
+
+void OutputQueue::ShareOwnedSlices(const size_t iovcnt) {
+  for (size_t i = 0; i < iovcnt; ++i) {
+    Slice& slice = slices_[i];
+    if (!slice.is_owned()) {
+      continue;
+    }
+    std::shared_ptr<std::string> owned = std::make_shared<std::string>(std::move(slice.owned));
+    slice.shared_data = owned->data();
+    slice.shared_len = owned->size();
+    slice.holder = std::move(owned);
+  }
+}
+
+void OutputQueue::RecordZeroCopySend(size_t len) {
+  ZeroCopyPending pending;
+  pending.seq = next_zerocopy_seq_++;
+  for (const Slice& slice : slices_) {
+    if (len == 0) {
+      break;
+    }
+    pending.holders.push_back(slice.holder);
+    len -= std::min(len, slice.size() - slice.offset);
+  }
+  zerocopy_pending_.push_back(std::move(pending));
+  ++zerocopy_stats_.sends;
+}
+
+void OutputQueue::CompleteZeroCopy(const uint32_t lo, const uint32_t hi, const bool copied) {
+  const uint32_t count = hi - lo + 1;
+  zerocopy_stats_.completions += count;
+  if (copied) {
+    zerocopy_stats_.copied += count;
+    if (zerocopy_min_bytes_ > 0) {
+      LOG_DEBUG << "kernel copied MSG_ZEROCOPY data, fall back to copy";
+      zerocopy_min_bytes_ = 0;
+    }
+  }
+  // 序号是 32 位的, 用无符号减法判断是否在区间内, 回绕之后也成立
+  for (ZeroCopyPending& pending : zerocopy_pending_) {
+    if (pending.seq - lo < count) {
+      pending.done = true;
+      pending.holders.clear();
+    }
+  }
+  while (!zerocopy_pending_.empty() && zerocopy_pending_.front().done) {
+    zerocopy_pending_.pop_front();
+  }
+}
+
+bool OutputQueue::IsSocket(const int fd) {
+  if (fd != sink_fd_) {
+    struct stat st;
+    sink_fd_ = fd;
+    sink_is_socket_ = ::fstat(fd, &st) < 0 || S_ISSOCK(st.st_mode);
+  }
+  return sink_is_socket_;
+}
+
+void OutputQueue::Consume(size_t len) {
+  CHECK_LE(len, bytes_);
+  bytes_ -= len;
+  while (len > 0) {
+    Slice& front = slices_.front();
+    size_t remaining = front.size() - front.offset;
+    if (len < remaining) {
+      front.offset += len;
+      return;
+    }
+    len -= remaining;
+    slices_.pop_front();
+  }
+}
+
+void OutputQueue::ClosePipe() {
+  if (pipe_fds_[0] >= 0) {
+    ::close(pipe_fds_[0]);
+    ::close(pipe_fds_[1]);
+    pipe_fds_[0] = -1;
+    pipe_fds_[1] = -1;
+  }
+  pipe_bytes_ = 0;
+}
+
+}  // namespace net
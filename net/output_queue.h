@@ -0,0 +1,166 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/file.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+/**
+ * @brief TcpConnection 的输出队列, 由一串数据片组成
+ *
+ * @note
+ *   1. 数据片有三种:
+ *        - 拷贝进来的数据, 连续追加的小块数据会合并到同一个数据片中, 减少 iovec 的数量
+ *        - 共享的只读数据, 通过 shared_ptr 持有, 不拷贝; 例如预先格式化好的响应头和缓存的响应体可以被多个连接同时发送
+ *        - 文件的一段, 通过 shared_ptr<const File> 持有 fd, 数据直接从 page cache 发送, 不经过用户态
+ *   2. 小于 kMinSharedBytes 的共享数据直接拷贝, 拷贝的开销比多一个 iovec 小
+ *   3. WriteTo 把连续的内存数据片用一次 sendmsg (writev) 写出, 文件数据片对 socket 用 sendfile, 对其他类型的 fd
+ *      (例如 pipe) 经过一个内部的 pipe 用 splice 转发, 直到队列写空、内核缓冲区写满或者用完 max_bytes
+ *   4. EnableZeroCopy 之后, 一次写出不少于 min_bytes 字节的内存数据时使用 MSG_ZEROCOPY, 内核直接引用用户态内存而不是
+ *      拷贝到 socket 缓冲区. sendmsg 返回之后内核仍在使用这些内存, 因此写出的数据片不会立即释放, 而是按发送的
+ *      序号挂在 zerocopy_pending_ 上, 直到从错误队列中读到对应的完成通知 (HandleErrorQueue). 内核实际上做了拷贝时
+ *      (例如发往本机的连接, 通知中带有 SO_EE_CODE_ZEROCOPY_COPIED) 自动关闭 MSG_ZEROCOPY, 因为此时它只有额外开销
+ *   5. 不是线程安全的
+ */
+class OutputQueue final {
+ public:
+  OutputQueue() = default;
+  ~OutputQueue();
+
+ public:
+  // 拷贝 [data, data + len)
+  void Append(const void* data, const size_t len);
+  // 共享 [data, data + len), holder 保证这段内存在发送完之前有效
+  void Append(std::shared_ptr<const void> holder, const void* data, const size_t len);
+  void Append(std::shared_ptr<const std::string> blob);
+  // 发送文件中 [offset, offset + len) 的内容, 发送时文件被截断会导致 WriteTo 以 ENODATA 失败
+  void AppendFile(std::shared_ptr<const File> file, const off_t offset, const size_t len);
+
+  /**
+   * @brief 把队列头部的数据写入 fd, 写入的数据会从队列中移除
+   *
+   * @param fd
+   * @param max_bytes 本次最多写入的字节数, 避免一个连接的大文件占满 IO 线程
+   * @param saved_errno 失败时保存 errno
+   * @return ssize_t 写入的字节数; 一个字节都没有写入就失败时返回 -1
+   */
+  ssize_t WriteTo(const int fd, const size_t max_bytes, int* const saved_errno);
+  void Clear();
+
+  // 开启 MSG_ZEROCOPY, fd 需要已经设置了 SO_ZEROCOPY
+  void EnableZeroCopy(const size_t min_bytes);
+  /**
+   * @brief 读取 fd 错误队列中的 MSG_ZEROCOPY 完成通知, 释放已经完成的数据片
+   * @return size_t 读到的通知数量
+   */
+  size_t HandleErrorQueue(const int fd);
+
+ public:
+  struct ZeroCopyStats {
+    // 使用 MSG_ZEROCOPY 的 sendmsg 次数
+    uint64_t sends = 0;
+    // 已经完成的次数, 以及其中内核实际做了拷贝的次数
+    uint64_t completions = 0;
+    uint64_t copied = 0;
+  };
+
+ public:
+  // 队列中还没有写出的字节数
+  size_t bytes() const;
+  bool empty() const;
+  size_t slice_num() const;
+  bool zerocopy_enabled() const;
+  // 已经写出但内核还没有通知完成的 MSG_ZEROCOPY 发送次数
+  size_t zerocopy_pending() const;
+  const ZeroCopyStats& zerocopy_stats() const;
+
+ private:
+  struct Slice {
+    // 拷贝进来的数据, holder 和 file 都为空时有效
+    std::string owned;
+    // 共享的数据
+    std::shared_ptr<const void> holder;
+    const char* shared_data = nullptr;
+    size_t shared_len = 0;
+    // 文件的一段
+    std::shared_ptr<const File> file;
+    off_t file_offset = 0;
+    size_t file_len = 0;
+    // 已经写出的字节数
+    size_t offset = 0;
+
+    bool is_file() const {
+      return file != nullptr;
+    }
+    bool is_owned() const {
+      return !holder && !file;
+    }
+    const char* data() const {
+      return holder ? shared_data : owned.data();
+    }
+    size_t size() const {
+      return file ? file_len : (holder ? shared_len : owned.size());
+    }
+  };
+
+ private:
+  // 把队列头部连续的内存数据片写出, attempted 返回尝试写入的字节数
+  ssize_t WriteMemory(const int fd, size_t* const attempted, int* const saved_errno);
+  // 把队列头部的文件数据片写出
+  ssize_t WriteFile(const int fd, const size_t max_bytes, size_t* const attempted, int* const saved_errno);
+  ssize_t SpliceFile(const int fd, const Slice& slice, const size_t max_bytes, size_t* const attempted,
+                     int* const saved_errno);
+  // 判断 fd 是否是 socket, 结果按 fd 缓存
+  bool IsSocket(const int fd);
+  // 把队列头部 iovcnt 个数据片中拷贝进来的数据转成共享的数据, 以便在完成通知之前保持有效
+  void ShareOwnedSlices(const size_t iovcnt);
+  // 记录一次写出了 len 字节的 MSG_ZEROCOPY 发送, 持有这些数据片直到完成
+  void RecordZeroCopySend(size_t len);
+  // 序号在 [lo, hi] 之间的发送已经完成
+  void CompleteZeroCopy(const uint32_t lo, const uint32_t hi, const bool copied);
+  // 从队列头部移除 len 字节
+  void Consume(size_t len);
+  void ClosePipe();
+
+ private:
+  // 每次 sendmsg 最多使用的 iovec 数量
+  static constexpr size_t kMaxIovecs = 64;
+  // 拷贝的数据合并到同一个数据片的上限
+  static constexpr size_t kMaxOwnedSliceBytes = 64 * 1024;
+  static constexpr size_t kMinSharedBytes = 256;
+
+  std::deque<Slice> slices_;
+  size_t bytes_ = 0;
+
+  int sink_fd_ = -1;
+  bool sink_is_socket_ = true;
+  // splice 使用的 pipe, 以及已经从文件读入 pipe 但还没有写到 fd 的字节数
+  int pipe_fds_[2] = {-1, -1};
+  size_t pipe_bytes_ = 0;
+
+  struct ZeroCopyPending {
+    uint32_t seq = 0;
+    bool done = false;
+    std::vector<std::shared_ptr<const void>> holders;
+  };
+  // 0 表示不使用 MSG_ZEROCOPY
+  size_t zerocopy_min_bytes_ = 0;
+  // 内核为每次成功的 MSG_ZEROCOPY 发送分配一个递增的 32 位序号, 从 0 开始
+  uint32_t next_zerocopy_seq_ = 0;
+  std::deque<ZeroCopyPending> zerocopy_pending_;
+  ZeroCopyStats zerocopy_stats_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(OutputQueue);
+};
+
+}  // namespace net
@@ -0,0 +1,198 @@
+#include "net/output_queue.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+std::string ReadAvailable(const int fd) {
+  std::string result;
+  char buf[4096];
+  ssize_t n = 0;
+  while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+    result.append(buf, n);
+  }
+  return result;
+}
+
+std::shared_ptr<File> CreateTempFile(const std::string& content, std::string* const path) {
+  char name[] = "/tmp/output_queue_test_XXXXXX";
+  int fd = ::mkstemp(name);
+  if (fd < 0) {
+    return nullptr;
+  }
+  EXPECT_EQ(::write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+  ::close(fd);
+  *path = name;
+  return File::Open(name);
+}
+
+std::string MakeContent(const size_t len) {
+  std::string content(len, '\0');
+  for (size_t i = 0; i < len; ++i) {
+    content[i] = static_cast<char>('a' + i * 7 % 26);
+  }
+  return content;
+}
+
+}  // namespace
+
+TEST(OutputQueueTest, coalesce_copied_data) {
+  OutputQueue queue;
+  EXPECT_TRUE(queue.empty());
+  queue.Append("hello ", 6);
+  queue.Append("world", 5);
+  // 连续拷贝的小块数据合并到同一个数据片
+  EXPECT_EQ(queue.slice_num(), 1UL);
+  EXPECT_EQ(queue.bytes(), 11UL);
+
+  // 太小的共享数据直接拷贝
+  queue.Append(std::make_shared<const std::string>("!"));
+  EXPECT_EQ(queue.slice_num(), 1UL);
+
+  std::shared_ptr<const std::string> blob = std::make_shared<const std::string>(1000, 'b');
+  queue.Append(blob);
+  queue.Append("tail", 4);
+  EXPECT_EQ(queue.slice_num(), 3UL);
+  EXPECT_EQ(queue.bytes(), 1016UL);
+  // 队列持有 blob 的引用
+  EXPECT_EQ(blob.use_count(), 2);
+
+  queue.Clear();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(blob.use_count(), 1);
+}
+
+TEST(OutputQueueTest, write_to_with_partial_writes) {
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+  int sndbuf = 4096;
+  ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof sndbuf);
+
+  OutputQueue queue;
+  std::string expected;
+  std::shared_ptr<const std::string> blob = std::make_shared<const std::string>(300000, 'z');
+  // 数据片数量超过一次 sendmsg 的 iovec 上限
+  for (int i = 0; i < 100; ++i) {
+    std::string header = "header #" + std::to_string(i) + "\r\n";
+    queue.Append(header.data(), header.size());
+    expected += header;
+    if (i % 10 == 0) {
+      queue.Append(blob);
+      expected += *blob;
+    } else {
+      auto body = std::make_shared<const std::string>(512, static_cast<char>('a' + i % 26));
+      queue.Append(body);
+      expected += *body;
+    }
+  }
+  EXPECT_EQ(queue.bytes(), expected.size());
+
+  std::string received;
+  int saved_errno = 0;
+  int rounds = 0;
+  while (!queue.empty()) {
+    ssize_t n = queue.WriteTo(fds[0], SIZE_MAX, &saved_errno);
+    if (n < 0) {
+      ASSERT_EQ(saved_errno, EAGAIN);
+    }
+    received += ReadAvailable(fds[1]);
+    ++rounds;
+    EXPECT_EQ(queue.bytes() + received.size(), expected.size());
+  }
+  received += ReadAvailable(fds[1]);
+  EXPECT_GT(rounds, 1);
+  EXPECT_EQ(received, expected);
+  EXPECT_EQ(blob.use_count(), 1);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+/**
+ * @brief 响应头和文件内容交替排队, 分别写到 socket (sendfile) 和 pipe (splice), 内容和顺序都应该正确
+ */
+TEST(OutputQueueTest, file_region_interleaved_with_memory) {
+  std::string path;
+  const std::string content = MakeContent(1024 * 1024 + 123);
+  std::shared_ptr<File> file = CreateTempFile(content, &path);
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(file->size(), content.size());
+
+  int socket_fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, socket_fds), 0);
+  int pipe_fds[2];
+  ASSERT_EQ(::pipe2(pipe_fds, O_NONBLOCK), 0);
+
+  for (int sink : {socket_fds[0], pipe_fds[1]}) {
+    const int source = sink == socket_fds[0] ? socket_fds[1] : pipe_fds[0];
+    OutputQueue queue;
+    std::string expected;
+    queue.Append("HEAD\r\n", 6);
+    queue.AppendFile(file, 0, content.size());
+    queue.Append("MID\r\n", 5);
+    queue.AppendFile(file, 1000, 5000);
+    queue.Append("END", 3);
+    expected = "HEAD\r\n" + content + "MID\r\n" + content.substr(1000, 5000) + "END";
+    EXPECT_EQ(queue.bytes(), expected.size());
+
+    std::string received;
+    int saved_errno = 0;
+    while (!queue.empty()) {
+      ssize_t n = queue.WriteTo(sink, 256 * 1024, &saved_errno);
+      if (n < 0) {
+        ASSERT_EQ(saved_errno, EAGAIN);
+      }
+      received += ReadAvailable(source);
+    }
+    received += ReadAvailable(source);
+    EXPECT_EQ(received, expected);
+  }
+  // 队列释放之后只剩下这里的引用
+  EXPECT_EQ(file.use_count(), 1);
+
+  ::close(socket_fds[0]);
+  ::close(socket_fds[1]);
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+  ::unlink(path.c_str());
+}
+
+TEST(OutputQueueTest, truncated_file) {
+  std::string path;
+  std::shared_ptr<File> file = CreateTempFile(MakeContent(1000), &path);
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(::truncate(path.c_str(), 100), 0);
+
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+  OutputQueue queue;
+  queue.AppendFile(file, 0, 1000);
+  int saved_errno = 0;
+  // 先写出截断之后剩下的 100 字节, 之后无法再满足承诺的长度
+  EXPECT_EQ(queue.WriteTo(fds[0], SIZE_MAX, &saved_errno), 100);
+  EXPECT_EQ(queue.WriteTo(fds[0], SIZE_MAX, &saved_errno), -1);
+  EXPECT_EQ(saved_errno, ENODATA);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+  ::unlink(path.c_str());
+}
+
+TEST(OutputQueueTest, file_open_errors) {
+  EXPECT_EQ(File::Open("/nonexistent/file"), nullptr);
+  EXPECT_EQ(errno, ENOENT);
+  EXPECT_EQ(File::Open("/tmp"), nullptr);
+  EXPECT_EQ(errno, EISDIR);
+}
+
+}  // namespace net
@@ -10,10 +10,9 @@ Poller::Poller(EventLoop* loop) : owner_loop_(loop) {
 
 Poller::~Poller() = default;
 
-bool Poller::HasChannel(Channel* channel) const {
+bool Poller::HasChannel(const Channel* channel) const {
   AssertInLoopThread();
-  const auto iter = channel_map_.find(channel->fd());
-  return iter != channel_map_.end() && iter->second == channel;
+  return channel_table_.Contains(channel->fd(), channel);
 }
 
 void Poller::AssertInLoopThread() const {
@@ -1,8 +1,9 @@
 #pragma once
 
-#include <map>
+#include <memory>
 #include <vector>
 
+#include "net/channel_table.hpp"
 #include "util/macros/macros.h"
 #include "util/time/timestamp.hpp"
 
@@ -12,7 +13,7 @@ class Channel;
 class EventLoop;
 
 /**
- * @brief IO 多路复用的基类, 用于支持 poll 和 epoll 两种 IO multiplexing 机制
+ * @brief IO 多路复用的基类, 用于支持 poll / epoll / io_uring 三种 IO multiplexing 机制
  *
  * @note
  *   1. Poller 是 EventLoop 的间接成员, 只供其 Owner EventLoop 在 IO 线程中调用, 因此无需加锁
@@ -26,6 +27,7 @@ class Poller {
   enum class PollerType {
     kPollPoller,
     kEpollPoller,
+    kIoUringPoller,
   };
 
  public:
@@ -39,18 +41,19 @@ class Poller {
   virtual PollerType GetPollType() = 0;
 
  public:
-  bool HasChannel(Channel* channel) const;
+  bool HasChannel(const Channel* channel) const;
   void AssertInLoopThread() const;
 
-  //  public:
-  //   static Poller* NewDefaultPoller(EventLoop* loop);
+ public:
+  // 创建指定类型的 Poller, 内核不支持 io_uring 时 kIoUringPoller 会回退到 EpollPoller
+  static std::unique_ptr<Poller> NewPoller(const PollerType poller_type, EventLoop* loop);
 
  private:
   EventLoop* owner_loop_ = nullptr;
 
  protected:
-  using ChannelMap = std::map<int, Channel*>;
-  ChannelMap channel_map_;
+  // fd -> Channel
+  ChannelTable channel_table_;
 
  private:
   // 禁止拷贝
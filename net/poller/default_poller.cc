@@ -0,0 +1,33 @@
+#include <memory>
+
+#include "logger/log.h"
+#include "net/poller.h"
+#include "net/poller/epoll_poller.h"
+#include "net/poller/io_uring_poller.h"
+#include "net/poller/poll_poller.h"
+
+namespace net {
+
+std::unique_ptr<Poller> Poller::NewPoller(const PollerType poller_type, EventLoop* loop) {
+  switch (poller_type) {
+    case PollerType::kPollPoller: {
+      return std::make_unique<PollPoller>(loop);
+    }
+    case PollerType::kEpollPoller: {
+      return std::make_unique<EpollPoller>(loop);
+    }
+    case PollerType::kIoUringPoller: {
+      if (IoUringPoller::IsSupported()) {
+        return std::make_unique<IoUringPoller>(loop);
+      }
+      LOG_WARN << "io_uring is not supported by current kernel, fallback to epoll";
+      return std::make_unique<EpollPoller>(loop);
+    }
+    default: {
+      CHECK(false) << "unsupported poller type: [" << static_cast<int>(poller_type) << "]";
+      return nullptr;
+    }
+  }
+}
+
+}  // namespace net
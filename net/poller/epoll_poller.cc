@@ -9,7 +9,7 @@
 namespace net {
 
 namespace {
-constexpr int32_t kNew = 1;
+constexpr int32_t kNew = -1;
 constexpr int32_t kAdded = 1;
 constexpr int32_t kDeleted = 2;
 
@@ -25,18 +25,18 @@ EpollPoller::~EpollPoller() {
 }
 
 ::util::time::Timestamp EpollPoller::Poll(int timeout_ms, ChannelList* active_channels) {
-  LOG_INFO << "fd total count " << channel_map_.size();
+  LOG_DEBUG << "fd total count " << channel_table_.size();
   int events_num = ::epoll_wait(epoll_fd_, &*events_.begin(), static_cast<int>(events_.size()), timeout_ms);
   int saved_errno = errno;
   util::time::Timestamp now = util::time::TimestampNanoSec();
   if (events_num > 0) {
-    LOG_INFO << events_num << " events happened";
+    LOG_DEBUG << events_num << " events happened";
     FillActiveChannels(events_num, active_channels);
     if (static_cast<size_t>(events_num) == events_.size()) {
       events_.resize(events_.size() * 2);
     }
   } else if (events_num == 0) {
-    LOG_INFO << "nothing happened";
+    LOG_DEBUG << "nothing happened";
   } else {
     if (saved_errno != EINTR) {
       errno = saved_errno;
@@ -49,13 +49,12 @@ EpollPoller::~EpollPoller() {
 void EpollPoller::FillActiveChannels(const int events_num, ChannelList* const active_channels) const {
   CHECK(events_num <= static_cast<int>(events_.size()));
   for (int i = 0; i < events_num; ++i) {
-    Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
-#ifndef NDEBUG
-    int fd = channel->fd();
-    auto iter = channel_map_.find(fd);
-    CHECK(iter != channel_map_.end());
-    CHECK(iter->second == channel);
-#endif
+    Channel* channel = channel_table_.FindByTag(events_[i].data.u64);
+    if (channel == nullptr) {
+      // fd 已经被注销或者被复用, 丢弃旧注册产生的事件
+      LOG_WARN << "drop stale event of fd [" << static_cast<int>(events_[i].data.u64 & 0xFFFFFFFF) << "]";
+      continue;
+    }
     channel->set_revents(events_[i].events);
     active_channels->push_back(channel);
   }
@@ -69,19 +68,17 @@ void EpollPoller::UpdateChannel(Channel* channel) {
     // a new one, add with EPOLL_CTL_ADD
     int fd = channel->fd();
     if (index == kNew) {
-      CHECK(channel_map_.find(fd) == channel_map_.end());
-      channel_map_[fd] = channel;
+      CHECK(channel_table_.Find(fd) == nullptr);
+      channel_table_.Insert(fd, channel);
     } else {  // index == kDeleted
-      CHECK(channel_map_.find(fd) != channel_map_.end());
-      CHECK(channel_map_[fd] == channel);
+      CHECK(channel_table_.Contains(fd, channel));
     }
     channel->set_index(kAdded);
     Update(EPOLL_CTL_ADD, channel);
   } else {
     // update existing one with EPOLL_CTL_MOD/DEL
     int fd = channel->fd();
-    CHECK(channel_map_.find(fd) != channel_map_.end());
-    CHECK(channel_map_[fd] == channel);
+    CHECK(channel_table_.Contains(fd, channel));
     CHECK(index == kAdded);
     if (channel->IsNoneEvent()) {
       Update(EPOLL_CTL_DEL, channel);
@@ -96,25 +93,29 @@ void EpollPoller::RemoveChannel(Channel* channel) {
   Poller::AssertInLoopThread();
   int fd = channel->fd();
   LOG_INFO << "fd = " << fd;
-  CHECK(channel_map_.find(fd) != channel_map_.end());
-  CHECK(channel_map_[fd] == channel);
+  CHECK(channel_table_.Contains(fd, channel));
   CHECK(channel->IsNoneEvent());
   int index = channel->index();
   CHECK(index == kAdded || index == kDeleted);
-  size_t n = channel_map_.erase(fd);
-  CHECK_EQ(n, 1);
   if (index == kAdded) {
     Update(EPOLL_CTL_DEL, channel);
   }
+  channel_table_.Erase(fd);
   channel->set_index(kNew);
 }
 
 void EpollPoller::Update(int operation, Channel* channel) {
   struct epoll_event event;
   ::memset(&event, 0, sizeof event);
-  event.events = channel->events();
-  event.data.ptr = channel;
   int fd = channel->fd();
+  event.events = channel->events();
+  if (channel->IsEdgeTriggered()) {
+    event.events |= EPOLLET;
+  }
+  if (channel->IsOneShot()) {
+    event.events |= EPOLLONESHOT;
+  }
+  event.data.u64 = ChannelTable::Encode(fd, channel_table_.generation(fd));
   LOG_INFO << "epoll_ctl op = " << OperationToString(operation) << " fd = " << fd << " event = { "
            << channel->EventsToString() << " }";
   if (::epoll_ctl(epoll_fd_, operation, fd, &event) < 0) {
@@ -126,6 +127,10 @@ void EpollPoller::Update(int operation, Channel* channel) {
   }
 }
 
+Poller::PollerType EpollPoller::GetPollType() {
+  return Poller::PollerType::kEpollPoller;
+}
+
 std::string EpollPoller::OperationToString(int op) {
   switch (op) {
     case EPOLL_CTL_ADD:
@@ -0,0 +1,295 @@
+#include "net/poller/io_uring_poller.h"
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include "logger/log.h"
+#include "net/channel.h"
+
+namespace net {
+
+namespace {
+
+constexpr int32_t kNew = -1;
+constexpr int32_t kAdded = 1;
+constexpr int32_t kDeleted = 2;
+
+// IoUringPoller 依赖的内核特性:
+//   1. IORING_FEAT_NODROP: CQ 溢出时不丢弃完成事件
+//   2. IORING_FEAT_EXT_ARG: io_uring_enter 支持超时参数 (5.11)
+//   3. IORING_FEAT_RSRC_TAGS: 与 multishot poll 同一版本 (5.13) 引入, 用来判断是否支持 IORING_POLL_ADD_MULTI
+constexpr uint32_t kRequiredFeatures = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+
+int IoUringSetup(const uint32_t entries, struct io_uring_params* const params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(const int ring_fd, const uint32_t to_submit, const uint32_t min_complete, const uint32_t flags,
+                 const void* arg, const size_t arg_size) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+template <typename T>
+T* RingOffset(void* ring_ptr, const uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(ring_ptr) + offset);
+}
+
+uint32_t LoadAcquire(const uint32_t* ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+void StoreRelease(uint32_t* ptr, const uint32_t value) {
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+}  // namespace
+
+IoUringPoller::IoUringPoller(EventLoop* loop) : Poller(loop) {
+  struct io_uring_params params;
+  ::memset(&params, 0, sizeof params);
+  ring_fd_ = IoUringSetup(kRingEntries, &params);
+  CHECK_GE(ring_fd_, 0) << "io_uring_setup fail with error [" << ::strerror(errno) << "]";
+  CHECK((params.features & kRequiredFeatures) == kRequiredFeatures)
+      << "io_uring features [" << params.features << "] not supported";
+  sq_entries_ = params.sq_entries;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    // SQ 和 CQ 共用一块内存
+    sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    cq_ring_size_ = sq_ring_size_;
+  }
+
+  sq_ring_ptr_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_SQ_RING);
+  CHECK(sq_ring_ptr_ != MAP_FAILED) << "mmap sq ring fail with error [" << ::strerror(errno) << "]";
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ptr_ = sq_ring_ptr_;
+  } else {
+    cq_ring_ptr_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                          IORING_OFF_CQ_RING);
+    CHECK(cq_ring_ptr_ != MAP_FAILED) << "mmap cq ring fail with error [" << ::strerror(errno) << "]";
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes_ptr =
+      ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  CHECK(sqes_ptr != MAP_FAILED) << "mmap sqes fail with error [" << ::strerror(errno) << "]";
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes_ptr);
+
+  sq_head_ = RingOffset<uint32_t>(sq_ring_ptr_, params.sq_off.head);
+  sq_tail_ = RingOffset<uint32_t>(sq_ring_ptr_, params.sq_off.tail);
+  sq_mask_ = RingOffset<uint32_t>(sq_ring_ptr_, params.sq_off.ring_mask);
+  sq_array_ = RingOffset<uint32_t>(sq_ring_ptr_, params.sq_off.array);
+  cq_head_ = RingOffset<uint32_t>(cq_ring_ptr_, params.cq_off.head);
+  cq_tail_ = RingOffset<uint32_t>(cq_ring_ptr_, params.cq_off.tail);
+  cq_mask_ = RingOffset<uint32_t>(cq_ring_ptr_, params.cq_off.ring_mask);
+  cqes_ = RingOffset<struct io_uring_cqe>(cq_ring_ptr_, params.cq_off.cqes);
+}
+
+IoUringPoller::~IoUringPoller() {
+  ::munmap(sqes_, sqes_size_);
+  if (cq_ring_ptr_ != sq_ring_ptr_) {
+    ::munmap(cq_ring_ptr_, cq_ring_size_);
+  }
+  ::munmap(sq_ring_ptr_, sq_ring_size_);
+  ::close(ring_fd_);
+}
+
+bool IoUringPoller::IsSupported() {
+  static const bool supported = []() {
+    struct io_uring_params params;
+    ::memset(&params, 0, sizeof params);
+    int ring_fd = IoUringSetup(1, &params);
+    if (ring_fd < 0) {
+      LOG_WARN << "io_uring_setup fail with error [" << ::strerror(errno) << "]";
+      return false;
+    }
+    ::close(ring_fd);
+    if ((params.features & kRequiredFeatures) != kRequiredFeatures) {
+      LOG_WARN << "io_uring features [" << params.features << "] not supported";
+      return false;
+    }
+    return true;
+  }();
+  return supported;
+}
+
+::util::time::Timestamp IoUringPoller::Poll(int timeout_ms, ChannelList* active_channels) {
+  LOG_DEBUG << "fd total count " << channel_table_.size();
+  // CQ 中还有未处理的事件时不再等待
+  uint32_t wait_nr = LoadAcquire(cq_tail_) == *cq_head_ ? 1 : 0;
+  int ret = Enter(wait_nr, timeout_ms);
+  int saved_errno = errno;
+  util::time::Timestamp now = util::time::TimestampNanoSec();
+  if (ret < 0 && saved_errno != ETIME && saved_errno != EINTR) {
+    LOG_ERROR << "IoUringPoller::poll() fail with error " << ::strerror(saved_errno);
+  }
+
+  FillActiveChannels(active_channels);
+  if (active_channels->empty()) {
+    LOG_DEBUG << "nothing happened";
+  } else {
+    LOG_DEBUG << active_channels->size() << " events happened";
+  }
+  return now;
+}
+
+void IoUringPoller::FillActiveChannels(ChannelList* const active_channels) {
+  fired_channels_.clear();
+  fired_index_.clear();
+
+  uint32_t head = *cq_head_;
+  uint32_t tail = LoadAcquire(cq_tail_);
+  for (; head != tail; ++head) {
+    const struct io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+    if (cqe.user_data == kInternalUserData) {
+      continue;
+    }
+    Channel* channel = channel_table_.FindByTag(cqe.user_data);
+    if (channel == nullptr) {
+      // 已经被取消的请求, 例如 POLL_REMOVE 之后返回的 -ECANCELED
+      continue;
+    }
+    int revents = cqe.res >= 0 ? cqe.res : POLLERR;
+    if (cqe.res < 0) {
+      LOG_WARN << "fd = " << channel->fd() << " poll fail with error " << ::strerror(-cqe.res);
+    }
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+      // 单次 poll 请求已经完成, 或者 multishot 请求被内核终止 (例如 CQ 溢出), 除 EPOLLONESHOT 外都需要重新注册
+      if (channel->index() == kAdded && cqe.res >= 0 && !channel->IsOneShot()) {
+        ArmPoll(channel);
+      }
+    }
+
+    auto fired_iter = fired_index_.find(channel);
+    if (fired_iter == fired_index_.end()) {
+      fired_index_[channel] = fired_channels_.size();
+      fired_channels_.emplace_back(channel, revents);
+    } else {
+      fired_channels_[fired_iter->second].second |= revents;
+    }
+  }
+  StoreRelease(cq_head_, head);
+
+  for (const auto& fired : fired_channels_) {
+    fired.first->set_revents(fired.second);
+    active_channels->push_back(fired.first);
+  }
+}
+
+void IoUringPoller::UpdateChannel(Channel* channel) {
+  Poller::AssertInLoopThread();
+  const int index = channel->index();
+  const int fd = channel->fd();
+  LOG_INFO << "fd = " << fd << " events = " << channel->events() << " index = " << index;
+  if (index == kNew || index == kDeleted) {
+    if (index == kNew) {
+      CHECK(channel_table_.Find(fd) == nullptr);
+      channel_table_.Insert(fd, channel);
+    } else {  // index == kDeleted
+      CHECK(channel_table_.Contains(fd, channel));
+    }
+    channel->set_index(kAdded);
+    ArmPoll(channel);
+  } else {
+    CHECK(channel_table_.Contains(fd, channel));
+    CHECK(index == kAdded);
+    // io_uring 的 poll 请求无法原地修改事件, 先取消旧请求再注册新请求, 两个 SQE 会在下次 Poll 时一起提交
+    DisarmPoll(fd);
+    if (channel->IsNoneEvent()) {
+      channel->set_index(kDeleted);
+    } else {
+      ArmPoll(channel);
+    }
+  }
+}
+
+void IoUringPoller::RemoveChannel(Channel* channel) {
+  Poller::AssertInLoopThread();
+  const int fd = channel->fd();
+  LOG_INFO << "fd = " << fd;
+  CHECK(channel_table_.Contains(fd, channel));
+  CHECK(channel->IsNoneEvent());
+  const int index = channel->index();
+  CHECK(index == kAdded || index == kDeleted);
+  if (index == kAdded) {
+    DisarmPoll(fd);
+  }
+  channel_table_.Erase(fd);
+  channel->set_index(kNew);
+}
+
+Poller::PollerType IoUringPoller::GetPollType() {
+  return Poller::PollerType::kIoUringPoller;
+}
+
+struct io_uring_sqe* IoUringPoller::GetSqe() {
+  uint32_t tail = *sq_tail_;
+  if (tail - LoadAcquire(sq_head_) >= sq_entries_) {
+    // SQ 已满, 先把积压的请求提交给内核
+    Enter(0, 0);
+    CHECK_LT(tail - LoadAcquire(sq_head_), sq_entries_) << "io_uring submission queue is full";
+  }
+  uint32_t index = tail & *sq_mask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  ::memset(sqe, 0, sizeof *sqe);
+  sq_array_[index] = index;
+  StoreRelease(sq_tail_, tail + 1);
+  ++to_submit_;
+  return sqe;
+}
+
+void IoUringPoller::ArmPoll(Channel* channel) {
+  // 每次注册都使用新的 generation, 旧请求残留的完成事件会因为 generation 不匹配而被忽略
+  uint64_t user_data = ChannelTable::Encode(channel->fd(), channel_table_.BumpGeneration(channel->fd()));
+
+  struct io_uring_sqe* sqe = GetSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = channel->fd();
+  sqe->poll32_events = static_cast<uint32_t>(channel->events());
+  if (channel->IsEdgeTriggered() && !channel->IsOneShot()) {
+    sqe->len = IORING_POLL_ADD_MULTI;
+  }
+  sqe->user_data = user_data;
+}
+
+void IoUringPoller::DisarmPoll(const int fd) {
+  uint64_t user_data = ChannelTable::Encode(fd, channel_table_.generation(fd));
+  channel_table_.BumpGeneration(fd);
+
+  struct io_uring_sqe* sqe = GetSqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->addr = user_data;
+  sqe->user_data = kInternalUserData;
+}
+
+int IoUringPoller::Enter(const uint32_t wait_nr, const int timeout_ms) {
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  ::memset(&arg, 0, sizeof arg);
+  if (timeout_ms >= 0) {
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<int64_t>(timeout_ms % 1000) * 1000 * 1000;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+  }
+
+  uint32_t flags = IORING_ENTER_EXT_ARG;
+  if (wait_nr > 0) {
+    flags |= IORING_ENTER_GETEVENTS;
+  }
+  int ret = IoUringEnter(ring_fd_, to_submit_, wait_nr, flags, &arg, sizeof arg);
+  // 即使等待超时, 内核也可能已经消费了部分 SQE, 以 SQ head 为准
+  to_submit_ = *sq_tail_ - LoadAcquire(sq_head_);
+  return ret;
+}
+
+}  // namespace net
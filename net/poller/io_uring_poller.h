@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "net/poller.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace net {
+
+/**
+ * @brief 基于 io_uring 实现的 IO Multiplexing 类
+ *
+ * @note
+ *   1. 每个 Channel 对应一个 IORING_OP_POLL_ADD 请求, 无需像 poll(2) 一样每次传入全部 fd,
+ *      也无需像 EpollPoller::Update 一样每次变更都调用一次 epoll_ctl
+ *   2. UpdateChannel / RemoveChannel 只是把 POLL_ADD / POLL_REMOVE 请求写入提交队列, 在下一次 Poll 时和等待事件
+ *      一起通过一次 io_uring_enter 提交
+ *   3. multishot poll 只在 fd 状态变化时投递事件, 语义和 EPOLLET 一致, 因此只用于边缘触发的 Channel;
+ *      水平触发的 Channel 使用单次 poll 请求, 每次触发后在下一次 Poll 时重新注册, 由内核在注册时重新检查就绪状态;
+ *      EPOLLONESHOT 的 Channel 同样使用单次 poll 请求, 但只在 Rearm 时重新注册
+ *   4. 需要 Linux 5.13 以上的内核, 请通过 IsSupported 判断, 不支持时 Poller::NewPoller 会自动回退到 EpollPoller
+ */
+class IoUringPoller : public Poller {
+ public:
+  explicit IoUringPoller(EventLoop* loop);
+  ~IoUringPoller();
+
+ public:
+  ::util::time::Timestamp Poll(int timeout_ms, ChannelList* active_channels) override;
+  void UpdateChannel(Channel* channel) override;
+  void RemoveChannel(Channel* channel) override;
+  PollerType GetPollType() override;
+
+ public:
+  // 判断当前内核是否支持 IoUringPoller 所需的 io_uring 特性
+  static bool IsSupported();
+
+ private:
+  // 获取一个空闲的 SQE, 提交队列满时会先把已有请求提交给内核
+  struct io_uring_sqe* GetSqe();
+  // 为 channel 注册一个新的 poll 请求
+  void ArmPoll(Channel* channel);
+  // 取消 fd 上当前的 poll 请求, user_data 是 ChannelTable::Encode 得到的 (fd, generation)
+  void DisarmPoll(const int fd);
+  // 提交请求并等待至少 wait_nr 个完成事件
+  int Enter(const uint32_t wait_nr, const int timeout_ms);
+  void FillActiveChannels(ChannelList* const active_channels);
+
+ private:
+  int ring_fd_ = -1;
+  uint32_t sq_entries_ = 0;
+
+  // 提交队列 (SQ) 和完成队列 (CQ) 的共享内存
+  void* sq_ring_ptr_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ptr_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  struct io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  uint32_t* sq_head_ = nullptr;
+  uint32_t* sq_tail_ = nullptr;
+  uint32_t* sq_mask_ = nullptr;
+  uint32_t* sq_array_ = nullptr;
+  uint32_t* cq_head_ = nullptr;
+  uint32_t* cq_tail_ = nullptr;
+  uint32_t* cq_mask_ = nullptr;
+  struct io_uring_cqe* cqes_ = nullptr;
+
+  // 已经写入 SQ 但还没有提交给内核的请求数
+  uint32_t to_submit_ = 0;
+
+  // 本轮 Poll 中产生了事件的 Channel 及其事件, 同一个 Channel 的多个完成事件会被合并
+  std::vector<std::pair<Channel*, int>> fired_channels_;
+  std::unordered_map<Channel*, size_t> fired_index_;
+
+ private:
+  // 内部请求 (例如 POLL_REMOVE) 的 user_data, 其完成事件直接忽略
+  static constexpr uint64_t kInternalUserData = 0;
+  static constexpr uint32_t kRingEntries = 256;
+};
+
+}  // namespace net
@@ -20,10 +20,10 @@ PollPoller::~PollPoller() = default;
   int saved_errno = errno;
   util::time::Timestamp now = util::time::TimestampNanoSec();
   if (events_num > 0) {
-    LOG_INFO << events_num << " events happened";
+    LOG_DEBUG << events_num << " events happened";
     FillActiveChannels(events_num, active_channels);
   } else if (events_num == 0) {
-    LOG_INFO << "nothing happened";
+    LOG_DEBUG << "nothing happened";
   } else {
     if (saved_errno != EINTR) {
       errno = saved_errno;
@@ -33,17 +33,20 @@ PollPoller::~PollPoller() = default;
   return now;
 }
 
-void PollPoller::FillActiveChannels(const int events_num, ChannelList* const active_channels) const {
+void PollPoller::FillActiveChannels(const int events_num, ChannelList* const active_channels) {
   int local_event_num = events_num;
-  for (auto fd_iter = poll_fds_.begin(); fd_iter != poll_fds_.end(); ++fd_iter) {
+  for (auto fd_iter = poll_fds_.begin(); fd_iter != poll_fds_.end() && local_event_num > 0; ++fd_iter) {
     if (fd_iter->revents > 0) {
       --local_event_num;
-      auto channel_iter = channel_map_.find(fd_iter->fd);
-      CHECK(channel_iter != channel_map_.end());
-      Channel* channel = channel_iter->second;
+      Channel* channel = channel_table_.Find(fd_iter->fd);
+      CHECK_NOTNULL(channel);
       CHECK_EQ(channel->fd(), fd_iter->fd);
       channel->set_revents(fd_iter->revents);
       active_channels->push_back(channel);
+      if (channel->IsOneShot()) {
+        // 在 Rearm 之前忽略这个 pollfd
+        fd_iter->fd = -channel->fd() - 1;
+      }
     }
   }
 }
@@ -51,9 +54,12 @@ void PollPoller::FillActiveChannels(const int events_num, ChannelList* const act
 void PollPoller::UpdateChannel(Channel* channel) {
   Poller::AssertInLoopThread();
   LOG_INFO << "fd = " << channel->fd() << " events = " << channel->events();
+  if (channel->IsEdgeTriggered()) {
+    LOG_WARN_FIRST_N(1) << "PollPoller does not support edge triggered mode, fallback to level triggered";
+  }
   if (channel->index() < 0) {
     // a new one, add to pollfds_
-    CHECK_EQ(channel_map_.find(channel->fd()), channel_map_.end());
+    CHECK(channel_table_.Find(channel->fd()) == nullptr);
     struct pollfd pfd;
     pfd.fd = channel->fd();
     pfd.events = static_cast<short>(channel->events());  // NOLINT
@@ -61,11 +67,10 @@ void PollPoller::UpdateChannel(Channel* channel) {
     poll_fds_.push_back(pfd);
     int idx = static_cast<int>(poll_fds_.size() - 1);
     channel->set_index(idx);
-    channel_map_[pfd.fd] = channel;
+    channel_table_.Insert(pfd.fd, channel);
   } else {
     // update existing one
-    CHECK_NE(channel_map_.find(channel->fd()), channel_map_.end());
-    CHECK_EQ(channel_map_[channel->fd()], channel);
+    CHECK(channel_table_.Contains(channel->fd(), channel));
     int idx = channel->index();
     CHECK(0 <= idx && idx < static_cast<int>(poll_fds_.size()));
     struct pollfd& pfd = poll_fds_[idx];
@@ -84,15 +89,13 @@ void PollPoller::UpdateChannel(Channel* channel) {
 void PollPoller::RemoveChannel(Channel* channel) {
   Poller::AssertInLoopThread();
   LOG_INFO << "fd = " << channel->fd();
-  CHECK_NE(channel_map_.find(channel->fd()), channel_map_.end());
-  CHECK_EQ(channel_map_[channel->fd()], channel);
+  CHECK(channel_table_.Contains(channel->fd(), channel));
   CHECK(channel->IsNoneEvent());
   int idx = channel->index();
   CHECK(0 <= idx && idx < static_cast<int>(poll_fds_.size()));
   const struct pollfd& pfd = poll_fds_[idx];
   CHECK(pfd.fd == -channel->fd() - 1 && pfd.events == channel->events());
-  size_t n = channel_map_.erase(channel->fd());
-  CHECK_EQ(n, 1);
+  channel_table_.Erase(channel->fd());
   if (idx == static_cast<int>(poll_fds_.size() - 1)) {
     // 如果恰好是 poll_fds_ 尾元素, 通过 pop_back 加速
     poll_fds_.pop_back();
@@ -103,7 +106,7 @@ void PollPoller::RemoveChannel(Channel* channel) {
     if (channel_fd_at_end < 0) {
       channel_fd_at_end = -channel_fd_at_end - 1;
     }
-    channel_map_[channel_fd_at_end]->set_index(idx);
+    channel_table_.Find(channel_fd_at_end)->set_index(idx);
     poll_fds_.pop_back();
   }
 }
@@ -10,6 +10,7 @@ namespace net {
 /**
  * @brief 基于 poll(2) 实现的 IO Multiplexing 类
  *
+ * @note poll(2) 只支持水平触发, 边缘触发的 Channel 会退化成水平触发; EPOLLONESHOT 通过在触发后忽略该 pollfd 模拟
  */
 class PollPoller : public Poller {
  public:
@@ -23,7 +24,7 @@ class PollPoller : public Poller {
   PollerType GetPollType() override;
 
  private:
-  void FillActiveChannels(const int events_num, ChannelList* const) const;
+  void FillActiveChannels(const int events_num, ChannelList* const);
 
  private:
   using PollFdList = std::vector<struct pollfd>;
@@ -0,0 +1,190 @@
+#include "net/poller.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "logger/log.h"
+#include "net/channel.h"
+#include "net/event_loop.h"
+#include "net/poller/io_uring_poller.h"
+
+namespace net {
+
+namespace {
+
+const Poller::PollerType kAllPollerTypes[] = {
+    Poller::PollerType::kPollPoller,
+    Poller::PollerType::kEpollPoller,
+    Poller::PollerType::kIoUringPoller,
+};
+
+}  // namespace
+
+TEST(PollerTest, new_poller) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  for (Poller::PollerType poller_type : kAllPollerTypes) {
+    std::unique_ptr<Poller> poller = Poller::NewPoller(poller_type, &loop);
+    if (poller_type == Poller::PollerType::kIoUringPoller && !IoUringPoller::IsSupported()) {
+      // 不支持 io_uring 时回退到 epoll
+      EXPECT_EQ(poller->GetPollType(), Poller::PollerType::kEpollPoller);
+    } else {
+      EXPECT_EQ(poller->GetPollType(), poller_type);
+    }
+  }
+}
+
+TEST(PollerTest, dispatch_read_event) {
+  for (Poller::PollerType poller_type : kAllPollerTypes) {
+    int pipe_fds[2];
+    ASSERT_EQ(::pipe(pipe_fds), 0);
+
+    EventLoop loop(poller_type);
+    Channel channel(&loop, pipe_fds[0]);
+    std::string received;
+    channel.SetReadCallback([&](util::time::Timestamp) {
+      char buf[64];
+      ssize_t n = ::read(pipe_fds[0], buf, sizeof buf);
+      ASSERT_GT(n, 0);
+      received.append(buf, n);
+      loop.Quit();
+    });
+    channel.EnableReading();
+    EXPECT_TRUE(loop.HasChannel(&channel));
+
+    ASSERT_EQ(::write(pipe_fds[1], "hello", 5), 5);
+    loop.Loop();
+    EXPECT_EQ(received, "hello");
+
+    // 修改关注的事件之后不再收到可读事件, 只收到可写事件
+    bool writable = false;
+    Channel write_channel(&loop, pipe_fds[1]);
+    write_channel.SetWriteCallback([&]() {
+      writable = true;
+      write_channel.DisableWriting();
+      loop.Quit();
+    });
+    channel.DisableReading();
+    write_channel.EnableWriting();
+    ASSERT_EQ(::write(pipe_fds[1], "world", 5), 5);
+    loop.Loop();
+    EXPECT_TRUE(writable);
+    EXPECT_EQ(received, "hello");
+
+    channel.DisableAll();
+    channel.Remove();
+    write_channel.DisableAll();
+    write_channel.Remove();
+    EXPECT_FALSE(loop.HasChannel(&channel));
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+  }
+}
+
+TEST(PollerTest, edge_triggered_fairness) {
+  for (Poller::PollerType poller_type : {Poller::PollerType::kEpollPoller, Poller::PollerType::kIoUringPoller}) {
+    int hot_fds[2];
+    int cold_fds[2];
+    ASSERT_EQ(::pipe(hot_fds), 0);
+    ASSERT_EQ(::pipe(cold_fds), 0);
+
+    EventLoop loop(poller_type);
+    loop.set_io_budget_bytes(4);
+    std::vector<std::string> handled;
+
+    // 繁忙的 fd 每次只允许读 io_budget_bytes 字节, 读不完时推迟到下一轮循环
+    Channel hot_channel(&loop, hot_fds[0]);
+    hot_channel.EnableEdgeTriggered();
+    int hot_calls = 0;
+    hot_channel.SetReadCallback([&](util::time::Timestamp) {
+      ++hot_calls;
+      char buf[64];
+      ssize_t n = ::read(hot_fds[0], buf, loop.io_budget_bytes());
+      ASSERT_GT(n, 0);
+      handled.emplace_back("hot");
+      if (static_cast<size_t>(n) == loop.io_budget_bytes()) {
+        loop.DeferChannel(&hot_channel);
+      } else {
+        loop.Quit();
+      }
+    });
+    hot_channel.EnableReading();
+
+    Channel cold_channel(&loop, cold_fds[0]);
+    cold_channel.SetReadCallback([&](util::time::Timestamp) {
+      char buf[64];
+      ASSERT_GT(::read(cold_fds[0], buf, sizeof buf), 0);
+      handled.emplace_back("cold");
+    });
+    cold_channel.EnableReading();
+
+    ASSERT_EQ(::write(hot_fds[1], "0123456789abcdef0", 17), 17);
+    loop.RunInLoop([&]() {
+      ASSERT_EQ(::write(cold_fds[1], "x", 1), 1);
+    });
+    loop.Loop();
+
+    // 17 字节需要分 5 次读完, 而冷 fd 在繁忙的 fd 读完之前就得到了处理
+    EXPECT_EQ(hot_calls, 5);
+    auto cold_iter = std::find(handled.begin(), handled.end(), "cold");
+    ASSERT_NE(cold_iter, handled.end());
+    EXPECT_NE(cold_iter, handled.end() - 1);
+
+    for (Channel* channel : {&hot_channel, &cold_channel}) {
+      channel->DisableAll();
+      channel->Remove();
+    }
+    for (int fd : {hot_fds[0], hot_fds[1], cold_fds[0], cold_fds[1]}) {
+      ::close(fd);
+    }
+  }
+}
+
+TEST(PollerTest, one_shot) {
+  for (Poller::PollerType poller_type : kAllPollerTypes) {
+    int data_fds[2];
+    int quit_fds[2];
+    ASSERT_EQ(::pipe(data_fds), 0);
+    ASSERT_EQ(::pipe(quit_fds), 0);
+
+    EventLoop loop(poller_type);
+    Channel data_channel(&loop, data_fds[0]);
+    data_channel.EnableOneShot();
+    int data_calls = 0;
+    data_channel.SetReadCallback([&](util::time::Timestamp) {
+      ++data_calls;
+      // 不读取数据, 触发之后在 Rearm 之前都不应该再收到通知
+      ASSERT_EQ(::write(quit_fds[1], "q", 1), 1);
+    });
+    data_channel.EnableReading();
+
+    Channel quit_channel(&loop, quit_fds[0]);
+    quit_channel.SetReadCallback([&](util::time::Timestamp) {
+      char buf[64];
+      ASSERT_GT(::read(quit_fds[0], buf, sizeof buf), 0);
+      loop.Quit();
+    });
+    quit_channel.EnableReading();
+
+    ASSERT_EQ(::write(data_fds[1], "data", 4), 4);
+    loop.Loop();
+    EXPECT_EQ(data_calls, 1);
+
+    data_channel.Rearm();
+    loop.Loop();
+    EXPECT_EQ(data_calls, 2);
+
+    for (Channel* channel : {&data_channel, &quit_channel}) {
+      channel->DisableAll();
+      channel->Remove();
+    }
+    for (int fd : {data_fds[0], data_fds[1], quit_fds[0], quit_fds[1]}) {
+      ::close(fd);
+    }
+  }
+}
+
+}  // namespace net
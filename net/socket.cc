@@ -0,0 +1,157 @@
+#include "net/socket.h"
+
+#include <linux/filter.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "logger/log.h"
+
+namespace net {
+
+namespace {
+
+void SetSocketOption(const int sockfd, const int level, const int option, const bool on) {
+  int value = on ? 1 : 0;
+  if (::setsockopt(sockfd, level, option, &value, static_cast<socklen_t>(sizeof value)) < 0) {
+    LOG_ERROR << "setsockopt fd [" << sockfd << "] option [" << option << "] fail with error [" << ::strerror(errno)
+              << "]";
+  }
+}
+
+}  // namespace
+
+Socket::~Socket() {
+  if (::close(sockfd_) < 0) {
+    LOG_ERROR << "close fd [" << sockfd_ << "] fail with error [" << ::strerror(errno) << "]";
+  }
+}
+
+int Socket::fd() const {
+  return sockfd_;
+}
+
+void Socket::BindAddress(const InetAddress& local_addr) {
+  if (::bind(sockfd_, local_addr.GetSockAddr(), local_addr.GetSockLen()) < 0) {
+    LOG_FATAL << "bind [" << local_addr.ToIpPort() << "] fail with error [" << ::strerror(errno) << "]";
+  }
+}
+
+void Socket::Listen() {
+  if (::listen(sockfd_, SOMAXCONN) < 0) {
+    LOG_FATAL << "listen fd [" << sockfd_ << "] fail with error [" << ::strerror(errno) << "]";
+  }
+}
+
+int Socket::Accept(InetAddress* const peer_addr) {
+  struct sockaddr_in6 addr;
+  ::memset(&addr, 0, sizeof addr);
+  socklen_t addr_len = static_cast<socklen_t>(sizeof addr);
+  int connfd = ::accept4(sockfd_, reinterpret_cast<struct sockaddr*>(&addr), &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (connfd >= 0) {
+    peer_addr->SetSockAddrInet6(addr);
+  }
+  return connfd;
+}
+
+void Socket::ShutdownWrite() {
+  if (::shutdown(sockfd_, SHUT_WR) < 0) {
+    LOG_ERROR << "shutdown fd [" << sockfd_ << "] fail with error [" << ::strerror(errno) << "]";
+  }
+}
+
+void Socket::Abort() {
+  struct sockaddr addr;
+  ::memset(&addr, 0, sizeof addr);
+  addr.sa_family = AF_UNSPEC;
+  if (::connect(sockfd_, &addr, static_cast<socklen_t>(sizeof addr)) < 0) {
+    LOG_ERROR << "abort fd [" << sockfd_ << "] fail with error [" << ::strerror(errno) << "]";
+  }
+}
+
+void Socket::SetTcpNoDelay(const bool on) {
+  SetSocketOption(sockfd_, IPPROTO_TCP, TCP_NODELAY, on);
+}
+
+void Socket::SetReuseAddr(const bool on) {
+  SetSocketOption(sockfd_, SOL_SOCKET, SO_REUSEADDR, on);
+}
+
+void Socket::SetReusePort(const bool on) {
+  SetSocketOption(sockfd_, SOL_SOCKET, SO_REUSEPORT, on);
+}
+
+void Socket::SetKeepAlive(const bool on) {
+  SetSocketOption(sockfd_, SOL_SOCKET, SO_KEEPALIVE, on);
+}
+
+bool Socket::SetZeroCopy(const bool on) {
+  int value = on ? 1 : 0;
+  if (::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &value, static_cast<socklen_t>(sizeof value)) < 0) {
+    LOG_WARN << "setsockopt SO_ZEROCOPY fd [" << sockfd_ << "] fail with error [" << ::strerror(errno) << "]";
+    return false;
+  }
+  return true;
+}
+
+bool Socket::AttachReusePortCpuSteering(const uint32_t group_size) {
+  CHECK_GT(group_size, 0U);
+  // A = 当前 CPU; A = A % group_size; return A
+  struct sock_filter code[] = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, group_size},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog = {static_cast<unsigned short>(sizeof code / sizeof code[0]), code};
+  if (::setsockopt(sockfd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, static_cast<socklen_t>(sizeof prog)) < 0) {
+    LOG_WARN << "attach reuseport cbpf to fd [" << sockfd_ << "] fail with error [" << ::strerror(errno) << "]";
+    return false;
+  }
+  return true;
+}
+
+namespace sockets {
+
+int CreateNonblockingOrDie(const sa_family_t family) {
+  int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  if (sockfd < 0) {
+    LOG_FATAL << "create socket fail with error [" << ::strerror(errno) << "]";
+  }
+  return sockfd;
+}
+
+int GetSocketError(const int sockfd) {
+  int optval = 0;
+  socklen_t optlen = static_cast<socklen_t>(sizeof optval);
+  if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+    return errno;
+  }
+  return optval;
+}
+
+struct sockaddr_in6 GetLocalAddr(const int sockfd) {
+  struct sockaddr_in6 local_addr;
+  ::memset(&local_addr, 0, sizeof local_addr);
+  socklen_t addr_len = static_cast<socklen_t>(sizeof local_addr);
+  if (::getsockname(sockfd, reinterpret_cast<struct sockaddr*>(&local_addr), &addr_len) < 0) {
+    LOG_ERROR << "getsockname fd [" << sockfd << "] fail with error [" << ::strerror(errno) << "]";
+  }
+  return local_addr;
+}
+
+struct sockaddr_in6 GetPeerAddr(const int sockfd) {
+  struct sockaddr_in6 peer_addr;
+  ::memset(&peer_addr, 0, sizeof peer_addr);
+  socklen_t addr_len = static_cast<socklen_t>(sizeof peer_addr);
+  if (::getpeername(sockfd, reinterpret_cast<struct sockaddr*>(&peer_addr), &addr_len) < 0) {
+    LOG_ERROR << "getpeername fd [" << sockfd << "] fail with error [" << ::strerror(errno) << "]";
+  }
+  return peer_addr;
+}
+
+}  // namespace sockets
+
+}  // namespace net
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include "net/inet_address.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+/**
+ * @brief socket fd 的 RAII 封装, 析构时关闭 fd
+ */
+class Socket final {
+ public:
+  explicit Socket(const int sockfd) : sockfd_(sockfd) {
+  }
+  ~Socket();
+
+ public:
+  int fd() const;
+
+  // 绑定失败时直接退出
+  void BindAddress(const InetAddress& local_addr);
+  // 监听失败时直接退出
+  void Listen();
+  /**
+   * @brief 接受一个新连接, 返回的 fd 已经设置了 SOCK_NONBLOCK | SOCK_CLOEXEC
+   *
+   * @param peer_addr 对端地址
+   * @return int 成功时返回新连接的 fd, 失败时返回 -1 并保留 errno
+   */
+  int Accept(InetAddress* const peer_addr);
+
+  void ShutdownWrite();
+  // 用 connect(AF_UNSPEC) 中止连接: 发送 RST 并丢弃发送队列, fd 仍然有效 (例如还可以读取错误队列)
+  void Abort();
+
+  // TCP_NODELAY, 关闭 Nagle 算法
+  void SetTcpNoDelay(const bool on);
+  void SetReuseAddr(const bool on);
+  void SetReusePort(const bool on);
+  void SetKeepAlive(const bool on);
+  // SO_ZEROCOPY, 之后才能使用 MSG_ZEROCOPY 发送, 内核不支持时返回 false
+  bool SetZeroCopy(const bool on);
+
+  /**
+   * @brief 给监听 socket 所在的 SO_REUSEPORT 组挂载 CBPF 程序, 按处理 SYN 的 CPU 选择组内第 (cpu % group_size) 个
+   *        socket (按 listen 的先后顺序编号), 需要所有 socket 都 listen 之后调用
+   * @return bool 内核不支持时返回 false, 此时退化为内核默认的四元组哈希
+   */
+  bool AttachReusePortCpuSteering(const uint32_t group_size);
+
+ private:
+  const int sockfd_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Socket);
+};
+
+namespace sockets {
+
+// 创建非阻塞的 TCP socket, 失败时直接退出
+int CreateNonblockingOrDie(const sa_family_t family);
+int GetSocketError(const int sockfd);
+struct sockaddr_in6 GetLocalAddr(const int sockfd);
+struct sockaddr_in6 GetPeerAddr(const int sockfd);
+
+}  // namespace sockets
+
+}  // namespace net
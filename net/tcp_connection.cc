@@ -0,0 +1,526 @@
+#include "net/tcp_connection.h"
+
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#include "logger/log.h"
+#include "net/channel.h"
+#include "net/event_loop.h"
+#include "net/socket.h"
+
+namespace net {
+
+void DefaultConnectionCallback(const TcpConnectionPtr& conn) {
+  LOG_DEBUG << conn->local_addr().ToIpPort() << " -> " << conn->peer_addr().ToIpPort() << " is "
+            << (conn->Connected() ? "UP" : "DOWN");
+}
+
+void DefaultMessageCallback(const TcpConnectionPtr&, Buffer* buffer, util::time::Timestamp) {
+  buffer->RetrieveAll();
+}
+
+TcpConnection::TcpConnection(EventLoop* loop, const std::string& name, const int sockfd,
+                             const InetAddress& local_addr, const InetAddress& peer_addr)
+    : loop_(loop),
+      name_(name),
+      socket_(std::make_unique<Socket>(sockfd)),
+      channel_(std::make_unique<Channel>(loop, sockfd)),
+      local_addr_(local_addr),
+      peer_addr_(peer_addr),
+      connection_callback_(DefaultConnectionCallback),
+      message_callback_(DefaultMessageCallback) {
+  channel_->SetReadCallback(std::bind(&TcpConnection::HandleRead, this, std::placeholders::_1));
+  channel_->SetWriteCallback(std::bind(&TcpConnection::HandleWrite, this));
+  channel_->SetCloseCallback(std::bind(&TcpConnection::HandleClose, this));
+  channel_->SetErrorCallback(std::bind(&TcpConnection::HandleError, this));
+  socket_->SetKeepAlive(true);
+  LOG_DEBUG << "TcpConnection [" << name_ << "] created with fd [" << sockfd << "]";
+}
+
+TcpConnection::~TcpConnection() {
+  LOG_DEBUG << "TcpConnection [" << name_ << "] destructs with fd [" << socket_->fd() << "] state ["
+            << StateToString() << "]";
+  CHECK(state_ == State::kDisconnected);
+}
+
+EventLoop* TcpConnection::GetLoop() const {
+  return loop_;
+}
+
+const std::string& TcpConnection::name() const {
+  return name_;
+}
+
+const InetAddress& TcpConnection::local_addr() const {
+  return local_addr_;
+}
+
+const InetAddress& TcpConnection::peer_addr() const {
+  return peer_addr_;
+}
+
+bool TcpConnection::Connected() const {
+  return state_ == State::kConnected;
+}
+
+bool TcpConnection::Disconnected() const {
+  return state_ == State::kDisconnected;
+}
+
+void TcpConnection::Send(const void* data, const size_t len) {
+  if (state_ != State::kConnected) {
+    return;
+  }
+  if (loop_->IsInLoopThread()) {
+    SendInLoop(data, len);
+  } else {
+    // 跨线程发送时需要拷贝一份数据
+    std::string message(static_cast<const char*>(data), len);
+    loop_->QueueInLoop([self = shared_from_this(), message = std::move(message)]() {
+      self->SendInLoop(message.data(), message.size());
+    });
+  }
+}
+
+void TcpConnection::Send(const std::string& message) {
+  Send(message.data(), message.size());
+}
+
+void TcpConnection::Send(Buffer* const buffer) {
+  Send(buffer->Peek(), buffer->ReadableBytes());
+  buffer->RetrieveAll();
+}
+
+void TcpConnection::Send(std::shared_ptr<const std::string> blob) {
+  const void* data = blob->data();
+  const size_t len = blob->size();
+  Send(std::shared_ptr<const void>(std::move(blob)), data, len);
+}
+
+void TcpConnection::Send(std::shared_ptr<const void> holder, const void* data, const size_t len) {
+  if (state_ != State::kConnected) {
+    return;
+  }
+  if (loop_->IsInLoopThread()) {
+    SendSharedInLoop(holder, data, len);
+  } else {
+    loop_->QueueInLoop([self = shared_from_this(), holder = std::move(holder), data, len]() {
+      self->SendSharedInLoop(holder, data, len);
+    });
+  }
+}
+
+void TcpConnection::SendFile(std::shared_ptr<const File> file, const off_t offset, const size_t len) {
+  if (state_ != State::kConnected) {
+    return;
+  }
+  if (loop_->IsInLoopThread()) {
+    SendFileInLoop(file, offset, len);
+  } else {
+    loop_->QueueInLoop([self = shared_from_this(), file = std::move(file), offset, len]() {
+      self->SendFileInLoop(file, offset, len);
+    });
+  }
+}
+
+void TcpConnection::BeginBatch() {
+  loop_->AssertInLoopThread();
+  CHECK(!batching_) << "batch can not be nested";
+  batching_ = true;
+}
+
+void TcpConnection::EndBatch() {
+  loop_->AssertInLoopThread();
+  CHECK(batching_);
+  batching_ = false;
+  if (state_ == State::kDisconnected) {
+    return;
+  }
+  // 开始之前已经有排队的数据时等待可写事件, 和 SendSharedInLoop 一样保证顺序
+  if (!output_queue_.empty() && !channel_->IsWriting()) {
+    FlushOutput();
+  }
+  // 期间推迟的 Shutdown
+  if (output_queue_.empty() && state_ == State::kDisconnecting) {
+    ShutdownInLoop();
+  }
+}
+
+void TcpConnection::Shutdown() {
+  State expected = State::kConnected;
+  if (state_.compare_exchange_strong(expected, State::kDisconnecting)) {
+    loop_->RunInLoop(std::bind(&TcpConnection::ShutdownInLoop, shared_from_this()));
+  }
+}
+
+void TcpConnection::ForceClose() {
+  State state = state_;
+  if (state == State::kConnected || state == State::kDisconnecting) {
+    state_ = State::kDisconnecting;
+    loop_->QueueInLoop(std::bind(&TcpConnection::ForceCloseInLoop, shared_from_this()));
+  }
+}
+
+void TcpConnection::SetTcpNoDelay(const bool on) {
+  socket_->SetTcpNoDelay(on);
+}
+
+void TcpConnection::StartRead() {
+  loop_->RunInLoop(std::bind(&TcpConnection::StartReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::StopRead() {
+  loop_->RunInLoop(std::bind(&TcpConnection::StopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::SetConnectionCallback(const ConnectionCallback& cb) {
+  connection_callback_ = cb;
+}
+
+void TcpConnection::SetMessageCallback(const MessageCallback& cb) {
+  message_callback_ = cb;
+}
+
+void TcpConnection::SetWriteCompleteCallback(const WriteCompleteCallback& cb) {
+  write_complete_callback_ = cb;
+}
+
+void TcpConnection::SetHighWaterMarkCallback(const HighWaterMarkCallback& cb, const size_t high_water_mark) {
+  high_water_mark_callback_ = cb;
+  high_water_mark_ = high_water_mark;
+}
+
+void TcpConnection::SetCloseCallback(const CloseCallback& cb) {
+  close_callback_ = cb;
+}
+
+void TcpConnection::SetContext(const std::any& context) {
+  context_ = context;
+}
+
+const std::any& TcpConnection::GetContext() const {
+  return context_;
+}
+
+std::any* TcpConnection::GetMutableContext() {
+  return &context_;
+}
+
+void TcpConnection::ConnectEstablished() {
+  loop_->AssertInLoopThread();
+  CHECK(state_ == State::kConnecting);
+  state_ = State::kConnected;
+  channel_->Tie(shared_from_this());
+  channel_->EnableReading();
+  connection_callback_(shared_from_this());
+}
+
+void TcpConnection::ConnectDestroyed() {
+  loop_->AssertInLoopThread();
+  // 半关闭 (Shutdown 之后对端还没有关闭) 或者 ForceClose 的任务还没有执行的连接同样还在监听事件
+  if (state_ != State::kDisconnected) {
+    state_ = State::kDisconnected;
+    channel_->DisableAll();
+    connection_callback_(shared_from_this());
+  }
+  channel_->Remove();
+  if (output_queue_.zerocopy_enabled()) {
+    // 没有写出的数据不会再发送了
+    output_queue_.Clear();
+    HandleErrorQueue();
+    if (output_queue_.zerocopy_pending() > 0) {
+      // 和关闭 fd 一样, 对端收完内核中已有的数据之后读到 EOF
+      socket_->ShutdownWrite();
+      WaitZeroCopyCompletions(util::time::TimestampMonotonicNanoSec() + kZeroCopyLingerNs, false);
+    }
+  }
+}
+
+bool TcpConnection::EnableZeroCopy(const size_t min_bytes) {
+  loop_->AssertInLoopThread();
+  if (!socket_->SetZeroCopy(true)) {
+    return false;
+  }
+  output_queue_.EnableZeroCopy(min_bytes);
+  channel_->SetErrorQueueCallback(std::bind(&TcpConnection::HandleErrorQueue, this));
+  return true;
+}
+
+size_t TcpConnection::input_bytes() const {
+  loop_->AssertInLoopThread();
+  return input_buffer_.ReadableBytes();
+}
+
+size_t TcpConnection::output_bytes() const {
+  loop_->AssertInLoopThread();
+  return output_queue_.bytes();
+}
+
+bool TcpConnection::IsReading() const {
+  loop_->AssertInLoopThread();
+  return channel_->IsReading();
+}
+
+const OutputQueue::ZeroCopyStats& TcpConnection::zerocopy_stats() const {
+  loop_->AssertInLoopThread();
+  return output_queue_.zerocopy_stats();
+}
+
+uint64_t TcpConnection::write_calls() const {
+  loop_->AssertInLoopThread();
+  return write_calls_;
+}
+
+void TcpConnection::HandleRead(const util::time::Timestamp receive_time) {
+  loop_->AssertInLoopThread();
+  size_t total = 0;
+  bool peer_closed = false;
+  while (true) {
+    const size_t max_read = input_buffer_.WritableBytes() + Buffer::kExtraBufferSize;
+    int saved_errno = 0;
+    ssize_t n = input_buffer_.ReadFd(socket_->fd(), &saved_errno);
+    if (n > 0) {
+      total += n;
+      // 没有读满说明内核缓冲区已经读空了; 超过预算时交给下一轮循环
+      if (static_cast<size_t>(n) < max_read || total >= loop_->io_budget_bytes()) {
+        break;
+      }
+    } else if (n == 0) {
+      peer_closed = true;
+      break;
+    } else if (saved_errno == EINTR) {
+      continue;
+    } else if (saved_errno == ECONNRESET) {
+      // 对端通过 RST 关闭连接, 和正常关闭一样处理
+      peer_closed = true;
+      break;
+    } else {
+      if (saved_errno != EAGAIN && saved_errno != EWOULDBLOCK) {
+        LOG_ERROR << "TcpConnection [" << name_ << "] read fail with error [" << ::strerror(saved_errno) << "]";
+        HandleError();
+      }
+      break;
+    }
+  }
+
+  if (total > 0) {
+    message_callback_(shared_from_this(), &input_buffer_, receive_time);
+  }
+  if (peer_closed) {
+    HandleClose();
+  }
+}
+
+void TcpConnection::HandleWrite() {
+  loop_->AssertInLoopThread();
+  if (!channel_->IsWriting()) {
+    LOG_DEBUG << "TcpConnection [" << name_ << "] is down, no more writing";
+    return;
+  }
+
+  FlushOutput();
+  if (output_queue_.empty() && state_ == State::kDisconnecting) {
+    ShutdownInLoop();
+  }
+}
+
+void TcpConnection::HandleClose() {
+  loop_->AssertInLoopThread();
+  LOG_DEBUG << "TcpConnection [" << name_ << "] fd [" << socket_->fd() << "] state [" << StateToString() << "]";
+  CHECK(state_ == State::kConnected || state_ == State::kDisconnecting);
+  state_ = State::kDisconnected;
+  channel_->DisableAll();
+
+  // 回调中可能释放最后一个外部引用, 需要保证本函数执行期间对象存活
+  TcpConnectionPtr guard(shared_from_this());
+  connection_callback_(guard);
+  if (close_callback_) {
+    close_callback_(guard);
+  }
+}
+
+void TcpConnection::HandleError() {
+  int err = sockets::GetSocketError(socket_->fd());
+  // 对端重置连接是常见情况, 随后的读事件会关闭连接
+  if (err == ECONNRESET || err == EPIPE) {
+    LOG_DEBUG << "TcpConnection [" << name_ << "] SO_ERROR [" << err << "] " << ::strerror(err);
+    return;
+  }
+  LOG_ERROR << "TcpConnection [" << name_ << "] SO_ERROR [" << err << "] " << ::strerror(err);
+}
+
+bool TcpConnection::HandleErrorQueue() {
+  loop_->AssertInLoopThread();
+  return output_queue_.HandleErrorQueue(socket_->fd()) > 0;
+}
+
+void TcpConnection::WaitZeroCopyCompletions(const util::time::Timestamp deadline, const bool aborted) {
+  loop_->AssertInLoopThread();
+  HandleErrorQueue();
+  const size_t pending = output_queue_.zerocopy_pending();
+  if (pending == 0) {
+    return;
+  }
+  const util::time::Timestamp now = util::time::TimestampMonotonicNanoSec();
+  if (now < deadline) {
+    loop_->RunAfter(kZeroCopyPollSeconds, std::bind(&TcpConnection::WaitZeroCopyCompletions, shared_from_this(),
+                                                    deadline, aborted));
+    return;
+  }
+  if (aborted) {
+    LOG_ERROR << "TcpConnection [" << name_ << "] give up waiting for [" << pending << "] zerocopy completions";
+    return;
+  }
+  // 例如对端的接收窗口一直为 0
+  LOG_WARN << "TcpConnection [" << name_ << "] abort with [" << pending << "] zerocopy sends not acknowledged";
+  socket_->Abort();
+  WaitZeroCopyCompletions(now + kZeroCopyAbortGraceNs, true);
+}
+
+void TcpConnection::SendInLoop(const void* data, const size_t len) {
+  loop_->AssertInLoopThread();
+  if (state_ == State::kDisconnected) {
+    LOG_WARN << "TcpConnection [" << name_ << "] is disconnected, give up writing";
+    return;
+  }
+
+  size_t written = 0;
+  // 没有排队的数据时直接写入内核, 省去一次拷贝和一次可写事件; 合并发送时留给 EndBatch
+  if (output_queue_.empty() && !batching_) {
+    ++write_calls_;
+    ssize_t n = ::send(socket_->fd(), data, len, MSG_NOSIGNAL);
+    if (n >= 0) {
+      written = static_cast<size_t>(n);
+      if (written == len && write_complete_callback_) {
+        loop_->QueueInLoop(std::bind(write_complete_callback_, shared_from_this()));
+      }
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      LOG_ERROR << "TcpConnection [" << name_ << "] send fail with error [" << ::strerror(errno) << "]";
+      if (errno == EPIPE || errno == ECONNRESET) {
+        return;
+      }
+    }
+  }
+
+  if (written < len) {
+    const size_t old_bytes = output_queue_.bytes();
+    output_queue_.Append(static_cast<const char*>(data) + written, len - written);
+    CheckHighWaterMark(old_bytes);
+    if (!batching_ && !channel_->IsWriting()) {
+      channel_->EnableWriting();
+    }
+  }
+}
+
+void TcpConnection::SendSharedInLoop(const std::shared_ptr<const void>& holder, const void* data,
+                                     const size_t len) {
+  loop_->AssertInLoopThread();
+  if (state_ == State::kDisconnected) {
+    LOG_WARN << "TcpConnection [" << name_ << "] is disconnected, give up writing";
+    return;
+  }
+
+  const size_t old_bytes = output_queue_.bytes();
+  output_queue_.Append(holder, data, len);
+  // 之前没有排队的数据时立即尝试写出, 否则等待可写事件, 保证数据的顺序
+  if (old_bytes == 0 && !batching_) {
+    FlushOutput();
+  }
+  CheckHighWaterMark(old_bytes);
+}
+
+void TcpConnection::SendFileInLoop(const std::shared_ptr<const File>& file, const off_t offset, const size_t len) {
+  loop_->AssertInLoopThread();
+  if (state_ == State::kDisconnected) {
+    LOG_WARN << "TcpConnection [" << name_ << "] is disconnected, give up writing";
+    return;
+  }
+
+  const size_t old_bytes = output_queue_.bytes();
+  output_queue_.AppendFile(file, offset, len);
+  if (old_bytes == 0 && !batching_) {
+    FlushOutput();
+  }
+  CheckHighWaterMark(old_bytes);
+}
+
+void TcpConnection::FlushOutput() {
+  ++write_calls_;
+  int saved_errno = 0;
+  ssize_t n = output_queue_.WriteTo(socket_->fd(), loop_->io_budget_bytes(), &saved_errno);
+  if (n < 0 && saved_errno != EAGAIN && saved_errno != EWOULDBLOCK && saved_errno != EINTR) {
+    LOG_ERROR << "TcpConnection [" << name_ << "] send fail with error [" << ::strerror(saved_errno) << "]";
+    if (saved_errno == ENODATA) {
+      // 文件被截断, 对端收到的数据已经不完整了, 只能关闭连接
+      output_queue_.Clear();
+      ForceClose();
+    }
+  }
+
+  if (output_queue_.empty()) {
+    if (channel_->IsWriting()) {
+      channel_->DisableWriting();
+    }
+    if (n > 0 && write_complete_callback_) {
+      loop_->QueueInLoop(std::bind(write_complete_callback_, shared_from_this()));
+    }
+  } else if (!channel_->IsWriting()) {
+    channel_->EnableWriting();
+  }
+}
+
+void TcpConnection::CheckHighWaterMark(const size_t old_bytes) {
+  const size_t bytes = output_queue_.bytes();
+  if (old_bytes < high_water_mark_ && bytes >= high_water_mark_ && high_water_mark_callback_) {
+    loop_->QueueInLoop(std::bind(high_water_mark_callback_, shared_from_this(), bytes));
+  }
+}
+
+void TcpConnection::StartReadInLoop() {
+  loop_->AssertInLoopThread();
+  if (state_ != State::kDisconnected && !channel_->IsReading()) {
+    channel_->EnableReading();
+  }
+}
+
+void TcpConnection::StopReadInLoop() {
+  loop_->AssertInLoopThread();
+  if (state_ != State::kDisconnected && channel_->IsReading()) {
+    channel_->DisableReading();
+  }
+}
+
+void TcpConnection::ShutdownInLoop() {
+  loop_->AssertInLoopThread();
+  // 还有数据没有写完时, 由 HandleWrite 或者 EndBatch 在写完之后再关闭
+  if (!channel_->IsWriting() && !batching_) {
+    socket_->ShutdownWrite();
+  }
+}
+
+void TcpConnection::ForceCloseInLoop() {
+  loop_->AssertInLoopThread();
+  if (state_ == State::kConnected || state_ == State::kDisconnecting) {
+    HandleClose();
+  }
+}
+
+const char* TcpConnection::StateToString() const {
+  switch (state_) {
+    case State::kDisconnected:
+      return "kDisconnected";
+    case State::kConnecting:
+      return "kConnecting";
+    case State::kConnected:
+      return "kConnected";
+    case State::kDisconnecting:
+      return "kDisconnecting";
+  }
+  return "unknown state";
+}
+
+}  // namespace net
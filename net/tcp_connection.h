@@ -0,0 +1,181 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <any>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "net/buffer.h"
+#include "net/callbacks.h"
+#include "net/file.h"
+#include "net/inet_address.h"
+#include "net/output_queue.h"
+#include "util/macros/macros.h"
+#include "util/time/timestamp.hpp"
+
+namespace net {
+
+class Channel;
+class EventLoop;
+class Socket;
+
+/**
+ * @brief 一个已经建立的 TCP 连接, 由 TcpServer 创建, 通过 shared_ptr 管理生命周期
+ *
+ * @note
+ *   1. 连接的所有 IO 都在所属的 IO 线程中进行, Send / Shutdown / ForceClose 可以跨线程调用
+ *   2. Channel 通过 Tie 持有 TcpConnection 的弱指针, 分发事件时临时提升为 shared_ptr, 保证回调执行期间
+ *      即使用户在回调中释放了最后一个 TcpConnectionPtr, TcpConnection 也不会被析构
+ *   3. 每次可读事件最多读取 EventLoop::io_budget_bytes 字节, 没有读完的数据会因为水平触发在下一轮循环中继续读取,
+ *      避免一个繁忙的连接饿死同一个 IO 线程上的其他连接
+ *   4. 写数据时先尝试直接写入内核, 写不完的部分才放入输出队列 (OutputQueue); 输出队列非空时关注可写事件,
+ *      每次可写事件最多写出 io_budget_bytes 字节, 写空之后取消关注
+ *   5. 输出队列超过高水位线时回调 HighWaterMarkCallback, 上层可以据此暂停生产数据 (例如对上游连接调用 StopRead),
+ *      在 WriteCompleteCallback 中恢复
+ *   6. EnableZeroCopy 之后大块数据用 MSG_ZEROCOPY 发送, 完成通知通过错误队列 (POLLERR) 送达, 见 OutputQueue.
+ *      内核在完成之前一直引用这些内存, 关闭 fd 之后也可能继续发送, 所以 ConnectDestroyed 时还有没完成的发送就
+ *      只关闭写端, 由定时器持有连接, 保持 fd 打开并轮询错误队列, 完成通知都到达之后才释放连接和数据.
+ *      对端超过 kZeroCopyLingerNs 仍不确认时中止连接 (RST), 内核丢弃发送队列之后完成通知随即到达
+ */
+class TcpConnection final : public std::enable_shared_from_this<TcpConnection> {
+ public:
+  TcpConnection(EventLoop* loop, const std::string& name, const int sockfd, const InetAddress& local_addr,
+                const InetAddress& peer_addr);
+  ~TcpConnection();
+
+ public:
+  EventLoop* GetLoop() const;
+  const std::string& name() const;
+  const InetAddress& local_addr() const;
+  const InetAddress& peer_addr() const;
+  bool Connected() const;
+  bool Disconnected() const;
+
+  // 发送数据, 可以跨线程调用
+  void Send(const void* data, const size_t len);
+  void Send(const std::string& message);
+  // 发送 buffer 中的全部可读数据并清空 buffer
+  void Send(Buffer* const buffer);
+  // 发送共享的只读数据, 不拷贝, 发送完之前 blob 不能被修改
+  void Send(std::shared_ptr<const std::string> blob);
+  // 发送共享的只读数据 [data, data + len), holder 保证这段内存在发送完之前有效
+  void Send(std::shared_ptr<const void> holder, const void* data, const size_t len);
+  // 用 sendfile 发送文件中 [offset, offset + len) 的内容, 和其他 Send 的数据按调用顺序发送
+  void SendFile(std::shared_ptr<const File> file, const off_t offset, const size_t len);
+  /**
+   * @brief 开始合并发送: 之后在 IO 线程中 Send / SendFile 的数据只追加到输出队列, 直到 EndBatch 时一起写出,
+   *        例如 pipelining 的多个响应只需要一次 sendmsg. 只能在 IO 线程中调用, 不能嵌套
+   */
+  void BeginBatch();
+  void EndBatch();
+  // 发送完输出缓冲区中的数据之后关闭写端, 可以跨线程调用
+  void Shutdown();
+  // 立即关闭连接, 丢弃输出缓冲区中的数据, 可以跨线程调用
+  void ForceClose();
+  void SetTcpNoDelay(const bool on);
+  /**
+   * @brief 一次写出不少于 min_bytes 字节时使用 MSG_ZEROCOPY, 只能在 IO 线程中调用
+   * @note 数据较小时锁定页面和处理完成通知的开销大于拷贝, 内核实际做了拷贝 (例如本机连接) 时会自动关闭
+   * @return bool 内核不支持 SO_ZEROCOPY 时返回 false
+   */
+  bool EnableZeroCopy(const size_t min_bytes = kDefaultZeroCopyMinBytes);
+  // 暂停 / 恢复读取数据, 可以跨线程调用
+  void StartRead();
+  void StopRead();
+
+  void SetConnectionCallback(const ConnectionCallback& cb);
+  void SetMessageCallback(const MessageCallback& cb);
+  void SetWriteCompleteCallback(const WriteCompleteCallback& cb);
+  void SetHighWaterMarkCallback(const HighWaterMarkCallback& cb, const size_t high_water_mark);
+  // 仅供 TcpServer 使用
+  void SetCloseCallback(const CloseCallback& cb);
+
+  // 上层协议附加在连接上的状态, 例如 HTTP 解析器, 只能在 IO 线程中访问
+  void SetContext(const std::any& context);
+  const std::any& GetContext() const;
+  std::any* GetMutableContext();
+
+  // 连接建立后由 TcpServer 在 IO 线程中调用, 只能调用一次
+  void ConnectEstablished();
+  // TcpServer 移除连接后在 IO 线程中调用, 只能调用一次
+  void ConnectDestroyed();
+
+ public:
+  // 输入缓冲区 / 输出队列中尚未处理的字节数, 只能在 IO 线程中调用
+  size_t input_bytes() const;
+  size_t output_bytes() const;
+  bool IsReading() const;
+  const OutputQueue::ZeroCopyStats& zerocopy_stats() const;
+  // 写 socket 的次数 (直接写一次数据或者写一次输出队列), 只能在 IO 线程中调用
+  uint64_t write_calls() const;
+
+ private:
+  enum class State {
+    kDisconnected = 0,
+    kConnecting = 1,
+    kConnected = 2,
+    kDisconnecting = 3,
+  };
+
+ private:
+  void HandleRead(const util::time::Timestamp receive_time);
+  void HandleWrite();
+  void HandleClose();
+  void HandleError();
+  // 处理错误队列中的 MSG_ZEROCOPY 完成通知, 读到通知时返回 true
+  bool HandleErrorQueue();
+  // ConnectDestroyed 之后轮询 MSG_ZEROCOPY 的完成通知, 超过 deadline (单调时钟) 时中止连接
+  void WaitZeroCopyCompletions(const util::time::Timestamp deadline, const bool aborted);
+  void SendInLoop(const void* data, const size_t len);
+  void SendSharedInLoop(const std::shared_ptr<const void>& holder, const void* data, const size_t len);
+  void SendFileInLoop(const std::shared_ptr<const File>& file, const off_t offset, const size_t len);
+  // 写出输出队列中的数据, 并根据队列是否为空开关可写事件
+  void FlushOutput();
+  // 输出队列从 old_bytes 增长之后检查是否越过了高水位线
+  void CheckHighWaterMark(const size_t old_bytes);
+  void StartReadInLoop();
+  void StopReadInLoop();
+  void ShutdownInLoop();
+  void ForceCloseInLoop();
+  const char* StateToString() const;
+
+ private:
+  EventLoop* loop_;
+  const std::string name_;
+  std::atomic<State> state_ = {State::kConnecting};
+
+  std::unique_ptr<Socket> socket_;
+  std::unique_ptr<Channel> channel_;
+  const InetAddress local_addr_;
+  const InetAddress peer_addr_;
+
+  ConnectionCallback connection_callback_;
+  MessageCallback message_callback_;
+  WriteCompleteCallback write_complete_callback_;
+  CloseCallback close_callback_;
+  HighWaterMarkCallback high_water_mark_callback_;
+  size_t high_water_mark_ = kDefaultHighWaterMark;
+
+  Buffer input_buffer_;
+  OutputQueue output_queue_;
+  // BeginBatch 和 EndBatch 之间为 true
+  bool batching_ = false;
+  uint64_t write_calls_ = 0;
+  std::any context_;
+
+ private:
+  static constexpr size_t kDefaultHighWaterMark = 64 * 1024 * 1024;
+  static constexpr size_t kDefaultZeroCopyMinBytes = 64 * 1024;
+  static constexpr double kZeroCopyPollSeconds = 0.01;
+  static constexpr util::time::Timestamp kZeroCopyLingerNs = 10 * util::time::kSeconds2NanoSeconds;
+  // 中止连接之后等待网卡驱动释放还在发送的数据
+  static constexpr util::time::Timestamp kZeroCopyAbortGraceNs = util::time::kSeconds2NanoSeconds;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TcpConnection);
+};
+
+}  // namespace net
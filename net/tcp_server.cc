@@ -0,0 +1,208 @@
+#include "net/tcp_server.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "logger/log.h"
+#include "net/acceptor.h"
+#include "net/event_loop.h"
+#include "net/event_loop_thread_pool.h"
+#include "net/socket.h"
+#include "net/tcp_connection.h"
+
+namespace net {
+
+namespace {
+
+// 把当前线程绑定到 cpu 上, 失败时只打印日志
+void BindCurrentThreadToCpu(const size_t cpu) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  int ret = ::pthread_setaffinity_np(::pthread_self(), sizeof cpu_set, &cpu_set);
+  if (ret != 0) {
+    LOG_WARN << "bind thread to cpu [" << cpu << "] fail with error [" << ::strerror(ret) << "]";
+  }
+}
+
+}  // namespace
+
+TcpServer::TcpServer(EventLoop* loop, const InetAddress& listen_addr, const std::string& name,
+                     const bool reuse_port, const AcceptMode accept_mode)
+    : loop_(loop),
+      name_(name),
+      accept_mode_(accept_mode),
+      acceptor_(
+          std::make_unique<Acceptor>(loop, listen_addr, reuse_port || accept_mode != AcceptMode::kSingleAcceptor)),
+      thread_pool_(std::make_unique<EventLoopThreadPool>(loop, name)),
+      connection_callback_(DefaultConnectionCallback),
+      message_callback_(DefaultMessageCallback) {
+  CHECK(loop != nullptr);
+  acceptor_->SetNewConnectionCallback(
+      std::bind(&TcpServer::NewConnection, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+TcpServer::~TcpServer() {
+  loop_->AssertInLoopThread();
+  LOG_INFO << "TcpServer [" << name_ << "] destructs";
+  acceptor_.reset();
+  // 连接和监听 socket 都要在所属的 IO 线程中销毁; IO 线程在退出之前会执行完这里投递的任务
+  for (std::pair<EventLoop* const, LoopContext>& item : loop_contexts_) {
+    EventLoop* io_loop = item.first;
+    io_loop->RunInLoop(std::bind(&TcpServer::DestroyLoopContext, this, io_loop));
+  }
+  thread_pool_.reset();
+}
+
+void TcpServer::SetThreadNum(const int num_threads) {
+  thread_pool_->SetThreadNum(num_threads);
+}
+
+void TcpServer::SetThreadInitCallback(const EventLoopThread::ThreadInitCallback& cb) {
+  thread_init_callback_ = cb;
+}
+
+void TcpServer::Start() {
+  bool expected = false;
+  if (!started_.compare_exchange_strong(expected, true)) {
+    return;
+  }
+  loop_->RunInLoop(std::bind(&TcpServer::StartInLoop, this));
+}
+
+void TcpServer::SetConnectionCallback(const ConnectionCallback& cb) {
+  connection_callback_ = cb;
+}
+
+void TcpServer::SetMessageCallback(const MessageCallback& cb) {
+  message_callback_ = cb;
+}
+
+void TcpServer::SetWriteCompleteCallback(const WriteCompleteCallback& cb) {
+  write_complete_callback_ = cb;
+}
+
+EventLoop* TcpServer::GetLoop() const {
+  return loop_;
+}
+
+const std::string& TcpServer::name() const {
+  return name_;
+}
+
+TcpServer::AcceptMode TcpServer::accept_mode() const {
+  return accept_mode_;
+}
+
+InetAddress TcpServer::listen_addr() const {
+  return acceptor_->listen_addr();
+}
+
+size_t TcpServer::connection_num() const {
+  return connection_num_;
+}
+
+void TcpServer::StartInLoop() {
+  loop_->AssertInLoopThread();
+  thread_pool_->Start(thread_init_callback_);
+  std::vector<EventLoop*> loops = thread_pool_->GetAllLoops();
+  for (EventLoop* io_loop : loops) {
+    loop_contexts_[io_loop];
+  }
+
+  // 没有 IO 线程时只有 base_loop 一个监听 socket, 和 kSingleAcceptor 没有区别
+  if (accept_mode_ == AcceptMode::kSingleAcceptor || (loops.size() == 1 && loops[0] == loop_)) {
+    CHECK(!acceptor_->listening());
+    acceptor_->Listen();
+  } else {
+    StartReusePortAcceptors();
+  }
+  LOG_INFO << "TcpServer [" << name_ << "] listening on [" << listen_addr().ToIpPort() << "] with ["
+           << loops.size() << "] io loops";
+}
+
+void TcpServer::StartReusePortAcceptors() {
+  // acceptor_ 已经绑定了端口, 其他监听 socket 绑定同一个端口
+  const InetAddress bound_addr = acceptor_->listen_addr();
+  std::vector<EventLoop*> loops = thread_pool_->GetAllLoops();
+  const bool cpu_steering = accept_mode_ == AcceptMode::kReusePortCpuSteering;
+  const size_t cpu_num = std::max(1U, std::thread::hardware_concurrency());
+
+  for (size_t i = 0; i < loops.size(); ++i) {
+    EventLoop* io_loop = loops[i];
+    LoopContext& context = loop_contexts_[io_loop];
+    context.acceptor = std::make_unique<Acceptor>(io_loop, bound_addr, true);
+    context.acceptor->SetNewConnectionCallback(std::bind(&TcpServer::NewConnectionInLoop, this, io_loop,
+                                                         std::placeholders::_1, std::placeholders::_2));
+    // SO_REUSEPORT 组内的 socket 按 listen 的先后编号, CBPF 程序返回的就是这个编号, 因此必须逐个等待 listen 完成
+    std::promise<void> listened;
+    Acceptor* acceptor = context.acceptor.get();
+    io_loop->RunInLoop([acceptor, &listened, cpu_steering, cpu_num, i]() {
+      if (cpu_steering && i < cpu_num) {
+        BindCurrentThreadToCpu(i);
+      }
+      acceptor->Listen();
+      listened.set_value();
+    });
+    listened.get_future().wait();
+  }
+
+  if (cpu_steering) {
+    loop_contexts_[loops[0]].acceptor->AttachReusePortCpuSteering(static_cast<uint32_t>(loops.size()));
+  }
+}
+
+void TcpServer::NewConnection(const int sockfd, const InetAddress& peer_addr) {
+  loop_->AssertInLoopThread();
+  EventLoop* io_loop = thread_pool_->GetNextLoop();
+  io_loop->RunInLoop(std::bind(&TcpServer::NewConnectionInLoop, this, io_loop, sockfd, peer_addr));
+}
+
+void TcpServer::NewConnectionInLoop(EventLoop* io_loop, const int sockfd, const InetAddress& peer_addr) {
+  io_loop->AssertInLoopThread();
+  std::string conn_name = name_ + "#" + std::to_string(next_conn_id_.fetch_add(1, std::memory_order_relaxed));
+  LOG_DEBUG << "TcpServer [" << name_ << "] new connection [" << conn_name << "] from [" << peer_addr.ToIpPort()
+            << "]";
+
+  InetAddress local_addr(sockets::GetLocalAddr(sockfd));
+  TcpConnectionPtr conn = std::make_shared<TcpConnection>(io_loop, conn_name, sockfd, local_addr, peer_addr);
+  loop_contexts_.at(io_loop).connections[conn_name] = conn;
+  ++connection_num_;
+  conn->SetConnectionCallback(connection_callback_);
+  conn->SetMessageCallback(message_callback_);
+  conn->SetWriteCompleteCallback(write_complete_callback_);
+  conn->SetCloseCallback(std::bind(&TcpServer::RemoveConnection, this, std::placeholders::_1));
+  conn->ConnectEstablished();
+}
+
+void TcpServer::RemoveConnection(const TcpConnectionPtr& conn) {
+  EventLoop* io_loop = conn->GetLoop();
+  io_loop->AssertInLoopThread();
+  LOG_DEBUG << "TcpServer [" << name_ << "] remove connection [" << conn->name() << "]";
+  if (loop_contexts_.at(io_loop).connections.erase(conn->name()) > 0) {
+    --connection_num_;
+  }
+  // 不能在 HandleClose 中直接销毁 Channel, 因此延后到 IO 线程处理完本轮事件之后
+  io_loop->QueueInLoop(std::bind(&TcpConnection::ConnectDestroyed, conn));
+}
+
+void TcpServer::DestroyLoopContext(EventLoop* io_loop) {
+  io_loop->AssertInLoopThread();
+  LoopContext& context = loop_contexts_.at(io_loop);
+  context.acceptor.reset();
+  for (ConnectionMap::value_type& item : context.connections) {
+    item.second->ConnectDestroyed();
+  }
+  connection_num_ -= context.connections.size();
+  context.connections.clear();
+}
+
+}  // namespace net
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "net/callbacks.h"
+#include "net/event_loop_thread.h"
+#include "net/inet_address.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+class Acceptor;
+class EventLoop;
+class EventLoopThreadPool;
+
+/**
+ * @brief TCP 服务端, 接受连接并把连接分配给 IO 线程池中的 EventLoop
+ *
+ * @note
+ *   1. 每个 IO 线程维护自己的连接表, 连接的建立、关闭和销毁都只在所属的 IO 线程中进行, 不需要经过 base_loop
+ *   2. 回调和线程数需要在 Start 之前设置, 线程数为 0 时所有 IO 都在 base_loop 中进行
+ *   3. 接受连接的方式见 AcceptMode
+ */
+class TcpServer final {
+ public:
+  enum class AcceptMode {
+    // base_loop 中的一个监听 socket 接受所有连接, 再轮询分配给 IO 线程
+    kSingleAcceptor = 0,
+    // 每个 IO 线程持有一个 SO_REUSEPORT 监听 socket, 由内核按四元组哈希分配连接, accept 不再集中在一个线程
+    kReusePort = 1,
+    // 在 kReusePort 的基础上挂载 CBPF 程序, 连接交给处理 SYN 的 CPU 对应的 IO 线程, 并把第 i 个 IO 线程绑定到第
+    // i 个 CPU 上, 连接的整个生命周期都留在同一个 CPU 上; IO 线程数等于 CPU 数 (并且网卡队列和 CPU 对应) 时效果最好
+    kReusePortCpuSteering = 2,
+  };
+
+ public:
+  /**
+   * @param reuse_port 监听 socket 是否设置 SO_REUSEPORT, 用于多个进程监听同一个端口; accept_mode 不是
+   *        kSingleAcceptor 时总是设置
+   */
+  TcpServer(EventLoop* loop, const InetAddress& listen_addr, const std::string& name, const bool reuse_port = false,
+            const AcceptMode accept_mode = AcceptMode::kSingleAcceptor);
+  ~TcpServer();
+
+ public:
+  // 设置 IO 线程的数量, 必须在 Start 之前调用
+  void SetThreadNum(const int num_threads);
+  void SetThreadInitCallback(const EventLoopThread::ThreadInitCallback& cb);
+  // 启动 IO 线程池并开始监听, 可以重复调用, 可以跨线程调用
+  void Start();
+
+  void SetConnectionCallback(const ConnectionCallback& cb);
+  void SetMessageCallback(const MessageCallback& cb);
+  void SetWriteCompleteCallback(const WriteCompleteCallback& cb);
+
+ public:
+  EventLoop* GetLoop() const;
+  const std::string& name() const;
+  AcceptMode accept_mode() const;
+  // 实际监听的地址, 监听 0 端口时可以通过它获取内核分配的端口
+  InetAddress listen_addr() const;
+  // 当前的连接数, 可以跨线程调用
+  size_t connection_num() const;
+
+ private:
+  using ConnectionMap = std::map<std::string, TcpConnectionPtr>;
+
+  // 每个 IO 线程的状态, 只在该 IO 线程中访问
+  struct LoopContext {
+    // kReusePort 模式下该 IO 线程自己的监听 socket
+    std::unique_ptr<Acceptor> acceptor;
+    ConnectionMap connections;
+  };
+
+ private:
+  void StartInLoop();
+  // 为每个 IO 线程创建 SO_REUSEPORT 监听 socket, 按顺序 listen
+  void StartReusePortAcceptors();
+  // 由 base_loop 中的 Acceptor 回调, 把连接交给下一个 IO 线程
+  void NewConnection(const int sockfd, const InetAddress& peer_addr);
+  // 在 io_loop 中建立连接
+  void NewConnectionInLoop(EventLoop* io_loop, const int sockfd, const InetAddress& peer_addr);
+  // 由 TcpConnection 在所属的 IO 线程中回调
+  void RemoveConnection(const TcpConnectionPtr& conn);
+  // 在 io_loop 中销毁它的所有连接和监听 socket
+  void DestroyLoopContext(EventLoop* io_loop);
+
+ private:
+  EventLoop* loop_;
+  const std::string name_;
+  const AcceptMode accept_mode_;
+  // base_loop 的监听 socket, kReusePort 模式下只用于占住端口 (监听 0 端口时确定实际端口), 有 IO 线程时不会 listen
+  std::unique_ptr<Acceptor> acceptor_;
+  std::unique_ptr<EventLoopThreadPool> thread_pool_;
+
+  ConnectionCallback connection_callback_;
+  MessageCallback message_callback_;
+  WriteCompleteCallback write_complete_callback_;
+  EventLoopThread::ThreadInitCallback thread_init_callback_;
+
+  std::atomic<bool> started_ = {false};
+  std::atomic<uint64_t> next_conn_id_ = {1};
+  std::atomic<size_t> connection_num_ = {0};
+  // 在 StartInLoop 中创建, 之后不再增删元素, 因此各个 IO 线程可以并发地查找
+  std::unordered_map<EventLoop*, LoopContext> loop_contexts_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TcpServer);
+};
+
+}  // namespace net
@@ -0,0 +1,532 @@
+#include "net/tcp_server.h"
+
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "logger/log.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/file.h"
+#include "net/inet_address.h"
+#include "net/tcp_connection.h"
+#include "net/test_util.hpp"
+
+namespace net {
+
+namespace {
+
+void EchoMessage(const TcpConnectionPtr& conn, Buffer* buffer, util::time::Timestamp) {
+  conn->Send(buffer);
+}
+
+/**
+ * @brief 启动一个 echo 服务, 在客户端线程中执行 client, 结束后等待所有连接都被移除再退出
+ */
+void RunEchoServer(const int num_threads, const std::function<void(const InetAddress&)>& client,
+                   std::atomic<int>* const up_count, std::atomic<int>* const down_count,
+                   const TcpServer::AcceptMode accept_mode = TcpServer::AcceptMode::kSingleAcceptor) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "EchoServer", false, accept_mode);
+  server.SetThreadNum(num_threads);
+  server.SetConnectionCallback([up_count, down_count](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      conn->SetTcpNoDelay(true);
+      ++*up_count;
+    } else {
+      ++*down_count;
+    }
+  });
+  server.SetMessageCallback(EchoMessage);
+  server.Start();
+
+  std::atomic<bool> client_done = {false};
+  std::thread client_thread([&]() {
+    client(server.listen_addr());
+    client_done = true;
+  });
+  loop.RunEvery(0.005, [&]() {
+    if (client_done && server.connection_num() == 0) {
+      loop.Quit();
+    }
+  });
+  loop.Loop();
+  client_thread.join();
+}
+
+}  // namespace
+
+TEST(TcpServerTest, echo) {
+  for (int num_threads : {0, 2}) {
+    std::atomic<int> up_count = {0};
+    std::atomic<int> down_count = {0};
+    RunEchoServer(num_threads, [](const InetAddress& addr) {
+      int fd = BlockingConnect(addr);
+      ASSERT_GE(fd, 0);
+      for (const std::string& message : {std::string("hello"), std::string("world"), std::string(1, 'x')}) {
+        ASSERT_TRUE(WriteAll(fd, message));
+        EXPECT_EQ(ReadExactly(fd, message.size()), message);
+      }
+      ::close(fd);
+    }, &up_count, &down_count);
+    EXPECT_EQ(up_count, 1);
+    EXPECT_EQ(down_count, 1);
+  }
+}
+
+TEST(TcpServerTest, large_message) {
+  std::atomic<int> up_count = {0};
+  std::atomic<int> down_count = {0};
+  RunEchoServer(1, [](const InetAddress& addr) {
+    int fd = BlockingConnect(addr);
+    ASSERT_GE(fd, 0);
+    // 超过 socket 缓冲区和 io_budget_bytes, 服务端需要分多次读取并通过输出缓冲区发送
+    std::string message;
+    for (int i = 0; i < 4 * 1024 * 1024; ++i) {
+      message.push_back(static_cast<char>('a' + i % 26));
+    }
+    std::thread writer([fd, &message]() {
+      EXPECT_TRUE(WriteAll(fd, message));
+    });
+    EXPECT_EQ(ReadExactly(fd, message.size()), message);
+    writer.join();
+    ::close(fd);
+  }, &up_count, &down_count);
+  EXPECT_EQ(up_count, 1);
+  EXPECT_EQ(down_count, 1);
+}
+
+TEST(TcpServerTest, many_connections) {
+  constexpr int kConnNum = 100;
+  for (TcpServer::AcceptMode accept_mode :
+       {TcpServer::AcceptMode::kSingleAcceptor, TcpServer::AcceptMode::kReusePort,
+        TcpServer::AcceptMode::kReusePortCpuSteering}) {
+    std::atomic<int> up_count = {0};
+    std::atomic<int> down_count = {0};
+    RunEchoServer(3, [](const InetAddress& addr) {
+      std::vector<int> fds;
+      for (int i = 0; i < kConnNum; ++i) {
+        fds.push_back(BlockingConnect(addr));
+        ASSERT_GE(fds.back(), 0);
+      }
+      for (int i = 0; i < kConnNum; ++i) {
+        std::string message = "message #" + std::to_string(i);
+        ASSERT_TRUE(WriteAll(fds[i], message));
+        EXPECT_EQ(ReadExactly(fds[i], message.size()), message);
+      }
+      for (int fd : fds) {
+        ::close(fd);
+      }
+    }, &up_count, &down_count, accept_mode);
+    EXPECT_EQ(up_count, kConnNum);
+    EXPECT_EQ(down_count, kConnNum);
+  }
+}
+
+TEST(TcpServerTest, reuse_port_spreads_connections) {
+  constexpr int kConnNum = 200;
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "ReusePortServer", false, TcpServer::AcceptMode::kReusePort);
+  server.SetThreadNum(4);
+  std::mutex mutex;
+  std::set<EventLoop*> accepted_loops;
+  std::atomic<int> up_count = {0};
+  server.SetConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      // 连接由接受它的 IO 线程直接处理, 不经过 base_loop
+      EXPECT_TRUE(conn->GetLoop()->IsInLoopThread());
+      std::lock_guard<std::mutex> lock(mutex);
+      accepted_loops.insert(conn->GetLoop());
+      ++up_count;
+    }
+  });
+  server.Start();
+
+  std::thread client_thread([&]() {
+    std::vector<int> fds;
+    for (int i = 0; i < kConnNum; ++i) {
+      fds.push_back(BlockingConnect(server.listen_addr()));
+    }
+    for (int fd : fds) {
+      ::close(fd);
+    }
+  });
+  loop.RunEvery(0.005, [&]() {
+    if (up_count == kConnNum && server.connection_num() == 0) {
+      loop.Quit();
+    }
+  });
+  loop.Loop();
+  client_thread.join();
+  EXPECT_FALSE(accepted_loops.count(&loop));
+  // 内核按四元组哈希, 200 个连接几乎不可能都落在同一个监听 socket 上
+  EXPECT_GT(accepted_loops.size(), 1UL);
+}
+
+TEST(TcpServerTest, shared_blob_and_high_water_mark) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "BlobServer");
+  server.SetThreadNum(1);
+  std::shared_ptr<const std::string> body = std::make_shared<const std::string>(8 * 1024 * 1024, 'b');
+  const std::string header = "Content-Length: " + std::to_string(body->size()) + "\r\n\r\n";
+  std::atomic<size_t> high_water_bytes = {0};
+  std::atomic<int> write_complete_count = {0};
+  std::atomic<int> down_count = {0};
+  server.SetConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      conn->SetHighWaterMarkCallback([&](const TcpConnectionPtr&, size_t bytes) {
+        high_water_bytes = bytes;
+      }, 1024 * 1024);
+      // 拷贝的响应头和共享的响应体在同一个输出队列中, 顺序不能乱
+      conn->Send(header);
+      conn->Send(body);
+      conn->Send(header);
+      conn->Shutdown();
+    } else {
+      ++down_count;
+    }
+  });
+  server.SetWriteCompleteCallback([&](const TcpConnectionPtr&) {
+    ++write_complete_count;
+  });
+  server.Start();
+
+  std::string received;
+  std::thread client_thread([&]() {
+    int fd = BlockingConnect(server.listen_addr());
+    ASSERT_GE(fd, 0);
+    // 客户端晚一点再读, 让服务端的输出队列堆积超过高水位线
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    char buf[64 * 1024];
+    ssize_t n = 0;
+    while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+      received.append(buf, n);
+    }
+    ::close(fd);
+  });
+  loop.RunEvery(0.005, [&]() {
+    if (down_count == 1 && server.connection_num() == 0) {
+      loop.Quit();
+    }
+  });
+  loop.Loop();
+  client_thread.join();
+
+  EXPECT_EQ(received, header + *body + header);
+  EXPECT_GE(high_water_bytes, 1024UL * 1024);
+  EXPECT_GE(write_complete_count, 1);
+  // 发送完之后输出队列不再持有 body
+  EXPECT_EQ(body.use_count(), 1);
+}
+
+TEST(TcpServerTest, zerocopy_send) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "ZeroCopyServer");
+  server.SetThreadNum(1);
+  std::string message(4 * 1024 * 1024, '\0');
+  for (size_t i = 0; i < message.size(); ++i) {
+    message[i] = static_cast<char>(i % 251);
+  }
+  std::shared_ptr<const std::string> blob = std::make_shared<const std::string>(1024 * 1024, 'z');
+  std::atomic<bool> enabled = {false};
+  std::atomic<int> down_count = {0};
+  OutputQueue::ZeroCopyStats stats;
+  server.SetConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      enabled = conn->EnableZeroCopy(1);
+      // 拷贝进输出队列的数据和共享的数据都走 MSG_ZEROCOPY
+      conn->Send(message);
+      conn->Send(blob);
+      conn->Shutdown();
+    } else {
+      stats = conn->zerocopy_stats();
+      ++down_count;
+    }
+  });
+  server.Start();
+
+  std::string received;
+  std::thread client_thread([&]() {
+    int fd = BlockingConnect(server.listen_addr());
+    ASSERT_GE(fd, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    char buf[64 * 1024];
+    ssize_t n = 0;
+    while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+      received.append(buf, n);
+    }
+    ::close(fd);
+  });
+  loop.RunEvery(0.005, [&]() {
+    if (down_count == 1 && server.connection_num() == 0) {
+      loop.Quit();
+    }
+  });
+  loop.Loop();
+  client_thread.join();
+
+  EXPECT_EQ(received, message + *blob);
+  if (!enabled) {
+    LOG_WARN << "SO_ZEROCOPY is not supported";
+    return;
+  }
+  LOG_INFO << "zerocopy sends [" << stats.sends << "] completions [" << stats.completions << "] copied ["
+           << stats.copied << "]";
+  EXPECT_GE(stats.sends, 1UL);
+  EXPECT_LE(stats.completions, stats.sends);
+  // 本机连接上内核总是拷贝数据, 收到第一个完成通知之后应该退化为普通发送
+  if (stats.completions > 0) {
+    EXPECT_GE(stats.copied, 1UL);
+  }
+  EXPECT_EQ(blob.use_count(), 1);
+}
+
+TEST(TcpServerTest, zerocopy_force_close) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "ZeroCopyServer");
+  server.SetThreadNum(1);
+  std::shared_ptr<const std::string> blob = std::make_shared<const std::string>(8 * 1024 * 1024, 'z');
+  std::atomic<bool> enabled = {false};
+  std::mutex mutex;
+  std::weak_ptr<TcpConnection> weak_conn;
+  server.SetConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      std::lock_guard<std::mutex> lock(mutex);
+      weak_conn = conn;
+      enabled = conn->EnableZeroCopy(1);
+      // 客户端还没有读, 发送队列中的数据仍然引用 blob
+      conn->Send(blob);
+      conn->ForceClose();
+    }
+  });
+  server.Start();
+
+  std::atomic<bool> client_done = {false};
+  std::string received;
+  std::thread client_thread([&]() {
+    int fd = BlockingConnect(server.listen_addr());
+    ASSERT_GE(fd, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    received = ReadUntilClose(fd);
+    ::close(fd);
+    client_done = true;
+  });
+  bool lingered = false;
+  loop.RunEvery(0.005, [&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (server.connection_num() > 0 || weak_conn.lock() == nullptr) {
+      if (client_done && server.connection_num() == 0) {
+        loop.Quit();
+      }
+      return;
+    }
+    // 连接已经被移除, 但是还在等待完成通知
+    lingered = true;
+  });
+  loop.Loop();
+  client_thread.join();
+
+  if (!enabled) {
+    LOG_WARN << "SO_ZEROCOPY is not supported";
+    return;
+  }
+  EXPECT_TRUE(lingered);
+  // 已经交给内核的数据完整地发送出去, 对端读到 EOF
+  EXPECT_FALSE(received.empty());
+  EXPECT_EQ(received, std::string(received.size(), 'z'));
+  EXPECT_EQ(blob.use_count(), 1);
+}
+
+TEST(TcpServerTest, send_file) {
+  char path[] = "/tmp/tcp_server_test_XXXXXX";
+  int tmp_fd = ::mkstemp(path);
+  ASSERT_GE(tmp_fd, 0);
+  std::string content(3 * 1024 * 1024 + 17, '\0');
+  for (size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>(i % 251);
+  }
+  ASSERT_EQ(::write(tmp_fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+  ::close(tmp_fd);
+  std::shared_ptr<File> file = File::Open(path);
+  ASSERT_NE(file, nullptr);
+
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "FileServer");
+  server.SetThreadNum(1);
+  std::atomic<int> down_count = {0};
+  server.SetConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      conn->Send("header\r\n");
+      conn->SendFile(file, 0, file->size());
+      conn->Send("trailer");
+      conn->Shutdown();
+    } else {
+      ++down_count;
+    }
+  });
+  server.Start();
+
+  std::string received;
+  std::thread client_thread([&]() {
+    int fd = BlockingConnect(server.listen_addr());
+    ASSERT_GE(fd, 0);
+    char buf[64 * 1024];
+    ssize_t n = 0;
+    while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+      received.append(buf, n);
+    }
+    ::close(fd);
+  });
+  loop.RunEvery(0.005, [&]() {
+    if (down_count == 1 && server.connection_num() == 0) {
+      loop.Quit();
+    }
+  });
+  loop.Loop();
+  client_thread.join();
+  ::unlink(path);
+
+  EXPECT_TRUE(received == "header\r\n" + content + "trailer");
+  EXPECT_EQ(file.use_count(), 1);
+}
+
+TEST(TcpServerTest, shutdown_after_send) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "ShutdownServer");
+  server.SetThreadNum(1);
+  std::atomic<int> down_count = {0};
+  server.SetConnectionCallback([&down_count](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      // 发送完之后关闭写端, 客户端应该在读完数据之后读到 EOF
+      conn->Send("bye");
+      conn->Shutdown();
+    } else {
+      ++down_count;
+    }
+  });
+  server.Start();
+
+  std::string received;
+  std::thread client_thread([&]() {
+    int fd = BlockingConnect(server.listen_addr());
+    ASSERT_GE(fd, 0);
+    char buf[16];
+    ssize_t n = 0;
+    while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+      received.append(buf, n);
+    }
+    ::close(fd);
+  });
+  loop.RunEvery(0.005, [&]() {
+    if (down_count == 1 && server.connection_num() == 0) {
+      loop.Quit();
+    }
+  });
+  loop.Loop();
+  client_thread.join();
+  EXPECT_EQ(received, "bye");
+}
+
+TEST(TcpServerTest, batch_send) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  TcpServer server(&loop, InetAddress(0, true), "BatchServer");
+  server.SetThreadNum(1);
+  std::shared_ptr<const std::string> blob = std::make_shared<const std::string>(1024, 's');
+  std::atomic<uint64_t> write_calls = {0};
+  std::atomic<int> down_count = {0};
+  server.SetConnectionCallback([&](const TcpConnectionPtr& conn) {
+    if (conn->Connected()) {
+      // 没有合并时, 每个共享数据片在输出队列为空时都会立即写一次
+      const uint64_t before = conn->write_calls();
+      conn->BeginBatch();
+      for (int i = 0; i < 10; ++i) {
+        conn->Send("header\r\n");
+        conn->Send(blob);
+      }
+      // 推迟到写完之后
+      conn->Shutdown();
+      conn->EndBatch();
+      write_calls = conn->write_calls() - before;
+    } else {
+      ++down_count;
+    }
+  });
+  server.Start();
+
+  std::string received;
+  std::thread client_thread([&]() {
+    int fd = BlockingConnect(server.listen_addr());
+    ASSERT_GE(fd, 0);
+    received = ReadUntilClose(fd);
+    ::close(fd);
+  });
+  loop.RunEvery(0.005, [&]() {
+    if (down_count == 1 && server.connection_num() == 0) {
+      loop.Quit();
+    }
+  });
+  loop.Loop();
+  client_thread.join();
+
+  std::string expected;
+  for (int i = 0; i < 10; ++i) {
+    expected += "header\r\n" + *blob;
+  }
+  EXPECT_EQ(received, expected);
+  EXPECT_EQ(write_calls, 1u);
+  EXPECT_EQ(blob.use_count(), 1);
+}
+
+TEST(TcpServerTest, destroy_with_half_closed_connection) {
+  for (int num_threads : {0, 1}) {
+    std::atomic<int> down_count = {0};
+    std::atomic<bool> eof = {false};
+    int fd = -1;
+    {
+      EventLoop loop(Poller::PollerType::kEpollPoller);
+      TcpServer server(&loop, InetAddress(0, true), "HalfClosedServer");
+      server.SetThreadNum(num_threads);
+      server.SetConnectionCallback([&down_count](const TcpConnectionPtr& conn) {
+        if (conn->Connected()) {
+          conn->Shutdown();
+        } else {
+          ++down_count;
+        }
+      });
+      server.Start();
+
+      // 客户端读到 EOF 之后不关闭连接, 服务端的连接停留在 kDisconnecting
+      std::thread client_thread([&]() {
+        fd = BlockingConnect(server.listen_addr());
+        ASSERT_GE(fd, 0);
+        char c = 0;
+        EXPECT_EQ(::read(fd, &c, 1), 0);
+        eof = true;
+      });
+      loop.RunEvery(0.005, [&]() {
+        if (eof) {
+          loop.Quit();
+        }
+      });
+      loop.Loop();
+      client_thread.join();
+      EXPECT_EQ(server.connection_num(), 1u);
+    }
+    // 服务端析构时销毁还没有断开的连接, 只通知一次断开
+    EXPECT_EQ(down_count, 1) << num_threads;
+    ::close(fd);
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "net/inet_address.h"
+
+// 只供单元测试使用: 测试线程中用阻塞的 socket 扮演客户端
+
+namespace net {
+
+// 阻塞地连接到 addr, 失败时返回 -1
+inline int BlockingConnect(const InetAddress& addr) {
+  int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (::connect(fd, addr.GetSockAddr(), addr.GetSockLen()) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+inline bool WriteAll(const int fd, std::string_view data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n <= 0) {
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+// 读满 len 字节, 对端提前关闭时返回读到的部分
+inline std::string ReadExactly(const int fd, const size_t len) {
+  std::string data(len, '\0');
+  size_t received = 0;
+  while (received < len) {
+    ssize_t n = ::read(fd, &data[received], len - received);
+    if (n <= 0) {
+      break;
+    }
+    received += n;
+  }
+  data.resize(received);
+  return data;
+}
+
+// 读到 delimiter 为止, 返回的数据包括 delimiter
+inline std::string ReadUntil(const int fd, std::string_view delimiter) {
+  std::string data;
+  char c = 0;
+  while (data.size() < delimiter.size() ||
+         data.compare(data.size() - delimiter.size(), delimiter.size(), delimiter) != 0) {
+    if (::read(fd, &c, 1) != 1) {
+      break;
+    }
+    data.push_back(c);
+  }
+  return data;
+}
+
+inline std::string ReadUntilClose(const int fd) {
+  std::string data;
+  char buf[4096];
+  ssize_t n = 0;
+  while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+    data.append(buf, n);
+  }
+  return data;
+}
+
+// 对端已经关闭连接
+inline bool ReadEof(const int fd) {
+  char c = 0;
+  return ::read(fd, &c, 1) == 0;
+}
+
+// 轮询等待其他线程中的 condition 成立, 例如 inotify 事件被处理或者后台任务完成; 超时返回 false
+inline bool WaitFor(const std::function<bool()>& condition) {
+  for (int i = 0; i < 400 && !condition(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return condition();
+}
+
+}  // namespace net
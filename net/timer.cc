@@ -8,10 +8,13 @@ namespace net {
 
 std::atomic<int64_t> Timer::num_created_ = {0};
 
-Timer::Timer(const TimerCallback cb, const util::time::Timestamp when, const double interval_seconds)
+Timer::Timer(const TimerCallback cb, const util::time::Timestamp when, const double interval_seconds,
+             const uint64_t slack_ns)
     : callback_(std::move(cb)),
       expiration_(when),
+      deadline_(ApplySlack(when, slack_ns)),
       interval_seconds_(interval_seconds),
+      slack_ns_(slack_ns),
       repeat_(interval_seconds > 0.0),
       sequence_(num_created_.fetch_add(1) + 1) {
 }
@@ -24,6 +27,14 @@ util::time::Timestamp Timer::expiration() const {
   return expiration_;
 }
 
+util::time::Timestamp Timer::deadline() const {
+  return deadline_;
+}
+
+uint64_t Timer::slack_ns() const {
+  return slack_ns_;
+}
+
 bool Timer::repeat() const {
   return repeat_;
 }
@@ -38,10 +49,22 @@ void Timer::Restart(const util::time::Timestamp now) {
   } else {
     expiration_ = 0;
   }
+  deadline_ = ApplySlack(expiration_, slack_ns_);
 }
 
 int64_t Timer::num_created() {
   return num_created_.load();
 }
 
+util::time::Timestamp Timer::ApplySlack(const util::time::Timestamp expiration, const uint64_t slack_ns) {
+  if (slack_ns == 0) {
+    return expiration;
+  }
+  util::time::Timestamp limit = expiration + slack_ns;
+  // expiration 和 limit 从最高的不同 bit 开始分叉, 把 limit 在这个 bit 以下的部分清零, 结果仍然落在区间内
+  int bit = 63 - __builtin_clzll(expiration ^ limit);
+  util::time::Timestamp mask = (1ULL << bit) - 1;
+  return limit & ~mask;
+}
+
 }  // namespace net
@@ -8,9 +8,17 @@
 
 namespace net {
 
+/**
+ * @brief 定时器
+ *
+ * @note 和 Linux 的 timer_slack_ns 一样, 每个定时器可以带一个 slack, 表示允许在 [expiration, expiration + slack]
+ *       内的任意时刻触发. TimerQueue 按 deadline 调度, deadline 是这个区间内末尾 0 最多的时间点, 这样到期时间相近的
+ *       定时器会对齐到同一个 deadline, 由同一次 timerfd 触发批量执行
+ */
 class Timer {
  public:
-  Timer(const TimerCallback cb, const util::time::Timestamp when, const double interval_seconds);
+  Timer(const TimerCallback cb, const util::time::Timestamp when, const double interval_seconds,
+        const uint64_t slack_ns = 0);
 
  public:
   // 运行回调函数
@@ -21,6 +29,9 @@ class Timer {
  public:
   // 获取触发时间
   util::time::Timestamp expiration() const;
+  // 考虑 slack 之后实际调度的触发时间, 不早于 expiration
+  util::time::Timestamp deadline() const;
+  uint64_t slack_ns() const;
   // 是否周期性触发
   bool repeat() const;
   // 全局的定时器序号
@@ -28,14 +39,26 @@ class Timer {
 
  public:
   static int64_t num_created();
+  // 在 [expiration, expiration + slack_ns] 中选取末尾 0 最多的时间点, 算法和 Linux 的 apply_slack 一致
+  static util::time::Timestamp ApplySlack(const util::time::Timestamp expiration, const uint64_t slack_ns);
 
  private:
   const TimerCallback callback_;
   util::time::Timestamp expiration_ = 0;
+  util::time::Timestamp deadline_ = 0;
   const double interval_seconds_;
+  const uint64_t slack_ns_;
   const bool repeat_;
   const int64_t sequence_;
 
+ private:
+  // TimerWheel 的侵入式双向链表节点, 使得在时间轮中增删 Timer 都是 O(1) 且无需额外分配内存
+  friend class TimerWheel;
+  Timer* wheel_prev_ = nullptr;
+  Timer* wheel_next_ = nullptr;
+  int32_t wheel_level_ = -1;
+  int32_t wheel_slot_ = -1;
+
  private:
   // 全局运行的 timer 数
   static std::atomic<int64_t> num_created_;
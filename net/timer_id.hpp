@@ -1,27 +1,31 @@
 #pragma once
 
+#include <cstdint>
+
 #include "net/timer.h"
-#include "util/macros/macros.h"
 
 namespace net {
 
 class Timer;
 
+/**
+ * @brief 定时任务的句柄
+ *
+ * @note Timer 由 TimerPool 分配, 槽位内存在 TimerQueue 析构前不会被释放, 因此 TimerId 只需要记录分配时的
+ *       generation, 定时器触发或者被取消之后 generation 不再匹配, TimerId 自然失效
+ */
 class TimerId {
  public:
   TimerId() {
   }
-  TimerId(Timer* timer, int64_t seq) : timer_(timer), sequence_(seq) {
+  TimerId(Timer* timer, uint64_t generation) : timer_(timer), generation_(generation) {
   }
 
   friend class TimerQueue;
 
  private:
   Timer* timer_ = nullptr;
-  int64_t sequence_ = 0;
-
- private:
-  DISALLOW_COPY_AND_ASSIGN(TimerId);
+  uint64_t generation_ = 0;
 };
 
 }  // namespace net
@@ -0,0 +1,66 @@
+#include "net/timer_pool.h"
+
+#include "logger/log.h"
+
+namespace net {
+
+TimerPool::~TimerPool() {
+  // 正常情况下 TimerQueue 析构时已经释放了所有 Timer, 这里只回收内存
+  if (size_ != 0) {
+    LOG_WARN << "TimerPool destructs with [" << size_ << "] timers still in use";
+  }
+}
+
+void TimerPool::Delete(Timer* const timer) {
+  Slot* slot = ToSlot(timer);
+  CHECK_EQ(slot->generation.load(std::memory_order_relaxed) % 2, 1UL) << "double free of timer [" << timer << "]";
+  timer->~Timer();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  slot->generation.fetch_add(1, std::memory_order_release);
+  slot->next_free = free_list_;
+  free_list_ = slot;
+  --size_;
+}
+
+uint64_t TimerPool::generation(const Timer* const timer) const {
+  return ToSlot(timer)->generation.load(std::memory_order_acquire);
+}
+
+bool TimerPool::IsLive(const Timer* const timer, const uint64_t generation) const {
+  return timer != nullptr && this->generation(timer) == generation;
+}
+
+size_t TimerPool::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+size_t TimerPool::capacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return chunks_.size() * kSlotsPerChunk;
+}
+
+TimerPool::Slot* TimerPool::AllocateSlot() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_list_ == nullptr) {
+    chunks_.emplace_back(new Slot[kSlotsPerChunk]);
+    Slot* chunk = chunks_.back().get();
+    for (size_t i = kSlotsPerChunk; i > 0; --i) {
+      chunk[i - 1].next_free = free_list_;
+      free_list_ = &chunk[i - 1];
+    }
+  }
+  Slot* slot = free_list_;
+  free_list_ = slot->next_free;
+  slot->next_free = nullptr;
+  slot->generation.fetch_add(1, std::memory_order_release);
+  ++size_;
+  return slot;
+}
+
+TimerPool::Slot* TimerPool::ToSlot(const Timer* const timer) {
+  return reinterpret_cast<Slot*>(const_cast<Timer*>(timer));
+}
+
+}  // namespace net
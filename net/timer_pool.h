@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "net/timer.h"
+#include "util/macros/macros.h"
+
+namespace net {
+
+/**
+ * @brief Timer 对象的 slab 分配器, 每个 TimerQueue 持有一个
+ *
+ * @note
+ *   1. 按 kSlotsPerChunk 个槽位为一块批量申请内存, 释放的槽位挂在空闲链表上供下次复用, 内存直到 TimerPool
+ *      析构时才归还, 因此大量短期定时器不会给全局分配器带来压力
+ *   2. 每个槽位带有一个 generation, 每次释放时递增. TimerId 记录分配时的 generation, 由于槽位内存不会被释放,
+ *      可以直接通过比较 generation 判断 TimerId 是否仍然有效, 无需额外维护一个活跃定时器的集合.
+ *      generation 在分配和释放时各递增一次, 奇数表示槽位正在使用, 偶数表示空闲
+ *   3. AddTimer 可以在任意线程调用, 所以 New / Delete 需要加锁; 锁只在分配和释放时持有, 几乎不会有竞争
+ */
+class TimerPool {
+ public:
+  TimerPool() = default;
+  ~TimerPool();
+
+ public:
+  // 分配一个 Timer, 返回的 Timer 必须通过 Delete 释放
+  template <typename... Args>
+  Timer* New(Args&&... args);
+  // 析构 timer 并归还槽位, 之后该槽位之前的所有 TimerId 都失效
+  void Delete(Timer* const timer);
+  // timer 当前的 generation
+  uint64_t generation(const Timer* const timer) const;
+  // 判断 (timer, generation) 是否仍然指向同一次分配的 Timer
+  bool IsLive(const Timer* const timer, const uint64_t generation) const;
+
+ public:
+  // 正在使用的 Timer 数量
+  size_t size() const;
+  // 已经申请的槽位数量
+  size_t capacity() const;
+
+ private:
+  // 槽位布局: Timer 位于开头, 这样 Timer* 和 Slot* 可以直接互相转换
+  struct Slot {
+    alignas(Timer) unsigned char storage[sizeof(Timer)];
+    Slot* next_free = nullptr;
+    std::atomic<uint64_t> generation = {0};
+  };
+
+ private:
+  Slot* AllocateSlot();
+  static Slot* ToSlot(const Timer* const timer);
+
+ private:
+  static constexpr size_t kSlotsPerChunk = 256;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Slot[]>> chunks_;
+  Slot* free_list_ = nullptr;
+  size_t size_ = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TimerPool);
+};
+
+template <typename... Args>
+Timer* TimerPool::New(Args&&... args) {
+  Slot* slot = AllocateSlot();
+  Timer* timer = new (slot->storage) Timer(std::forward<Args>(args)...);
+  return timer;
+}
+
+}  // namespace net
@@ -0,0 +1,78 @@
+#include "net/timer_pool.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/timer.h"
+#include "util/time/timestamp.hpp"
+
+namespace net {
+
+TEST(TimerPoolTest, reuse_slot) {
+  TimerPool pool;
+  bool called = false;
+  Timer* timer = pool.New([&called]() { called = true; }, util::time::TimestampNanoSec(), 0.0);
+  uint64_t generation = pool.generation(timer);
+  EXPECT_TRUE(pool.IsLive(timer, generation));
+  EXPECT_EQ(pool.size(), 1UL);
+  timer->Run();
+  EXPECT_TRUE(called);
+
+  pool.Delete(timer);
+  EXPECT_FALSE(pool.IsLive(timer, generation));
+  EXPECT_EQ(pool.size(), 0UL);
+
+  // 释放的槽位会被立即复用, 但旧的 generation 不再有效
+  Timer* reused = pool.New([]() {}, util::time::TimestampNanoSec(), 1.0);
+  EXPECT_EQ(reused, timer);
+  EXPECT_FALSE(pool.IsLive(reused, generation));
+  EXPECT_TRUE(pool.IsLive(reused, pool.generation(reused)));
+  EXPECT_TRUE(reused->repeat());
+  pool.Delete(reused);
+}
+
+TEST(TimerPoolTest, grow) {
+  TimerPool pool;
+  std::vector<Timer*> timers;
+  for (int i = 0; i < 1000; ++i) {
+    timers.push_back(pool.New([]() {}, 0, 0.0));
+  }
+  EXPECT_EQ(pool.size(), 1000UL);
+  EXPECT_GE(pool.capacity(), 1000UL);
+  size_t capacity = pool.capacity();
+  for (Timer* timer : timers) {
+    pool.Delete(timer);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    timers[i] = pool.New([]() {}, 0, 0.0);
+  }
+  // 第二轮分配完全复用第一轮的槽位
+  EXPECT_EQ(pool.capacity(), capacity);
+  for (Timer* timer : timers) {
+    pool.Delete(timer);
+  }
+}
+
+TEST(TimerPoolTest, multi_thread) {
+  TimerPool pool;
+  constexpr int kThreadNum = 4;
+  constexpr int kTimerNum = 10000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadNum; ++i) {
+    threads.emplace_back([&pool]() {
+      for (int j = 0; j < kTimerNum; ++j) {
+        Timer* timer = pool.New([]() {}, 0, 0.0);
+        uint64_t generation = pool.generation(timer);
+        ASSERT_TRUE(pool.IsLive(timer, generation));
+        pool.Delete(timer);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(pool.size(), 0UL);
+}
+
+}  // namespace net
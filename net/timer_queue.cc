@@ -14,12 +14,16 @@
 #include "net/event_loop.h"
 #include "net/timer.h"
 #include "net/timer_id.hpp"
+#include "net/timer_wheel.h"
 #include "util/time/timestamp.hpp"
 
 namespace net {
 
 namespace {
 
+// timerfd 的最短触发间隔, 已经过期的定时器也至少等待这么久, 避免频繁触发
+constexpr int64_t kMinTimerFdIntervalNs = 100 * 1000;
+
 int CreateTimerFd() {
   int timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
   if (timer_fd < 0) {
@@ -30,28 +34,28 @@ int CreateTimerFd() {
 
 /**
  * @brief 获取 when 和 now 之前的差值, 返回格式是 struct timespec
+ * @note when 可能已经过期 (例如重复定时器的回调执行得太久), 此时返回最小间隔让 timerfd 尽快触发
  *
  * @param when
  * @return struct timespec
  */
 struct timespec HowMuchTimeFromNow(const util::time::Timestamp when) {
-  uint64_t when_microseconds = util::time::TimestampToMicroseconds(when);
-  uint64_t now_microseconds = util::time::TimestampMicroSec();
-  CHECK_LT(when_microseconds, now_microseconds);
-  int64_t microseconds_diff = when_microseconds - now_microseconds;
-  if (microseconds_diff < 100) {
-    microseconds_diff = 100;
+  // 这里必须读取最新的时间: 在循环中缓存的时间已经过去了回调执行的时长, 用它计算会让 timerfd 晚触发
+  // 直接用纳秒计算, 避免截断到微秒导致 timerfd 比 when 略早触发, 从而多一次无效的唤醒
+  int64_t nanoseconds_diff = static_cast<int64_t>(when) - static_cast<int64_t>(util::time::TimestampNanoSec());
+  if (nanoseconds_diff < kMinTimerFdIntervalNs) {
+    nanoseconds_diff = kMinTimerFdIntervalNs;
   }
   struct timespec ts = {};
-  ts.tv_sec = static_cast<time_t>(microseconds_diff / util::time::kSeconds2Microseconds);
-  ts.tv_nsec = static_cast<uint64_t>((microseconds_diff % util::time::kSeconds2Microseconds) * 1000);
+  ts.tv_sec = static_cast<time_t>(nanoseconds_diff / util::time::kSeconds2NanoSeconds);
+  ts.tv_nsec = static_cast<long>(nanoseconds_diff % util::time::kSeconds2NanoSeconds);
   return ts;
 }
 
 void ReadTimerFd(const int timer_fd, const util::time::Timestamp now) {
   uint64_t how_many = 0;
   ssize_t n = ::read(timer_fd, &how_many, sizeof how_many);
-  LOG_INFO << "TimerQueue::handleRead() [" << how_many << "] at " << util::time::TimestampToString(now);
+  LOG_DEBUG << "TimerQueue::handleRead() [" << how_many << "] at " << util::time::TimestampToString(now);
   if (n != sizeof how_many) {
     LOG_ERROR << "TimerQueue::handleRead() reads " << n << " bytes instead of 8";
   }
@@ -72,7 +76,11 @@ void ResetTimerFd(const int timer_fd, const util::time::Timestamp expiration) {
 
 }  // namespace
 
-TimerQueue::TimerQueue(EventLoop* loop) : loop_(loop), timerfd_(CreateTimerFd()), timerfd_channel_(loop, timerfd_) {
+TimerQueue::TimerQueue(EventLoop* loop, const Type type, const uint64_t tick_ms)
+    : loop_(loop), type_(type), timerfd_(CreateTimerFd()), timerfd_channel_(loop, timerfd_) {
+  if (type_ == Type::kTimingWheel) {
+    timer_wheel_ = std::make_unique<TimerWheel>(tick_ms, util::time::TimestampNanoSec());
+  }
   timerfd_channel_.SetReadCallback(std::bind(&TimerQueue::HandleRead, this));
   timerfd_channel_.EnableReading();
 }
@@ -83,141 +91,177 @@ TimerQueue::~TimerQueue() {
   ::close(timerfd_);
   // don't remove channel, since we're in EventLoop::dtor();
   for (const Entry& timer : timers_) {
-    delete timer.second;
+    timer_pool_.Delete(timer.second);
+  }
+  if (timer_wheel_) {
+    std::vector<Timer*> timers;
+    timer_wheel_->Clear(&timers);
+    for (Timer* timer : timers) {
+      timer_pool_.Delete(timer);
+    }
   }
 }
 
-TimerId TimerQueue::AddTimer(const TimerCallback cb, util::time::Timestamp when, const double interval_seconds) {
-  Timer* timer = new Timer(std::move(cb), when, interval_seconds);
+TimerId TimerQueue::AddTimer(const TimerCallback cb, util::time::Timestamp when, const double interval_seconds,
+                             const double slack_seconds) {
+  uint64_t slack_ns = static_cast<uint64_t>(slack_seconds * util::time::kSeconds2NanoSeconds);
+  Timer* timer = timer_pool_.New(std::move(cb), when, interval_seconds, slack_ns);
+  TimerId timer_id(timer, timer_pool_.generation(timer));
   loop_->RunInLoop(std::bind(&TimerQueue::AddTimerInLoop, this, timer));
-  return TimerId(timer, timer->sequence());
+  return timer_id;
 }
 
 void TimerQueue::Cancel(const TimerId& timer_id) {
   loop_->RunInLoop(std::bind(&TimerQueue::CancelInLoop, this, timer_id));
 }
 
+TimerQueue::Type TimerQueue::type() const {
+  return type_;
+}
+
+size_t TimerQueue::size() const {
+  loop_->AssertInLoopThread();
+  return type_ == Type::kPrecise ? timers_.size() : timer_wheel_->size();
+}
+
+const TimerQueue::Stats& TimerQueue::stats() const {
+  return stats_;
+}
+
+/**
+ * @brief 只有当新 Timer 的 deadline 早于 timerfd 当前的触发时间时才需要调用 timerfd_settime
+ *
+ * @note 如果当前触发时间落在新 Timer 的 [expiration, deadline] 之间, 那么到时候它会和其他 Timer 一起被执行,
+ *       这正是 slack 能够减少 timerfd_settime 调用的原因
+ */
 void TimerQueue::AddTimerInLoop(Timer* timer) {
   loop_->AssertInLoopThread();
-  bool earliest_changed = Insert(timer);
-  if (earliest_changed) {
-    ResetTimerFd(timerfd_, timer->expiration());
+  util::time::Timestamp deadline = Insert(timer);
+  if (armed_expiration_ == 0 || deadline < armed_expiration_) {
+    ArmTimerFd(deadline);
+  } else if (timer->expiration() < armed_expiration_) {
+    ++stats_.reprograms_avoided;
   }
 }
 
 void TimerQueue::CancelInLoop(const TimerId& timer_id) {
   loop_->AssertInLoopThread();
-  CHECK_EQ(timers_.size(), active_timers_.size());
-  ActiveTimer timer(timer_id.timer_, timer_id.sequence_);
-  ActiveTimerSet::iterator it = active_timers_.find(timer);
-  if (it != active_timers_.end()) {
-    size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
-    CHECK_EQ(n, 1);
-    (void)n;
-    delete it->first;  // TODO: no delete please
-    active_timers_.erase(it);
+  // 已经触发或者已经被取消的 Timer 的槽位 generation 已经变化了
+  if (!timer_pool_.IsLive(timer_id.timer_, timer_id.generation_)) {
+    return;
+  }
+
+  Timer* timer = timer_id.timer_;
+  bool removed = false;
+  if (type_ == Type::kTimingWheel) {
+    if (timer_wheel_->Contains(timer)) {
+      timer_wheel_->Remove(timer);
+      removed = true;
+    }
+  } else {
+    removed = timers_.erase(Entry(timer->deadline(), timer)) == 1;
+  }
+
+  if (removed) {
+    timer_pool_.Delete(timer);
   } else if (calling_expired_timers_) {
+    // 正在执行到期回调的 Timer 不在 timers_ / timer_wheel_ 中, 由 Reset 负责释放
     canceling_timers_.insert(timer);
   }
-  CHECK_EQ(timers_.size(), active_timers_.size());
 }
 
 void TimerQueue::HandleRead() {
   loop_->AssertInLoopThread();
-  util::time::Timestamp now = util::time::TimestampNanoSec();
+  // timerfd_ 的可读事件由本轮 Poll 返回, 直接使用 Poll 返回时读取的时间, 不必再读一次时钟
+  util::time::Timestamp now = loop_->poll_return_time();
   ReadTimerFd(timerfd_, now);
-
-  std::vector<Entry> expired = RemoveExpiredTimers(now);
+  // timerfd_ 是一次性的, 触发之后就不再处于设置状态
+  armed_expiration_ = 0;
+
+  expired_.clear();
+  RemoveExpiredTimers(now, &expired_);
+  ++stats_.wakeups;
+  if (expired_.size() > 1) {
+    stats_.wakeups_avoided += expired_.size() - 1;
+  }
 
   calling_expired_timers_ = true;
   canceling_timers_.clear();
   // safe to callback outside critical section
-  for (const Entry& it : expired) {
-    it.second->Run();
+  for (Timer* timer : expired_) {
+    timer->Run();
   }
   calling_expired_timers_ = false;
 
-  Reset(expired, now);
+  Reset(expired_, now);
 }
 
 /**
- * @brief 从 timers_ 中移除已到期的 Timer
+ * @brief 移除已到期的 Timer 并追加到 expired
  *
  * @param now
- * @return std::vector<TimerQueue::Entry>
+ * @param expired
  */
-std::vector<TimerQueue::Entry> TimerQueue::RemoveExpiredTimers(const util::time::Timestamp now) {
-  CHECK_EQ(timers_.size(), active_timers_.size());
-  std::vector<Entry> expired;
+void TimerQueue::RemoveExpiredTimers(const util::time::Timestamp now, std::vector<Timer*>* const expired) {
+  if (type_ == Type::kTimingWheel) {
+    timer_wheel_->Advance(now, expired);
+    return;
+  }
 
   // 哨兵值 (sentry) 作用是让 lower_bound 返回第一个未到期的 Timer 的迭代器
   Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
   TimerList::iterator end = timers_.lower_bound(sentry);
   CHECK(end == timers_.end() || now < end->first);
-  std::copy(timers_.begin(), end, back_inserter(expired));
+  for (TimerList::iterator it = timers_.begin(); it != end; ++it) {
+    expired->push_back(it->second);
+  }
 
   // 从 timers_ 中移除已到期的 Timer
   timers_.erase(timers_.begin(), end);
-
-  for (const Entry& it : expired) {
-    ActiveTimer timer(it.second, it.second->sequence());
-    size_t n = active_timers_.erase(timer);
-    CHECK_EQ(n, 1);
-    (void)n;
-  }
-
-  CHECK_EQ(timers_.size(), active_timers_.size());
-
-  // 编译器会实施 RVO (Return Value Optimization) 优化, 不必关心性能问题
-  // 必要时可以考虑像 EventLoop::active_channels_ 一样复用 vector
-  return expired;
 }
 
-void TimerQueue::Reset(const std::vector<Entry>& expired, const util::time::Timestamp now) {
+void TimerQueue::Reset(const std::vector<Timer*>& expired, const util::time::Timestamp now) {
   util::time::Timestamp next_expire = 0;
 
-  for (const Entry& it : expired) {
-    ActiveTimer timer(it.second, it.second->sequence());
-    if (it.second->repeat() && canceling_timers_.find(timer) == canceling_timers_.end()) {
-      it.second->Restart(now);
-      Insert(it.second);
+  for (Timer* timer : expired) {
+    if (timer->repeat() && canceling_timers_.find(timer) == canceling_timers_.end()) {
+      // 重复的定时器原地复用, generation 不变, 之前返回的 TimerId 仍然有效
+      timer->Restart(now);
+      Insert(timer);
     } else {
-      // FIXME move to a free list
-      delete it.second;  // FIXME: no delete please
+      timer_pool_.Delete(timer);
     }
   }
 
-  if (!timers_.empty()) {
-    next_expire = timers_.begin()->second->expiration();
+  if (type_ == Type::kTimingWheel) {
+    next_expire = timer_wheel_->NextExpiration();
+  } else if (!timers_.empty()) {
+    next_expire = timers_.begin()->first;
   }
 
-  if (next_expire > 0) {
-    ResetTimerFd(timerfd_, next_expire);
+  // 回调中新增的 Timer 可能已经把 timerfd_ 设置到了同一个时间
+  if (next_expire > 0 && next_expire != armed_expiration_) {
+    ArmTimerFd(next_expire);
   }
 }
 
-bool TimerQueue::Insert(Timer* const timer) {
+util::time::Timestamp TimerQueue::Insert(Timer* const timer) {
   loop_->AssertInLoopThread();
-  CHECK_EQ(timers_.size(), active_timers_.size());
-  bool earliest_changed = false;
-  util::time::Timestamp when = timer->expiration();
-  TimerList::iterator it = timers_.begin();
-  if (it == timers_.end() || when < it->first) {
-    earliest_changed = true;
-  }
-  {
-    std::pair<TimerList::iterator, bool> result = timers_.insert(Entry(when, timer));
-    CHECK(result.second);
-    (void)result;
-  }
-  {
-    std::pair<ActiveTimerSet::iterator, bool> result = active_timers_.insert(ActiveTimer(timer, timer->sequence()));
-    CHECK(result.second);
-    (void)result;
-  }
-
-  CHECK_EQ(timers_.size(), active_timers_.size());
-  return earliest_changed;
+  if (type_ == Type::kTimingWheel) {
+    return timer_wheel_->Add(timer);
+  }
+
+  util::time::Timestamp when = timer->deadline();
+  std::pair<TimerList::iterator, bool> result = timers_.insert(Entry(when, timer));
+  CHECK(result.second);
+  (void)result;
+  return when;
+}
+
+void TimerQueue::ArmTimerFd(const util::time::Timestamp expiration) {
+  ResetTimerFd(timerfd_, expiration);
+  armed_expiration_ = expiration;
+  ++stats_.reprograms;
 }
 
 }  // namespace net
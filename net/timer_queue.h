@@ -8,6 +8,7 @@
 
 #include "net/callbacks.h"
 #include "net/channel.h"
+#include "net/timer_pool.h"
 #include "util/macros/macros.h"
 #include "util/time/timestamp.hpp"
 
@@ -16,15 +17,27 @@ namespace net {
 class EventLoop;
 class Timer;
 class TimerId;
+class TimerWheel;
 
 /**
  * @brief 基于 timerfd 实现的定时器, 这样我们可以用和处理 IO 事件一样的逻辑来处理定时
  *
- * @note TimerQueue 只能在其所属的 IO 线程被调用, 因此不必加锁
+ * @note
+ *   1. TimerQueue 只能在其所属的 IO 线程被调用, 因此不必加锁
+ *   2. 支持两种组织方式:
+ *      kPrecise: 按到期时间排序的 std::set, 增删都是 O(log n), 定时器在到期时间精确触发
+ *      kTimingWheel: 分层时间轮, 增删都是 O(1), 但会延迟到 tick 结束时触发, 适合大量连接的超时管理等
+ *      对精度要求不高、数量多且大部分会在到期前被取消的场景
  */
 class TimerQueue {
  public:
-  explicit TimerQueue(EventLoop* loop);
+  enum class Type {
+    kPrecise = 0,
+    kTimingWheel = 1,
+  };
+
+ public:
+  explicit TimerQueue(EventLoop* loop, const Type type = Type::kPrecise, const uint64_t tick_ms = kDefaultTickMs);
   ~TimerQueue();
 
  public:
@@ -35,9 +48,11 @@ class TimerQueue {
    * @param cb
    * @param when
    * @param interval_seconds
+   * @param slack_seconds 允许推迟触发的时间, 用于和到期时间相近的定时器合并成一次 timerfd 触发
    * @return TimerId 注册的定时任务的唯一标识
    */
-  TimerId AddTimer(const TimerCallback cb, util::time::Timestamp when, const double interval_seconds);
+  TimerId AddTimer(const TimerCallback cb, util::time::Timestamp when, const double interval_seconds,
+                   const double slack_seconds = 0.0);
   /**
    * @brief 取消 timer_id 对应的定时任务
    *
@@ -45,37 +60,70 @@ class TimerQueue {
    */
   void Cancel(const TimerId& timer_id);
 
+ public:
+  // 定时器合并的统计信息, 只能在 IO 线程读取
+  struct Stats {
+    // 调用 timerfd_settime 的次数
+    uint64_t reprograms = 0;
+    // 新定时器早于 timerfd 当前的触发时间, 但当前触发时间仍然落在它的 slack 范围内, 因此无需调用 timerfd_settime 的次数
+    uint64_t reprograms_avoided = 0;
+    // timerfd 触发的次数
+    uint64_t wakeups = 0;
+    // 和其他定时器在同一次 timerfd 触发中执行的定时器数量, 即节省的唤醒次数
+    uint64_t wakeups_avoided = 0;
+  };
+
+ public:
+  Type type() const;
+  // 尚未触发的定时器数量, 只能在 IO 线程调用
+  size_t size() const;
+  const Stats& stats() const;
+
+ public:
+  static constexpr uint64_t kDefaultTickMs = 1;
+
  private:
-  // TODO: using std::unique_ptr<Timer> instead of raw pointers
   // 以 Entry 作为 Key 是因为如果仅仅用 Timestamp 作 key 可能处理两个 Timer 到期时间相同的情况
   using Entry = std::pair<util::time::Timestamp, Timer*>;
   using TimerList = std::set<Entry>;
-  using ActiveTimer = std::pair<Timer*, int64_t>;
-  using ActiveTimerSet = std::set<ActiveTimer>;
 
  private:
   void AddTimerInLoop(Timer* timer);
   void CancelInLoop(const TimerId& timer_id);
   void HandleRead();
   // 获取并删除所有过期的 Timer
-  std::vector<Entry> RemoveExpiredTimers(const util::time::Timestamp now);
-  void Reset(const std::vector<Entry>& expired, const util::time::Timestamp now);
-  bool Insert(Timer* const timer);
+  void RemoveExpiredTimers(const util::time::Timestamp now, std::vector<Timer*>* const expired);
+  void Reset(const std::vector<Timer*>& expired, const util::time::Timestamp now);
+  // 插入 Timer, 返回 timerfd_ 需要在什么时候触发才能执行这个 Timer
+  util::time::Timestamp Insert(Timer* const timer);
+  // 让 timerfd_ 在 expiration 时触发
+  void ArmTimerFd(const util::time::Timestamp expiration);
 
  private:
   EventLoop* loop_;
+  const Type type_;
+  // 所有 Timer 都从这里分配, TimerId 通过 generation 校验
+  TimerPool timer_pool_;
   const int timerfd_;
   // 使用 Channel 来观察 timerfd_ 上的 readable 事件
   Channel timerfd_channel_;
-  // 按照 expiration 排序的 Timer 列表
+  // timerfd_ 当前设置的触发时间, 0 表示没有设置
+  util::time::Timestamp armed_expiration_ = 0;
+  // kPrecise: 按照 deadline 排序的 Timer 列表
   TimerList timers_;
+  // kTimingWheel: 时间轮
+  std::unique_ptr<TimerWheel> timer_wheel_;
+  // 复用的过期 Timer 列表, 避免每次触发都分配内存
+  std::vector<Timer*> expired_;
 
   ///
   /// for cancel()
   ///
-  ActiveTimerSet active_timers_;
   std::atomic<bool> calling_expired_timers_ = {false};
-  ActiveTimerSet canceling_timers_;
+  // 在到期回调中被取消的 Timer, 它们已经不在 timers_ / timer_wheel_ 中, 需要在 Reset 时跳过
+  std::set<Timer*> canceling_timers_;
+
+  Stats stats_;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(TimerQueue);
@@ -0,0 +1,143 @@
+#include "net/timer_queue.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "logger/log.h"
+#include "net/event_loop.h"
+#include "net/timer_id.hpp"
+#include "util/time/timestamp.hpp"
+
+namespace net {
+
+namespace {
+
+const TimerQueue::Type kAllTimerQueueTypes[] = {
+    TimerQueue::Type::kPrecise,
+    TimerQueue::Type::kTimingWheel,
+};
+
+}  // namespace
+
+TEST(TimerQueueTest, run_after) {
+  for (TimerQueue::Type type : kAllTimerQueueTypes) {
+    EventLoop loop(Poller::PollerType::kEpollPoller, type);
+    std::vector<int> fired;
+    util::time::Timestamp start = util::time::TimestampNanoSec();
+    util::time::Timestamp quit_time = 0;
+
+    loop.RunAfter(0.03, [&]() {
+      fired.push_back(3);
+      quit_time = util::time::TimestampNanoSec();
+      loop.Quit();
+    });
+    loop.RunAfter(0.01, [&]() {
+      fired.push_back(1);
+    });
+    loop.RunAfter(0.02, [&]() {
+      fired.push_back(2);
+    });
+    loop.Loop();
+
+    EXPECT_EQ(fired, std::vector<int>({1, 2, 3}));
+    EXPECT_GE(quit_time - start, util::time::SecondsLater(0, 0.03));
+  }
+}
+
+TEST(TimerQueueTest, run_every_and_cancel) {
+  for (TimerQueue::Type type : kAllTimerQueueTypes) {
+    EventLoop loop(Poller::PollerType::kEpollPoller, type, 2);
+    int count = 0;
+    TimerId timer_id;
+    timer_id = loop.RunEvery(0.005, [&]() {
+      if (++count == 3) {
+        // 在回调中取消自己, 之后不应再被触发
+        loop.Cancel(timer_id);
+        loop.RunAfter(0.03, [&]() {
+          loop.Quit();
+        });
+      }
+    });
+    loop.Loop();
+    EXPECT_EQ(count, 3);
+  }
+}
+
+TEST(TimerQueueTest, cancel_before_fire) {
+  for (TimerQueue::Type type : kAllTimerQueueTypes) {
+    EventLoop loop(Poller::PollerType::kEpollPoller, type);
+    bool canceled_fired = false;
+    TimerId timer_id = loop.RunAfter(0.01, [&]() {
+      canceled_fired = true;
+    });
+    // 一个远期的定时器, 析构时应该被正确释放
+    loop.RunAfter(3600, []() {});
+    loop.Cancel(timer_id);
+    loop.RunAfter(0.02, [&]() {
+      loop.Quit();
+    });
+    loop.Loop();
+    EXPECT_FALSE(canceled_fired);
+  }
+}
+
+TEST(TimerQueueTest, stale_timer_id) {
+  for (TimerQueue::Type type : kAllTimerQueueTypes) {
+    EventLoop loop(Poller::PollerType::kEpollPoller, type);
+    TimerId fired_id = loop.RunAfter(0.001, []() {});
+    bool reused_fired = false;
+    loop.RunAfter(0.01, [&]() {
+      // fired_id 对应的 Timer 已经触发并释放, 新的 Timer 会复用它的槽位, 用旧的 TimerId 取消不应该有任何影响
+      loop.RunAfter(0.01, [&]() {
+        reused_fired = true;
+        loop.Quit();
+      });
+      loop.Cancel(fired_id);
+    });
+    loop.Loop();
+    EXPECT_TRUE(reused_fired);
+  }
+}
+
+TEST(TimerQueueTest, slack_coalescing) {
+  EventLoop loop(Poller::PollerType::kEpollPoller);
+  constexpr int kTimerNum = 100;
+  int fired = 0;
+  // 到期时间相差 10 微秒, slack 为 5 毫秒, 应该合并为极少的几次 timerfd 触发
+  for (int i = 0; i < kTimerNum; ++i) {
+    loop.RunAfter(0.01 + i * 0.00001, [&]() {
+      ++fired;
+    }, 0.005);
+  }
+  loop.RunAfter(0.05, [&]() {
+    loop.Quit();
+  });
+  loop.Loop();
+
+  EXPECT_EQ(fired, kTimerNum);
+  const TimerQueue::Stats& stats = loop.timer_stats();
+  LOG_INFO << "reprograms [" << stats.reprograms << "] reprograms_avoided [" << stats.reprograms_avoided
+           << "] wakeups [" << stats.wakeups << "] wakeups_avoided [" << stats.wakeups_avoided << "]";
+  EXPECT_LE(stats.wakeups, 4UL);
+  EXPECT_GE(stats.wakeups_avoided, static_cast<uint64_t>(kTimerNum - 3));
+  EXPECT_LE(stats.reprograms, 6UL);
+}
+
+TEST(TimerQueueTest, add_from_other_thread) {
+  for (TimerQueue::Type type : kAllTimerQueueTypes) {
+    EventLoop loop(Poller::PollerType::kEpollPoller, type);
+    bool fired = false;
+    std::thread thread([&]() {
+      loop.RunAfter(0.01, [&]() {
+        fired = true;
+        loop.Quit();
+      });
+    });
+    loop.Loop();
+    thread.join();
+    EXPECT_TRUE(fired);
+  }
+}
+
+}  // namespace net
@@ -47,4 +47,27 @@ TEST(TimerTest, restart) {
   EXPECT_EQ(timer.expiration(), next_expiration);
 }
 
+TEST(TimerTest, apply_slack) {
+  util::time::Timestamp now = util::time::TimestampNanoSec();
+  EXPECT_EQ(Timer::ApplySlack(now, 0), now);
+
+  uint64_t slack_ns = 1000 * 1000;
+  for (uint64_t offset = 0; offset < 100 * 1000; offset += 997) {
+    util::time::Timestamp expiration = now + offset;
+    util::time::Timestamp deadline = Timer::ApplySlack(expiration, slack_ns);
+    EXPECT_GE(deadline, expiration);
+    EXPECT_LE(deadline, expiration + slack_ns);
+  }
+
+  // 到期时间相近的定时器会对齐到同一个 deadline
+  util::time::Timestamp aligned = (now | ((1ULL << 20) - 1)) + 1;
+  EXPECT_EQ(Timer::ApplySlack(aligned - 1000, slack_ns), aligned);
+  EXPECT_EQ(Timer::ApplySlack(aligned - 2000, slack_ns), aligned);
+
+  Timer timer([]() {}, now, 1.0, slack_ns);
+  EXPECT_EQ(timer.deadline(), Timer::ApplySlack(now, slack_ns));
+  timer.Restart(now);
+  EXPECT_EQ(timer.deadline(), Timer::ApplySlack(util::time::SecondsLater(now, 1.0), slack_ns));
+}
+
 }  // namespace net
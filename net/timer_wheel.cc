@@ -0,0 +1,222 @@
+#include "net/timer_wheel.h"
+
+#include <algorithm>
+
+#include "logger/log.h"
+#include "net/timer.h"
+
+namespace net {
+
+namespace {
+
+/**
+ * @brief 从 start 开始循环查找位图中第一个置位的 bit, 返回它到 start 的距离, 没有时返回 -1
+ *
+ * @param bitmap
+ * @param nbits 位图长度, 必须是 2 的幂
+ * @param start
+ * @return int
+ */
+int FindNextSet(const uint64_t* const bitmap, const uint32_t nbits, const uint32_t start) {
+  uint32_t scanned = 0;
+  while (scanned < nbits) {
+    uint32_t index = (start + scanned) & (nbits - 1);
+    uint32_t bit = index % 64;
+    uint32_t available = std::min(64 - bit, nbits - index);
+    uint64_t word = bitmap[index / 64] >> bit;
+    if (word != 0) {
+      uint32_t offset = static_cast<uint32_t>(__builtin_ctzll(word));
+      if (offset < available) {
+        return static_cast<int>(scanned + offset);
+      }
+    }
+    scanned += available;
+  }
+  return -1;
+}
+
+}  // namespace
+
+TimerWheel::TimerWheel(const uint64_t tick_ms, const util::time::Timestamp now)
+    : tick_ns_(tick_ms * util::time::kMilliSeconds2NanoSeconds), current_tick_(now / tick_ns_) {
+  CHECK_GT(tick_ms, 0UL);
+}
+
+util::time::Timestamp TimerWheel::Add(Timer* const timer) {
+  CHECK_EQ(timer->wheel_level_, -1);
+  // current_tick_ 已经处理过了, 过期的定时器放到下一个 tick
+  uint64_t expire_tick = std::max(ExpirationTick(timer), current_tick_ + 1);
+  Link(timer, expire_tick);
+  return expire_tick * tick_ns_;
+}
+
+void TimerWheel::Remove(Timer* const timer) {
+  CHECK_GE(timer->wheel_level_, 0);
+  Unlink(timer);
+}
+
+bool TimerWheel::Contains(const Timer* const timer) const {
+  return timer->wheel_level_ >= 0;
+}
+
+void TimerWheel::Advance(const util::time::Timestamp now, std::vector<Timer*>* const expired) {
+  uint64_t target_tick = now / tick_ns_;
+  // 直接跳到下一个有事可做的 tick, 中间空闲的 tick 不需要逐个处理
+  for (uint64_t tick = NextTick(); tick <= target_tick; tick = NextTick()) {
+    ProcessTick(tick, expired);
+  }
+  current_tick_ = std::max(current_tick_, target_tick);
+}
+
+void TimerWheel::Clear(std::vector<Timer*>* const timers) {
+  for (Level& level : levels_) {
+    for (Timer*& head : level.slots) {
+      for (Timer* timer = head; timer != nullptr;) {
+        Timer* next = timer->wheel_next_;
+        timer->wheel_prev_ = nullptr;
+        timer->wheel_next_ = nullptr;
+        timer->wheel_level_ = -1;
+        timer->wheel_slot_ = -1;
+        timers->push_back(timer);
+        timer = next;
+      }
+      head = nullptr;
+    }
+    level.bitmap.fill(0);
+  }
+  size_ = 0;
+}
+
+util::time::Timestamp TimerWheel::NextExpiration() const {
+  uint64_t tick = NextTick();
+  return tick == UINT64_MAX ? 0 : tick * tick_ns_;
+}
+
+size_t TimerWheel::size() const {
+  return size_;
+}
+
+bool TimerWheel::empty() const {
+  return size_ == 0;
+}
+
+uint64_t TimerWheel::tick_ns() const {
+  return tick_ns_;
+}
+
+uint64_t TimerWheel::ExpirationTick(const Timer* const timer) const {
+  return (timer->deadline() + tick_ns_ - 1) / tick_ns_;
+}
+
+void TimerWheel::Link(Timer* const timer, uint64_t expire_tick) {
+  CHECK_GE(expire_tick, current_tick_);
+  if (expire_tick - current_tick_ >= kMaxTicks) {
+    expire_tick = current_tick_ + kMaxTicks - 1;
+  }
+
+  uint64_t delta = expire_tick - current_tick_;
+  int level = 0;
+  while (delta >= (1ULL << Shift(level + 1))) {
+    ++level;
+  }
+  uint32_t slot = static_cast<uint32_t>(expire_tick >> Shift(level)) & (SlotCount(level) - 1);
+
+  Level& wheel_level = levels_[level];
+  Timer* head = wheel_level.slots[slot];
+  timer->wheel_prev_ = nullptr;
+  timer->wheel_next_ = head;
+  if (head != nullptr) {
+    head->wheel_prev_ = timer;
+  }
+  wheel_level.slots[slot] = timer;
+  wheel_level.bitmap[slot / 64] |= 1ULL << (slot % 64);
+  timer->wheel_level_ = level;
+  timer->wheel_slot_ = static_cast<int32_t>(slot);
+  ++size_;
+}
+
+void TimerWheel::Unlink(Timer* const timer) {
+  Level& wheel_level = levels_[timer->wheel_level_];
+  uint32_t slot = static_cast<uint32_t>(timer->wheel_slot_);
+  if (timer->wheel_prev_ != nullptr) {
+    timer->wheel_prev_->wheel_next_ = timer->wheel_next_;
+  } else {
+    wheel_level.slots[slot] = timer->wheel_next_;
+  }
+  if (timer->wheel_next_ != nullptr) {
+    timer->wheel_next_->wheel_prev_ = timer->wheel_prev_;
+  }
+  if (wheel_level.slots[slot] == nullptr) {
+    wheel_level.bitmap[slot / 64] &= ~(1ULL << (slot % 64));
+  }
+  timer->wheel_prev_ = nullptr;
+  timer->wheel_next_ = nullptr;
+  timer->wheel_level_ = -1;
+  timer->wheel_slot_ = -1;
+  --size_;
+}
+
+void TimerWheel::Cascade(const int level, const uint32_t slot) {
+  Level& wheel_level = levels_[level];
+  Timer* timer = wheel_level.slots[slot];
+  wheel_level.slots[slot] = nullptr;
+  wheel_level.bitmap[slot / 64] &= ~(1ULL << (slot % 64));
+  while (timer != nullptr) {
+    Timer* next = timer->wheel_next_;
+    --size_;
+    // 此时 current_tick_ 对应的第 0 层槽位还没有被收集, 因此允许 expire_tick 等于 current_tick_
+    Link(timer, std::max(ExpirationTick(timer), current_tick_));
+    timer = next;
+  }
+}
+
+void TimerWheel::ProcessTick(const uint64_t tick, std::vector<Timer*>* const expired) {
+  current_tick_ = tick;
+  for (int level = 1; level < kLevels; ++level) {
+    if ((tick & ((1ULL << Shift(level)) - 1)) != 0) {
+      break;
+    }
+    Cascade(level, static_cast<uint32_t>(tick >> Shift(level)) & (SlotCount(level) - 1));
+  }
+
+  uint32_t slot = static_cast<uint32_t>(tick) & (SlotCount(0) - 1);
+  Level& wheel_level = levels_[0];
+  Timer* timer = wheel_level.slots[slot];
+  wheel_level.slots[slot] = nullptr;
+  wheel_level.bitmap[slot / 64] &= ~(1ULL << (slot % 64));
+  while (timer != nullptr) {
+    Timer* next = timer->wheel_next_;
+    timer->wheel_prev_ = nullptr;
+    timer->wheel_next_ = nullptr;
+    timer->wheel_level_ = -1;
+    timer->wheel_slot_ = -1;
+    --size_;
+    expired->push_back(timer);
+    timer = next;
+  }
+}
+
+/**
+ * @brief 计算下一个需要处理的 tick
+ *
+ * @note 第 0 层的槽位和 tick 一一对应; 更高层的槽位只需要在低层转完一圈、轮到它 cascade 的那个 tick 处理
+ */
+uint64_t TimerWheel::NextTick() const {
+  if (size_ == 0) {
+    return UINT64_MAX;
+  }
+
+  uint64_t next_tick = UINT64_MAX;
+  for (int level = 0; level < kLevels; ++level) {
+    uint64_t position = current_tick_ >> Shift(level);
+    uint32_t slot_count = SlotCount(level);
+    int distance = FindNextSet(levels_[level].bitmap.data(), slot_count,
+                               static_cast<uint32_t>(position + 1) & (slot_count - 1));
+    if (distance >= 0) {
+      next_tick = std::min(next_tick, (position + 1 + distance) << Shift(level));
+    }
+  }
+  return next_tick;
+}
+
+}  // namespace net
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "util/macros/macros.h"
+#include "util/time/timestamp.hpp"
+
+namespace net {
+
+class Timer;
+
+/**
+ * @brief 分层哈希时间轮 (Hashed Hierarchical Timing Wheel)
+ *
+ * @note
+ *   1. 时间被切分为固定长度的 tick, 共 4 层: 第 0 层 256 个槽位, 每个槽位对应 1 个 tick; 第 1~3 层各 64 个槽位,
+ *      每个槽位分别对应 2^8 / 2^14 / 2^20 个 tick, 总共可以表示 2^26 个 tick, 超出范围的定时器先放在最高层的
+ *      最后一个槽位, 轮转到时重新计算位置
+ *   2. Timer 通过侵入式双向链表挂在槽位上, Add / Remove 都是 O(1); 低层每转完一圈, 把高层对应槽位的定时器
+ *      重新分配 (cascade) 到低层
+ *   3. 定时器在 expiration 所在 tick 结束之后才会被触发, 即最多延迟一个 tick, 精度由 tick 大小决定
+ *   4. 每层用位图记录非空槽位, NextExpiration 可以直接跳过空槽位, 因此 TimerQueue 只需在真正有事可做的 tick
+ *      唤醒 IO 线程, 而不是每个 tick 都唤醒一次
+ *   5. 非线程安全, 只能在 TimerQueue 所属的 IO 线程中使用
+ */
+class TimerWheel {
+ public:
+  TimerWheel(const uint64_t tick_ms, const util::time::Timestamp now);
+
+ public:
+  // 加入定时器, 已经过期的定时器会在下一个 tick 触发; 返回需要调用 Advance 才能触发该定时器的时间
+  util::time::Timestamp Add(Timer* const timer);
+  // 移除尚未触发的定时器
+  void Remove(Timer* const timer);
+  // timer 是否在时间轮中
+  bool Contains(const Timer* const timer) const;
+  // 将时间轮推进到 now, 把所有到期的定时器从时间轮中移除并追加到 expired
+  void Advance(const util::time::Timestamp now, std::vector<Timer*>* const expired);
+  // 移除所有定时器并追加到 timers, 用于析构时释放
+  void Clear(std::vector<Timer*>* const timers);
+  // 下一次需要调用 Advance 的时间, 时间轮为空时返回 0
+  util::time::Timestamp NextExpiration() const;
+
+ public:
+  size_t size() const;
+  bool empty() const;
+  uint64_t tick_ns() const;
+
+ private:
+  // 以 tick 为单位对 deadline 向上取整, 保证定时器不会早于 expiration 触发
+  uint64_t ExpirationTick(const Timer* const timer) const;
+  void Link(Timer* const timer, uint64_t expire_tick);
+  void Unlink(Timer* const timer);
+  // 把第 level 层 slot 槽位上的定时器重新分配到更低的层
+  void Cascade(const int level, const uint32_t slot);
+  // 处理 tick: 依次 cascade 各层到期的槽位, 然后收集第 0 层槽位上的定时器
+  void ProcessTick(const uint64_t tick, std::vector<Timer*>* const expired);
+  // current_tick_ 之后下一个需要处理的 tick, 没有定时器时返回 UINT64_MAX
+  uint64_t NextTick() const;
+
+ private:
+  static constexpr int kLevels = 4;
+  static constexpr int kLevel0Bits = 8;
+  static constexpr int kLevelNBits = 6;
+  static constexpr uint32_t kMaxSlots = 1U << kLevel0Bits;
+  // 时间轮能表示的最大 tick 数
+  static constexpr uint64_t kMaxTicks = 1ULL << (kLevel0Bits + kLevelNBits * (kLevels - 1));
+
+  // 第 level 层槽位下标在 tick 中的起始 bit
+  static constexpr int Shift(const int level) {
+    return level == 0 ? 0 : kLevel0Bits + kLevelNBits * (level - 1);
+  }
+  static constexpr uint32_t SlotCount(const int level) {
+    return level == 0 ? (1U << kLevel0Bits) : (1U << kLevelNBits);
+  }
+
+ private:
+  struct Level {
+    std::array<Timer*, kMaxSlots> slots = {};
+    // 非空槽位的位图
+    std::array<uint64_t, kMaxSlots / 64> bitmap = {};
+  };
+
+  const uint64_t tick_ns_;
+  // 已经处理完的最后一个 tick (从 Unix 纪元开始计数)
+  uint64_t current_tick_;
+  std::array<Level, kLevels> levels_;
+  size_t size_ = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+}  // namespace net
@@ -0,0 +1,140 @@
+#include "net/timer_wheel.h"
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "net/timer.h"
+#include "util/time/timestamp.hpp"
+
+namespace net {
+
+namespace {
+
+constexpr uint64_t kTickMs = 1;
+constexpr util::time::Timestamp kTickNs = kTickMs * util::time::kMilliSeconds2NanoSeconds;
+// 起点故意不对齐到 tick
+constexpr util::time::Timestamp kStart = 1'700'000'000'123'456'789ULL;
+
+std::unique_ptr<Timer> NewTimer(const util::time::Timestamp when) {
+  return std::make_unique<Timer>([]() {}, when, 0.0);
+}
+
+}  // namespace
+
+TEST(TimerWheelTest, fire_in_order) {
+  TimerWheel wheel(kTickMs, kStart);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.NextExpiration(), 0UL);
+
+  std::unique_ptr<Timer> timer = NewTimer(kStart + 5 * kTickNs);
+  util::time::Timestamp due = wheel.Add(timer.get());
+  EXPECT_GE(due, timer->expiration());
+  EXPECT_LT(due, timer->expiration() + kTickNs);
+  EXPECT_EQ(wheel.NextExpiration(), due);
+  EXPECT_EQ(wheel.size(), 1UL);
+
+  std::vector<Timer*> expired;
+  wheel.Advance(due - 1, &expired);
+  EXPECT_TRUE(expired.empty());
+  wheel.Advance(due, &expired);
+  ASSERT_EQ(expired.size(), 1UL);
+  EXPECT_EQ(expired[0], timer.get());
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, expired_timer_fires_next_tick) {
+  TimerWheel wheel(kTickMs, kStart);
+  std::unique_ptr<Timer> timer = NewTimer(kStart - 10 * kTickNs);
+  util::time::Timestamp due = wheel.Add(timer.get());
+  EXPECT_GT(due, kStart);
+  EXPECT_LE(due, kStart + kTickNs);
+
+  std::vector<Timer*> expired;
+  wheel.Advance(due, &expired);
+  EXPECT_EQ(expired.size(), 1UL);
+}
+
+TEST(TimerWheelTest, remove) {
+  TimerWheel wheel(kTickMs, kStart);
+  std::unique_ptr<Timer> first = NewTimer(kStart + 3 * kTickNs);
+  std::unique_ptr<Timer> second = NewTimer(kStart + 3 * kTickNs);
+  std::unique_ptr<Timer> far = NewTimer(kStart + 100000 * kTickNs);
+  wheel.Add(first.get());
+  wheel.Add(second.get());
+  wheel.Add(far.get());
+  wheel.Remove(first.get());
+  wheel.Remove(far.get());
+  EXPECT_EQ(wheel.size(), 1UL);
+
+  std::vector<Timer*> expired;
+  wheel.Advance(kStart + 200000 * kTickNs, &expired);
+  ASSERT_EQ(expired.size(), 1UL);
+  EXPECT_EQ(expired[0], second.get());
+  EXPECT_EQ(wheel.NextExpiration(), 0UL);
+}
+
+/**
+ * @brief 随机生成跨越各层 (包括超出时间轮范围) 的定时器, 以随机步长推进时间,
+ *        检查每个定时器都不早于到期时间触发, 并且在到期所在的 tick 结束之后的第一次 Advance 中触发
+ */
+TEST(TimerWheelTest, cascade_across_levels) {
+  TimerWheel wheel(kTickMs, kStart);
+  std::mt19937_64 rng(42);
+  const uint64_t ranges[] = {1ULL << 8, 1ULL << 14, 1ULL << 20, 1ULL << 26, 1ULL << 28};
+
+  std::vector<std::unique_ptr<Timer>> timers;
+  std::unordered_map<Timer*, bool> fired;
+  for (uint64_t range : ranges) {
+    std::uniform_int_distribution<uint64_t> dist(0, range * kTickNs);
+    for (int i = 0; i < 200; ++i) {
+      timers.push_back(NewTimer(kStart + dist(rng)));
+      wheel.Add(timers.back().get());
+      fired[timers.back().get()] = false;
+    }
+  }
+  EXPECT_EQ(wheel.size(), timers.size());
+
+  util::time::Timestamp now = kStart;
+  std::vector<Timer*> expired;
+  while (!wheel.empty()) {
+    // 一半的时候直接跳到下一个需要处理的时间, 另一半随机推进一段时间 (不一定对齐到 tick)
+    util::time::Timestamp next = wheel.NextExpiration();
+    ASSERT_GT(next, now);
+    if (rng() % 2 == 0) {
+      now = next;
+    } else {
+      now += std::uniform_int_distribution<uint64_t>(1, (1ULL << 20) * kTickNs)(rng);
+    }
+
+    expired.clear();
+    wheel.Advance(now, &expired);
+    for (Timer* timer : expired) {
+      EXPECT_LE(timer->expiration(), now);
+      EXPECT_FALSE(fired[timer]);
+      fired[timer] = true;
+    }
+    for (const std::unique_ptr<Timer>& timer : timers) {
+      util::time::Timestamp due = (timer->expiration() + kTickNs - 1) / kTickNs * kTickNs;
+      ASSERT_EQ(fired[timer.get()], due <= now);
+    }
+  }
+}
+
+TEST(TimerWheelTest, clear) {
+  TimerWheel wheel(kTickMs, kStart);
+  std::vector<std::unique_ptr<Timer>> timers;
+  for (uint64_t delay : {1ULL, 1000ULL, 100000ULL, 10000000ULL}) {
+    timers.push_back(NewTimer(kStart + delay * kTickNs));
+    wheel.Add(timers.back().get());
+  }
+  std::vector<Timer*> cleared;
+  wheel.Clear(&cleared);
+  EXPECT_EQ(cleared.size(), timers.size());
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.NextExpiration(), 0UL);
+}
+
+}  // namespace net
@@ -1,8 +1,8 @@
 target("net", function()
     set_kind("object")
-    -- add_files("**.cc|**_test.cc")
-    add_files("timer.cc")
-    add_deps("logger")
+    add_files("**.cc|**_test.cc|**_bench.cc")
+    add_deps("logger", "util.threadpool")
+    add_packages("zlib", "brotli", "openssl", {public = true})
 end)
 
 target("net.timer_test", function()
@@ -13,3 +13,213 @@ target("net.timer_test", function()
     add_tests("default")
     add_packages("gtest")
 end)
+
+target("net.event_loop_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("event_loop_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.poller.poller_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("poller/poller_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.channel_table_bench", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("channel_table_bench.cc")
+    add_deps("net")
+end)
+
+target("net.channel_table_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("channel_table_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.timer_queue_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("timer_queue_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.timer_wheel_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("timer_wheel_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.timer_pool_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("timer_pool_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.tcp_server_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("tcp_server_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.echo_bench", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("echo_bench.cc")
+    -- 日志配置 conf/echo_bench.conf 按源文件的相对路径查找
+    set_rundir("$(projectdir)")
+    add_deps("net")
+end)
+
+target("net.buffer_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("buffer_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.output_queue_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("output_queue_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.http_parser_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/http_parser_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.http_parser_bench", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/http_parser_bench.cc")
+    add_deps("net")
+end)
+
+target("net.http.http_server_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/http_server_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.http_stream_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/http_stream_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.websocket_codec_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/websocket_codec_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.websocket_connection_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/websocket_connection_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.broadcast_hub_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/broadcast_hub_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.http_router_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/http_router_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.http_router_bench", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/http_router_bench.cc")
+    add_deps("net")
+end)
+
+target("net.http.static_file_handler_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/static_file_handler_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.http_range_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/http_range_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.content_encoding_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/content_encoding_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("net.http.compression_cache_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("http/compression_cache_test.cc")
+    add_deps("net")
+    add_tests("default")
+    add_packages("gtest")
+end)
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "util/macros/macros.h"
+
+namespace util {
+namespace sync {
+
+/**
+ * @brief 侵入式队列节点, 队列元素需要继承该类
+ */
+struct MpscQueueNode {
+  std::atomic<MpscQueueNode*> mpsc_next = {nullptr};
+};
+
+/**
+ * @brief 侵入式无锁多生产者单消费者队列 (Dmitry Vyukov 算法)
+ *
+ * @note
+ *   1. Push 可以被任意线程并发调用, 只有一次 atomic exchange, 生产者之间不会竞争锁
+ *   2. Drain 只能被唯一的消费者线程调用
+ *   3. 队列不持有节点, 节点的分配和释放由调用方负责
+ *   4. size_ 在节点入队前递增、在消费者批量取出后递减, 因此 Push 的返回值可以准确地表示队列由空变为非空,
+ *      调用方只需要在这个时刻通知消费者
+ *
+ * @tparam T 继承自 MpscQueueNode 的类型
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {
+  }
+
+ public:
+  /**
+   * @brief 入队, 线程安全
+   *
+   * @param node
+   * @return true 队列由空变为非空, 调用方需要通知消费者
+   */
+  bool Push(T* const node) {
+    bool was_empty = size_.fetch_add(1, std::memory_order_acq_rel) == 0;
+    PushNode(node);
+    return was_empty;
+  }
+
+  /**
+   * @brief 批量出队, 只能在消费者线程中调用
+   *
+   * @note 最多取出 max_count 个节点并依次交给 fn 处理 (fn 获得节点的所有权), 取出的数量在最后一次性从 size_
+   *       中扣除. 如果返回值大于 0, 说明还有节点未被取出 (或者生产者尚未完成入队), 这些节点入队时 Push 返回的
+   *       是 false, 调用方需要自己保证稍后会再次 Drain
+   *
+   * @param max_count
+   * @param fn
+   * @return size_t 剩余的节点数
+   */
+  template <typename Fn>
+  size_t Drain(const size_t max_count, Fn&& fn) {
+    size_t count = 0;
+    while (count < max_count) {
+      T* node = Pop();
+      if (node == nullptr) {
+        break;
+      }
+      ++count;
+      fn(node);
+    }
+    if (count == 0) {
+      return size_.load(std::memory_order_acquire);
+    }
+    return size_.fetch_sub(count, std::memory_order_acq_rel) - count;
+  }
+
+  size_t Size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  bool Empty() const {
+    return Size() == 0;
+  }
+
+ private:
+  void PushNode(MpscQueueNode* const node) {
+    node->mpsc_next.store(nullptr, std::memory_order_relaxed);
+    MpscQueueNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+    // 在 exchange 和 store 之间, 消费者会看到一个 "断开" 的链表, 此时 Pop 返回 nullptr 即可
+    prev->mpsc_next.store(node, std::memory_order_release);
+  }
+
+  T* Pop() {
+    MpscQueueNode* tail = tail_;
+    MpscQueueNode* next = tail->mpsc_next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->mpsc_next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    MpscQueueNode* head = head_.load(std::memory_order_acquire);
+    if (tail != head) {
+      // 有生产者正在入队
+      return nullptr;
+    }
+    // tail 是最后一个节点, 重新放入 stub_ 之后才能把它取出
+    PushNode(&stub_);
+    next = tail->mpsc_next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+ private:
+  // 生产者和消费者各自访问的成员放在不同的 cache line 上, 避免伪共享
+  alignas(64) std::atomic<MpscQueueNode*> head_;
+  alignas(64) std::atomic<size_t> size_ = {0};
+  alignas(64) MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MpscQueue);
+};
+
+}  // namespace sync
+}  // namespace util
@@ -0,0 +1,161 @@
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "util/sync/mpsc_queue.hpp"
+#include "util/time/timestamp.hpp"
+
+// 模拟 EventLoop::QueueInLoop 的扇入场景: 多个生产者线程向一个 IO 线程投递任务, 需要唤醒时写 eventfd
+
+namespace {
+
+using Functor = std::function<void()>;
+
+constexpr uint64_t kTotalTasks = 4 * 1000 * 1000;
+
+void WriteEventFd(const int fd) {
+  uint64_t one = 1;
+  ssize_t n = ::write(fd, &one, sizeof one);
+  (void)n;
+}
+
+void ReadEventFd(const int fd) {
+  uint64_t value = 0;
+  ssize_t n = ::read(fd, &value, sizeof value);
+  (void)n;
+}
+
+/**
+ * @brief 原来的实现: 互斥锁保护的 vector, 消费者 swap 出来执行, 每次跨线程投递都会唤醒
+ */
+class MutexVectorQueue {
+ public:
+  explicit MutexVectorQueue(const int event_fd) : event_fd_(event_fd) {
+  }
+
+  void Push(Functor cb) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      functors_.emplace_back(std::move(cb));
+    }
+    WriteEventFd(event_fd_);
+    ++wakeups_;
+  }
+
+  void Consume() {
+    std::vector<Functor> functors;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      functors.swap(functors_);
+    }
+    for (const Functor& functor : functors) {
+      functor();
+    }
+  }
+
+  uint64_t wakeups() const {
+    return wakeups_;
+  }
+
+ private:
+  const int event_fd_;
+  std::mutex mutex_;
+  std::vector<Functor> functors_;
+  std::atomic<uint64_t> wakeups_ = {0};
+};
+
+/**
+ * @brief 新的实现: 侵入式无锁 MPSC 队列, 只有队列由空变为非空时才唤醒
+ */
+class LockFreeQueue {
+ public:
+  explicit LockFreeQueue(const int event_fd) : event_fd_(event_fd) {
+  }
+
+  void Push(Functor cb) {
+    if (queue_.Push(new Node(std::move(cb)))) {
+      WriteEventFd(event_fd_);
+      ++wakeups_;
+    }
+  }
+
+  void Consume() {
+    size_t batch_size = queue_.Size();
+    if (batch_size == 0) {
+      return;
+    }
+    size_t remaining = queue_.Drain(batch_size, [](Node* node) {
+      std::unique_ptr<Node> guard(node);
+      guard->functor();
+    });
+    if (remaining > 0) {
+      WriteEventFd(event_fd_);
+    }
+  }
+
+  uint64_t wakeups() const {
+    return wakeups_;
+  }
+
+ private:
+  struct Node : public util::sync::MpscQueueNode {
+    explicit Node(Functor&& cb) : functor(std::move(cb)) {
+    }
+    Functor functor;
+  };
+
+  const int event_fd_;
+  util::sync::MpscQueue<Node> queue_;
+  std::atomic<uint64_t> wakeups_ = {0};
+};
+
+template <typename Queue>
+void Bench(const char* name, const uint32_t producer_num) {
+  int event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  Queue queue(event_fd);
+  uint64_t tasks_per_producer = kTotalTasks / producer_num;
+  uint64_t total_tasks = tasks_per_producer * producer_num;
+  uint64_t executed = 0;
+
+  uint64_t t_start_ns = util::time::TimestampNanoSec();
+  std::vector<std::thread> producers;
+  for (uint32_t i = 0; i < producer_num; ++i) {
+    producers.emplace_back([&queue, &executed, tasks_per_producer]() {
+      for (uint64_t j = 0; j < tasks_per_producer; ++j) {
+        queue.Push([&executed]() {
+          ++executed;
+        });
+      }
+    });
+  }
+
+  // 消费者模拟 IO 线程: 读 eventfd 清除唤醒状态后执行任务
+  while (executed < total_tasks) {
+    ReadEventFd(event_fd);
+    queue.Consume();
+  }
+
+  double t_cost_seconds = static_cast<double>(util::time::TimestampNanoSec() - t_start_ns) / 1000.0 / 1000.0 / 1000.0;
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  ::close(event_fd);
+  printf("[MpscQueue Bench] %-14s producers=%-3u %8.3f seconds || %12.2f tasks/s || %10lu wakeups\n", name,
+         producer_num, t_cost_seconds, total_tasks / t_cost_seconds, queue.wakeups());
+}
+
+}  // namespace
+
+int main() {
+  for (uint32_t producer_num : {1, 8, 32}) {
+    Bench<MutexVectorQueue>("mutex+vector", producer_num);
+    Bench<LockFreeQueue>("lock-free mpsc", producer_num);
+  }
+}
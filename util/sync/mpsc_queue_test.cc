@@ -0,0 +1,87 @@
+#include "util/sync/mpsc_queue.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace util {
+namespace sync {
+
+namespace {
+
+struct Item : public MpscQueueNode {
+  Item(int32_t producer, int32_t seq) : producer_id(producer), sequence(seq) {
+  }
+  int32_t producer_id = 0;
+  int32_t sequence = 0;
+};
+
+}  // namespace
+
+TEST(MpscQueueTest, empty_to_non_empty) {
+  MpscQueue<Item> queue;
+  Item a(0, 1);
+  Item b(0, 2);
+  EXPECT_TRUE(queue.Empty());
+  // 只有第一次入队会返回 true
+  EXPECT_TRUE(queue.Push(&a));
+  EXPECT_FALSE(queue.Push(&b));
+  EXPECT_EQ(queue.Size(), 2UL);
+
+  std::vector<int32_t> sequences;
+  size_t remaining = queue.Drain(1, [&sequences](Item* item) {
+    sequences.push_back(item->sequence);
+  });
+  EXPECT_EQ(remaining, 1UL);
+  remaining = queue.Drain(SIZE_MAX, [&sequences](Item* item) {
+    sequences.push_back(item->sequence);
+  });
+  EXPECT_EQ(remaining, 0UL);
+  EXPECT_EQ(sequences, std::vector<int32_t>({1, 2}));
+
+  // 取空之后再次入队又会返回 true
+  EXPECT_TRUE(queue.Push(&a));
+  queue.Drain(SIZE_MAX, [](Item*) {
+  });
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(MpscQueueTest, multi_producer) {
+  constexpr int32_t kProducerNum = 8;
+  constexpr int32_t kItemNum = 100000;
+
+  MpscQueue<Item> queue;
+  std::vector<std::thread> producers;
+  for (int32_t i = 0; i < kProducerNum; ++i) {
+    producers.emplace_back([&queue, i]() {
+      for (int32_t seq = 0; seq < kItemNum; ++seq) {
+        queue.Push(new Item(i, seq));
+      }
+    });
+  }
+
+  // 每个生产者的元素必须按照入队顺序出队
+  std::vector<int32_t> next_sequence(kProducerNum, 0);
+  int64_t total = 0;
+  while (total < kProducerNum * kItemNum) {
+    queue.Drain(SIZE_MAX, [&](Item* item) {
+      std::unique_ptr<Item> guard(item);
+      EXPECT_EQ(item->sequence, next_sequence[item->producer_id]);
+      ++next_sequence[item->producer_id];
+      ++total;
+    });
+  }
+
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.Empty());
+  for (int32_t i = 0; i < kProducerNum; ++i) {
+    EXPECT_EQ(next_sequence[i], kItemNum);
+  }
+}
+
+}  // namespace sync
+}  // namespace util
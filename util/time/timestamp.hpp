@@ -12,6 +12,7 @@ namespace util {
 namespace time {
 
 constexpr uint64_t kSeconds2NanoSeconds = 1'000'000'000;
+constexpr uint64_t kMilliSeconds2NanoSeconds = 1'000'000;
 constexpr uint64_t kMicroseconds2Nanoseconds = 1000;
 constexpr uint64_t kSeconds2Microseconds = 1000'000;
 
@@ -50,6 +51,39 @@ inline uint64_t TimestampNanoSec() {
   return time.tv_sec * 1000 * 1000 * 1000 + time.tv_nsec;
 }
 
+/**
+ * @brief 返回单调时钟的时间戳, 不受系统时间调整的影响, 适合计算耗时， 单位: 纳秒
+ *
+ * @return uint64_t
+ */
+inline uint64_t TimestampMonotonicNanoSec() {
+  struct timespec time;
+  ::clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1000 * 1000 * 1000 + time.tv_nsec;
+}
+
+/**
+ * @brief 返回粗粒度的时间戳, 精度为一个内核 tick (通常是 1~4 毫秒), 但比 TimestampNanoSec 快得多， 单位: 纳秒
+ *
+ * @return uint64_t
+ */
+inline uint64_t TimestampCoarseNanoSec() {
+  struct timespec time;
+  ::clock_gettime(CLOCK_REALTIME_COARSE, &time);
+  return time.tv_sec * 1000 * 1000 * 1000 + time.tv_nsec;
+}
+
+/**
+ * @brief 返回粗粒度的单调时钟时间戳， 单位: 纳秒
+ *
+ * @return uint64_t
+ */
+inline uint64_t TimestampMonotonicCoarseNanoSec() {
+  struct timespec time;
+  ::clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+  return time.tv_sec * 1000 * 1000 * 1000 + time.tv_nsec;
+}
+
 /**
  * @brief 返回 now 加上 seconds 秒后的时间戳
  *
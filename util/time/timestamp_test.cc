@@ -10,5 +10,26 @@ TEST(TimestampTest, to_string) {
   std::cout << "Timestamp [" << now << "] to string [" << TimestampToString(now) << "]" << std::endl;
 }
 
+TEST(TimestampTest, monotonic) {
+  Timestamp last = TimestampMonotonicNanoSec();
+  for (int i = 0; i < 1000; ++i) {
+    Timestamp now = TimestampMonotonicNanoSec();
+    EXPECT_GE(now, last);
+    last = now;
+  }
+}
+
+TEST(TimestampTest, coarse) {
+  // 粗粒度时钟的误差在一个内核 tick 以内, 这里放宽到 100 毫秒
+  constexpr uint64_t kMaxErrorNs = 100 * kMilliSeconds2NanoSeconds;
+  Timestamp precise = TimestampNanoSec();
+  Timestamp coarse = TimestampCoarseNanoSec();
+  EXPECT_LT(precise > coarse ? precise - coarse : coarse - precise, kMaxErrorNs);
+
+  Timestamp monotonic = TimestampMonotonicNanoSec();
+  Timestamp monotonic_coarse = TimestampMonotonicCoarseNanoSec();
+  EXPECT_LT(monotonic > monotonic_coarse ? monotonic - monotonic_coarse : monotonic_coarse - monotonic, kMaxErrorNs);
+}
+
 }  // namespace time
 }  // namespace util
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <time.h>
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "util/macros/macros.h"
+#include "util/time/timestamp.hpp"
+
+namespace util {
+namespace time {
+
+/**
+ * @brief 基于 TSC (Time Stamp Counter) 的高精度时钟, 用于统计耗时
+ *
+ * @note
+ *   1. 读取 TSC 只需要一条 rdtsc 指令, 不需要像 clock_gettime 一样经过 vDSO 读取时钟源和换算
+ *   2. 只有 invariant TSC (CPUID.80000007H:EDX[8]) 的频率不受 CPU 变频和 C-state 影响, 且各个核心同步,
+ *      因此只在检测到 invariant TSC 时才启用, 否则 (包括非 x86 平台和部分虚拟机) 自动回退到 CLOCK_MONOTONIC
+ *   3. 第一次调用 Instance 时会用 CLOCK_MONOTONIC 校准 TSC 频率, 耗时约 kCalibrationNs, 建议在程序启动时调用
+ *   4. Now 返回的是 tick 而不是纳秒, 回退时 tick 就是纳秒; 两次 Now 的差值通过 ToNanoseconds 换算成纳秒
+ *
+ * @example
+ *   const TscClock& clock = TscClock::Instance();
+ *   uint64_t start = clock.Now();
+ *   DoSomething();
+ *   uint64_t cost_ns = clock.ToNanoseconds(clock.Now() - start);
+ */
+class TscClock {
+ public:
+  static const TscClock& Instance() {
+    static const TscClock clock;
+    return clock;
+  }
+
+ public:
+  // 读取当前 tick, 启用 TSC 时是 CPU cycle 数, 否则是 CLOCK_MONOTONIC 的纳秒数
+  uint64_t Now() const {
+    return is_tsc_ ? ReadTsc() : TimestampMonotonicNanoSec();
+  }
+
+  // 和 Now 一样, 但是保证之前的指令都执行完毕之后才读取, 适合作为耗时统计的终点
+  uint64_t NowSerialized() const {
+    return is_tsc_ ? ReadTscSerialized() : TimestampMonotonicNanoSec();
+  }
+
+  // 将 tick 的差值换算成纳秒
+  uint64_t ToNanoseconds(const uint64_t ticks) const {
+    if (!is_tsc_) {
+      return ticks;
+    }
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) * ns_per_tick_mult_) >> kShift);
+  }
+
+  // 与 Now 对应的单调时间, 单位: 纳秒
+  uint64_t NowNanoSec() const {
+    if (!is_tsc_) {
+      return TimestampMonotonicNanoSec();
+    }
+    return base_ns_ + ToNanoseconds(ReadTsc() - base_ticks_);
+  }
+
+  // 是否使用 TSC 作为时钟源
+  bool is_tsc() const {
+    return is_tsc_;
+  }
+
+  // 每纳秒的 tick 数, 即 TSC 的频率 (GHz), 回退时为 1
+  double ticks_per_ns() const {
+    return ticks_per_ns_;
+  }
+
+ public:
+  // 判断 CPU 是否支持 invariant TSC
+  static bool HasInvariantTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+      return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1U << 8)) != 0;
+#else
+    return false;
+#endif
+  }
+
+  static uint64_t ReadTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return TimestampMonotonicNanoSec();
+#endif
+  }
+
+  static uint64_t ReadTscSerialized() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int aux = 0;
+    return __rdtscp(&aux);
+#else
+    return TimestampMonotonicNanoSec();
+#endif
+  }
+
+ private:
+  TscClock() {
+    if (HasInvariantTsc()) {
+      Calibrate();
+    }
+  }
+
+  /**
+   * @brief 在 kCalibrationNs 内同时读取 TSC 和 CLOCK_MONOTONIC, 用两者的增量计算 TSC 频率
+   * @note 每个采样点用前后两次 rdtsc 夹住 clock_gettime 并取中点, 减小 clock_gettime 本身耗时带来的误差
+   */
+  void Calibrate() {
+    uint64_t start_ns = 0;
+    uint64_t start_ticks = Sample(&start_ns);
+    struct timespec sleep_time = {0, static_cast<long>(kCalibrationNs)};
+    ::nanosleep(&sleep_time, nullptr);
+    uint64_t end_ns = 0;
+    uint64_t end_ticks = Sample(&end_ns);
+    if (end_ns <= start_ns || end_ticks <= start_ticks) {
+      return;
+    }
+
+    double ticks_per_ns = static_cast<double>(end_ticks - start_ticks) / static_cast<double>(end_ns - start_ns);
+    // 频率明显不合理时 (例如虚拟机中 TSC 被错误地模拟) 放弃使用 TSC
+    if (ticks_per_ns < kMinTicksPerNs || ticks_per_ns > kMaxTicksPerNs) {
+      return;
+    }
+    ticks_per_ns_ = ticks_per_ns;
+    ns_per_tick_mult_ = static_cast<uint64_t>(static_cast<double>(1ULL << kShift) / ticks_per_ns);
+    base_ticks_ = end_ticks;
+    base_ns_ = end_ns;
+    is_tsc_ = true;
+  }
+
+  static uint64_t Sample(uint64_t* const ns) {
+    uint64_t before = ReadTscSerialized();
+    *ns = TimestampMonotonicNanoSec();
+    uint64_t after = ReadTscSerialized();
+    return before + (after - before) / 2;
+  }
+
+ private:
+  // tick 换算成纳秒使用定点数乘法: ns = ticks * ns_per_tick_mult_ >> kShift
+  static constexpr int kShift = 32;
+  static constexpr uint64_t kCalibrationNs = 20 * 1000 * 1000;
+  static constexpr double kMinTicksPerNs = 0.1;
+  static constexpr double kMaxTicksPerNs = 20.0;
+
+  bool is_tsc_ = false;
+  double ticks_per_ns_ = 1.0;
+  uint64_t ns_per_tick_mult_ = 1ULL << kShift;
+  uint64_t base_ticks_ = 0;
+  uint64_t base_ns_ = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TscClock);
+};
+
+}  // namespace time
+}  // namespace util
@@ -0,0 +1,73 @@
+#include <sys/time.h>
+#include <time.h>
+
+#include <cstdio>
+
+#include "util/time/timestamp.hpp"
+#include "util/time/tsc_clock.hpp"
+
+// 对比各种读取时间方式的单次调用开销, 统计耗时时每个请求至少要读两次时钟
+
+namespace {
+
+constexpr uint64_t kLoopCount = 20 * 1000 * 1000;
+
+template <typename Fn>
+void Bench(const char* name, Fn&& fn) {
+  // 防止编译器把循环优化掉
+  volatile uint64_t sink = 0;
+  uint64_t t_start_ns = util::time::TimestampMonotonicNanoSec();
+  for (uint64_t i = 0; i < kLoopCount; ++i) {
+    sink = sink + fn();
+  }
+  uint64_t t_cost_ns = util::time::TimestampMonotonicNanoSec() - t_start_ns;
+  printf("[TscClock Bench] %-32s %8.3f seconds || %8.2f ns/call\n", name, t_cost_ns / 1e9,
+         static_cast<double>(t_cost_ns) / kLoopCount);
+}
+
+}  // namespace
+
+int main() {
+  const util::time::TscClock& clock = util::time::TscClock::Instance();
+  printf("[TscClock Bench] tsc=%d invariant_tsc=%d ticks_per_ns=%.4f\n", clock.is_tsc(),
+         util::time::TscClock::HasInvariantTsc(), clock.ticks_per_ns());
+
+  Bench("gettimeofday", []() {
+    struct timeval tv;
+    ::gettimeofday(&tv, nullptr);
+    return static_cast<uint64_t>(tv.tv_usec);
+  });
+  Bench("TimestampMicroSec", []() {
+    return util::time::TimestampMicroSec();
+  });
+  Bench("TimestampNanoSec", []() {
+    return util::time::TimestampNanoSec();
+  });
+  Bench("TimestampMonotonicNanoSec", []() {
+    return util::time::TimestampMonotonicNanoSec();
+  });
+  Bench("TimestampCoarseNanoSec", []() {
+    return util::time::TimestampCoarseNanoSec();
+  });
+  Bench("TimestampMonotonicCoarseNanoSec", []() {
+    return util::time::TimestampMonotonicCoarseNanoSec();
+  });
+  Bench("TscClock::Now", [&clock]() {
+    return clock.Now();
+  });
+  Bench("TscClock::NowSerialized", [&clock]() {
+    return clock.NowSerialized();
+  });
+  Bench("TscClock::NowNanoSec", [&clock]() {
+    return clock.NowNanoSec();
+  });
+  // 统计一次耗时的完整开销: 两次读取 + 换算
+  Bench("TscClock elapsed", [&clock]() {
+    uint64_t start = clock.Now();
+    return clock.ToNanoseconds(clock.NowSerialized() - start);
+  });
+  Bench("TimestampNanoSec elapsed", []() {
+    uint64_t start = util::time::TimestampNanoSec();
+    return util::time::TimestampNanoSec() - start;
+  });
+}
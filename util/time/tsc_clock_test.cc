@@ -0,0 +1,55 @@
+#include "util/time/tsc_clock.hpp"
+
+#include <time.h>
+
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include "util/time/timestamp.hpp"
+
+namespace util {
+namespace time {
+
+TEST(TscClockTest, calibrate) {
+  const TscClock& clock = TscClock::Instance();
+  std::cout << "TSC available [" << clock.is_tsc() << "] invariant TSC [" << TscClock::HasInvariantTsc()
+            << "] ticks per ns [" << clock.ticks_per_ns() << "]" << std::endl;
+  if (clock.is_tsc()) {
+    EXPECT_TRUE(TscClock::HasInvariantTsc());
+    EXPECT_GT(clock.ticks_per_ns(), 0.1);
+  } else {
+    EXPECT_EQ(clock.ToNanoseconds(12345), 12345UL);
+  }
+}
+
+TEST(TscClockTest, elapsed) {
+  const TscClock& clock = TscClock::Instance();
+  uint64_t start_ticks = clock.Now();
+  uint64_t start_ns = TimestampMonotonicNanoSec();
+  struct timespec sleep_time = {0, 50 * 1000 * 1000};
+  ::nanosleep(&sleep_time, nullptr);
+  uint64_t end_ticks = clock.NowSerialized();
+  uint64_t end_ns = TimestampMonotonicNanoSec();
+
+  // 和 CLOCK_MONOTONIC 的测量结果误差在 1% 以内
+  double elapsed_ns = static_cast<double>(clock.ToNanoseconds(end_ticks - start_ticks));
+  double expected_ns = static_cast<double>(end_ns - start_ns);
+  EXPECT_NEAR(elapsed_ns, expected_ns, expected_ns * 0.01);
+}
+
+TEST(TscClockTest, now_nanosec) {
+  const TscClock& clock = TscClock::Instance();
+  uint64_t last = clock.NowNanoSec();
+  for (int i = 0; i < 1000; ++i) {
+    uint64_t now = clock.NowNanoSec();
+    EXPECT_GE(now, last);
+    last = now;
+  }
+  // NowNanoSec 和 CLOCK_MONOTONIC 对齐, 长时间运行后的漂移取决于校准精度, 这里只检查毫秒级别的误差
+  uint64_t monotonic = TimestampMonotonicNanoSec();
+  uint64_t diff = last > monotonic ? last - monotonic : monotonic - last;
+  EXPECT_LT(diff, 10 * kMilliSeconds2NanoSeconds);
+}
+
+}  // namespace time
+}  // namespace util
@@ -5,3 +5,17 @@ target("util.time.timestamp_test", function()
     add_tests("default")
     add_packages("gtest")
 end)
+
+target("util.time.tsc_clock_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("tsc_clock_test.cc")
+    add_tests("default")
+    add_packages("gtest")
+end)
+
+target("util.time.tsc_clock_bench", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("tsc_clock_bench.cc")
+end)
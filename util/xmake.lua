@@ -0,0 +1,14 @@
+target("util.threadpool", function()
+    set_kind("object")
+    add_files("threadpool.cc")
+    add_deps("logger")
+end)
+
+target("util.threadpool_test", function()
+    set_kind("binary")
+    set_default(false)
+    add_files("threadpool_test.cc")
+    add_deps("util.threadpool")
+    add_tests("default")
+    add_packages("gtest")
+end)
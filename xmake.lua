@@ -13,3 +13,4 @@ add_includedirs(os.projectdir())
 add_cxxflags("-Wall", "-Wextra", "-Werror")
 
 add_requires("gtest 1.13.0", {configs = {main = true}})
+add_requires("zlib", "brotli", "openssl")